@@ -0,0 +1,194 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "cpu.h"
+#include "datareader.h"
+#include "net.h"
+
+class DataReaderFromEmpty : public ncnn::DataReader
+{
+public:
+    virtual int scan(const char* format, void* p) const
+    {
+        return 0;
+    }
+    virtual size_t read(void* buf, size_t size) const
+    {
+        memset(buf, 0, size);
+        return size;
+    }
+};
+
+static int g_loop_count = 4;
+
+// llm style feed forward blocks, weights are packed by gemm create_pipeline
+static void make_gemm_stack_param(char* param, int block_count, int hidden, int intermediate)
+{
+    char* p = param;
+
+    p += sprintf(p, "7767517\n");
+    p += sprintf(p, "%d %d\n", block_count * 2 + 1, block_count * 2 + 1);
+    p += sprintf(p, "Input data 0 1 blob0\n");
+
+    for (int i = 0; i < block_count; i++)
+    {
+        p += sprintf(p, "Gemm up%d 1 1 blob%d blob%d 5=1 6=1 8=%d 9=%d 10=-1\n", i, i * 2, i * 2 + 1, intermediate, hidden);
+        p += sprintf(p, "Gemm down%d 1 1 blob%d blob%d 5=1 6=1 8=%d 9=%d 10=-1\n", i, i * 2 + 1, i * 2 + 2, hidden, intermediate);
+    }
+}
+
+static double benchmark_load(const char* param, bool from_mem, const ncnn::Option& opt)
+{
+    double time_min = DBL_MAX;
+
+    for (int i = 0; i < g_loop_count; i++)
+    {
+        ncnn::Net net;
+        net.opt = opt;
+
+        int ret = from_mem ? net.load_param_mem(param) : net.load_param(param);
+        if (ret != 0)
+        {
+            fprintf(stderr, "load_param %s failed\n", from_mem ? "mem" : param);
+            return -1;
+        }
+
+        double start = ncnn::get_current_time();
+
+        DataReaderFromEmpty dr;
+        net.load_model(dr);
+
+        double end = ncnn::get_current_time();
+
+        time_min = std::min(time_min, end - start);
+    }
+
+    return time_min;
+}
+
+static void benchmark(const char* comment, const char* param, bool from_mem, const ncnn::Option& opt)
+{
+    ncnn::Option opt_serial = opt;
+    opt_serial.use_parallel_create_pipeline = false;
+
+    ncnn::Option opt_parallel = opt;
+    opt_parallel.use_parallel_create_pipeline = true;
+
+    double time_serial = benchmark_load(param, from_mem, opt_serial);
+    double time_parallel = benchmark_load(param, from_mem, opt_parallel);
+    if (time_serial < 0 || time_parallel < 0)
+        return;
+
+    fprintf(stderr, "%20s  serial = %8.2f  parallel = %8.2f  speedup = %5.2f\n", comment, time_serial, time_parallel, time_serial / time_parallel);
+}
+
+void show_usage()
+{
+    fprintf(stderr, "Usage: benchload [loop count] [num threads] [(key=value)...]\n");
+    fprintf(stderr, "  param=model.param\n");
+}
+
+int main(int argc, char** argv)
+{
+    int loop_count = 4;
+    int num_threads = ncnn::get_physical_big_cpu_count();
+    char* model = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (argv[i][0] == '-' && argv[i][1] == 'h')
+        {
+            show_usage();
+            return -1;
+        }
+
+        if (strcmp(argv[i], "--help") == 0)
+        {
+            show_usage();
+            return -1;
+        }
+    }
+
+    if (argc >= 2)
+    {
+        loop_count = atoi(argv[1]);
+    }
+    if (argc >= 3)
+    {
+        num_threads = atoi(argv[2]);
+    }
+
+    for (int i = 3; i < argc; i++)
+    {
+        // key=value
+        char* kv = argv[i];
+
+        char* eqs = strchr(kv, '=');
+        if (eqs == NULL)
+        {
+            fprintf(stderr, "unrecognized arg %s\n", kv);
+            continue;
+        }
+
+        // split k v
+        eqs[0] = '\0';
+        const char* key = kv;
+        char* value = eqs + 1;
+
+        if (strcmp(key, "param") == 0)
+            model = value;
+    }
+
+    g_loop_count = loop_count;
+
+    ncnn::set_omp_dynamic(0);
+    ncnn::set_omp_num_threads(num_threads);
+
+    // default option
+    ncnn::Option opt;
+    opt.lightmode = true;
+    opt.num_threads = num_threads;
+    opt.use_winograd_convolution = true;
+    opt.use_sgemm_convolution = true;
+    opt.use_int8_inference = true;
+    opt.use_packing_layout = true;
+
+    fprintf(stderr, "loop_count = %d\n", g_loop_count);
+    fprintf(stderr, "num_threads = %d\n", num_threads);
+
+    if (model != 0)
+    {
+        // run user defined benchmark
+        benchmark(model, model, false, opt);
+    }
+    else
+    {
+        // run default cases
+        benchmark("resnet50", "resnet50.param", false, opt);
+
+        benchmark("vgg16", "vgg16.param", false, opt);
+
+        char gemm_stack_param[4096];
+        make_gemm_stack_param(gemm_stack_param, 12, 1024, 4096);
+        benchmark("gemm_stack", gemm_stack_param, true, opt);
+    }
+
+    return 0;
+}
@@ -468,6 +468,8 @@ int main(int argc, char** argv)
         benchmark("vision_transformer", ncnn::Mat(384, 384, 3), opt);
 
         benchmark("FastestDet", ncnn::Mat(352, 352, 3), opt);
+
+        benchmark("style_transfer", ncnn::Mat(256, 256, 3), opt);
     }
 #if NCNN_VULKAN
     delete g_blob_vkallocator;
@@ -219,7 +219,15 @@ PYBIND11_MODULE(ncnn, m)
     .def_readwrite("use_subgroup_ballot", &Option::use_subgroup_ballot)
     .def_readwrite("use_subgroup_shuffle", &Option::use_subgroup_shuffle)
     .def_readwrite("use_image_storage", &Option::use_image_storage)
-    .def_readwrite("use_tensor_storage", &Option::use_tensor_storage);
+    .def_readwrite("use_tensor_storage", &Option::use_tensor_storage)
+    // bit fields have no member pointer for def_readwrite
+    .def_property("use_memory_planner", [](const Option& opt) { return (bool)opt.use_memory_planner; }, [](Option& opt, bool v) { opt.use_memory_planner = v; })
+    .def_property("use_branch_parallel", [](const Option& opt) { return (bool)opt.use_branch_parallel; }, [](Option& opt, bool v) { opt.use_branch_parallel = v; })
+    .def_property("use_parallel_create_pipeline", [](const Option& opt) { return (bool)opt.use_parallel_create_pipeline; }, [](Option& opt, bool v) { opt.use_parallel_create_pipeline = v; })
+    .def_property("use_elementwise_fusion", [](const Option& opt) { return (bool)opt.use_elementwise_fusion; }, [](Option& opt, bool v) { opt.use_elementwise_fusion = v; })
+    .def_property("use_kernel_autotune", [](const Option& opt) { return (bool)opt.use_kernel_autotune; }, [](Option& opt, bool v) { opt.use_kernel_autotune = v; })
+    .def_property("use_x86_fp16_storage", [](const Option& opt) { return (bool)opt.use_x86_fp16_storage; }, [](Option& opt, bool v) { opt.use_x86_fp16_storage = v; })
+    .def_property("use_x86_fp16_arithmetic", [](const Option& opt) { return (bool)opt.use_x86_fp16_arithmetic; }, [](Option& opt, bool v) { opt.use_x86_fp16_arithmetic = v; });
 
     py::class_<Mat> mat(m, "Mat", py::buffer_protocol());
     mat.def(py::init<>())
@@ -265,46 +273,9 @@ PYBIND11_MODULE(ncnn, m)
     .def(py::init<const Mat&>(), py::arg("m"))
 
     .def(py::init([](py::buffer const b) {
-        py::buffer_info info = b.request();
-        if (info.ndim > 4)
-        {
-            std::stringstream ss;
-            ss << "convert numpy.ndarray to ncnn.Mat only dims <=4 support now, but given " << info.ndim;
-            pybind11::pybind11_fail(ss.str());
-        }
-
-        size_t elemsize = info.itemsize;
-
-        Mat* v = nullptr;
-        if (info.ndim == 1)
-        {
-            v = new Mat((int)info.shape[0], info.ptr, elemsize);
-        }
-        else if (info.ndim == 2)
-        {
-            v = new Mat((int)info.shape[1], (int)info.shape[0], info.ptr, elemsize);
-        }
-        else if (info.ndim == 3)
-        {
-            v = new Mat((int)info.shape[2], (int)info.shape[1], (int)info.shape[0], info.ptr, elemsize);
-
-            // in ncnn, buffer to construct ncnn::Mat need align to ncnn::alignSize
-            // with (w * h * elemsize, 16) / elemsize, but the buffer from numpy not
-            // so we set the cstep as numpy's cstep
-            v->cstep = (int)info.shape[2] * (int)info.shape[1];
-        }
-        else if (info.ndim == 4)
-        {
-            v = new Mat((int)info.shape[3], (int)info.shape[2], (int)info.shape[1], (int)info.shape[0], info.ptr, elemsize);
-
-            // in ncnn, buffer to construct ncnn::Mat need align to ncnn::alignSize
-            // with (w * h * d elemsize, 16) / elemsize, but the buffer from numpy not
-            // so we set the cstep as numpy's cstep
-            v->cstep = (int)info.shape[3] * (int)info.shape[2] * (int)info.shape[1];
-        }
-        return std::unique_ptr<Mat>(v);
+        return std::unique_ptr<Mat>(new Mat(from_buffer_info(b.request())));
     }),
-    py::arg("array"))
+    py::arg("array"), py::keep_alive<1, 2>()) // mat shares the array memory, keep array alive
     .def_buffer([](Mat& m) -> py::buffer_info {
         return to_buffer_info(m);
     })
@@ -859,23 +830,43 @@ PYBIND11_MODULE(ncnn, m)
     .def("set_num_threads", &Extractor::set_num_threads, py::arg("num_threads"))
     .def("set_blob_allocator", &Extractor::set_blob_allocator, py::arg("allocator"))
     .def("set_workspace_allocator", &Extractor::set_workspace_allocator, py::arg("allocator"))
+    // input mat may share numpy memory, keep it alive as long as the extractor
+    // extract runs without the gil so that several python threads can infer concurrently
 #if NCNN_STRING
-    .def("input", (int (Extractor::*)(const char*, const Mat&)) & Extractor::input, py::arg("blob_name"), py::arg("in"))
-    .def("extract", (int (Extractor::*)(const char*, Mat&, int)) & Extractor::extract, py::arg("blob_name"), py::arg("feat"), py::arg("type") = 0)
+    .def("input", (int (Extractor::*)(const char*, const Mat&)) & Extractor::input, py::arg("blob_name"), py::arg("in"), py::keep_alive<1, 3>())
+    .def(
+    "input", [](Extractor& ex, const char* blob_name, py::buffer const b) {
+        return ex.input(blob_name, from_buffer_info(b.request()));
+    },
+    py::arg("blob_name"), py::arg("array"), py::keep_alive<1, 3>())
+    .def("extract", (int (Extractor::*)(const char*, Mat&, int)) & Extractor::extract, py::arg("blob_name"), py::arg("feat"), py::arg("type") = 0, py::call_guard<py::gil_scoped_release>())
     .def(
     "extract", [](Extractor& ex, const char* blob_name, int type) {
         ncnn::Mat feat;
-        int ret = ex.extract(blob_name, feat, type);
+        int ret;
+        {
+            py::gil_scoped_release release;
+            ret = ex.extract(blob_name, feat, type);
+        }
         return py::make_tuple(ret, feat.clone());
     },
     py::arg("blob_name"), py::arg("type") = 0)
 #endif
-    .def("input", (int (Extractor::*)(int, const Mat&)) & Extractor::input)
-    .def("extract", (int (Extractor::*)(int, Mat&, int)) & Extractor::extract, py::arg("blob_index"), py::arg("feat"), py::arg("type") = 0)
+    .def("input", (int (Extractor::*)(int, const Mat&)) & Extractor::input, py::keep_alive<1, 3>())
+    .def(
+    "input", [](Extractor& ex, int blob_index, py::buffer const b) {
+        return ex.input(blob_index, from_buffer_info(b.request()));
+    },
+    py::arg("blob_index"), py::arg("array"), py::keep_alive<1, 3>())
+    .def("extract", (int (Extractor::*)(int, Mat&, int)) & Extractor::extract, py::arg("blob_index"), py::arg("feat"), py::arg("type") = 0, py::call_guard<py::gil_scoped_release>())
     .def(
     "extract", [](Extractor& ex, int blob_index, int type) {
         ncnn::Mat feat;
-        int ret = ex.extract(blob_index, feat, type);
+        int ret;
+        {
+            py::gil_scoped_release release;
+            ret = ex.extract(blob_index, feat, type);
+        }
         return py::make_tuple(ret, feat.clone());
     },
     py::arg("blob_index"), py::arg("type") = 0);
@@ -957,26 +948,27 @@ PYBIND11_MODULE(ncnn, m)
         return net.register_custom_layer(index, lf.creator_func, lf.destroyer_func);
     },
     py::arg("index"), py::arg("creator"), py::arg("destroyer"))
+    // loading runs without the gil, python datareader and custom layer callbacks reacquire it
 #if NCNN_STRING
-    .def("load_param", (int (Net::*)(const DataReader&)) & Net::load_param, py::arg("dr"))
+    .def("load_param", (int (Net::*)(const DataReader&)) & Net::load_param, py::arg("dr"), py::call_guard<py::gil_scoped_release>())
 #endif // NCNN_STRING
-    .def("load_param_bin", (int (Net::*)(const DataReader&)) & Net::load_param_bin, py::arg("dr"))
-    .def("load_model", (int (Net::*)(const DataReader&)) & Net::load_model, py::arg("dr"))
+    .def("load_param_bin", (int (Net::*)(const DataReader&)) & Net::load_param_bin, py::arg("dr"), py::call_guard<py::gil_scoped_release>())
+    .def("load_model", (int (Net::*)(const DataReader&)) & Net::load_model, py::arg("dr"), py::call_guard<py::gil_scoped_release>())
 
 #if NCNN_STDIO
 #if NCNN_STRING
-    .def("load_param", (int (Net::*)(const char*)) & Net::load_param, py::arg("protopath"))
-    .def("load_param_mem", (int (Net::*)(const char*)) & Net::load_param_mem, py::arg("mem"))
+    .def("load_param", (int (Net::*)(const char*)) & Net::load_param, py::arg("protopath"), py::call_guard<py::gil_scoped_release>())
+    .def("load_param_mem", (int (Net::*)(const char*)) & Net::load_param_mem, py::arg("mem"), py::call_guard<py::gil_scoped_release>())
 #endif // NCNN_STRING
-    .def("load_param_bin", (int (Net::*)(const char*)) & Net::load_param_bin, py::arg("protopath"))
-    .def("load_model", (int (Net::*)(const char*)) & Net::load_model, py::arg("modelpath"))
+    .def("load_param_bin", (int (Net::*)(const char*)) & Net::load_param_bin, py::arg("protopath"), py::call_guard<py::gil_scoped_release>())
+    .def("load_model", (int (Net::*)(const char*)) & Net::load_model, py::arg("modelpath"), py::call_guard<py::gil_scoped_release>())
     .def(
     "load_model_mem", [](Net& net, const char* mem) {
         const unsigned char* _mem = (const unsigned char*)mem;
         DataReaderFromMemoryCopy dr(_mem);
         net.load_model(dr);
     },
-    py::arg("mem"))
+    py::arg("mem"), py::call_guard<py::gil_scoped_release>())
 #endif // NCNN_STDIO
 
     .def("clear", &Net::clear)
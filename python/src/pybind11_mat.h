@@ -16,6 +16,7 @@
 #ifndef PYBIND11_NCNN_MAT_H
 #define PYBIND11_NCNN_MAT_H
 
+#include <sstream>
 #include <string>
 
 #include <pybind11/pybind11.h>
@@ -113,4 +114,63 @@ py::buffer_info to_buffer_info(ncnn::Mat& m, const std::string& format = "")
                           );
 }
 
+// wrap the buffer as an external-data ncnn::Mat without memory copy
+// rows must be dense, only the outermost stride of 3/4-dims buffer may be padded
+ncnn::Mat from_buffer_info(const py::buffer_info& info)
+{
+    if (info.ndim < 1 || info.ndim > 4)
+    {
+        std::stringstream ss;
+        ss << "convert numpy.ndarray to ncnn.Mat only dims <=4 support now, but given " << info.ndim;
+        pybind11::pybind11_fail(ss.str());
+    }
+
+    const size_t elemsize = info.itemsize;
+
+    // dims that map to one ncnn channel must be dense
+    const int dense_begin = info.ndim >= 3 ? 1 : 0;
+    py::ssize_t dense_stride = elemsize;
+    for (int i = (int)info.ndim - 1; i >= dense_begin; i--)
+    {
+        if (info.shape[i] != 1 && info.strides[i] != dense_stride)
+        {
+            pybind11::pybind11_fail("convert numpy.ndarray to ncnn.Mat requires c-contiguous rows, use numpy.ascontiguousarray first");
+        }
+        dense_stride *= info.shape[i];
+    }
+
+    if (info.ndim >= 3 && info.shape[0] != 1 && (info.strides[0] < dense_stride || info.strides[0] % elemsize != 0))
+    {
+        pybind11::pybind11_fail("convert numpy.ndarray to ncnn.Mat requires c-contiguous channels, use numpy.ascontiguousarray first");
+    }
+
+    ncnn::Mat m;
+    if (info.ndim == 1)
+    {
+        m = ncnn::Mat((int)info.shape[0], info.ptr, elemsize);
+    }
+    else if (info.ndim == 2)
+    {
+        m = ncnn::Mat((int)info.shape[1], (int)info.shape[0], info.ptr, elemsize);
+    }
+    else if (info.ndim == 3)
+    {
+        m = ncnn::Mat((int)info.shape[2], (int)info.shape[1], (int)info.shape[0], info.ptr, elemsize);
+    }
+    else if (info.ndim == 4)
+    {
+        m = ncnn::Mat((int)info.shape[3], (int)info.shape[2], (int)info.shape[1], (int)info.shape[0], info.ptr, elemsize);
+    }
+
+    if (info.ndim >= 3)
+    {
+        // in ncnn, buffer to construct ncnn::Mat need align to ncnn::alignSize
+        // with (w * h * d * elemsize, 16) / elemsize, but the buffer from numpy not
+        // so we set the cstep as numpy's channel stride
+        m.cstep = info.shape[0] == 1 ? dense_stride / elemsize : info.strides[0] / elemsize;
+    }
+
+    return m;
+}
+
 #endif
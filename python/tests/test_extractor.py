@@ -12,6 +12,9 @@
 # CONDITIONS OF ANY KIND, either express or implied. See the License for the
 # specific language governing permissions and limitations under the License.
 
+import threading
+
+import numpy as np
 import pytest
 
 import ncnn
@@ -84,3 +87,56 @@ def test_extractor_index():
 
     # not use with sentence, call clear manually to ensure ex destruct before net
     ex.clear()
+
+
+def test_extractor_numpy():
+    dr = ncnn.DataReaderFromEmpty()
+
+    net = ncnn.Net()
+    net.load_param("tests/test.param")
+    net.load_model(dr)
+
+    array = np.random.rand(3, 227, 227).astype(np.float32)
+    ex = net.create_extractor()
+    ex.set_light_mode(True)
+
+    # numpy array is fed without memory copy
+    ex.input("data", array)
+    ret, out_mat = ex.extract("conv0_fwd")
+    assert (
+        ret == 0
+        and out_mat.dims == 3
+        and out_mat.w == 225
+        and out_mat.h == 225
+        and out_mat.c == 3
+    )
+
+    ex.clear()
+
+
+def test_extractor_threads():
+    dr = ncnn.DataReaderFromEmpty()
+
+    net = ncnn.Net()
+    net.load_param("tests/test.param")
+    net.load_model(dr)
+
+    results = [None] * 4
+
+    def infer(i):
+        in_mat = ncnn.Mat((227, 227, 3))
+        in_mat.fill(0.1 * i)
+        ex = net.create_extractor()
+        ex.input("data", in_mat)
+        results[i] = ex.extract("conv0_fwd")
+        ex.clear()
+
+    # extract releases the gil, extractors from one net can run concurrently
+    threads = [threading.Thread(target=infer, args=(i,)) for i in range(4)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    for ret, out_mat in results:
+        assert ret == 0 and out_mat.w == 225 and out_mat.h == 225 and out_mat.c == 3
@@ -774,3 +774,22 @@ def test_substract_mean_normalize():
     assert (
         np.abs((pixels[0, 0, 0] - 127.5) * 0.007843 - mat.channel(0).row(0)[0]) < 1e-5
     )
+
+
+def test_numpy_no_copy():
+    array = np.random.rand(3, 4, 5).astype(np.float32)
+    mat = ncnn.Mat(array)
+    assert mat.w == 5 and mat.h == 4 and mat.c == 3 and mat.cstep == 20
+    array[1, 2, 3] = 42
+    assert mat.channel(1).row(2)[3] == 42
+
+    del array
+    assert mat.numpy()[1, 2, 3] == 42
+
+    array = np.zeros((3, 4, 8), dtype=np.float32)[:, :, :5]
+    with pytest.raises(RuntimeError) as execinfo:
+        mat = ncnn.Mat(array)
+    assert "ascontiguousarray" in str(execinfo.value)
+
+    mat = ncnn.Mat(np.ascontiguousarray(array))
+    assert mat.w == 5 and mat.h == 4 and mat.c == 3
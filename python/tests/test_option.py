@@ -137,3 +137,38 @@ def test_option():
     assert opt.use_tensor_storage == True
     opt.use_tensor_storage = False
     assert opt.use_tensor_storage == False
+
+    opt.use_memory_planner = True
+    assert opt.use_memory_planner == True
+    opt.use_memory_planner = False
+    assert opt.use_memory_planner == False
+
+    opt.use_branch_parallel = True
+    assert opt.use_branch_parallel == True
+    opt.use_branch_parallel = False
+    assert opt.use_branch_parallel == False
+
+    opt.use_parallel_create_pipeline = True
+    assert opt.use_parallel_create_pipeline == True
+    opt.use_parallel_create_pipeline = False
+    assert opt.use_parallel_create_pipeline == False
+
+    opt.use_elementwise_fusion = True
+    assert opt.use_elementwise_fusion == True
+    opt.use_elementwise_fusion = False
+    assert opt.use_elementwise_fusion == False
+
+    opt.use_kernel_autotune = True
+    assert opt.use_kernel_autotune == True
+    opt.use_kernel_autotune = False
+    assert opt.use_kernel_autotune == False
+
+    opt.use_x86_fp16_storage = True
+    assert opt.use_x86_fp16_storage == True
+    opt.use_x86_fp16_storage = False
+    assert opt.use_x86_fp16_storage == False
+
+    opt.use_x86_fp16_arithmetic = True
+    assert opt.use_x86_fp16_arithmetic == True
+    opt.use_x86_fp16_arithmetic = False
+    assert opt.use_x86_fp16_arithmetic == False
@@ -357,6 +357,706 @@ void UnlockedPoolAllocator::fastFree(void* ptr)
     ncnn::fastFree(ptr);
 }
 
+class PlannedAllocatorPrivate
+{
+public:
+    // session state
+    // 0 = recording on heap
+    // 1 = replaying from arena
+    // 2 = heap passthrough, arena still referenced by someone
+    int state;
+
+    Mutex lock;
+
+    // recorded sequence, block index for malloc and -1 - block index for free
+    std::vector<int> events;
+    std::vector<size_t> block_sizes;
+    std::vector<size_t> block_offsets;
+
+    // recording blocks in use
+    std::list<std::pair<void*, int> > payouts;
+
+    unsigned char* arena;
+    size_t arena_size;
+
+    // replay cursor in events
+    size_t cursor;
+    bool diverged;
+
+    // arena blocks in use
+    int arena_payouts;
+
+    // heap source for recording and deviations
+    Allocator* fallback_allocator;
+
+    void* heap_malloc(size_t size) const
+    {
+        return fallback_allocator ? fallback_allocator->fastMalloc(size) : ncnn::fastMalloc(size);
+    }
+
+    void heap_free(void* ptr) const
+    {
+        if (fallback_allocator)
+            fallback_allocator->fastFree(ptr);
+        else
+            ncnn::fastFree(ptr);
+    }
+
+    bool in_arena(const void* ptr) const
+    {
+        return arena && (const unsigned char*)ptr >= arena && (const unsigned char*)ptr < arena + arena_size;
+    }
+
+    int plan();
+    void reset_plan();
+};
+
+void PlannedAllocatorPrivate::reset_plan()
+{
+    ncnn::fastFree(arena);
+    arena = 0;
+    arena_size = 0;
+
+    events.clear();
+    block_sizes.clear();
+    block_offsets.clear();
+
+    state = 0;
+    cursor = 0;
+    diverged = false;
+}
+
+int PlannedAllocatorPrivate::plan()
+{
+    // plan only a complete session
+    if (state != 0 || events.empty() || !payouts.empty())
+        return -1;
+
+    const int block_count = (int)block_sizes.size();
+    const int event_count = (int)events.size();
+
+    // resolve block lifetime as [alloc event, free event)
+    std::vector<int> alloc_times(block_count, 0);
+    std::vector<int> free_times(block_count, event_count);
+    for (int i = 0; i < event_count; i++)
+    {
+        int e = events[i];
+        if (e >= 0)
+            alloc_times[e] = i;
+        else
+            free_times[-1 - e] = i;
+    }
+
+    // greedy by size, the largest block picks its offset first
+    std::vector<std::pair<size_t, int> > order(block_count);
+    for (int i = 0; i < block_count; i++)
+    {
+        order[i] = std::make_pair(block_sizes[i], -i);
+    }
+    std::sort(order.begin(), order.end());
+    std::reverse(order.begin(), order.end());
+
+    block_offsets.resize(block_count);
+
+    size_t total_size = 0;
+    std::vector<std::pair<size_t, size_t> > conflicts;
+    std::vector<int> placed;
+    for (int i = 0; i < block_count; i++)
+    {
+        const int bi = -order[i].second;
+        const size_t size = alignSize(block_sizes[bi], NCNN_MALLOC_ALIGN);
+
+        // gather placed blocks alive at the same time
+        conflicts.clear();
+        for (size_t j = 0; j < placed.size(); j++)
+        {
+            const int pj = placed[j];
+            if (alloc_times[pj] < free_times[bi] && alloc_times[bi] < free_times[pj])
+            {
+                conflicts.push_back(std::make_pair(block_offsets[pj], block_offsets[pj] + alignSize(block_sizes[pj], NCNN_MALLOC_ALIGN)));
+            }
+        }
+        std::sort(conflicts.begin(), conflicts.end());
+
+        // best fit into the smallest gap, or append at the end
+        size_t best_offset = (size_t)-1;
+        size_t best_gap = (size_t)-1;
+        size_t offset = 0;
+        for (size_t j = 0; j < conflicts.size(); j++)
+        {
+            if (conflicts[j].first >= offset + size)
+            {
+                size_t gap = conflicts[j].first - offset;
+                if (gap < best_gap)
+                {
+                    best_gap = gap;
+                    best_offset = offset;
+                }
+            }
+
+            offset = std::max(offset, conflicts[j].second);
+        }
+        if (best_offset == (size_t)-1)
+        {
+            best_offset = offset;
+        }
+
+        block_offsets[bi] = best_offset;
+        total_size = std::max(total_size, best_offset + size);
+
+        placed.push_back(bi);
+    }
+
+    arena = (unsigned char*)ncnn::fastMalloc(total_size);
+    if (!arena)
+    {
+        NCNN_LOGE("planned allocator arena %lu bytes allocation failed", (unsigned long)total_size);
+        events.clear();
+        block_sizes.clear();
+        block_offsets.clear();
+        return -100;
+    }
+
+    arena_size = total_size;
+    state = 1;
+    cursor = events.size();
+    diverged = false;
+
+    return 0;
+}
+
+PlannedAllocator::PlannedAllocator()
+    : Allocator(), d(new PlannedAllocatorPrivate)
+{
+    d->state = 0;
+    d->arena = 0;
+    d->arena_size = 0;
+    d->cursor = 0;
+    d->diverged = false;
+    d->arena_payouts = 0;
+    d->fallback_allocator = 0;
+}
+
+PlannedAllocator::~PlannedAllocator()
+{
+    if (!d->payouts.empty() || d->arena_payouts != 0)
+    {
+        NCNN_LOGE("FATAL ERROR! planned allocator destroyed too early");
+#if NCNN_STDIO
+        std::list<std::pair<void*, int> >::iterator it = d->payouts.begin();
+        for (; it != d->payouts.end(); ++it)
+        {
+            void* ptr = it->first;
+            NCNN_LOGE("%p still in use", ptr);
+        }
+#endif
+    }
+
+    ncnn::fastFree(d->arena);
+
+    delete d;
+}
+
+PlannedAllocator::PlannedAllocator(const PlannedAllocator&)
+    : d(0)
+{
+}
+
+PlannedAllocator& PlannedAllocator::operator=(const PlannedAllocator&)
+{
+    return *this;
+}
+
+void PlannedAllocator::rewind()
+{
+    MutexLockGuard lock(d->lock);
+
+    if (d->state == 0)
+    {
+        if (d->events.empty())
+            return;
+
+        // the previous session was not planned yet
+        if (d->plan() != 0)
+        {
+            // keep recording, blocks still in use are detached to heap
+            d->events.clear();
+            d->block_sizes.clear();
+            d->payouts.clear();
+            return;
+        }
+    }
+
+    if (d->arena_payouts != 0)
+    {
+        // someone still holds arena memory from the previous session
+        d->state = 2;
+        return;
+    }
+
+    if (d->state == 1 && (d->diverged || d->cursor != d->events.size()))
+    {
+        // input shape changed, record a new plan
+        d->reset_plan();
+        return;
+    }
+
+    d->state = 1;
+    d->cursor = 0;
+    d->diverged = false;
+}
+
+int PlannedAllocator::plan()
+{
+    MutexLockGuard lock(d->lock);
+
+    return d->plan();
+}
+
+size_t PlannedAllocator::arena_size() const
+{
+    MutexLockGuard lock(d->lock);
+
+    return d->arena_size;
+}
+
+void PlannedAllocator::clear()
+{
+    MutexLockGuard lock(d->lock);
+
+    if (d->arena_payouts != 0)
+    {
+        NCNN_LOGE("planned allocator clear while arena still in use");
+        d->state = 2;
+        return;
+    }
+
+    d->reset_plan();
+}
+
+void PlannedAllocator::set_fallback_allocator(Allocator* allocator)
+{
+    MutexLockGuard lock(d->lock);
+
+    if (!d->payouts.empty())
+    {
+        NCNN_LOGE("planned allocator set_fallback_allocator while recording blocks in use");
+        return;
+    }
+
+    d->fallback_allocator = allocator;
+}
+
+void* PlannedAllocator::fastMalloc(size_t size)
+{
+    MutexLockGuard lock(d->lock);
+
+    if (d->state == 0)
+    {
+        void* ptr = d->heap_malloc(size);
+        if (!ptr)
+            return 0;
+
+        const int bi = (int)d->block_sizes.size();
+        d->block_sizes.push_back(size);
+        d->events.push_back(bi);
+        d->payouts.push_back(std::make_pair(ptr, bi));
+
+        return ptr;
+    }
+
+    if (d->state == 1 && !d->diverged && d->cursor < d->events.size())
+    {
+        const int e = d->events[d->cursor];
+        if (e >= 0 && d->block_sizes[e] >= size)
+        {
+            d->cursor++;
+            d->arena_payouts++;
+            return d->arena + d->block_offsets[e];
+        }
+    }
+
+    // no more arena block handed out in this session
+    d->diverged = true;
+
+    return d->heap_malloc(size);
+}
+
+void PlannedAllocator::fastFree(void* ptr)
+{
+    MutexLockGuard lock(d->lock);
+
+    if (d->in_arena(ptr))
+    {
+        d->arena_payouts--;
+
+        if (d->state == 1 && !d->diverged && d->cursor < d->events.size())
+        {
+            const int e = d->events[d->cursor];
+            if (e < 0 && d->arena + d->block_offsets[-1 - e] == ptr)
+            {
+                d->cursor++;
+                return;
+            }
+        }
+
+        d->diverged = true;
+        return;
+    }
+
+    if (d->state == 0)
+    {
+        std::list<std::pair<void*, int> >::iterator it = d->payouts.begin();
+        for (; it != d->payouts.end(); ++it)
+        {
+            if (it->first == ptr)
+            {
+                d->events.push_back(-1 - it->second);
+                d->payouts.erase(it);
+                d->heap_free(ptr);
+                return;
+            }
+        }
+    }
+
+    // heap block from fallback or from an unfinished recording
+    d->heap_free(ptr);
+}
+
+// atomic pointer and counter operations for the lock-free shared free list
+#if NCNN_THREADS && defined _MSC_VER
+static NCNN_FORCEINLINE void* atomic_exchange_ptr(void* volatile* addr, void* value)
+{
+    return InterlockedExchangePointer(addr, value);
+}
+
+static NCNN_FORCEINLINE bool atomic_cas_ptr(void* volatile* addr, void* comparand, void* value)
+{
+    return InterlockedCompareExchangePointer(addr, value, comparand) == comparand;
+}
+
+static NCNN_FORCEINLINE void atomic_add_size(volatile size_t* addr, size_t delta)
+{
+#if defined _WIN64
+    InterlockedExchangeAdd64((volatile LONG64*)addr, (LONG64)delta);
+#else
+    InterlockedExchangeAdd((volatile LONG*)addr, (LONG)delta);
+#endif
+}
+#elif NCNN_THREADS && defined __GNUC__ && !(defined __riscv && !defined __riscv_atomic)
+static NCNN_FORCEINLINE void* atomic_exchange_ptr(void* volatile* addr, void* value)
+{
+    return __sync_lock_test_and_set(addr, value);
+}
+
+static NCNN_FORCEINLINE bool atomic_cas_ptr(void* volatile* addr, void* comparand, void* value)
+{
+    return __sync_bool_compare_and_swap(addr, comparand, value);
+}
+
+static NCNN_FORCEINLINE void atomic_add_size(volatile size_t* addr, size_t delta)
+{
+    __sync_fetch_and_add(addr, delta);
+}
+#else
+// thread-unsafe branch
+static NCNN_FORCEINLINE void* atomic_exchange_ptr(void* volatile* addr, void* value)
+{
+    void* tmp = *addr;
+    *addr = value;
+    return tmp;
+}
+
+static NCNN_FORCEINLINE bool atomic_cas_ptr(void* volatile* addr, void* comparand, void* value)
+{
+    if (*addr != comparand)
+        return false;
+
+    *addr = value;
+    return true;
+}
+
+static NCNN_FORCEINLINE void atomic_add_size(volatile size_t* addr, size_t delta)
+{
+    *addr += delta;
+}
+#endif
+
+// 64 bytes to 2G bytes, larger blocks bypass the pool
+static const int size_class_min_shift = 6;
+static const int size_class_count = 26;
+
+// free blocks kept by each thread for each size class
+static const int size_class_cache_depth = 4;
+
+// free blocks shared among threads for each size class
+static const int size_class_slot_count = 8;
+
+static inline int size_class_index(size_t size)
+{
+    int k = 0;
+    while (((size_t)1 << (k + size_class_min_shift)) < size)
+    {
+        k++;
+        if (k == size_class_count)
+            return -1;
+    }
+
+    return k;
+}
+
+static inline size_t size_class_size(int k)
+{
+    return (size_t)1 << (k + size_class_min_shift);
+}
+
+// the size class index is stored in a header right before the block
+static void* size_class_block_malloc(size_t size, int k)
+{
+    unsigned char* udata = (unsigned char*)ncnn::fastMalloc(size + NCNN_MALLOC_ALIGN);
+    if (!udata)
+        return 0;
+
+    *(int*)udata = k;
+
+    return udata + NCNN_MALLOC_ALIGN;
+}
+
+static void size_class_block_free(void* ptr)
+{
+    ncnn::fastFree((unsigned char*)ptr - NCNN_MALLOC_ALIGN);
+}
+
+static inline int size_class_block_index(void* ptr)
+{
+    return *(const int*)((const unsigned char*)ptr - NCNN_MALLOC_ALIGN);
+}
+
+class SizeClassThreadCache
+{
+public:
+    int counts[size_class_count];
+    void* blocks[size_class_count][size_class_cache_depth];
+};
+
+class SizeClassPoolAllocatorPrivate
+{
+public:
+    SizeClassThreadCache* thread_cache();
+
+    // each slot owns at most one block and is only swapped as a whole
+    // so there is no aba problem unlike a linked free list
+    void* volatile slots[size_class_count][size_class_slot_count];
+
+    ThreadLocalStorage tls;
+    Mutex caches_lock;
+    std::vector<SizeClassThreadCache*> caches;
+
+    volatile size_t hit_count;
+    volatile size_t miss_count;
+    volatile size_t held_size;
+    volatile size_t payout_count;
+};
+
+SizeClassThreadCache* SizeClassPoolAllocatorPrivate::thread_cache()
+{
+    SizeClassThreadCache* cache = (SizeClassThreadCache*)tls.get();
+    if (cache)
+        return cache;
+
+    // first allocation on this thread
+    cache = new SizeClassThreadCache;
+    for (int k = 0; k < size_class_count; k++)
+    {
+        cache->counts[k] = 0;
+    }
+
+    caches_lock.lock();
+    caches.push_back(cache);
+    caches_lock.unlock();
+
+    tls.set(cache);
+
+    return cache;
+}
+
+SizeClassPoolAllocator::SizeClassPoolAllocator()
+    : Allocator(), d(new SizeClassPoolAllocatorPrivate)
+{
+    for (int k = 0; k < size_class_count; k++)
+    {
+        for (int i = 0; i < size_class_slot_count; i++)
+        {
+            d->slots[k][i] = 0;
+        }
+    }
+
+    d->hit_count = 0;
+    d->miss_count = 0;
+    d->held_size = 0;
+    d->payout_count = 0;
+}
+
+SizeClassPoolAllocator::~SizeClassPoolAllocator()
+{
+    clear();
+
+    if (d->payout_count != 0)
+    {
+        NCNN_LOGE("FATAL ERROR! size class pool allocator destroyed too early, %lu blocks still in use", (unsigned long)d->payout_count);
+    }
+
+    for (size_t i = 0; i < d->caches.size(); i++)
+    {
+        delete d->caches[i];
+    }
+
+    delete d;
+}
+
+SizeClassPoolAllocator::SizeClassPoolAllocator(const SizeClassPoolAllocator&)
+    : d(0)
+{
+}
+
+SizeClassPoolAllocator& SizeClassPoolAllocator::operator=(const SizeClassPoolAllocator&)
+{
+    return *this;
+}
+
+void SizeClassPoolAllocator::clear()
+{
+    MutexLockGuard lock(d->caches_lock);
+
+    for (size_t i = 0; i < d->caches.size(); i++)
+    {
+        SizeClassThreadCache* cache = d->caches[i];
+        for (int k = 0; k < size_class_count; k++)
+        {
+            for (int j = 0; j < cache->counts[k]; j++)
+            {
+                size_class_block_free(cache->blocks[k][j]);
+            }
+            cache->counts[k] = 0;
+        }
+    }
+
+    for (int k = 0; k < size_class_count; k++)
+    {
+        for (int i = 0; i < size_class_slot_count; i++)
+        {
+            void* ptr = atomic_exchange_ptr(&d->slots[k][i], 0);
+            if (ptr)
+                size_class_block_free(ptr);
+        }
+    }
+
+    d->held_size = 0;
+}
+
+size_t SizeClassPoolAllocator::hit_count() const
+{
+    return d->hit_count;
+}
+
+size_t SizeClassPoolAllocator::miss_count() const
+{
+    return d->miss_count;
+}
+
+size_t SizeClassPoolAllocator::held_size() const
+{
+    return d->held_size;
+}
+
+void* SizeClassPoolAllocator::fastMalloc(size_t size)
+{
+    const int k = size_class_index(size);
+    if (k == -1)
+    {
+        atomic_add_size(&d->miss_count, 1);
+
+        void* ptr = size_class_block_malloc(size, -1);
+        if (ptr)
+            atomic_add_size(&d->payout_count, 1);
+
+        return ptr;
+    }
+
+    void* ptr = 0;
+
+    // thread cache first, no synchronization needed
+    SizeClassThreadCache* cache = d->thread_cache();
+    if (cache->counts[k] > 0)
+    {
+        cache->counts[k]--;
+        ptr = cache->blocks[k][cache->counts[k]];
+    }
+
+    // then the shared slots
+    for (int i = 0; i < size_class_slot_count && !ptr; i++)
+    {
+        if (d->slots[k][i])
+            ptr = atomic_exchange_ptr(&d->slots[k][i], 0);
+    }
+
+    if (ptr)
+    {
+        atomic_add_size(&d->hit_count, 1);
+        atomic_add_size(&d->held_size, (size_t)0 - size_class_size(k));
+    }
+    else
+    {
+        atomic_add_size(&d->miss_count, 1);
+
+        ptr = size_class_block_malloc(size_class_size(k), k);
+        if (!ptr)
+            return 0;
+    }
+
+    atomic_add_size(&d->payout_count, 1);
+
+    return ptr;
+}
+
+void SizeClassPoolAllocator::fastFree(void* ptr)
+{
+    if (!ptr)
+        return;
+
+    atomic_add_size(&d->payout_count, (size_t)0 - 1);
+
+    const int k = size_class_block_index(ptr);
+    if (k == -1)
+    {
+        size_class_block_free(ptr);
+        return;
+    }
+
+    // count before the block becomes visible to other threads
+    atomic_add_size(&d->held_size, size_class_size(k));
+
+    SizeClassThreadCache* cache = d->thread_cache();
+    if (cache->counts[k] < size_class_cache_depth)
+    {
+        cache->blocks[k][cache->counts[k]] = ptr;
+        cache->counts[k]++;
+        return;
+    }
+
+    // thread cache full, spill to the shared slots
+    for (int i = 0; i < size_class_slot_count; i++)
+    {
+        if (!d->slots[k][i] && atomic_cas_ptr(&d->slots[k][i], 0, ptr))
+            return;
+    }
+
+    // pool full
+    atomic_add_size(&d->held_size, (size_t)0 - size_class_size(k));
+
+    size_class_block_free(ptr);
+}
+
 #if NCNN_VULKAN
 VkAllocator::VkAllocator(const VulkanDevice* _vkdev)
     : vkdev(_vkdev)
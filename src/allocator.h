@@ -216,6 +216,75 @@ private:
     UnlockedPoolAllocatorPrivate* const d;
 };
 
+class PlannedAllocatorPrivate;
+class NCNN_EXPORT PlannedAllocator : public Allocator
+{
+public:
+    PlannedAllocator();
+    ~PlannedAllocator();
+
+    // begin a new inference session
+    // the first session runs on heap and records the lifetime of every block
+    // the following sessions hand out blocks from one preallocated arena
+    // any deviation from the recorded sequence falls back to heap safely
+    void rewind();
+
+    // pack the recorded blocks into one arena with interval offset assignment
+    // return 0 if success
+    int plan();
+
+    // arena size in bytes, 0 if not planned yet
+    size_t arena_size() const;
+
+    // drop the plan and the arena, start recording again
+    void clear();
+
+    // allocator for recording sessions and deviations from the plan
+    // default is null, which means the heap, set it before the first session
+    void set_fallback_allocator(Allocator* allocator);
+
+    virtual void* fastMalloc(size_t size);
+    virtual void fastFree(void* ptr);
+
+private:
+    PlannedAllocator(const PlannedAllocator&);
+    PlannedAllocator& operator=(const PlannedAllocator&);
+
+private:
+    PlannedAllocatorPrivate* const d;
+};
+
+class SizeClassPoolAllocatorPrivate;
+class NCNN_EXPORT SizeClassPoolAllocator : public Allocator
+{
+public:
+    SizeClassPoolAllocator();
+    ~SizeClassPoolAllocator();
+
+    // release all cached blocks immediately
+    // must not be called while other threads are allocating
+    void clear();
+
+    // allocations served from cache
+    size_t hit_count() const;
+
+    // allocations served from heap
+    size_t miss_count() const;
+
+    // bytes of free blocks cached for reuse
+    size_t held_size() const;
+
+    virtual void* fastMalloc(size_t size);
+    virtual void fastFree(void* ptr);
+
+private:
+    SizeClassPoolAllocator(const SizeClassPoolAllocator&);
+    SizeClassPoolAllocator& operator=(const SizeClassPoolAllocator&);
+
+private:
+    SizeClassPoolAllocatorPrivate* const d;
+};
+
 #if NCNN_VULKAN
 
 class VulkanDevice;
@@ -46,9 +46,11 @@
 #include "layer/convolutiondepthwise3d.h"
 #include "layer/deconvolution3d.h"
 #include "layer/deconvolutiondepthwise3d.h"
+#endif // NCNN_BENCHMARK
 
+#if NCNN_STDIO || NCNN_BENCHMARK
 #include <stdio.h>
-#endif // NCNN_BENCHMARK
+#endif
 
 namespace ncnn {
 
@@ -95,6 +97,117 @@ void sleep(unsigned long long int milliseconds)
 #endif
 }
 
+LayerProfile::LayerProfile()
+{
+    layer_index = -1;
+    type = "";
+    name = "";
+    kernel = "";
+    start = 0.0;
+    end = 0.0;
+    allocated_bytes = 0;
+}
+
+static ThreadLocalStorage tls_current_layer_profile;
+
+void profile_kernel(const char* kernel)
+{
+    LayerProfile* profile = (LayerProfile*)tls_current_layer_profile.get();
+    if (profile)
+        profile->kernel = kernel;
+}
+
+void set_current_layer_profile(LayerProfile* profile)
+{
+    tls_current_layer_profile.set(profile);
+}
+
+#if NCNN_STDIO
+static void fprint_json_string(FILE* fp, const char* str)
+{
+    fputc('"', fp);
+    for (const char* p = str; *p; p++)
+    {
+        if (*p == '"' || *p == '\\')
+            fputc('\\', fp);
+        if ((unsigned char)*p < 0x20)
+            continue;
+        fputc(*p, fp);
+    }
+    fputc('"', fp);
+}
+
+static void fprint_json_shapes(FILE* fp, const std::vector<Mat>& shapes)
+{
+    fputc('[', fp);
+    for (size_t i = 0; i < shapes.size(); i++)
+    {
+        const Mat& m = shapes[i];
+
+        if (i != 0)
+            fputc(',', fp);
+
+        fprintf(fp, "{\"dims\":%d,\"w\":%d,\"h\":%d,\"d\":%d,\"c\":%d,\"elemsize\":%d,\"elempack\":%d}", m.dims, m.w, m.h, m.d, m.c, (int)m.elemsize, m.elempack);
+    }
+    fputc(']', fp);
+}
+
+int save_chrome_trace(const char* path, const std::vector<LayerProfile>& profiles)
+{
+    FILE* fp = fopen(path, "wb");
+    if (!fp)
+    {
+        NCNN_LOGE("fopen %s failed", path);
+        return -1;
+    }
+
+    double origin = 0.0;
+    for (size_t i = 0; i < profiles.size(); i++)
+    {
+        if (i == 0 || profiles[i].start < origin)
+            origin = profiles[i].start;
+    }
+
+    // overlapping layers from branch parallel go to separate tracks
+    std::vector<double> track_ends;
+
+    fprintf(fp, "{\"traceEvents\":[\n");
+    for (size_t i = 0; i < profiles.size(); i++)
+    {
+        const LayerProfile& profile = profiles[i];
+
+        size_t track = 0;
+        for (; track < track_ends.size(); track++)
+        {
+            if (track_ends[track] <= profile.start)
+                break;
+        }
+        if (track == track_ends.size())
+            track_ends.push_back(profile.end);
+        else
+            track_ends[track] = profile.end;
+
+        fprintf(fp, "{\"name\":");
+        fprint_json_string(fp, profile.name);
+        fprintf(fp, ",\"cat\":");
+        fprint_json_string(fp, profile.type);
+        fprintf(fp, ",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f", (int)track, (profile.start - origin) * 1000, (profile.end - profile.start) * 1000);
+        fprintf(fp, ",\"args\":{\"layer_index\":%d,\"kernel\":", profile.layer_index);
+        fprint_json_string(fp, profile.kernel);
+        fprintf(fp, ",\"bottoms\":");
+        fprint_json_shapes(fp, profile.bottom_shapes);
+        fprintf(fp, ",\"tops\":");
+        fprint_json_shapes(fp, profile.top_shapes);
+        fprintf(fp, ",\"allocated_bytes\":%lu}}%s\n", (unsigned long)profile.allocated_bytes, i + 1 == profiles.size() ? "" : ",");
+    }
+    fprintf(fp, "],\"displayTimeUnit\":\"ms\"}\n");
+
+    fclose(fp);
+
+    return 0;
+}
+#endif // NCNN_STDIO
+
 #if NCNN_BENCHMARK
 
 void benchmark(const Layer* layer, double start, double end)
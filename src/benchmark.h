@@ -27,6 +27,45 @@ NCNN_EXPORT double get_current_time();
 // sleep milliseconds
 NCNN_EXPORT void sleep(unsigned long long int milliseconds = 1000);
 
+// one layer forward recorded by extractor profiling
+class NCNN_EXPORT LayerProfile
+{
+public:
+    LayerProfile();
+
+    int layer_index;
+
+    // point into the layer, valid as long as the net
+    const char* type;
+    const char* name;
+
+    // kernel path tagged by the layer implementation, empty if untagged
+    const char* kernel;
+
+    // timestamp in ms
+    double start;
+    double end;
+
+    // shape, elemsize and elempack only, without data
+    std::vector<Mat> bottom_shapes;
+    std::vector<Mat> top_shapes;
+
+    // workspace allocation plus newly created top blobs
+    size_t allocated_bytes;
+};
+
+// tag the kernel path taken by the layer forward running on this thread
+// no-op unless extractor profiling is enabled
+NCNN_EXPORT void profile_kernel(const char* kernel);
+
+// bind the record that profile_kernel writes to on this thread, null to unbind
+NCNN_EXPORT void set_current_layer_profile(LayerProfile* profile);
+
+#if NCNN_STDIO
+// write records as chrome trace event json, viewable in chrome://tracing or perfetto
+NCNN_EXPORT int save_chrome_trace(const char* path, const std::vector<LayerProfile>& profiles);
+#endif // NCNN_STDIO
+
 #if NCNN_BENCHMARK
 
 NCNN_EXPORT void benchmark(const Layer* layer, double start, double end);
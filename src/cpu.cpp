@@ -187,6 +187,8 @@ static int g_cpu_support_x86_avx512;
 static int g_cpu_support_x86_avx512_vnni;
 static int g_cpu_support_x86_avx512_bf16;
 static int g_cpu_support_x86_avx512_fp16;
+static int g_cpu_support_x86_amx_int8;
+static int g_cpu_support_x86_amx_bf16;
 #endif // defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
 
 static int g_cpu_level2_cachesize;
@@ -196,6 +198,7 @@ static int g_cpu_level3_cachesize;
 #if defined __ANDROID__ || defined __linux__
 #if __aarch64__
 static int g_cpu_is_arm_a53_a55;
+static int g_cpu_arm_sve_vector_bits;
 #endif // __aarch64__
 #endif // defined __ANDROID__ || defined __linux__
 
@@ -736,6 +739,80 @@ static int get_cpu_support_x86_avx512_fp16()
     return cpu_info[3] & (1u << 23);
 #endif
 }
+
+static int get_cpu_support_x86_amx_tile()
+{
+#if __APPLE__
+    return 0;
+#else
+    unsigned int cpu_info[4] = {0};
+    x86_cpuid(0, cpu_info);
+
+    int nIds = cpu_info[0];
+    if (nIds < 7)
+        return 0;
+
+    x86_cpuid(1, cpu_info);
+    // check XSAVE OSXSAVE
+    if (!(cpu_info[2] & (1u << 26)) || !(cpu_info[2] & (1u << 27)))
+        return 0;
+
+    x86_cpuid_sublevel(7, 0, cpu_info);
+    if (!(cpu_info[3] & (1u << 24)))
+        return 0;
+
+    // check tile config and tile data XSAVE enabled by kernel
+    if ((x86_get_xcr0() & 0x60000) != 0x60000)
+        return 0;
+
+    return 1;
+#endif
+}
+
+// tile data is off by default, it is requested on first amx kernel use
+// -1 = not requested yet
+static int g_cpu_x86_amx_tile_data_granted = -1;
+
+static int request_x86_amx_tile_data()
+{
+#if (defined __ANDROID__ || defined __linux__) && defined SYS_arch_prctl
+    // ARCH_REQ_XCOMP_PERM = 0x1023  XFEATURE_XTILEDATA = 18
+    return syscall(SYS_arch_prctl, 0x1023, 18) == 0 ? 1 : 0;
+#else
+    return 1;
+#endif
+}
+
+static int try_request_x86_amx_tile_data()
+{
+    // the request is idempotent, racing first callers get the same answer
+    if (g_cpu_x86_amx_tile_data_granted == -1)
+    {
+        g_cpu_x86_amx_tile_data_granted = request_x86_amx_tile_data();
+    }
+
+    return g_cpu_x86_amx_tile_data_granted;
+}
+
+static int get_cpu_support_x86_amx_int8()
+{
+    if (!get_cpu_support_x86_amx_tile())
+        return 0;
+
+    unsigned int cpu_info[4] = {0};
+    x86_cpuid_sublevel(7, 0, cpu_info);
+    return cpu_info[3] & (1u << 25);
+}
+
+static int get_cpu_support_x86_amx_bf16()
+{
+    if (!get_cpu_support_x86_amx_tile())
+        return 0;
+
+    unsigned int cpu_info[4] = {0};
+    x86_cpuid_sublevel(7, 0, cpu_info);
+    return cpu_info[3] & (1u << 22);
+}
 #endif // defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
 
 static int get_cpucount()
@@ -1857,6 +1934,19 @@ static int detect_cpu_is_arm_a53_a55()
     // little cores are a53/a55
     return 2;
 }
+
+static int detect_cpu_arm_sve_vector_bits()
+{
+    if (!(g_hwcaps & HWCAP_SVE))
+        return 0;
+
+    // PR_SVE_GET_VL, the low 16 bits are the vector length in bytes
+    int vl = syscall(SYS_prctl, 51, 0, 0, 0, 0);
+    if (vl < 0)
+        return 0;
+
+    return (vl & 0xffff) * 8;
+}
 #endif // __aarch64__
 #endif // defined __ANDROID__ || defined __linux__
 
@@ -1920,6 +2010,8 @@ static void initialize_global_cpu_info()
     g_cpu_support_x86_avx512_vnni = get_cpu_support_x86_avx512_vnni();
     g_cpu_support_x86_avx512_bf16 = get_cpu_support_x86_avx512_bf16();
     g_cpu_support_x86_avx512_fp16 = get_cpu_support_x86_avx512_fp16();
+    g_cpu_support_x86_amx_int8 = get_cpu_support_x86_amx_int8();
+    g_cpu_support_x86_amx_bf16 = get_cpu_support_x86_amx_bf16();
 #endif // defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
 
     g_cpu_level2_cachesize = get_cpu_level2_cachesize();
@@ -1928,6 +2020,7 @@ static void initialize_global_cpu_info()
 #if defined __ANDROID__ || defined __linux__
 #if __aarch64__
     g_cpu_is_arm_a53_a55 = detect_cpu_is_arm_a53_a55();
+    g_cpu_arm_sve_vector_bits = detect_cpu_arm_sve_vector_bits();
 #endif // __aarch64__
 #endif // defined __ANDROID__ || defined __linux__
 }
@@ -2378,6 +2471,16 @@ int cpu_support_arm_svef32mm()
 #endif
 }
 
+int get_cpu_arm_sve_vector_bits()
+{
+    try_initialize_global_cpu_info();
+#if __aarch64__ && (defined __ANDROID__ || defined __linux__)
+    return g_cpu_arm_sve_vector_bits;
+#else
+    return 0;
+#endif
+}
+
 int cpu_support_x86_avx()
 {
     try_initialize_global_cpu_info();
@@ -2478,6 +2581,26 @@ int cpu_support_x86_avx512_fp16()
 #endif
 }
 
+int cpu_support_x86_amx_int8()
+{
+    try_initialize_global_cpu_info();
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+    return g_cpu_support_x86_amx_int8 && try_request_x86_amx_tile_data();
+#else
+    return 0;
+#endif
+}
+
+int cpu_support_x86_amx_bf16()
+{
+    try_initialize_global_cpu_info();
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+    return g_cpu_support_x86_amx_bf16 && try_request_x86_amx_tile_data();
+#else
+    return 0;
+#endif
+}
+
 int cpu_support_mips_msa()
 {
     try_initialize_global_cpu_info();
@@ -80,6 +80,8 @@ NCNN_EXPORT int cpu_support_arm_svebf16();
 NCNN_EXPORT int cpu_support_arm_svei8mm();
 // svef32mm = aarch64 svef32mm
 NCNN_EXPORT int cpu_support_arm_svef32mm();
+// sve vector length in bits, 0 if sve is not supported or the length is unknown
+NCNN_EXPORT int get_cpu_arm_sve_vector_bits();
 
 // avx = x86 avx
 NCNN_EXPORT int cpu_support_x86_avx();
@@ -101,6 +103,12 @@ NCNN_EXPORT int cpu_support_x86_avx512_vnni();
 NCNN_EXPORT int cpu_support_x86_avx512_bf16();
 // avx512_fp16 = x86 avx512 fp16
 NCNN_EXPORT int cpu_support_x86_avx512_fp16();
+// amx_int8 = x86 amx tile + amx int8, tile data usable by this process
+// the first call with amx present requests tile data permission from the kernel
+NCNN_EXPORT int cpu_support_x86_amx_int8();
+// amx_bf16 = x86 amx tile + amx bf16, tile data usable by this process
+// the first call with amx present requests tile data permission from the kernel
+NCNN_EXPORT int cpu_support_x86_amx_bf16();
 
 // lsx = loongarch lsx
 NCNN_EXPORT int cpu_support_loongarch_lsx();
@@ -16,6 +16,17 @@
 
 #include <string.h>
 
+#if NCNN_STDIO
+#if defined _WIN32
+#include <windows.h>
+#elif defined __unix__ || defined __APPLE__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#endif // NCNN_STDIO
+
 namespace ncnn {
 
 DataReader::DataReader()
@@ -85,6 +96,178 @@ size_t DataReaderFromStdio::read(void* buf, size_t size) const
 {
     return fread(buf, 1, size, d->fp);
 }
+
+class DataReaderFromMmapPrivate
+{
+public:
+    DataReaderFromMmapPrivate()
+        : ok(false), data(0), length(0), offset(0)
+    {
+#if defined _WIN32
+        file = INVALID_HANDLE_VALUE;
+        mapping = 0;
+#endif
+    }
+    bool ok;
+    const unsigned char* data;
+    size_t length;
+    mutable size_t offset;
+#if defined _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+};
+
+DataReaderFromMmap::DataReaderFromMmap(const char* path)
+    : DataReader(), d(new DataReaderFromMmapPrivate)
+{
+#if defined _WIN32
+    d->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (d->file == INVALID_HANDLE_VALUE)
+    {
+        NCNN_LOGE("CreateFile %s failed", path);
+        return;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(d->file, &file_size))
+    {
+        NCNN_LOGE("GetFileSizeEx %s failed", path);
+        return;
+    }
+
+    d->length = (size_t)file_size.QuadPart;
+    if (d->length == 0)
+    {
+        // nothing to map
+        d->ok = true;
+        return;
+    }
+
+    d->mapping = CreateFileMappingA(d->file, 0, PAGE_READONLY, 0, 0, 0);
+    if (!d->mapping)
+    {
+        NCNN_LOGE("CreateFileMapping %s failed", path);
+        return;
+    }
+
+    d->data = (const unsigned char*)MapViewOfFile(d->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!d->data)
+    {
+        NCNN_LOGE("MapViewOfFile %s failed", path);
+        return;
+    }
+
+    d->ok = true;
+#elif defined __unix__ || defined __APPLE__
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+    {
+        NCNN_LOGE("open %s failed", path);
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        NCNN_LOGE("fstat %s failed", path);
+        close(fd);
+        return;
+    }
+
+    d->length = (size_t)st.st_size;
+    if (d->length == 0)
+    {
+        // nothing to map
+        close(fd);
+        d->ok = true;
+        return;
+    }
+
+    // read-only shared mapping, clean pages are shared with other processes through page cache
+    void* ptr = mmap(0, d->length, PROT_READ, MAP_SHARED, fd, 0);
+
+    // the mapping holds its own reference to the file
+    close(fd);
+
+    if (ptr == MAP_FAILED)
+    {
+        NCNN_LOGE("mmap %s failed", path);
+        return;
+    }
+
+    d->data = (const unsigned char*)ptr;
+    d->ok = true;
+#else
+    NCNN_LOGE("mmap %s not supported on this platform", path);
+#endif
+}
+
+DataReaderFromMmap::~DataReaderFromMmap()
+{
+#if defined _WIN32
+    if (d->data)
+        UnmapViewOfFile(d->data);
+    if (d->mapping)
+        CloseHandle(d->mapping);
+    if (d->file != INVALID_HANDLE_VALUE)
+        CloseHandle(d->file);
+#elif defined __unix__ || defined __APPLE__
+    if (d->data)
+        munmap((void*)d->data, d->length);
+#endif
+
+    delete d;
+}
+
+DataReaderFromMmap::DataReaderFromMmap(const DataReaderFromMmap&)
+    : d(0)
+{
+}
+
+DataReaderFromMmap& DataReaderFromMmap::operator=(const DataReaderFromMmap&)
+{
+    return *this;
+}
+
+bool DataReaderFromMmap::empty() const
+{
+    return !d->ok;
+}
+
+size_t DataReaderFromMmap::read(void* buf, size_t size) const
+{
+    if (size > d->length - d->offset)
+        return 0;
+
+    memcpy(buf, d->data + d->offset, size);
+    d->offset += size;
+    return size;
+}
+
+size_t DataReaderFromMmap::reference(size_t size, const void** buf) const
+{
+    if (size > d->length - d->offset)
+        return 0;
+
+    *buf = d->data + d->offset;
+    d->offset += size;
+    return size;
+}
+
+void DataReaderFromMmap::release_resident_pages() const
+{
+    if (!d->data)
+        return;
+
+#if defined _WIN32
+    // unlocking pages that are not locked removes them from the working set
+    VirtualUnlock((void*)d->data, d->length);
+#elif defined __unix__ || defined __APPLE__
+    // the mapping is read-only and file backed, so nothing is lost
+    madvise((void*)d->data, d->length, MADV_DONTNEED);
+#endif
+}
 #endif // NCNN_STDIO
 
 class DataReaderFromMemoryPrivate
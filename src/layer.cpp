@@ -70,6 +70,26 @@ int Layer::destroy_pipeline(const Option& /*opt*/)
     return 0;
 }
 
+int Layer::save_pipeline_data(std::vector<Mat>& /*pipeline_data*/) const
+{
+    return -1;
+}
+
+int Layer::load_pipeline_data(const std::vector<Mat>& /*pipeline_data*/, const Option& /*opt*/)
+{
+    return -1;
+}
+
+int Layer::save_kernel_profile(std::vector<int>& /*profile*/) const
+{
+    return -1;
+}
+
+int Layer::load_kernel_profile(const std::vector<int>& /*profile*/)
+{
+    return -1;
+}
+
 int Layer::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
     if (!support_inplace)
@@ -52,6 +52,22 @@ public:
     // return 0 if success
     virtual int destroy_pipeline(const Option& opt);
 
+    // export the weight data transformed by create_pipeline
+    // return 0 if success, -1 if not supported
+    virtual int save_pipeline_data(std::vector<Mat>& pipeline_data) const;
+
+    // setup from the exported weight data instead of transforming weight again
+    // return 0 if success, -1 if not supported and create_pipeline should be used
+    virtual int load_pipeline_data(const std::vector<Mat>& pipeline_data, const Option& opt);
+
+    // export the kernel choice made for each input shape seen so far
+    // return 0 if success, -1 if not supported
+    virtual int save_kernel_profile(std::vector<int>& profile) const;
+
+    // use the exported kernel choice, called after load_param and before create_pipeline
+    // return 0 if success, -1 if not supported or the profile does not fit this layer
+    virtual int load_kernel_profile(const std::vector<int>& profile);
+
 public:
     // one input and one output blob
     bool one_blob_only;
@@ -22,6 +22,10 @@
 #include <arm_neon.h>
 #endif // __ARM_NEON
 
+#if __ARM_FEATURE_SVE
+#include <arm_sve.h>
+#endif // __ARM_FEATURE_SVE
+
 #include "arm_activation.h"
 #include "arm_usability.h"
 
@@ -743,6 +747,15 @@ int Convolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option
 
 int Convolution_arm::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
+    if (residual)
+    {
+        int ret = forward(bottom_blobs[0], top_blobs[0], opt);
+        if (ret != 0)
+            return ret;
+
+        return add_residual_arm(bottom_blobs[1], top_blobs[0], opt);
+    }
+
     const Mat& bottom_blob = bottom_blobs[0];
     const Mat& _weight_data = bottom_blobs[1];
     Mat& top_blob = top_blobs[0];
@@ -1436,6 +1449,51 @@ int Convolution_arm::forward_int8_arm(const Mat& bottom_blob, Mat& top_blob, con
 }
 #endif // NCNN_INT8
 
+int Convolution_arm::add_residual_arm(const Mat& residual, Mat& top_blob, const Option& opt) const
+{
+    if (top_blob.elembits() != 32 || residual.elempack != top_blob.elempack || residual.dims != top_blob.dims || residual.w != top_blob.w || residual.h != top_blob.h || residual.d != top_blob.d || residual.c != top_blob.c)
+        return add_residual(residual, top_blob, opt);
+
+    const int channels = top_blob.c;
+    const int size = top_blob.w * top_blob.h * top_blob.d * top_blob.elempack;
+
+    // one pass over the output, add the residual and apply the activation while it is in register
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* ptr = residual.channel(q);
+        float* outptr = top_blob.channel(q);
+
+        int i = 0;
+#if __ARM_NEON
+        for (; i + 7 < size; i += 8)
+        {
+            float32x4_t _p0 = vaddq_f32(vld1q_f32(outptr), vld1q_f32(ptr));
+            float32x4_t _p1 = vaddq_f32(vld1q_f32(outptr + 4), vld1q_f32(ptr + 4));
+            vst1q_f32(outptr, activation_ps(_p0, residual_activation_type, residual_activation_params));
+            vst1q_f32(outptr + 4, activation_ps(_p1, residual_activation_type, residual_activation_params));
+            ptr += 8;
+            outptr += 8;
+        }
+        for (; i + 3 < size; i += 4)
+        {
+            float32x4_t _p = vaddq_f32(vld1q_f32(outptr), vld1q_f32(ptr));
+            vst1q_f32(outptr, activation_ps(_p, residual_activation_type, residual_activation_params));
+            ptr += 4;
+            outptr += 4;
+        }
+#endif // __ARM_NEON
+        for (; i < size; i++)
+        {
+            *outptr = activation_ss(*outptr + *ptr, residual_activation_type, residual_activation_params);
+            ptr++;
+            outptr++;
+        }
+    }
+
+    return 0;
+}
+
 int Convolution_arm::forwardDilation_arm(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
     int w = bottom_blob.w;
@@ -46,6 +46,7 @@ protected:
     int forward_int8_arm(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 #endif
     int forwardDilation_arm(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+    int add_residual_arm(const Mat& residual, Mat& top_blob, const Option& opt) const;
 
 public:
     Layer* activation;
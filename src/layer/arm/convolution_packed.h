@@ -12,10 +12,55 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
+#if NCNN_RUNTIME_CPU && NCNN_ARM86SVE && __aarch64__ && !__ARM_FEATURE_SVE
+void convolution_transform_kernel_packed_sve(const Mat& kernel, Mat& kernel_tm, int inch, int outch, int kernel_w, int kernel_h);
+void convolution_packed_sve(const Mat& bottom_blob, Mat& top_blob, const Mat& weight_data_tm, const Mat& bias_data, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, int activation_type, const Mat& activation_params, const Option& opt);
+#endif
+
 static void convolution_transform_kernel_packed(const Mat& kernel, Mat& kernel_tm, int inch, int outch, int kernel_w, int kernel_h)
 {
+#if NCNN_RUNTIME_CPU && NCNN_ARM86SVE && __aarch64__ && !__ARM_FEATURE_SVE
+    // 128bit sve has no more lanes than neon, keep the tuned neon kernels there
+    if (ncnn::cpu_support_arm_sve() && ncnn::get_cpu_arm_sve_vector_bits() > 128)
+    {
+        convolution_transform_kernel_packed_sve(kernel, kernel_tm, inch, outch, kernel_w, kernel_h);
+        return;
+    }
+#endif
+
     const int maxk = kernel_w * kernel_h;
 
+#if __ARM_FEATURE_SVE
+    // one vector of output channels per group, the vector length is only known at runtime
+    // dst = vl-kw-kh-inch-outch/vl
+    // at 128bit the neon layout below is used, convolution_packed makes the same choice
+    if (svcntw() > 4)
+    {
+        const int vl = (int)svcntw();
+
+        kernel_tm.create(vl * maxk * inch, (outch + vl - 1) / vl);
+
+        for (int q = 0; q < outch; q += vl)
+        {
+            float* g00 = kernel_tm.row(q / vl);
+
+            for (int p = 0; p < inch; p++)
+            {
+                for (int k = 0; k < maxk; k++)
+                {
+                    for (int l = 0; l < vl; l++)
+                    {
+                        g00[l] = q + l < outch ? kernel[((q + l) * inch + p) * maxk + k] : 0.f;
+                    }
+                    g00 += vl;
+                }
+            }
+        }
+
+        return;
+    }
+#endif // __ARM_FEATURE_SVE
+
     // src = kw-kh-inch-outch
     // dst = pb-pa-kw-kh-inch/pa-outch/pb
 
@@ -504,8 +549,172 @@ static void convolution_transform_kernel_packed(const Mat& kernel, Mat& kernel_t
     }
 }
 
+#if __ARM_FEATURE_SVE
+static inline svfloat32_t convolution_packed_activation_sve(svbool_t pg, svfloat32_t _v, int activation_type, const Mat& activation_params)
+{
+    if (activation_type == 1)
+    {
+        _v = svmax_n_f32_x(pg, _v, 0.f);
+    }
+    else if (activation_type == 2)
+    {
+        svbool_t _neg = svcmplt_n_f32(pg, _v, 0.f);
+        _v = svmul_n_f32_m(_neg, _v, activation_params[0]);
+    }
+    else if (activation_type == 3)
+    {
+        _v = svmax_n_f32_x(pg, _v, activation_params[0]);
+        _v = svmin_n_f32_x(pg, _v, activation_params[1]);
+    }
+    else if (activation_type != 0)
+    {
+        // the transcendental ones are rare here, take the scalar route
+        float tmp[64];
+        svst1_f32(pg, tmp, _v);
+        const int n = (int)svcntp_b32(pg, pg);
+        for (int l = 0; l < n; l++)
+        {
+            tmp[l] = activation_ss(tmp[l], activation_type, activation_params);
+        }
+        _v = svld1_f32(pg, tmp);
+    }
+
+    return _v;
+}
+
+// vector length agnostic direct convolution, each group of output channels fills one sve vector
+// kernel_tm comes from convolution_transform_kernel_packed with the same vector length
+static void convolution_packed_vla(const Mat& bottom_blob, Mat& top_blob, const Mat& weight_data_tm, const Mat& bias_data, const int* space_ofs, int kernel_w, int kernel_h, int stride_w, int stride_h, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    const int w = bottom_blob.w;
+    const int elempack = bottom_blob.elempack;
+    const int inch = bottom_blob.c * elempack;
+
+    const int N = bottom_blob.cstep * elempack;
+
+    const int outw = top_blob.w;
+    const int outh = top_blob.h;
+    const int out_elempack = top_blob.elempack;
+    const int outch = top_blob.c * out_elempack;
+
+    const int M = top_blob.cstep * out_elempack;
+
+    const int maxk = kernel_w * kernel_h;
+    const int size = outw * outh;
+
+    const int vl = (int)svcntw();
+    const int nn_outch = (outch + vl - 1) / vl;
+
+    // lane l of a group writes to output channel q0 + l, vl is a multiple of 4 so groups start on a whole pack
+    std::vector<int> _out_ofs(vl);
+    for (int l = 0; l < vl; l++)
+    {
+        _out_ofs[l] = l / out_elempack * M + l % out_elempack;
+    }
+    const svint32_t _out_index = svld1_s32(svptrue_b32(), &_out_ofs[0]);
+
+    const float* bias_data_ptr = bias_data;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int g = 0; g < nn_outch; g++)
+    {
+        const int q0 = g * vl;
+        const svbool_t _pq = svwhilelt_b32(q0, outch);
+
+        float* outptr = (float*)top_blob.data + q0 / out_elempack * M;
+        const float* kptr0 = weight_data_tm.row(g);
+
+        svfloat32_t _bias = svdup_n_f32(0.f);
+        if (bias_data_ptr)
+        {
+            _bias = svld1_f32(_pq, bias_data_ptr + q0);
+        }
+
+        int ij = 0;
+        for (; ij + 3 < size; ij += 4)
+        {
+            int sofs[4];
+            for (int t = 0; t < 4; t++)
+            {
+                const int i = (ij + t) / outw;
+                const int j = (ij + t) % outw;
+                sofs[t] = (i * stride_h * w + j * stride_w) * elempack;
+            }
+
+            svfloat32_t _sum0 = _bias;
+            svfloat32_t _sum1 = _bias;
+            svfloat32_t _sum2 = _bias;
+            svfloat32_t _sum3 = _bias;
+
+            const float* kptr = kptr0;
+            for (int p = 0; p < inch; p++)
+            {
+                const float* ptr = (const float*)bottom_blob.data + p / elempack * N + p % elempack;
+                const float* r0 = ptr + sofs[0];
+                const float* r1 = ptr + sofs[1];
+                const float* r2 = ptr + sofs[2];
+                const float* r3 = ptr + sofs[3];
+
+                for (int k = 0; k < maxk; k++)
+                {
+                    svfloat32_t _w = svld1_f32(_pq, kptr);
+                    _sum0 = svmla_n_f32_x(_pq, _sum0, _w, r0[space_ofs[k]]);
+                    _sum1 = svmla_n_f32_x(_pq, _sum1, _w, r1[space_ofs[k]]);
+                    _sum2 = svmla_n_f32_x(_pq, _sum2, _w, r2[space_ofs[k]]);
+                    _sum3 = svmla_n_f32_x(_pq, _sum3, _w, r3[space_ofs[k]]);
+                    kptr += vl;
+                }
+            }
+
+            _sum0 = convolution_packed_activation_sve(_pq, _sum0, activation_type, activation_params);
+            _sum1 = convolution_packed_activation_sve(_pq, _sum1, activation_type, activation_params);
+            _sum2 = convolution_packed_activation_sve(_pq, _sum2, activation_type, activation_params);
+            _sum3 = convolution_packed_activation_sve(_pq, _sum3, activation_type, activation_params);
+
+            svst1_scatter_s32index_f32(_pq, outptr + ij * out_elempack, _out_index, _sum0);
+            svst1_scatter_s32index_f32(_pq, outptr + (ij + 1) * out_elempack, _out_index, _sum1);
+            svst1_scatter_s32index_f32(_pq, outptr + (ij + 2) * out_elempack, _out_index, _sum2);
+            svst1_scatter_s32index_f32(_pq, outptr + (ij + 3) * out_elempack, _out_index, _sum3);
+        }
+        for (; ij < size; ij++)
+        {
+            const int i = ij / outw;
+            const int j = ij % outw;
+
+            svfloat32_t _sum = _bias;
+
+            const float* kptr = kptr0;
+            for (int p = 0; p < inch; p++)
+            {
+                const float* r0 = (const float*)bottom_blob.data + p / elempack * N + p % elempack + (i * stride_h * w + j * stride_w) * elempack;
+
+                for (int k = 0; k < maxk; k++)
+                {
+                    svfloat32_t _w = svld1_f32(_pq, kptr);
+                    _sum = svmla_n_f32_x(_pq, _sum, _w, r0[space_ofs[k]]);
+                    kptr += vl;
+                }
+            }
+
+            _sum = convolution_packed_activation_sve(_pq, _sum, activation_type, activation_params);
+
+            svst1_scatter_s32index_f32(_pq, outptr + ij * out_elempack, _out_index, _sum);
+        }
+    }
+}
+#endif // __ARM_FEATURE_SVE
+
 static void convolution_packed(const Mat& bottom_blob, Mat& top_blob, const Mat& weight_data_tm, const Mat& bias_data, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, int activation_type, const Mat& activation_params, const Option& opt)
 {
+#if NCNN_RUNTIME_CPU && NCNN_ARM86SVE && __aarch64__ && !__ARM_FEATURE_SVE
+    // 128bit sve has no more lanes than neon, keep the tuned neon kernels there
+    if (ncnn::cpu_support_arm_sve() && ncnn::get_cpu_arm_sve_vector_bits() > 128)
+    {
+        convolution_packed_sve(bottom_blob, top_blob, weight_data_tm, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, activation_type, activation_params, opt);
+        return;
+    }
+#endif
+
     const int w = bottom_blob.w;
     const int elempack = bottom_blob.elempack;
     const int inch = bottom_blob.c * elempack;
@@ -540,6 +749,14 @@ static void convolution_packed(const Mat& bottom_blob, Mat& top_blob, const Mat&
         }
     }
 
+#if __ARM_FEATURE_SVE
+    if (svcntw() > 4)
+    {
+        convolution_packed_vla(bottom_blob, top_blob, weight_data_tm, bias_data, space_ofs, kernel_w, kernel_h, stride_w, stride_h, activation_type, activation_params, opt);
+        return;
+    }
+#endif // __ARM_FEATURE_SVE
+
     const float* bias_data_ptr = bias_data;
 
     int nn_outch = 0;
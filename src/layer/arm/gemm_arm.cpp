@@ -18,6 +18,12 @@
 #include <arm_neon.h>
 #endif // __ARM_NEON
 
+// for the sve int8 kernel in gemm_int8.h
+// the fp32 gemm has no sve kernel yet, its tiles keep the fixed 4/8 lane neon packing on sve cpus
+#if __ARM_FEATURE_SVE
+#include <arm_sve.h>
+#endif // __ARM_FEATURE_SVE
+
 #include "arm_usability.h"
 
 #include "cpu.h"
@@ -29,6 +35,10 @@ namespace ncnn {
 #include "gemm_bf16s.h"
 #endif
 
+#if NCNN_INT8
+#include "gemm_int8.h"
+#endif
+
 Gemm_arm::Gemm_arm()
 {
 #if __ARM_NEON
@@ -4164,6 +4174,13 @@ static int gemm_AT_BT_arm(const Mat& AT, const Mat& BT, const Mat& C, Mat& top_b
 
 int Gemm_arm::create_pipeline(const Option& opt)
 {
+#if NCNN_INT8
+    if (int8_scale_term)
+    {
+        return create_pipeline_int8(opt);
+    }
+#endif
+
 #if NCNN_ARM82
     if (cpu_support_arm_asimdhp() && opt.use_fp16_storage)
     {
@@ -4311,6 +4328,13 @@ int Gemm_arm::create_pipeline(const Option& opt)
 
 int Gemm_arm::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
+#if NCNN_INT8
+    if (int8_scale_term)
+    {
+        return forward_int8(bottom_blobs, top_blobs, opt);
+    }
+#endif
+
     const Mat& bottom_blob = constantA ? AT_data : bottom_blobs[0];
     int elembits = bottom_blob.elembits();
 
@@ -5199,4 +5223,305 @@ int Gemm_arm::forward_bf16s(const std::vector<Mat>& bottom_blobs, std::vector<Ma
 }
 #endif // NCNN_BF16
 
+#if NCNN_INT8
+int Gemm_arm::create_pipeline_int8(const Option& opt)
+{
+    Option opt_tm = opt;
+    opt_tm.workspace_allocator = 0;
+
+    // int8 rows along K, scales stay in A_data_int8_scales and B_data_int8_scales
+    if (constantA)
+    {
+        Mat AT_data_scales;
+        int ret = gemm_quantize_int8(A_data, transA, A_data_int8_scales, AT_data, AT_data_scales, opt_tm);
+        if (ret != 0)
+            return ret;
+
+        if (opt.lightmode)
+            A_data.release();
+    }
+
+    if (constantB)
+    {
+        Mat BT_data_scales;
+        int ret = gemm_quantize_int8(B_data, transB ? 0 : 1, B_data_int8_scales, BT_data, BT_data_scales, opt_tm);
+        if (ret != 0)
+            return ret;
+
+        if (opt.lightmode)
+            B_data.release();
+    }
+
+    if (constantC && constant_broadcast_type_C != -1)
+    {
+        CT_data = C_data;
+
+        // pre-multiply C with beta
+        if (beta != 1.f)
+        {
+            Mat C2;
+            C2.create_like(C_data);
+            if (C2.empty())
+                return -100;
+
+            const int size = C_data.total();
+            for (int i = 0; i < size; i++)
+            {
+                C2[i] = C_data[i] * beta;
+            }
+
+            CT_data = C2;
+        }
+
+        if (opt.lightmode)
+            C_data.release();
+    }
+
+    if (constantA || constantB || constantC)
+    {
+        nT = opt.num_threads;
+    }
+
+    return 0;
+}
+
+// unpack and widen fp16 / bf16 storage to fp32
+static int gemm_int8_unpack_fp32(const Mat& src, Mat& dst, int elemtype, const Option& opt)
+{
+    Mat src_unpacked;
+    convert_packing(src, src_unpacked, 1, opt);
+    if (src_unpacked.empty())
+        return -100;
+
+    if (src_unpacked.elembits() != 16)
+    {
+        dst = src_unpacked;
+        return 0;
+    }
+
+    if (elemtype == 2)
+        cast_float16_to_float32(src_unpacked, dst, opt);
+    else
+        cast_bfloat16_to_float32(src_unpacked, dst, opt);
+    if (dst.empty())
+        return -100;
+
+    return 0;
+}
+
+int Gemm_arm::forward_int8(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    Option opt_unpack = opt;
+    opt_unpack.blob_allocator = opt.workspace_allocator;
+
+    // 16bit storage inputs produce 16bit storage output, 2=fp16 4=bf16
+    int elemtype = 1;
+    if (!bottom_blobs.empty() && bottom_blobs[0].elembits() == 16)
+    {
+        elemtype = 4;
+#if NCNN_VFPV4
+        if (support_fp16_storage && opt.use_fp16_storage)
+            elemtype = 2;
+#endif
+#if NCNN_BF16
+        if (opt.use_bf16_storage)
+            elemtype = 4;
+#endif
+#if NCNN_ARM82
+        if (cpu_support_arm_asimdhp() && opt.use_fp16_storage)
+            elemtype = 2;
+#endif
+    }
+
+    Mat AT = AT_data;
+    Mat AT_scales = A_data_int8_scales;
+    if (!constantA)
+    {
+        Mat A;
+        int ret = gemm_int8_unpack_fp32(bottom_blobs[0], A, elemtype, opt_unpack);
+        if (ret != 0)
+            return ret;
+
+        // dynamic quantize per row of A
+        ret = gemm_quantize_int8(A, transA, Mat(), AT, AT_scales, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    Mat BT = BT_data;
+    Mat BT_scales = B_data_int8_scales;
+    if (!constantB)
+    {
+        Mat B;
+        int ret = gemm_int8_unpack_fp32(constantA ? bottom_blobs[0] : bottom_blobs[1], B, elemtype, opt_unpack);
+        if (ret != 0)
+            return ret;
+
+        // dynamic quantize per column of B
+        ret = gemm_quantize_int8(B, transB ? 0 : 1, Mat(), BT, BT_scales, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    const int M = AT.h;
+    const int N = BT.h;
+
+    Mat C;
+    int broadcast_type_C = 0;
+    if (constantC)
+    {
+        C = CT_data;
+        broadcast_type_C = constant_broadcast_type_C;
+    }
+    else
+    {
+        if (constantA && constantB)
+        {
+            C = bottom_blobs.size() == 1 ? bottom_blobs[0] : Mat();
+        }
+        else if (constantA)
+        {
+            C = bottom_blobs.size() == 2 ? bottom_blobs[1] : Mat();
+        }
+        else if (constantB)
+        {
+            C = bottom_blobs.size() == 2 ? bottom_blobs[1] : Mat();
+        }
+        else
+        {
+            C = bottom_blobs.size() == 3 ? bottom_blobs[2] : Mat();
+        }
+
+        if (!C.empty())
+        {
+            Mat C_unpacked;
+            int ret = gemm_int8_unpack_fp32(C, C_unpacked, elemtype, opt_unpack);
+            if (ret != 0)
+                return ret;
+
+            C = C_unpacked;
+
+            if (C.dims == 1 && C.w == 1)
+            {
+                // scalar
+                broadcast_type_C = 0;
+            }
+            if (C.dims == 1 && C.w == M)
+            {
+                // M
+                // auto broadcast from h to w is the ncnn-style convention
+                broadcast_type_C = 1;
+            }
+            if (C.dims == 1 && C.w == N)
+            {
+                // N
+                broadcast_type_C = 4;
+            }
+            if (C.dims == 2 && C.w == 1 && C.h == M)
+            {
+                // Mx1
+                broadcast_type_C = 2;
+            }
+            if (C.dims == 2 && C.w == N && C.h == M)
+            {
+                // MxN
+                broadcast_type_C = 3;
+            }
+            if (C.dims == 2 && C.w == N && C.h == 1)
+            {
+                // 1xN
+                broadcast_type_C = 4;
+            }
+
+            // pre-multiply C with beta
+            if (beta != 1.f)
+            {
+                Mat C2;
+                C2.create_like(C, opt.workspace_allocator);
+                if (C2.empty())
+                    return -100;
+
+                const int size = C.total();
+                for (int i = 0; i < size; i++)
+                {
+                    C2[i] = C[i] * beta;
+                }
+
+                C = C2;
+            }
+        }
+    }
+
+    int out_elempack = 1;
+#if __ARM_NEON
+    if (opt.use_packing_layout)
+    {
+        int outh = output_transpose ? N : M;
+        out_elempack = outh % 4 == 0 ? 4 : 1;
+    }
+#endif // __ARM_NEON
+    if (output_elempack)
+        out_elempack = output_elempack;
+
+    Mat& top_blob = top_blobs[0];
+
+    // write into the preallocated top_blob when no repacking is needed
+    Mat top_blob_unpacked;
+    if (out_elempack == 1 && elemtype == 1)
+        top_blob_unpacked = top_blob;
+
+    Allocator* top_allocator = out_elempack == 1 && elemtype == 1 ? opt.blob_allocator : opt.workspace_allocator;
+    if (output_transpose)
+    {
+        if (output_N1M)
+            top_blob_unpacked.create(M, 1, N, 4u, top_allocator);
+        else
+            top_blob_unpacked.create(M, N, 4u, top_allocator);
+    }
+    else
+    {
+        if (output_N1M)
+            top_blob_unpacked.create(N, 1, M, 4u, top_allocator);
+        else
+            top_blob_unpacked.create(N, M, 4u, top_allocator);
+    }
+    if (top_blob_unpacked.empty())
+        return -100;
+
+    gemm_int8(AT, AT_scales, BT, BT_scales, C, top_blob_unpacked, broadcast_type_C, alpha, output_transpose, opt);
+
+    Mat top_blob_fp32;
+    if (out_elempack == 1)
+    {
+        top_blob_fp32 = top_blob_unpacked;
+    }
+    else
+    {
+        Option opt_pack = opt;
+        if (elemtype != 1)
+            opt_pack.blob_allocator = opt.workspace_allocator;
+
+        convert_packing(top_blob_unpacked, top_blob_fp32, out_elempack, opt_pack);
+        if (top_blob_fp32.empty())
+            return -100;
+    }
+
+    if (elemtype == 1)
+    {
+        top_blob = top_blob_fp32;
+    }
+    else
+    {
+        if (elemtype == 2)
+            cast_float32_to_float16(top_blob_fp32, top_blob, opt);
+        else
+            cast_float32_to_bfloat16(top_blob_fp32, top_blob, opt);
+        if (top_blob.empty())
+            return -100;
+    }
+
+    return 0;
+}
+#endif // NCNN_INT8
+
 } // namespace ncnn
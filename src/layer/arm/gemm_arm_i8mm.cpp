@@ -0,0 +1,32 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "cpu.h"
+#include "mat.h"
+#include "layer.h"
+#include "arm_activation.h"
+#include "arm_usability.h"
+
+namespace ncnn {
+
+#if NCNN_INT8
+#include "gemm_int8.h"
+
+void gemm_int8_i8mm(const Mat& AT, const Mat& AT_scales, const Mat& BT, const Mat& BT_scales, const Mat& C, Mat& top_blob, int broadcast_type_C, float alpha, int output_transpose, const Option& opt)
+{
+    gemm_int8(AT, AT_scales, BT, BT_scales, C, top_blob, broadcast_type_C, alpha, output_transpose, opt);
+}
+#endif // NCNN_INT8
+
+} // namespace ncnn
@@ -0,0 +1,587 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#if NCNN_RUNTIME_CPU && NCNN_ARM86SVEI8MM && __aarch64__ && !__ARM_FEATURE_SVE_MATMUL_INT8
+void gemm_int8_svei8mm(const Mat& AT, const Mat& AT_scales, const Mat& BT, const Mat& BT_scales, const Mat& C, Mat& top_blob, int broadcast_type_C, float alpha, int output_transpose, const Option& opt);
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_ARM84I8MM && __aarch64__ && !__ARM_FEATURE_MATMUL_INT8
+void gemm_int8_i8mm(const Mat& AT, const Mat& AT_scales, const Mat& BT, const Mat& BT_scales, const Mat& C, Mat& top_blob, int broadcast_type_C, float alpha, int output_transpose, const Option& opt);
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_ARM82DOT && __aarch64__ && !__ARM_FEATURE_DOTPROD && !__ARM_FEATURE_MATMUL_INT8
+void gemm_int8_asimddp(const Mat& AT, const Mat& AT_scales, const Mat& BT, const Mat& BT_scales, const Mat& C, Mat& top_blob, int broadcast_type_C, float alpha, int output_transpose, const Option& opt);
+#endif
+
+static float gemm_int8_get_absmax(const float* ptr, int size)
+{
+    float absmax = 0.f;
+
+    int i = 0;
+#if __ARM_NEON
+    float32x4_t _absmax = vdupq_n_f32(0.f);
+    for (; i + 3 < size; i += 4)
+    {
+        float32x4_t _p = vld1q_f32(ptr);
+        _absmax = vmaxq_f32(_absmax, vabsq_f32(_p));
+        ptr += 4;
+    }
+#if __aarch64__
+    absmax = vmaxvq_f32(_absmax);
+#else
+    float32x2_t _absmax2 = vmax_f32(vget_low_f32(_absmax), vget_high_f32(_absmax));
+    _absmax2 = vpmax_f32(_absmax2, _absmax2);
+    absmax = vget_lane_f32(_absmax2, 0);
+#endif
+#endif // __ARM_NEON
+    for (; i < size; i++)
+    {
+        absmax = std::max(absmax, (float)fabs(*ptr));
+        ptr++;
+    }
+
+    return absmax;
+}
+
+static void gemm_int8_scale2int8(const float* ptr, int size, float scale, signed char* outptr)
+{
+    int i = 0;
+#if __ARM_NEON
+    float32x4_t _scale = vdupq_n_f32(scale);
+    for (; i + 7 < size; i += 8)
+    {
+        float32x4_t _p0 = vld1q_f32(ptr);
+        float32x4_t _p1 = vld1q_f32(ptr + 4);
+        _p0 = vmulq_f32(_p0, _scale);
+        _p1 = vmulq_f32(_p1, _scale);
+        vst1_s8(outptr, float2int8(_p0, _p1));
+        ptr += 8;
+        outptr += 8;
+    }
+#endif // __ARM_NEON
+    for (; i < size; i++)
+    {
+        *outptr++ = float2int8(*ptr++ * scale);
+    }
+}
+
+// quantize the rows of X to int8 rows along K
+// X is (K, rows) when trans == 0, or (rows, K) when trans == 1
+// use the given scales, or the absmax of each row when scales is empty
+static int gemm_quantize_int8(const Mat& X, int trans, const Mat& scales, Mat& XT, Mat& XT_scales, const Option& opt)
+{
+    const int X_h = X.dims == 3 ? X.c : X.h;
+    const int X_hstep = X.dims == 3 ? (int)X.cstep : X.w;
+
+    const int rows = trans ? X.w : X_h;
+    const int K = trans ? X_h : X.w;
+
+    XT.create(K, rows, (size_t)1u, opt.workspace_allocator);
+    if (XT.empty())
+        return -100;
+
+    if (X.elemsize == 1u)
+    {
+        // already int8, only the layout changes
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i = 0; i < rows; i++)
+        {
+            signed char* outptr = XT.row<signed char>(i);
+
+            if (trans)
+            {
+                const signed char* ptr = (const signed char*)X.data + i;
+                for (int k = 0; k < K; k++)
+                {
+                    outptr[k] = ptr[k * X_hstep];
+                }
+            }
+            else
+            {
+                memcpy(outptr, (const signed char*)X.data + i * X_hstep, K);
+            }
+        }
+
+        XT_scales = scales;
+        return 0;
+    }
+
+    if (scales.empty())
+    {
+        XT_scales.create(rows, (size_t)4u, opt.workspace_allocator);
+        if (XT_scales.empty())
+            return -100;
+
+        if (trans)
+        {
+            XT_scales.fill(0.f);
+
+            float* absmax = XT_scales;
+            for (int k = 0; k < K; k++)
+            {
+                const float* ptr = (const float*)X.data + k * X_hstep;
+                for (int i = 0; i < rows; i++)
+                {
+                    absmax[i] = std::max(absmax[i], (float)fabs(ptr[i]));
+                }
+            }
+
+            for (int i = 0; i < rows; i++)
+            {
+                absmax[i] = absmax[i] == 0.f ? 1.f : 127.f / absmax[i];
+            }
+        }
+        else
+        {
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int i = 0; i < rows; i++)
+            {
+                const float absmax = gemm_int8_get_absmax((const float*)X.data + i * X_hstep, K);
+                XT_scales[i] = absmax == 0.f ? 1.f : 127.f / absmax;
+            }
+        }
+    }
+    else
+    {
+        XT_scales = scales;
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int i = 0; i < rows; i++)
+    {
+        signed char* outptr = XT.row<signed char>(i);
+        const float scale = XT_scales[i];
+
+        if (trans)
+        {
+            const float* ptr = (const float*)X.data + i;
+            for (int k = 0; k < K; k++)
+            {
+                outptr[k] = float2int8(ptr[k * X_hstep] * scale);
+            }
+        }
+        else
+        {
+            gemm_int8_scale2int8((const float*)X.data + i * X_hstep, K, scale, outptr);
+        }
+    }
+
+    return 0;
+}
+
+#if __ARM_NEON
+static inline int gemm_int8_reduce_add(int32x4_t _sum)
+{
+#if __aarch64__
+    return vaddvq_s32(_sum);
+#else
+    int32x2_t _sum2 = vadd_s32(vget_low_s32(_sum), vget_high_s32(_sum));
+    _sum2 = vpadd_s32(_sum2, _sum2);
+    return vget_lane_s32(_sum2, 0);
+#endif
+}
+#endif // __ARM_NEON
+
+// dot one int8 row of A with four int8 rows of B
+static void gemm_int8_dot_1x4(const signed char* pA, const signed char* pB0, const signed char* pB1, const signed char* pB2, const signed char* pB3, int K, int* sums)
+{
+    int sum0 = 0;
+    int sum1 = 0;
+    int sum2 = 0;
+    int sum3 = 0;
+
+    int k = 0;
+#if __ARM_NEON
+    int32x4_t _sum0 = vdupq_n_s32(0);
+    int32x4_t _sum1 = vdupq_n_s32(0);
+    int32x4_t _sum2 = vdupq_n_s32(0);
+    int32x4_t _sum3 = vdupq_n_s32(0);
+    for (; k + 15 < K; k += 16)
+    {
+        int8x16_t _a = vld1q_s8(pA + k);
+        int8x16_t _b0 = vld1q_s8(pB0 + k);
+        int8x16_t _b1 = vld1q_s8(pB1 + k);
+        int8x16_t _b2 = vld1q_s8(pB2 + k);
+        int8x16_t _b3 = vld1q_s8(pB3 + k);
+#if __ARM_FEATURE_DOTPROD
+        _sum0 = vdotq_s32(_sum0, _a, _b0);
+        _sum1 = vdotq_s32(_sum1, _a, _b1);
+        _sum2 = vdotq_s32(_sum2, _a, _b2);
+        _sum3 = vdotq_s32(_sum3, _a, _b3);
+#else
+        // int8 values are within [-127, 127], two products fit in int16
+        int16x8_t _s0 = vmull_s8(vget_low_s8(_a), vget_low_s8(_b0));
+        int16x8_t _s1 = vmull_s8(vget_low_s8(_a), vget_low_s8(_b1));
+        int16x8_t _s2 = vmull_s8(vget_low_s8(_a), vget_low_s8(_b2));
+        int16x8_t _s3 = vmull_s8(vget_low_s8(_a), vget_low_s8(_b3));
+        _s0 = vmlal_s8(_s0, vget_high_s8(_a), vget_high_s8(_b0));
+        _s1 = vmlal_s8(_s1, vget_high_s8(_a), vget_high_s8(_b1));
+        _s2 = vmlal_s8(_s2, vget_high_s8(_a), vget_high_s8(_b2));
+        _s3 = vmlal_s8(_s3, vget_high_s8(_a), vget_high_s8(_b3));
+        _sum0 = vpadalq_s16(_sum0, _s0);
+        _sum1 = vpadalq_s16(_sum1, _s1);
+        _sum2 = vpadalq_s16(_sum2, _s2);
+        _sum3 = vpadalq_s16(_sum3, _s3);
+#endif // __ARM_FEATURE_DOTPROD
+    }
+    sum0 += gemm_int8_reduce_add(_sum0);
+    sum1 += gemm_int8_reduce_add(_sum1);
+    sum2 += gemm_int8_reduce_add(_sum2);
+    sum3 += gemm_int8_reduce_add(_sum3);
+#endif // __ARM_NEON
+    for (; k < K; k++)
+    {
+        sum0 += pA[k] * pB0[k];
+        sum1 += pA[k] * pB1[k];
+        sum2 += pA[k] * pB2[k];
+        sum3 += pA[k] * pB3[k];
+    }
+
+    sums[0] = sum0;
+    sums[1] = sum1;
+    sums[2] = sum2;
+    sums[3] = sum3;
+}
+
+#if __ARM_FEATURE_MATMUL_INT8
+// dot two int8 rows of A with four int8 rows of B
+// sums are row 0 with B 0~3, then row 1 with B 0~3
+static void gemm_int8_dot_2x4(const signed char* pA0, const signed char* pA1, const signed char* pB0, const signed char* pB1, const signed char* pB2, const signed char* pB3, int K, int* sums)
+{
+    int32x4_t _sum01 = vdupq_n_s32(0);
+    int32x4_t _sum23 = vdupq_n_s32(0);
+
+    int k = 0;
+    for (; k + 7 < K; k += 8)
+    {
+        int8x16_t _a = vcombine_s8(vld1_s8(pA0 + k), vld1_s8(pA1 + k));
+        int8x16_t _b01 = vcombine_s8(vld1_s8(pB0 + k), vld1_s8(pB1 + k));
+        int8x16_t _b23 = vcombine_s8(vld1_s8(pB2 + k), vld1_s8(pB3 + k));
+
+        // a0b0 a0b1 a1b0 a1b1
+        _sum01 = vmmlaq_s32(_sum01, _a, _b01);
+        _sum23 = vmmlaq_s32(_sum23, _a, _b23);
+    }
+
+    sums[0] = vgetq_lane_s32(_sum01, 0);
+    sums[1] = vgetq_lane_s32(_sum01, 1);
+    sums[2] = vgetq_lane_s32(_sum23, 0);
+    sums[3] = vgetq_lane_s32(_sum23, 1);
+    sums[4] = vgetq_lane_s32(_sum01, 2);
+    sums[5] = vgetq_lane_s32(_sum01, 3);
+    sums[6] = vgetq_lane_s32(_sum23, 2);
+    sums[7] = vgetq_lane_s32(_sum23, 3);
+
+    for (; k < K; k++)
+    {
+        sums[0] += pA0[k] * pB0[k];
+        sums[1] += pA0[k] * pB1[k];
+        sums[2] += pA0[k] * pB2[k];
+        sums[3] += pA0[k] * pB3[k];
+        sums[4] += pA1[k] * pB0[k];
+        sums[5] += pA1[k] * pB1[k];
+        sums[6] += pA1[k] * pB2[k];
+        sums[7] += pA1[k] * pB3[k];
+    }
+}
+#endif // __ARM_FEATURE_MATMUL_INT8
+
+static int gemm_int8_dot_1x1(const signed char* pA, const signed char* pB, int K)
+{
+    int sum = 0;
+
+    int k = 0;
+#if __ARM_NEON
+    int32x4_t _sum = vdupq_n_s32(0);
+    for (; k + 15 < K; k += 16)
+    {
+        int8x16_t _a = vld1q_s8(pA + k);
+        int8x16_t _b = vld1q_s8(pB + k);
+#if __ARM_FEATURE_DOTPROD
+        _sum = vdotq_s32(_sum, _a, _b);
+#else
+        int16x8_t _s = vmull_s8(vget_low_s8(_a), vget_low_s8(_b));
+        _s = vmlal_s8(_s, vget_high_s8(_a), vget_high_s8(_b));
+        _sum = vpadalq_s16(_sum, _s);
+#endif // __ARM_FEATURE_DOTPROD
+    }
+    sum += gemm_int8_reduce_add(_sum);
+#endif // __ARM_NEON
+    for (; k < K; k++)
+    {
+        sum += pA[k] * pB[k];
+    }
+
+    return sum;
+}
+
+static inline float gemm_int8_get_C(const float* pC, int broadcast_type_C, int N, int i, int j)
+{
+    if (broadcast_type_C == 0)
+        return pC[0];
+    if (broadcast_type_C == 1 || broadcast_type_C == 2)
+        return pC[i];
+    if (broadcast_type_C == 3)
+        return pC[i * N + j];
+    // broadcast_type_C == 4
+    return pC[j];
+}
+
+static inline void gemm_int8_store(Mat& top_blob, int out_hstep, const Mat& AT_scales, const Mat& BT_scales, const float* pC, int broadcast_type_C, float alpha, int output_transpose, int N, int i, int j, int sum_int)
+{
+    float sum = sum_int / (AT_scales[i] * BT_scales[j]);
+
+    if (pC)
+        sum += gemm_int8_get_C(pC, broadcast_type_C, N, i, j);
+
+    sum *= alpha;
+
+    if (output_transpose)
+        top_blob[j * out_hstep + i] = sum;
+    else
+        top_blob[i * out_hstep + j] = sum;
+}
+
+#if __ARM_FEATURE_SVE_MATMUL_INT8
+// interleave two int8 rows in blocks of 8 along K, as the 2x8 operand of svmmla
+// p1 may be null for a missing row, the missing row and the K tail are zero
+static void gemm_int8_pack_row_pair_sve(const signed char* p0, const signed char* p1, int K, int Kp, signed char* outptr)
+{
+    for (int k = 0; k < Kp; k += 8)
+    {
+        for (int kk = 0; kk < 8; kk++)
+        {
+            outptr[kk] = k + kk < K ? p0[k + kk] : 0;
+            outptr[8 + kk] = p1 && k + kk < K ? p1[k + kk] : 0;
+        }
+        outptr += 16;
+    }
+}
+
+// four int8 rows of A with four int8 rows of B, each as two interleaved row pairs
+// every 128bit segment of the vector multiplies its own 8 of K, sums are row major 4x4
+static void gemm_int8_dot_4x4_sve(const signed char* pA01, const signed char* pA23, const signed char* pB01, const signed char* pB23, int Kp, int* sums)
+{
+    svint32_t _sum00 = svdup_n_s32(0);
+    svint32_t _sum01 = svdup_n_s32(0);
+    svint32_t _sum10 = svdup_n_s32(0);
+    svint32_t _sum11 = svdup_n_s32(0);
+
+    const int size = Kp * 2;
+    for (int k = 0; k < size; k += (int)svcntb())
+    {
+        const svbool_t _pg = svwhilelt_b8(k, size);
+        svint8_t _a01 = svld1_s8(_pg, pA01 + k);
+        svint8_t _a23 = svld1_s8(_pg, pA23 + k);
+        svint8_t _b01 = svld1_s8(_pg, pB01 + k);
+        svint8_t _b23 = svld1_s8(_pg, pB23 + k);
+
+        // a0b0 a0b1 a1b0 a1b1 in each segment
+        _sum00 = svmmla_s32(_sum00, _a01, _b01);
+        _sum01 = svmmla_s32(_sum01, _a01, _b23);
+        _sum10 = svmmla_s32(_sum10, _a23, _b01);
+        _sum11 = svmmla_s32(_sum11, _a23, _b23);
+    }
+
+    // reduce lane t of all segments
+    const svuint32_t _lane = svand_n_u32_x(svptrue_b32(), svindex_u32(0, 1), 3);
+    for (int t = 0; t < 4; t++)
+    {
+        const svbool_t _pt = svcmpeq_n_u32(svptrue_b32(), _lane, t);
+        const int r = t / 2;
+        const int c = t % 2;
+        sums[r * 4 + c] = (int)svaddv_s32(_pt, _sum00);
+        sums[r * 4 + 2 + c] = (int)svaddv_s32(_pt, _sum01);
+        sums[(r + 2) * 4 + c] = (int)svaddv_s32(_pt, _sum10);
+        sums[(r + 2) * 4 + 2 + c] = (int)svaddv_s32(_pt, _sum11);
+    }
+}
+
+static int gemm_int8_sve(const Mat& AT, const Mat& AT_scales, const Mat& BT, const Mat& BT_scales, const Mat& C, Mat& top_blob, int broadcast_type_C, float alpha, int output_transpose, const Option& opt)
+{
+    const int M = AT.h;
+    const int N = BT.h;
+    const int K = AT.w;
+    const int Kp = (K + 7) / 8 * 8;
+
+    const float* pC = C.empty() ? 0 : (const float*)C;
+
+    const int out_hstep = top_blob.dims == 3 ? (int)top_blob.cstep : top_blob.w;
+
+    // B row pairs are shared by all threads
+    const int nn_N2 = (N + 1) / 2;
+    Mat BP(Kp * 2, nn_N2, (size_t)1u, opt.workspace_allocator);
+    if (BP.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int jj2 = 0; jj2 < nn_N2; jj2++)
+    {
+        const int j = jj2 * 2;
+        gemm_int8_pack_row_pair_sve(BT.row<const signed char>(j), j + 1 < N ? BT.row<const signed char>(j + 1) : 0, K, Kp, BP.row<signed char>(jj2));
+    }
+
+    const int TILE_M = 8;
+    const int nn_M = (M + TILE_M - 1) / TILE_M;
+
+    Mat APX(Kp * 2, TILE_M / 2, opt.num_threads, (size_t)1u, opt.workspace_allocator);
+    if (APX.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int ppi = 0; ppi < nn_M; ppi++)
+    {
+        const int i0 = ppi * TILE_M;
+        const int max_ii = std::min(M - i0, TILE_M);
+
+        Mat AP = APX.channel(get_omp_thread_num());
+
+        for (int ii = 0; ii < max_ii; ii += 2)
+        {
+            gemm_int8_pack_row_pair_sve(AT.row<const signed char>(i0 + ii), ii + 1 < max_ii ? AT.row<const signed char>(i0 + ii + 1) : 0, K, Kp, AP.row<signed char>(ii / 2));
+        }
+
+        for (int j = 0; j < N; j += 4)
+        {
+            const int max_jj = std::min(N - j, 4);
+            const signed char* pB01 = BP.row<const signed char>(j / 2);
+            const signed char* pB23 = max_jj > 2 ? BP.row<const signed char>(j / 2 + 1) : pB01;
+
+            for (int ii = 0; ii < max_ii; ii += 4)
+            {
+                const signed char* pA01 = AP.row<const signed char>(ii / 2);
+                const signed char* pA23 = ii + 2 < max_ii ? AP.row<const signed char>(ii / 2 + 1) : pA01;
+
+                int sums[16];
+                gemm_int8_dot_4x4_sve(pA01, pA23, pB01, pB23, Kp, sums);
+
+                for (int r = 0; r < 4 && ii + r < max_ii; r++)
+                {
+                    for (int c = 0; c < max_jj; c++)
+                    {
+                        gemm_int8_store(top_blob, out_hstep, AT_scales, BT_scales, pC, broadcast_type_C, alpha, output_transpose, N, i0 + ii + r, j + c, sums[r * 4 + c]);
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+#endif // __ARM_FEATURE_SVE_MATMUL_INT8
+
+// top = alpha * (dequantize(AT * BT^T) + C)
+// AT is (K, M) int8, BT is (K, N) int8, C is pre-multiplied with beta
+// top_blob is unpacked fp32, (N, M) or (M, N) when output_transpose
+static void gemm_int8(const Mat& AT, const Mat& AT_scales, const Mat& BT, const Mat& BT_scales, const Mat& C, Mat& top_blob, int broadcast_type_C, float alpha, int output_transpose, const Option& opt)
+{
+#if NCNN_RUNTIME_CPU && NCNN_ARM86SVEI8MM && __aarch64__ && !__ARM_FEATURE_SVE_MATMUL_INT8
+    // 128bit sve has one svmmla segment like i8mm, keep the tuned neon kernels there
+    if (ncnn::cpu_support_arm_svei8mm() && ncnn::get_cpu_arm_sve_vector_bits() > 128)
+    {
+        gemm_int8_svei8mm(AT, AT_scales, BT, BT_scales, C, top_blob, broadcast_type_C, alpha, output_transpose, opt);
+        return;
+    }
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_ARM84I8MM && __aarch64__ && !__ARM_FEATURE_MATMUL_INT8
+    if (ncnn::cpu_support_arm_i8mm())
+    {
+        gemm_int8_i8mm(AT, AT_scales, BT, BT_scales, C, top_blob, broadcast_type_C, alpha, output_transpose, opt);
+        return;
+    }
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_ARM82DOT && __aarch64__ && !__ARM_FEATURE_DOTPROD && !__ARM_FEATURE_MATMUL_INT8
+    if (ncnn::cpu_support_arm_asimddp())
+    {
+        gemm_int8_asimddp(AT, AT_scales, BT, BT_scales, C, top_blob, broadcast_type_C, alpha, output_transpose, opt);
+        return;
+    }
+#endif
+
+#if __ARM_FEATURE_SVE_MATMUL_INT8
+    // fall back to the neon kernels at 128bit or if the workspace is not available
+    if (svcntb() > 16 && gemm_int8_sve(AT, AT_scales, BT, BT_scales, C, top_blob, broadcast_type_C, alpha, output_transpose, opt) == 0)
+        return;
+#endif // __ARM_FEATURE_SVE_MATMUL_INT8
+
+    const int M = AT.h;
+    const int N = BT.h;
+    const int K = AT.w;
+
+    const float* pC = C.empty() ? 0 : (const float*)C;
+
+    const int out_hstep = top_blob.dims == 3 ? (int)top_blob.cstep : top_blob.w;
+
+    // a few rows of A share each group of four rows of B while it is hot in cache
+    const int TILE_M = 8;
+    const int nn_M = (M + TILE_M - 1) / TILE_M;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int ppi = 0; ppi < nn_M; ppi++)
+    {
+        const int i0 = ppi * TILE_M;
+        const int max_ii = std::min(M - i0, TILE_M);
+
+        int j = 0;
+        for (; j + 3 < N; j += 4)
+        {
+            const signed char* pB0 = BT.row<const signed char>(j);
+            const signed char* pB1 = BT.row<const signed char>(j + 1);
+            const signed char* pB2 = BT.row<const signed char>(j + 2);
+            const signed char* pB3 = BT.row<const signed char>(j + 3);
+
+            int ii = 0;
+#if __ARM_FEATURE_MATMUL_INT8
+            for (; ii + 1 < max_ii; ii += 2)
+            {
+                const int i = i0 + ii;
+
+                int sums[8];
+                gemm_int8_dot_2x4(AT.row<const signed char>(i), AT.row<const signed char>(i + 1), pB0, pB1, pB2, pB3, K, sums);
+
+                for (int jj = 0; jj < 4; jj++)
+                {
+                    gemm_int8_store(top_blob, out_hstep, AT_scales, BT_scales, pC, broadcast_type_C, alpha, output_transpose, N, i, j + jj, sums[jj]);
+                    gemm_int8_store(top_blob, out_hstep, AT_scales, BT_scales, pC, broadcast_type_C, alpha, output_transpose, N, i + 1, j + jj, sums[4 + jj]);
+                }
+            }
+#endif // __ARM_FEATURE_MATMUL_INT8
+            for (; ii < max_ii; ii++)
+            {
+                const int i = i0 + ii;
+
+                int sums[4];
+                gemm_int8_dot_1x4(AT.row<const signed char>(i), pB0, pB1, pB2, pB3, K, sums);
+
+                for (int jj = 0; jj < 4; jj++)
+                {
+                    gemm_int8_store(top_blob, out_hstep, AT_scales, BT_scales, pC, broadcast_type_C, alpha, output_transpose, N, i, j + jj, sums[jj]);
+                }
+            }
+        }
+        for (; j < N; j++)
+        {
+            const signed char* pB = BT.row<const signed char>(j);
+
+            for (int ii = 0; ii < max_ii; ii++)
+            {
+                const int i = i0 + ii;
+
+                gemm_int8_store(top_blob, out_hstep, AT_scales, BT_scales, pC, broadcast_type_C, alpha, output_transpose, N, i, j, gemm_int8_dot_1x1(AT.row<const signed char>(i), pB, K));
+            }
+        }
+    }
+}
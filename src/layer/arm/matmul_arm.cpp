@@ -51,6 +51,7 @@ int MatMul_arm::create_pipeline(const Option& opt)
     pd.set(10, -1);    // constant_broadcast_type_C = null
     pd.set(11, 0);     // output_N1M
     pd.set(12, 1);     // output_elempack
+    pd.set(18, int8_scale_term);
 
     gemm->load_param(pd);
 
@@ -14,6 +14,7 @@
 
 #include "convolution.h"
 
+#include "cpu.h"
 #include "layer_type.h"
 
 #include "fused_activation.h"
@@ -47,12 +48,38 @@ int Convolution::load_param(const ParamDict& pd)
     activation_params = pd.get(10, Mat());
 
     dynamic_weight = pd.get(19, 0);
+    residual = pd.get(20, 0);
 
     if (dynamic_weight)
     {
         one_blob_only = false;
     }
 
+    residual_activation_type = 0;
+    residual_activation_params = Mat();
+
+    if (residual)
+    {
+        if (dynamic_weight)
+        {
+            NCNN_LOGE("residual with dynamic_weight is not supported");
+            return -1;
+        }
+
+        if (int8_scale_term > 100)
+        {
+            NCNN_LOGE("residual with int8 requantize is not supported");
+            return -1;
+        }
+
+        one_blob_only = false;
+
+        residual_activation_type = activation_type;
+        residual_activation_params = activation_params;
+        activation_type = 0;
+        activation_params = Mat();
+    }
+
     if (int8_scale_term)
     {
 #if NCNN_INT8
@@ -279,6 +306,15 @@ int Convolution::forward(const Mat& bottom_blob, Mat& top_blob, const Option& op
 
 int Convolution::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
+    if (residual)
+    {
+        int ret = forward(bottom_blobs[0], top_blobs[0], opt);
+        if (ret != 0)
+            return ret;
+
+        return add_residual(bottom_blobs[1], top_blobs[0], opt);
+    }
+
     const Mat& bottom_blob = bottom_blobs[0];
     const Mat& _weight_data = bottom_blobs[1];
     Mat& top_blob = top_blobs[0];
@@ -327,6 +363,82 @@ int Convolution::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>&
     return 0;
 }
 
+int Convolution::add_residual(const Mat& _residual, Mat& top_blob, const Option& opt) const
+{
+    Mat residual = _residual;
+    if (residual.elempack != top_blob.elempack)
+    {
+        Option opt_pack = opt;
+        opt_pack.blob_allocator = opt.workspace_allocator;
+        convert_packing(_residual, residual, top_blob.elempack, opt_pack);
+        if (residual.empty())
+            return -100;
+    }
+
+    if (residual.dims != top_blob.dims || residual.w != top_blob.w || residual.h != top_blob.h || residual.d != top_blob.d || residual.c != top_blob.c || residual.elemsize != top_blob.elemsize)
+    {
+        NCNN_LOGE("residual shape %d %d %d %d does not match output shape %d %d %d %d", residual.w, residual.h, residual.d, residual.c, top_blob.w, top_blob.h, top_blob.d, top_blob.c);
+        return -1;
+    }
+
+    const int channels = top_blob.c;
+    const int size = top_blob.w * top_blob.h * top_blob.d * top_blob.elempack;
+    const int elembits = top_blob.elembits();
+
+    // 16 bit blobs follow the storage the net picks for this cpu
+    const bool use_bf16 = opt.use_bf16_storage && !(opt.use_fp16_storage && (cpu_support_arm_asimdhp() || (cpu_support_riscv_v() && cpu_support_riscv_zfh())));
+
+    if (elembits == 16 && use_bf16)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = 0; q < channels; q++)
+        {
+            const unsigned short* ptr = residual.channel(q);
+            unsigned short* outptr = top_blob.channel(q);
+
+            for (int i = 0; i < size; i++)
+            {
+                float v = bfloat16_to_float32(outptr[i]) + bfloat16_to_float32(ptr[i]);
+                outptr[i] = float32_to_bfloat16(activation_ss(v, residual_activation_type, residual_activation_params));
+            }
+        }
+
+        return 0;
+    }
+
+    if (elembits == 16)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = 0; q < channels; q++)
+        {
+            const unsigned short* ptr = residual.channel(q);
+            unsigned short* outptr = top_blob.channel(q);
+
+            for (int i = 0; i < size; i++)
+            {
+                float v = float16_to_float32(outptr[i]) + float16_to_float32(ptr[i]);
+                outptr[i] = float32_to_float16(activation_ss(v, residual_activation_type, residual_activation_params));
+            }
+        }
+
+        return 0;
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* ptr = residual.channel(q);
+        float* outptr = top_blob.channel(q);
+
+        for (int i = 0; i < size; i++)
+        {
+            outptr[i] = activation_ss(outptr[i] + ptr[i], residual_activation_type, residual_activation_params);
+        }
+    }
+
+    return 0;
+}
+
 void Convolution::make_padding(const Mat& bottom_blob, Mat& bottom_blob_bordered, const Option& opt) const
 {
     make_padding(bottom_blob, bottom_blob_bordered, kernel_w, kernel_h, opt);
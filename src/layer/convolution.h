@@ -40,6 +40,9 @@ protected:
     int forward_int8(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 #endif
 
+    // top_blob = activation(top_blob + residual)
+    int add_residual(const Mat& residual, Mat& top_blob, const Option& opt) const;
+
 public:
     // param
     int num_output;
@@ -66,6 +69,13 @@ public:
 
     int dynamic_weight;
 
+    // add the second input before the activation
+    // the activation is moved to residual_activation_type, kernels only compute convolution and bias
+    // the add and activation run as a separate pass over the output, not inside the gemm or winograd output stage
+    int residual;
+    int residual_activation_type;
+    Mat residual_activation_params;
+
     // model
     Mat weight_data;
     Mat bias_data;
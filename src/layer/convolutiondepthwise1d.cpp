@@ -18,6 +18,8 @@
 
 #include "fused_activation.h"
 
+#include <string.h>
+
 namespace ncnn {
 
 ConvolutionDepthWise1D::ConvolutionDepthWise1D()
@@ -42,12 +44,28 @@ int ConvolutionDepthWise1D::load_param(const ParamDict& pd)
     activation_params = pd.get(10, Mat());
 
     dynamic_weight = pd.get(19, 0);
+    streaming = pd.get(20, 0);
 
     if (dynamic_weight)
     {
         one_blob_only = false;
     }
 
+    if (streaming)
+    {
+        if (dynamic_weight)
+        {
+            NCNN_LOGE("ConvolutionDepthWise1D streaming with dynamic weight is not supported");
+            return -1;
+        }
+
+        // the cached frames replace the padding
+        pad_left = 0;
+        pad_right = 0;
+
+        one_blob_only = false;
+    }
+
     if (num_output % group != 0)
     {
         // reject invalid group
@@ -195,6 +213,9 @@ int ConvolutionDepthWise1D::forward(const Mat& bottom_blob, Mat& top_blob, const
 
 int ConvolutionDepthWise1D::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
+    if (streaming)
+        return forward_streaming(bottom_blobs, top_blobs, opt);
+
     const Mat& bottom_blob = bottom_blobs[0];
     const Mat& _weight_data = bottom_blobs[1];
     Mat& top_blob = top_blobs[0];
@@ -239,6 +260,88 @@ int ConvolutionDepthWise1D::forward(const std::vector<Mat>& bottom_blobs, std::v
     return 0;
 }
 
+int ConvolutionDepthWise1D::forward_streaming(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const Mat& bottom_blob = bottom_blobs[0];
+    const Mat& cache = bottom_blobs[1];
+    Mat& top_blob = top_blobs[0];
+    Mat& top_cache = top_blobs[1];
+
+    const int w = bottom_blob.w;
+    const int h = bottom_blob.h;
+    const size_t elemsize = bottom_blob.elemsize;
+    const int elempack = bottom_blob.elempack;
+
+    // the last (kernel_w - 1) * dilation_w input frames of previous chunks
+    const int history_w = dilation_w * (kernel_w - 1);
+
+    if (w % stride_w != 0)
+    {
+        NCNN_LOGE("ConvolutionDepthWise1D streaming input width %d is not a multiple of stride %d", w, stride_w);
+        return -1;
+    }
+
+    if (!cache.empty() && (cache.w != history_w || cache.h != h || cache.elemsize != elemsize || cache.elempack != elempack))
+    {
+        NCNN_LOGE("ConvolutionDepthWise1D streaming cache shape mismatch");
+        return -1;
+    }
+
+    Mat bottom_blob_joined = bottom_blob;
+    if (history_w > 0)
+    {
+        bottom_blob_joined.create(history_w + w, h, elemsize, elempack, opt.workspace_allocator);
+        if (bottom_blob_joined.empty())
+            return -100;
+
+        const size_t history_size = history_w * elemsize;
+        const size_t size = w * elemsize;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i = 0; i < h; i++)
+        {
+            unsigned char* outptr = bottom_blob_joined.row<unsigned char>(i);
+
+            if (cache.empty())
+            {
+                // start from zero history
+                memset(outptr, 0, history_size);
+            }
+            else
+            {
+                memcpy(outptr, cache.row<const unsigned char>(i), history_size);
+            }
+
+            memcpy(outptr + history_size, bottom_blob.row<const unsigned char>(i), size);
+        }
+    }
+
+    // no padding in streaming mode, one output for every stride frames
+    int ret = forward(bottom_blob_joined, top_blob, opt);
+    if (ret != 0)
+        return ret;
+
+    if (history_w > 0)
+    {
+        top_cache.create(history_w, h, elemsize, elempack, opt.blob_allocator);
+        if (top_cache.empty())
+            return -100;
+
+        const size_t history_size = history_w * elemsize;
+
+        for (int i = 0; i < h; i++)
+        {
+            memcpy(top_cache.row<unsigned char>(i), bottom_blob_joined.row<const unsigned char>(i) + w * elemsize, history_size);
+        }
+    }
+    else
+    {
+        top_cache = Mat();
+    }
+
+    return 0;
+}
+
 void ConvolutionDepthWise1D::make_padding(const Mat& bottom_blob, Mat& bottom_blob_bordered, const Option& opt) const
 {
     make_padding(bottom_blob, bottom_blob_bordered, kernel_w, opt);
@@ -36,6 +36,8 @@ protected:
     void make_padding(const Mat& bottom_blob, Mat& bottom_blob_bordered, const Option& opt) const;
     void make_padding(const Mat& bottom_blob, Mat& bottom_blob_bordered, int kernel_w, const Option& opt) const;
 
+    int forward_streaming(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
+
 public:
     // param
     int num_output;
@@ -56,6 +58,9 @@ public:
 
     int dynamic_weight;
 
+    // take the cached tail of previous input as the 2nd input, output the new tail as the 2nd output
+    int streaming;
+
     // model
     Mat weight_data;
     Mat bias_data;
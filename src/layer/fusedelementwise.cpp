@@ -0,0 +1,281 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "fusedelementwise.h"
+
+#include "binaryop.h"
+#include "unaryop.h"
+
+#include <float.h>
+
+namespace ncnn {
+
+FusedElementwise::FusedElementwise()
+{
+    one_blob_only = true;
+    support_inplace = true;
+    support_packing = true;
+}
+
+int FusedElementwise::load_param(const ParamDict& pd)
+{
+    input_count = pd.get(0, 1);
+    program = pd.get(1, Mat());
+
+    const int instruction_count = program.w / 5;
+    if (instruction_count == 0 || instruction_count > MAX_INSTRUCTION_COUNT)
+    {
+        NCNN_LOGE("FusedElementwise invalid instruction count %d", instruction_count);
+        return -1;
+    }
+
+    instructions.resize(instruction_count);
+    for (int i = 0; i < instruction_count; i++)
+    {
+        const float* p = (const float*)program + i * 5;
+
+        Instruction& ins = instructions[i];
+        ins.op_type = (int)p[0];
+        ins.src0 = (int)p[1];
+        ins.src1 = (int)p[2];
+        ins.a = p[3];
+        ins.b = p[4];
+
+        // registers are written in order, read only the computed ones
+        if (ins.src0 < 0 || ins.src0 > i || ins.src1 < 0 || ins.src1 > i)
+        {
+            NCNN_LOGE("FusedElementwise instruction %d reads unknown register", i);
+            return -1;
+        }
+    }
+
+    if (input_count > 1)
+    {
+        one_blob_only = false;
+        support_inplace = false;
+    }
+
+    return 0;
+}
+
+static float fused_unary_op(int op_type, float x)
+{
+    switch (op_type)
+    {
+    case UnaryOp::Operation_ABS:
+        return fabsf(x);
+    case UnaryOp::Operation_NEG:
+        return -x;
+    case UnaryOp::Operation_FLOOR:
+        return floorf(x);
+    case UnaryOp::Operation_CEIL:
+        return ceilf(x);
+    case UnaryOp::Operation_SQUARE:
+        return x * x;
+    case UnaryOp::Operation_SQRT:
+        return sqrtf(x);
+    case UnaryOp::Operation_RSQRT:
+        return 1.f / sqrtf(x);
+    case UnaryOp::Operation_EXP:
+        return expf(x);
+    case UnaryOp::Operation_LOG:
+        return logf(x);
+    case UnaryOp::Operation_SIN:
+        return sinf(x);
+    case UnaryOp::Operation_COS:
+        return cosf(x);
+    case UnaryOp::Operation_TAN:
+        return tanf(x);
+    case UnaryOp::Operation_ASIN:
+        return asinf(x);
+    case UnaryOp::Operation_ACOS:
+        return acosf(x);
+    case UnaryOp::Operation_ATAN:
+        return atanf(x);
+    case UnaryOp::Operation_RECIPROCAL:
+        return 1.f / x;
+    case UnaryOp::Operation_TANH:
+        return tanhf(x);
+    case UnaryOp::Operation_LOG10:
+        return log10f(x);
+    case UnaryOp::Operation_ROUND:
+        // round to nearest even with the default rounding mode
+        return nearbyintf(x);
+    case UnaryOp::Operation_TRUNC:
+        return truncf(x);
+    default:
+        return x;
+    }
+}
+
+static float fused_binary_op(int op_type, float x, float y)
+{
+    switch (op_type)
+    {
+    case BinaryOp::Operation_ADD:
+        return x + y;
+    case BinaryOp::Operation_SUB:
+        return x - y;
+    case BinaryOp::Operation_MUL:
+        return x * y;
+    case BinaryOp::Operation_DIV:
+        return x / y;
+    case BinaryOp::Operation_MAX:
+        return std::max(x, y);
+    case BinaryOp::Operation_MIN:
+        return std::min(x, y);
+    case BinaryOp::Operation_POW:
+        return powf(x, y);
+    case BinaryOp::Operation_RSUB:
+        return y - x;
+    case BinaryOp::Operation_RDIV:
+        return y / x;
+    case BinaryOp::Operation_RPOW:
+        return powf(y, x);
+    case BinaryOp::Operation_ATAN2:
+        return atan2f(x, y);
+    case BinaryOp::Operation_RATAN2:
+        return atan2f(y, x);
+    default:
+        return x;
+    }
+}
+
+static float fused_op(const FusedElementwise::Instruction& ins, float x, float y)
+{
+    switch (ins.op_type)
+    {
+    case FusedElementwise::Operation_UNARYOP:
+        return fused_unary_op((int)ins.a, x);
+    case FusedElementwise::Operation_BINARYOP:
+        return fused_binary_op((int)ins.a, x, y);
+    case FusedElementwise::Operation_BINARYOP_SCALAR:
+        return fused_binary_op((int)ins.a, x, ins.b);
+    case FusedElementwise::Operation_SIGMOID:
+        return 1.f / (1.f + expf(-x));
+    case FusedElementwise::Operation_RELU:
+        return x < 0.f ? x * ins.a : x;
+    case FusedElementwise::Operation_CLIP:
+        return x < ins.a ? ins.a : (x > ins.b ? ins.b : x);
+    case FusedElementwise::Operation_SWISH:
+        return x / (1.f + expf(-x));
+    case FusedElementwise::Operation_HARDSIGMOID:
+        return std::min(std::max(x * ins.a + ins.b, 0.f), 1.f);
+    case FusedElementwise::Operation_HARDSWISH:
+        return x * std::min(std::max(x * ins.a + ins.b, 0.f), 1.f);
+    case FusedElementwise::Operation_ELU:
+        return x < 0.f ? ins.a * (expf(x) - 1.f) : x;
+    case FusedElementwise::Operation_GELU:
+        if (ins.a != 0.f)
+            return 0.5f * x * (1.0f + tanhf(0.79788452f * (x + 0.044715f * x * x * x)));
+        return 0.5f * x * erfcf(-0.70710678f * x);
+    case FusedElementwise::Operation_MISH:
+    {
+        const float MISH_THRESHOLD = 20;
+        float y;
+        if (x > MISH_THRESHOLD)
+            y = x;
+        else if (x < -MISH_THRESHOLD)
+            y = expf(x);
+        else
+            y = logf(expf(x) + 1);
+        return x * tanhf(y);
+    }
+    default:
+        return x;
+    }
+}
+
+void FusedElementwise::run_instruction(const Instruction& ins, const float* a, const float* b, float* out, int n)
+{
+    if (ins.op_type == Operation_BINARYOP)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            out[i] = fused_op(ins, a[i], b[i]);
+        }
+    }
+    else
+    {
+        for (int i = 0; i < n; i++)
+        {
+            out[i] = fused_op(ins, a[i], 0.f);
+        }
+    }
+}
+
+void FusedElementwise::run_program(const float* ptr, float* outptr, int n) const
+{
+    const int instruction_count = (int)instructions.size();
+
+    // register i + 1 lives in regs[i], the last one is written to outptr directly
+    float regs[MAX_INSTRUCTION_COUNT - 1][TILE_SIZE];
+
+    for (int i = 0; i < instruction_count; i++)
+    {
+        const Instruction& ins = instructions[i];
+
+        const float* a = ins.src0 == 0 ? ptr : regs[ins.src0 - 1];
+        const float* b = ins.src1 == 0 ? ptr : regs[ins.src1 - 1];
+        float* out = i == instruction_count - 1 ? outptr : regs[i];
+
+        run_instruction(ins, a, b, out, n);
+    }
+}
+
+int FusedElementwise::forward_program(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    const int channels = bottom_blob.c;
+    const int size = bottom_blob.w * bottom_blob.h * bottom_blob.d * bottom_blob.elempack;
+
+    const int nn_tile = (size + TILE_SIZE - 1) / TILE_SIZE;
+
+    // split over tiles so that 1d and 2d blobs run in parallel too
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int t = 0; t < channels * nn_tile; t++)
+    {
+        const int q = t / nn_tile;
+        const int i = t % nn_tile * TILE_SIZE;
+        const int n = std::min((int)TILE_SIZE, size - i);
+
+        const float* ptr = (const float*)bottom_blob.channel(q) + i;
+        float* outptr = (float*)top_blob.channel(q) + i;
+
+        run_program(ptr, outptr, n);
+    }
+
+    return 0;
+}
+
+int FusedElementwise::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    top_blob.create_like(bottom_blob, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    return forward_program(bottom_blob, top_blob, opt);
+}
+
+int FusedElementwise::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+{
+    return forward_program(bottom_top_blob, bottom_top_blob, opt);
+}
+
+int FusedElementwise::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    // all inputs hold the same tensor
+    return forward(bottom_blobs[0], top_blobs[0], opt);
+}
+
+} // namespace ncnn
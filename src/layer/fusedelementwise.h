@@ -0,0 +1,90 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef LAYER_FUSEDELEMENTWISE_H
+#define LAYER_FUSEDELEMENTWISE_H
+
+#include "layer.h"
+
+namespace ncnn {
+
+// a chain of elementwise layers evaluated in one pass
+// every input blob holds the same tensor, register 0 is that tensor
+// instruction i writes register i + 1, the last one is the output
+class FusedElementwise : public Layer
+{
+public:
+    FusedElementwise();
+
+    virtual int load_param(const ParamDict& pd);
+
+    virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+
+    virtual int forward_inplace(Mat& bottom_top_blob, const Option& opt) const;
+
+    virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
+
+    enum OperationType
+    {
+        Operation_UNARYOP = 0,         // a = unaryop op_type
+        Operation_BINARYOP = 1,        // a = binaryop op_type
+        Operation_BINARYOP_SCALAR = 2, // a = binaryop op_type, b = scalar
+        Operation_SIGMOID = 3,
+        Operation_RELU = 4,            // a = slope
+        Operation_CLIP = 5,            // a = min, b = max
+        Operation_SWISH = 6,
+        Operation_HARDSIGMOID = 7,     // a = alpha, b = beta
+        Operation_HARDSWISH = 8,       // a = alpha, b = beta
+        Operation_ELU = 9,             // a = alpha
+        Operation_GELU = 10,           // a = fast_gelu
+        Operation_MISH = 11
+    };
+
+    struct Instruction
+    {
+        int op_type;
+        int src0;
+        int src1;
+        float a;
+        float b;
+    };
+
+    enum
+    {
+        // values of each register are kept in a tile of this many floats
+        TILE_SIZE = 64,
+        MAX_INSTRUCTION_COUNT = 31
+    };
+
+    // out[i] = instruction(a[i], b[i]) for i in [0, n)
+    static void run_instruction(const Instruction& ins, const float* a, const float* b, float* out, int n);
+
+protected:
+    // evaluate the program over bottom_blob, top_blob may be bottom_blob
+    virtual void run_program(const float* ptr, float* outptr, int n) const;
+
+    int forward_program(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+
+public:
+    int input_count;
+
+    // 5 floats per instruction, op_type src0 src1 a b
+    Mat program;
+
+    std::vector<Instruction> instructions;
+};
+
+} // namespace ncnn
+
+#endif // LAYER_FUSEDELEMENTWISE_H
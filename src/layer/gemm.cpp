@@ -39,6 +39,7 @@ int Gemm::load_param(const ParamDict& pd)
     output_elempack = pd.get(12, 0);
     output_elemtype = pd.get(13, 0);
     output_transpose = pd.get(14, 0);
+    int8_scale_term = pd.get(18, 0);
     constant_TILE_M = pd.get(20, 0);
     constant_TILE_N = pd.get(21, 0);
     constant_TILE_K = pd.get(22, 0);
@@ -61,6 +62,14 @@ int Gemm::load_param(const ParamDict& pd)
         return -1;
     }
 
+    if (int8_scale_term)
+    {
+#if !NCNN_INT8
+        NCNN_LOGE("please build ncnn with NCNN_INT8 enabled for int8 inference");
+        return -1;
+#endif
+    }
+
     if (constantA == 0 && constantB == 1 && constantC == 1)
         one_blob_only = true;
 
@@ -111,75 +120,32 @@ int Gemm::load_model(const ModelBin& mb)
             return -100;
     }
 
-    return 0;
-}
-
-int Gemm::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
-{
-    std::vector<Mat> bottom_blobs(1, bottom_blob);
-    std::vector<Mat> top_blobs(1, top_blob);
-    int ret = forward(bottom_blobs, top_blobs, opt);
-    top_blob = top_blobs[0];
-    return ret;
-}
-
-int Gemm::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
-{
-    const Mat& A0 = constantA ? A_data : bottom_blobs[0];
-    const Mat& B0 = constantB ? B_data : constantA ? bottom_blobs[0] : bottom_blobs[1];
-
-    size_t elemsize = A0.elemsize;
-
-    Mat A;
-    if (transA == 0)
+#if NCNN_INT8
+    if (int8_scale_term)
     {
-        A = A0;
-    }
-    else
-    {
-        // transpose A to row-major
-        A.create((A0.dims == 3 ? A0.c : A0.h), A0.w, elemsize, opt.workspace_allocator);
-
-        const int A0_hstep = A0.dims == 3 ? (int)A0.cstep : A0.w;
-
-        for (int i = 0; i < A.h; i++)
+        if (constantA == 1)
         {
-            float* ptr = A.row(i);
-            for (int j = 0; j < A.w; j++)
-            {
-                ptr[j] = A0[j * A0_hstep + i];
-            }
+            A_data_int8_scales = mb.load(constantM, 1);
+            if (A_data_int8_scales.empty())
+                return -100;
         }
-    }
-
-    Mat B;
-    if (transB == 0)
-    {
-        // transpose B to col-major
-        B.create((B0.dims == 3 ? B0.c : B0.h), B0.w, elemsize, opt.workspace_allocator);
 
-        const int B0_hstep = B0.dims == 3 ? (int)B0.cstep : B0.w;
-
-        for (int i = 0; i < B.h; i++)
+        if (constantB == 1)
         {
-            float* ptr = B.row(i);
-            for (int j = 0; j < B.w; j++)
-            {
-                ptr[j] = B0[j * B0_hstep + i];
-            }
+            B_data_int8_scales = mb.load(constantN, 1);
+            if (B_data_int8_scales.empty())
+                return -100;
         }
     }
-    else
-    {
-        B = B0;
-    }
+#endif // NCNN_INT8
 
-    const int M = A.dims == 3 ? A.c : A.h;
-    const int K = A.w; // assert A.w == B.w
-    const int N = B.dims == 3 ? B.c : B.h;
+    return 0;
+}
 
-    const float* ptrC = 0;
-    int broadcast_type_C = 0;
+void Gemm::resolve_C(const std::vector<Mat>& bottom_blobs, int M, int N, const float*& ptrC, int& broadcast_type_C) const
+{
+    ptrC = 0;
+    broadcast_type_C = 0;
     if (constantC)
     {
         ptrC = C_data;
@@ -241,6 +207,82 @@ int Gemm::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_bl
             }
         }
     }
+}
+
+int Gemm::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    std::vector<Mat> bottom_blobs(1, bottom_blob);
+    std::vector<Mat> top_blobs(1, top_blob);
+    int ret = forward(bottom_blobs, top_blobs, opt);
+    top_blob = top_blobs[0];
+    return ret;
+}
+
+int Gemm::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+#if NCNN_INT8
+    if (int8_scale_term)
+    {
+        return forward_int8(bottom_blobs, top_blobs, opt);
+    }
+#endif
+
+    const Mat& A0 = constantA ? A_data : bottom_blobs[0];
+    const Mat& B0 = constantB ? B_data : constantA ? bottom_blobs[0] : bottom_blobs[1];
+
+    size_t elemsize = A0.elemsize;
+
+    Mat A;
+    if (transA == 0)
+    {
+        A = A0;
+    }
+    else
+    {
+        // transpose A to row-major
+        A.create((A0.dims == 3 ? A0.c : A0.h), A0.w, elemsize, opt.workspace_allocator);
+
+        const int A0_hstep = A0.dims == 3 ? (int)A0.cstep : A0.w;
+
+        for (int i = 0; i < A.h; i++)
+        {
+            float* ptr = A.row(i);
+            for (int j = 0; j < A.w; j++)
+            {
+                ptr[j] = A0[j * A0_hstep + i];
+            }
+        }
+    }
+
+    Mat B;
+    if (transB == 0)
+    {
+        // transpose B to col-major
+        B.create((B0.dims == 3 ? B0.c : B0.h), B0.w, elemsize, opt.workspace_allocator);
+
+        const int B0_hstep = B0.dims == 3 ? (int)B0.cstep : B0.w;
+
+        for (int i = 0; i < B.h; i++)
+        {
+            float* ptr = B.row(i);
+            for (int j = 0; j < B.w; j++)
+            {
+                ptr[j] = B0[j * B0_hstep + i];
+            }
+        }
+    }
+    else
+    {
+        B = B0;
+    }
+
+    const int M = A.dims == 3 ? A.c : A.h;
+    const int K = A.w; // assert A.w == B.w
+    const int N = B.dims == 3 ? B.c : B.h;
+
+    const float* ptrC = 0;
+    int broadcast_type_C = 0;
+    resolve_C(bottom_blobs, M, N, ptrC, broadcast_type_C);
 
     Mat& top_blob = top_blobs[0];
     if (output_transpose)
@@ -322,4 +364,183 @@ int Gemm::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_bl
     return 0;
 }
 
+#if NCNN_INT8
+static inline signed char float2int8(float v)
+{
+    int int32 = static_cast<int>(round(v));
+    if (int32 > 127) return 127;
+    if (int32 < -127) return -127;
+    return (signed char)int32;
+}
+
+// quantize the rows of X to int8 rows along K
+// X is (K, rows) when trans == 0, or (rows, K) when trans == 1
+// use the given scales, or the absmax of each row when scales is empty
+static int gemm_quantize_int8(const Mat& X, int trans, const Mat& scales, Mat& XT, Mat& XT_scales, const Option& opt)
+{
+    const int X_h = X.dims == 3 ? X.c : X.h;
+    const int X_hstep = X.dims == 3 ? (int)X.cstep : X.w;
+
+    const int rows = trans ? X.w : X_h;
+    const int K = trans ? X_h : X.w;
+
+    XT.create(K, rows, (size_t)1u, opt.workspace_allocator);
+    if (XT.empty())
+        return -100;
+
+    if (X.elemsize == 1u)
+    {
+        // already int8
+        for (int i = 0; i < rows; i++)
+        {
+            signed char* outptr = XT.row<signed char>(i);
+            for (int k = 0; k < K; k++)
+            {
+                outptr[k] = trans ? ((const signed char*)X.data)[k * X_hstep + i] : ((const signed char*)X.data)[i * X_hstep + k];
+            }
+        }
+
+        XT_scales = scales;
+        return 0;
+    }
+
+    if (scales.empty())
+    {
+        XT_scales.create(rows, (size_t)4u, opt.workspace_allocator);
+        if (XT_scales.empty())
+            return -100;
+
+        for (int i = 0; i < rows; i++)
+        {
+            float absmax = 0.f;
+            for (int k = 0; k < K; k++)
+            {
+                const float v = trans ? X[k * X_hstep + i] : X[i * X_hstep + k];
+                absmax = std::max(absmax, (float)fabs(v));
+            }
+
+            XT_scales[i] = absmax == 0.f ? 1.f : 127.f / absmax;
+        }
+    }
+    else
+    {
+        XT_scales = scales;
+    }
+
+    for (int i = 0; i < rows; i++)
+    {
+        signed char* outptr = XT.row<signed char>(i);
+        const float scale = XT_scales[i];
+
+        for (int k = 0; k < K; k++)
+        {
+            const float v = trans ? X[k * X_hstep + i] : X[i * X_hstep + k];
+            outptr[k] = float2int8(v * scale);
+        }
+    }
+
+    return 0;
+}
+
+int Gemm::forward_int8(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const Mat& A0 = constantA ? A_data : bottom_blobs[0];
+    const Mat& B0 = constantB ? B_data : constantA ? bottom_blobs[0] : bottom_blobs[1];
+
+    // constant side uses the stored scales, the other side is quantized on the fly per row
+    Mat AT;
+    Mat AT_scales;
+    int ret = gemm_quantize_int8(A0, transA, constantA ? A_data_int8_scales : Mat(), AT, AT_scales, opt);
+    if (ret != 0)
+        return ret;
+
+    Mat BT;
+    Mat BT_scales;
+    ret = gemm_quantize_int8(B0, transB ? 0 : 1, constantB ? B_data_int8_scales : Mat(), BT, BT_scales, opt);
+    if (ret != 0)
+        return ret;
+
+    const int M = AT.h;
+    const int K = AT.w; // assert AT.w == BT.w
+    const int N = BT.h;
+
+    const float* ptrC = 0;
+    int broadcast_type_C = 0;
+    resolve_C(bottom_blobs, M, N, ptrC, broadcast_type_C);
+
+    Mat& top_blob = top_blobs[0];
+    if (output_transpose)
+    {
+        if (output_N1M)
+            top_blob.create(M, 1, N, 4u, opt.blob_allocator);
+        else
+            top_blob.create(M, N, 4u, opt.blob_allocator);
+    }
+    else
+    {
+        if (output_N1M)
+            top_blob.create(N, 1, M, 4u, opt.blob_allocator);
+        else
+            top_blob.create(N, M, 4u, opt.blob_allocator);
+    }
+    if (top_blob.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int i = 0; i < M; i++)
+    {
+        const int out_hstep = top_blob.dims == 3 ? (int)top_blob.cstep : top_blob.w;
+
+        const signed char* ptrA = AT.row<const signed char>(i);
+
+        for (int j = 0; j < N; j++)
+        {
+            const signed char* ptrB = BT.row<const signed char>(j);
+
+            int sum_int = 0;
+            for (int k = 0; k < K; k++)
+            {
+                sum_int += ptrA[k] * ptrB[k];
+            }
+
+            // dequantize
+            float sum = sum_int / (AT_scales[i] * BT_scales[j]);
+
+            if (ptrC)
+            {
+                if (broadcast_type_C == 0)
+                {
+                    sum += ptrC[0] * beta;
+                }
+                if (broadcast_type_C == 1 || broadcast_type_C == 2)
+                {
+                    sum += ptrC[i] * beta;
+                }
+                if (broadcast_type_C == 3)
+                {
+                    sum += ptrC[i * N + j] * beta;
+                }
+                if (broadcast_type_C == 4)
+                {
+                    sum += ptrC[j] * beta;
+                }
+            }
+
+            sum *= alpha;
+
+            if (output_transpose)
+            {
+                top_blob[j * out_hstep + i] = sum;
+            }
+            else
+            {
+                top_blob[i * out_hstep + j] = sum;
+            }
+        }
+    }
+
+    return 0;
+}
+#endif // NCNN_INT8
+
 } // namespace ncnn
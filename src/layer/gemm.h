@@ -32,6 +32,13 @@ public:
 
     virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
 
+protected:
+    void resolve_C(const std::vector<Mat>& bottom_blobs, int M, int N, const float*& ptrC, int& broadcast_type_C) const;
+
+#if NCNN_INT8
+    int forward_int8(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
+#endif
+
 public:
     float alpha;
     float beta;
@@ -50,6 +57,8 @@ public:
     int output_elemtype; // 0=auto 1=fp32
     int output_transpose;
 
+    int int8_scale_term;
+
     int constant_TILE_M;
     int constant_TILE_N;
     int constant_TILE_K;
@@ -58,6 +67,12 @@ public:
     Mat A_data;
     Mat B_data;
     Mat C_data;
+
+#if NCNN_INT8
+    // per M for constant A, per N for constant B
+    Mat A_data_int8_scales;
+    Mat B_data_int8_scales;
+#endif
 };
 
 } // namespace ncnn
@@ -0,0 +1,176 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef KERNEL_CACHE_H
+#define KERNEL_CACHE_H
+
+#include "platform.h"
+
+#include <vector>
+
+namespace ncnn {
+
+// kernel choice of a layer remembered per input shape
+// key and value are four ints each, their meaning is up to the layer
+// autotuning fills the cache under its lock, a loaded profile freezes it
+// a frozen cache is read only and looked up without lock
+// at most max_entry_count shapes are kept, a new shape replaces the oldest one beyond that
+class KernelCache
+{
+public:
+    enum
+    {
+        max_entry_count = 64
+    };
+
+    KernelCache()
+        : frozen(false), next_replace(0)
+    {
+    }
+
+    // return 0 and fill value if key has been seen, -1 otherwise
+    int find(const int* key, int* value) const
+    {
+        if (frozen)
+            return find_entry(key, value);
+
+        MutexLockGuard guard(lock);
+        return find_entry(key, value);
+    }
+
+    void insert(const int* key, const int* value)
+    {
+        if (frozen)
+            return;
+
+        MutexLockGuard guard(lock);
+
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            int* p = entries[i].data;
+            if (p[0] == key[0] && p[1] == key[1] && p[2] == key[2] && p[3] == key[3])
+            {
+                p[4] = value[0];
+                p[5] = value[1];
+                p[6] = value[2];
+                p[7] = value[3];
+                return;
+            }
+        }
+
+        Entry entry;
+        for (int j = 0; j < 4; j++)
+        {
+            entry.data[j] = key[j];
+            entry.data[4 + j] = value[j];
+        }
+
+        if ((int)entries.size() < max_entry_count)
+        {
+            entries.push_back(entry);
+            return;
+        }
+
+        // dynamic shapes would grow the cache without bound
+        entries[next_replace] = entry;
+        next_replace = (next_replace + 1) % max_entry_count;
+    }
+
+    // return true if any key maps to a value starting with value0
+    bool has_value(int value0) const
+    {
+        MutexLockGuard guard(lock);
+
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            if (entries[i].data[4] == value0)
+                return true;
+        }
+
+        return false;
+    }
+
+    // flatten to eight ints per entry, key followed by value
+    void save(std::vector<int>& data) const
+    {
+        MutexLockGuard guard(lock);
+
+        data.resize(entries.size() * 8);
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            for (int j = 0; j < 8; j++)
+            {
+                data[i * 8 + j] = entries[i].data[j];
+            }
+        }
+    }
+
+    // load entries and freeze, call before inference
+    void load(const std::vector<int>& data)
+    {
+        for (size_t i = 0; i + 8 <= data.size(); i += 8)
+        {
+            insert(&data[i], &data[i + 4]);
+        }
+
+        frozen = true;
+    }
+
+    bool is_frozen() const
+    {
+        return frozen;
+    }
+
+    void clear()
+    {
+        MutexLockGuard guard(lock);
+        entries.clear();
+        frozen = false;
+        next_replace = 0;
+    }
+
+private:
+    int find_entry(const int* key, int* value) const
+    {
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            const int* p = entries[i].data;
+            if (p[0] == key[0] && p[1] == key[1] && p[2] == key[2] && p[3] == key[3])
+            {
+                value[0] = p[4];
+                value[1] = p[5];
+                value[2] = p[6];
+                value[3] = p[7];
+                return 0;
+            }
+        }
+
+        return -1;
+    }
+
+    struct Entry
+    {
+        int data[8];
+    };
+
+    bool frozen;
+    int next_replace;
+
+    mutable Mutex lock;
+    std::vector<Entry> entries;
+};
+
+} // namespace ncnn
+
+#endif // KERNEL_CACHE_H
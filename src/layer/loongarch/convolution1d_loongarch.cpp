@@ -314,6 +314,9 @@ int Convolution1D_loongarch::forward(const Mat& bottom_blob, Mat& top_blob, cons
 
 int Convolution1D_loongarch::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
+    if (streaming)
+        return forward_streaming(bottom_blobs, top_blobs, opt);
+
     const Mat& bottom_blob = bottom_blobs[0];
     const Mat& _weight_data = bottom_blobs[1];
     Mat& top_blob = top_blobs[0];
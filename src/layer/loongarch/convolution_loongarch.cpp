@@ -559,6 +559,9 @@ int Convolution_loongarch::forward(const Mat& bottom_blob, Mat& top_blob, const
 
 int Convolution_loongarch::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
+    if (residual)
+        return Convolution::forward(bottom_blobs, top_blobs, opt);
+
     const Mat& bottom_blob = bottom_blobs[0];
     const Mat& _weight_data = bottom_blobs[1];
     Mat& top_blob = top_blobs[0];
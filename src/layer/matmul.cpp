@@ -25,6 +25,15 @@ MatMul::MatMul()
 int MatMul::load_param(const ParamDict& pd)
 {
     transB = pd.get(0, 0);
+    int8_scale_term = pd.get(18, 0);
+
+    if (int8_scale_term)
+    {
+#if !NCNN_INT8
+        NCNN_LOGE("please build ncnn with NCNN_INT8 enabled for int8 inference");
+        return -1;
+#endif
+    }
 
     return 0;
 }
@@ -48,8 +57,95 @@ static void transpose(const Mat& X, Mat& XT, const Option& opt)
     }
 }
 
-static void matmul_transb(const Mat& A, const Mat& B, Mat& top_blob, const Option& opt)
+#if NCNN_INT8
+static inline signed char float2int8(float v)
+{
+    int int32 = static_cast<int>(round(v));
+    if (int32 > 127) return 127;
+    if (int32 < -127) return -127;
+    return (signed char)int32;
+}
+
+// dynamic quantize each row
+static void matmul_quantize_rows(const Mat& X, Mat& X_int8, Mat& X_int8_scales)
+{
+    const int K = X.w;
+
+    for (int i = 0; i < X.h; i++)
+    {
+        const float* ptr = X.row(i);
+
+        float absmax = 0.f;
+        for (int k = 0; k < K; k++)
+        {
+            absmax = std::max(absmax, (float)fabs(ptr[k]));
+        }
+
+        const float scale = absmax == 0.f ? 1.f : 127.f / absmax;
+        X_int8_scales[i] = scale;
+
+        signed char* outptr = X_int8.row<signed char>(i);
+        for (int k = 0; k < K; k++)
+        {
+            outptr[k] = float2int8(ptr[k] * scale);
+        }
+    }
+}
+
+static int matmul_transb_int8(const Mat& A, const Mat& B, Mat& top_blob, const Option& opt)
+{
+    const int M = A.h;
+    const int K = A.w; // assert A.w == B.w
+    const int N = B.h;
+
+    Mat A_int8(K, M, (size_t)1u, opt.workspace_allocator);
+    Mat A_int8_scales(M, (size_t)4u, opt.workspace_allocator);
+    Mat B_int8(K, N, (size_t)1u, opt.workspace_allocator);
+    Mat B_int8_scales(N, (size_t)4u, opt.workspace_allocator);
+    if (A_int8.empty() || A_int8_scales.empty() || B_int8.empty() || B_int8_scales.empty())
+        return -100;
+
+    matmul_quantize_rows(A, A_int8, A_int8_scales);
+    matmul_quantize_rows(B, B_int8, B_int8_scales);
+
+    float* pOut = top_blob;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int i = 0; i < M; i++)
+    {
+        const signed char* ptrA = A_int8.row<const signed char>(i);
+        float* outptr = pOut + i * N;
+
+        for (int j = 0; j < N; j++)
+        {
+            const signed char* ptrB = B_int8.row<const signed char>(j);
+
+            int sum = 0;
+            for (int k = 0; k < K; k++)
+            {
+                sum += ptrA[k] * ptrB[k];
+            }
+
+            *outptr++ = sum / (A_int8_scales[i] * B_int8_scales[j]);
+        }
+    }
+
+    return 0;
+}
+#endif // NCNN_INT8
+
+static void matmul_transb(const Mat& A, const Mat& B, Mat& top_blob, int int8_scale_term, const Option& opt)
 {
+#if NCNN_INT8
+    if (int8_scale_term)
+    {
+        matmul_transb_int8(A, B, top_blob, opt);
+        return;
+    }
+#else
+    (void)int8_scale_term;
+#endif
+
     const int M = A.h;
     const int K = A.w; // assert A.w == B.w
     const int N = B.h;
@@ -97,6 +193,14 @@ int MatMul::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_
         if (top_blob.empty())
             return -100;
 
+#if NCNN_INT8
+        if (int8_scale_term)
+        {
+            matmul_transb(A.reshape(A.w, 1), B.reshape(B.w, 1), top_blob, int8_scale_term, opt);
+            return 0;
+        }
+#endif
+
         const int K = A.w; // assert A.w == B.w
         const float* ptrA = A;
         const float* ptrB = B;
@@ -133,7 +237,7 @@ int MatMul::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_
             BT = B;
         }
 
-        matmul_transb(A, BT, top_blob, opt);
+        matmul_transb(A, BT, top_blob, int8_scale_term, opt);
     }
     else if (Adims == 1 && Bdims == 2)
     {
@@ -160,7 +264,7 @@ int MatMul::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_
             BT = B;
         }
 
-        matmul_transb(A1, BT, top_blob1, opt);
+        matmul_transb(A1, BT, top_blob1, int8_scale_term, opt);
 
         top_blob = top_blob1.reshape(N);
     }
@@ -175,7 +279,7 @@ int MatMul::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_
 
         Mat BT = B.reshape(B.w, 1);
 
-        matmul_transb(A, BT, top_blob1, opt);
+        matmul_transb(A, BT, top_blob1, int8_scale_term, opt);
 
         top_blob = top_blob1.reshape(M);
     }
@@ -209,7 +313,7 @@ int MatMul::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_
             }
 
             Mat top_blob1_p = top_blob1.channel(p);
-            matmul_transb(A1, BT, top_blob1_p, opt);
+            matmul_transb(A1, BT, top_blob1_p, int8_scale_term, opt);
         }
 
         if (Bdims == 3)
@@ -233,7 +337,7 @@ int MatMul::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_
         for (int p = 0; p < batch_size; p++)
         {
             Mat top_blob1_p = top_blob1.channel(p);
-            matmul_transb(A1.channel(p), BT, top_blob1_p, opt);
+            matmul_transb(A1.channel(p), BT, top_blob1_p, int8_scale_term, opt);
         }
 
         if (Adims == 3)
@@ -298,7 +402,7 @@ int MatMul::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_
             }
 
             Mat top_blob_p = top_blob.channel(p);
-            matmul_transb(A1.channel(Ap), BT, top_blob_p, opt);
+            matmul_transb(A1.channel(Ap), BT, top_blob_p, int8_scale_term, opt);
         }
     }
     else if (max_ABdims == 4)
@@ -385,7 +489,7 @@ int MatMul::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_
                 }
 
                 Mat top_blob_p_q = top_blob.channel(p).depth(q);
-                matmul_transb(A1.channel(Ap).depth(Ad), BT, top_blob_p_q, opt);
+                matmul_transb(A1.channel(Ap).depth(Ad), BT, top_blob_p_q, int8_scale_term, opt);
             }
         }
     }
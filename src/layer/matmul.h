@@ -30,6 +30,7 @@ public:
 
 public:
     int transB;
+    int int8_scale_term;
 };
 
 } // namespace ncnn
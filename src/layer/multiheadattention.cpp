@@ -31,6 +31,16 @@ int MultiHeadAttention::load_param(const ParamDict& pd)
     vdim = pd.get(4, embed_dim);
     attn_mask = pd.get(5, 0);
     scale = pd.get(6, 1.f / sqrtf(embed_dim / num_heads));
+    kv_cache = pd.get(7, 0);
+    int8_scale_term = pd.get(18, 0);
+
+    if (int8_scale_term)
+    {
+#if !NCNN_INT8
+        NCNN_LOGE("please build ncnn with NCNN_INT8 enabled for int8 inference");
+        return -1;
+#endif
+    }
 
     return 0;
 }
@@ -71,19 +81,94 @@ int MultiHeadAttention::load_model(const ModelBin& mb)
     if (out_bias_data.empty())
         return -100;
 
+#if NCNN_INT8
+    if (int8_scale_term)
+    {
+        q_weight_data_int8_scales = mb.load(embed_dim, 1);
+        k_weight_data_int8_scales = mb.load(embed_dim, 1);
+        v_weight_data_int8_scales = mb.load(embed_dim, 1);
+        out_weight_data_int8_scales = mb.load(qdim, 1);
+    }
+#endif // NCNN_INT8
+
     return 0;
 }
 
+#if NCNN_INT8
+static inline signed char float2int8(float v)
+{
+    int int32 = static_cast<int>(round(v));
+    if (int32 > 127) return 127;
+    if (int32 < -127) return -127;
+    return (signed char)int32;
+}
+
+// out = dequantize(quantize(x) * weight^T) + bias
+// each row of x is quantized dynamically with its own absmax
+static int affine_int8(const Mat& x, const Mat& weight_data_int8, const Mat& weight_data_int8_scales, const Mat& bias_data, Mat& out, const Option& opt)
+{
+    const int size = x.w;
+    const int num_output = out.w;
+
+    Mat x_int8(size, x.h, (size_t)1u, opt.workspace_allocator);
+    if (x_int8.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int i = 0; i < x.h; i++)
+    {
+        const float* ptr = x.row(i);
+        signed char* xptr = x_int8.row<signed char>(i);
+
+        float absmax = 0.f;
+        for (int k = 0; k < size; k++)
+        {
+            absmax = std::max(absmax, (float)fabs(ptr[k]));
+        }
+
+        const float scale = absmax == 0.f ? 1.f : 127.f / absmax;
+
+        for (int k = 0; k < size; k++)
+        {
+            xptr[k] = float2int8(ptr[k] * scale);
+        }
+
+        float* outptr = out.row(i);
+
+        for (int j = 0; j < num_output; j++)
+        {
+            const signed char* kptr = (const signed char*)weight_data_int8 + size * j;
+
+            int sum = 0;
+            for (int k = 0; k < size; k++)
+            {
+                sum += xptr[k] * kptr[k];
+            }
+
+            outptr[j] = sum / (scale * weight_data_int8_scales[j]) + bias_data[j];
+        }
+    }
+
+    return 0;
+}
+#endif // NCNN_INT8
+
 // refers to https://pytorch.org/docs/stable/generated/torch.nn.MultiheadAttention.html
 int MultiHeadAttention::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
+    // the past xk and xv come last when kv_cache enabled
+    const size_t input_count = kv_cache ? bottom_blobs.size() - 2 : bottom_blobs.size();
+
     const Mat& q_blob = bottom_blobs[0];
-    const Mat& k_blob = (bottom_blobs.size() == 1 || (bottom_blobs.size() == 2 && attn_mask)) ? q_blob : bottom_blobs[1];
-    const Mat& v_blob = (bottom_blobs.size() == 1 || (bottom_blobs.size() == 2 && attn_mask)) ? q_blob : (bottom_blobs.size() == 2 || (bottom_blobs.size() == 3 && attn_mask)) ? k_blob : bottom_blobs[2];
-    const Mat& attn_mask_blob = attn_mask ? bottom_blobs[bottom_blobs.size() - 1] : Mat();
+    const Mat& k_blob = (input_count == 1 || (input_count == 2 && attn_mask)) ? q_blob : bottom_blobs[1];
+    const Mat& v_blob = (input_count == 1 || (input_count == 2 && attn_mask)) ? q_blob : (input_count == 2 || (input_count == 3 && attn_mask)) ? k_blob : bottom_blobs[2];
+    const Mat& attn_mask_blob = attn_mask ? bottom_blobs[input_count - 1] : Mat();
+    const Mat& past_xk_blob = kv_cache ? bottom_blobs[input_count] : Mat();
+    const Mat& past_xv_blob = kv_cache ? bottom_blobs[input_count + 1] : Mat();
 
+    const int past_seqlen = past_xk_blob.empty() ? 0 : past_xk_blob.w;
     const int src_seqlen = q_blob.h;
-    const int dst_seqlen = k_blob.h;
+    const int dst_seqlen = past_seqlen + k_blob.h;
     const int embed_dim_per_head = embed_dim / num_heads;
     const int qdim = weight_data_size / embed_dim;
 
@@ -112,6 +197,33 @@ int MultiHeadAttention::forward(const std::vector<Mat>& bottom_blobs, std::vecto
     if (xqkv.empty())
         return -100;
 
+#if NCNN_INT8
+    // the int8 projections of q, k and v, sliced per head below
+    Mat q_affine;
+    Mat k_affine;
+    Mat v_affine;
+    if (int8_scale_term)
+    {
+        q_affine.create(embed_dim, src_seqlen, 4u, opt.workspace_allocator);
+        k_affine.create(embed_dim, k_blob.h, 4u, opt.workspace_allocator);
+        v_affine.create(embed_dim, v_blob.h, 4u, opt.workspace_allocator);
+        if (q_affine.empty() || k_affine.empty() || v_affine.empty())
+            return -100;
+
+        int ret = affine_int8(q_blob, q_weight_data, q_weight_data_int8_scales, q_bias_data, q_affine, opt);
+        if (ret != 0)
+            return ret;
+
+        ret = affine_int8(k_blob, k_weight_data, k_weight_data_int8_scales, k_bias_data, k_affine, opt);
+        if (ret != 0)
+            return ret;
+
+        ret = affine_int8(v_blob, v_weight_data, v_weight_data_int8_scales, v_bias_data, v_affine, opt);
+        if (ret != 0)
+            return ret;
+    }
+#endif // NCNN_INT8
+
     #pragma omp parallel for num_threads(opt.num_threads)
     for (int q = 0; q < num_heads; q++)
     {
@@ -125,6 +237,14 @@ int MultiHeadAttention::forward(const std::vector<Mat>& bottom_blobs, std::vecto
 
                 for (int j = 0; j < embed_dim_per_head; j++)
                 {
+#if NCNN_INT8
+                    if (int8_scale_term)
+                    {
+                        outptr[j] = q_affine.row(i)[q * embed_dim_per_head + j] * scale;
+                        continue;
+                    }
+#endif
+
                     const float* ptr = q_blob.row(i);
                     const float* kptr = (const float*)q_weight_data + qdim * (q * embed_dim_per_head + j);
 
@@ -139,17 +259,35 @@ int MultiHeadAttention::forward(const std::vector<Mat>& bottom_blobs, std::vecto
             }
         }
 
-        // xk = affine(k)
+        // xk = concat(past_xk, affine(k))
         {
             Mat outm = xk.channel(q);
 
-            for (int i = 0; i < dst_seqlen; i++)
+            for (int i = 0; i < past_seqlen; i++)
             {
                 float* outptr = outm.row(i);
 
                 for (int j = 0; j < embed_dim_per_head; j++)
                 {
-                    const float* ptr = k_blob.row(i);
+                    outptr[j] = past_xk_blob.row(q * embed_dim_per_head + j)[i];
+                }
+            }
+
+            for (int i = past_seqlen; i < dst_seqlen; i++)
+            {
+                float* outptr = outm.row(i);
+
+                for (int j = 0; j < embed_dim_per_head; j++)
+                {
+#if NCNN_INT8
+                    if (int8_scale_term)
+                    {
+                        outptr[j] = k_affine.row(i - past_seqlen)[q * embed_dim_per_head + j];
+                        continue;
+                    }
+#endif
+
+                    const float* ptr = k_blob.row(i - past_seqlen);
                     const float* kptr = (const float*)k_weight_data + kdim * (q * embed_dim_per_head + j);
 
                     float sum = k_bias_data[q * embed_dim_per_head + j];
@@ -163,15 +301,28 @@ int MultiHeadAttention::forward(const std::vector<Mat>& bottom_blobs, std::vecto
             }
         }
 
-        // xv = affine(v)
+        // xv = concat(past_xv, affine(v))
         {
             Mat outm = xv.channel(q);
 
             for (int i = 0; i < embed_dim_per_head; i++)
             {
-                for (int j = 0; j < dst_seqlen; j++)
+                if (past_seqlen > 0)
+                {
+                    memcpy(outm.row(i), past_xv_blob.row(q * embed_dim_per_head + i), past_seqlen * sizeof(float));
+                }
+
+                for (int j = past_seqlen; j < dst_seqlen; j++)
                 {
-                    const float* ptr = v_blob.row(j);
+#if NCNN_INT8
+                    if (int8_scale_term)
+                    {
+                        outm.row(i)[j] = v_affine.row(j - past_seqlen)[q * embed_dim_per_head + i];
+                        continue;
+                    }
+#endif
+
+                    const float* ptr = v_blob.row(j - past_seqlen);
                     const float* kptr = (const float*)v_weight_data + vdim * (q * embed_dim_per_head + i);
 
                     float sum = v_bias_data[q * embed_dim_per_head + i];
@@ -293,23 +444,71 @@ int MultiHeadAttention::forward(const std::vector<Mat>& bottom_blobs, std::vecto
 
     // out = affine(xqkv)
     // xqkv  (embed_dim, src_seqlen)
-    #pragma omp parallel for num_threads(opt.num_threads)
-    for (int i = 0; i < src_seqlen; i++)
+#if NCNN_INT8
+    if (int8_scale_term)
     {
-        float* outptr = top_blob.row(i);
+        Mat xqkv2 = xqkv.reshape(embed_dim, src_seqlen, opt.workspace_allocator);
+        if (xqkv2.empty())
+            return -100;
 
-        for (int j = 0; j < qdim; j++)
+        int ret = affine_int8(xqkv2, out_weight_data, out_weight_data_int8_scales, out_bias_data, top_blob, opt);
+        if (ret != 0)
+            return ret;
+    }
+    else
+#endif // NCNN_INT8
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i = 0; i < src_seqlen; i++)
         {
-            const float* ptr = xqkv.channel(i);
-            const float* kptr = (const float*)out_weight_data + embed_dim * j;
+            float* outptr = top_blob.row(i);
 
-            float sum = out_bias_data[j];
-            for (int k = 0; k < embed_dim; k++)
+            for (int j = 0; j < qdim; j++)
             {
-                sum += *ptr++ * *kptr++;
+                const float* ptr = xqkv.channel(i);
+                const float* kptr = (const float*)out_weight_data + embed_dim * j;
+
+                float sum = out_bias_data[j];
+                for (int k = 0; k < embed_dim; k++)
+                {
+                    sum += *ptr++ * *kptr++;
+                }
+
+                outptr[j] = sum;
             }
+        }
+    }
+
+    if (kv_cache)
+    {
+        // xk and xv of all heads, (dst_seqlen, embed_dim)
+        Mat& out_xk_blob = top_blobs[1];
+        out_xk_blob.create(dst_seqlen, embed_dim, 4u, opt.blob_allocator);
+        if (out_xk_blob.empty())
+            return -100;
+
+        Mat& out_xv_blob = top_blobs[2];
+        out_xv_blob.create(dst_seqlen, embed_dim, 4u, opt.blob_allocator);
+        if (out_xv_blob.empty())
+            return -100;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = 0; q < num_heads; q++)
+        {
+            const Mat xkm = xk.channel(q);
+            const Mat xvm = xv.channel(q);
+
+            for (int i = 0; i < embed_dim_per_head; i++)
+            {
+                float* outptr = out_xk_blob.row(q * embed_dim_per_head + i);
 
-            outptr[j] = sum;
+                for (int j = 0; j < dst_seqlen; j++)
+                {
+                    outptr[j] = xkm.row(j)[i];
+                }
+
+                memcpy(out_xv_blob.row(q * embed_dim_per_head + i), xvm.row(i), dst_seqlen * sizeof(float));
+            }
         }
     }
 
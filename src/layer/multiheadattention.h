@@ -38,6 +38,8 @@ public:
     int vdim;
     int attn_mask;
     float scale;
+    int kv_cache;
+    int int8_scale_term;
 
     Mat q_weight_data;
     Mat q_bias_data;
@@ -47,6 +49,13 @@ public:
     Mat v_bias_data;
     Mat out_weight_data;
     Mat out_bias_data;
+
+#if NCNN_INT8
+    Mat q_weight_data_int8_scales;
+    Mat k_weight_data_int8_scales;
+    Mat v_weight_data_int8_scales;
+    Mat out_weight_data_int8_scales;
+#endif
 };
 
 } // namespace ncnn
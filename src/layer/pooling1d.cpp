@@ -17,6 +17,7 @@
 #include "layer_type.h"
 
 #include <float.h>
+#include <string.h>
 
 namespace ncnn {
 
@@ -38,6 +39,23 @@ int Pooling1D::load_param(const ParamDict& pd)
     avgpool_count_include_pad = pd.get(6, 0);
     adaptive_pooling = pd.get(7, 0);
     out_w = pd.get(8, 0);
+    streaming = pd.get(20, 0);
+
+    if (streaming)
+    {
+        if (global_pooling || adaptive_pooling)
+        {
+            NCNN_LOGE("Pooling1D streaming with global or adaptive pooling is not supported");
+            return -1;
+        }
+
+        // the cached frames replace the padding
+        pad_left = 0;
+        pad_right = 0;
+        pad_mode = 1;
+
+        one_blob_only = false;
+    }
 
     return 0;
 }
@@ -262,6 +280,101 @@ int Pooling1D::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
     return 0;
 }
 
+int Pooling1D::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    if (streaming)
+        return forward_streaming(bottom_blobs, top_blobs, opt);
+
+    return Layer::forward(bottom_blobs, top_blobs, opt);
+}
+
+int Pooling1D::forward_streaming(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const Mat& bottom_blob = bottom_blobs[0];
+    const Mat& cache = bottom_blobs[1];
+    Mat& top_blob = top_blobs[0];
+    Mat& top_cache = top_blobs[1];
+
+    const int w = bottom_blob.w;
+    const int h = bottom_blob.h;
+    const size_t elemsize = bottom_blob.elemsize;
+    const int elempack = bottom_blob.elempack;
+
+    // the last kernel_w - 1 input frames of previous chunks
+    const int history_w = kernel_w - 1;
+
+    if (w % stride_w != 0)
+    {
+        NCNN_LOGE("Pooling1D streaming input width %d is not a multiple of stride %d", w, stride_w);
+        return -1;
+    }
+
+    if (!cache.empty() && (cache.w != history_w || cache.h != h || cache.elemsize != elemsize || cache.elempack != elempack))
+    {
+        NCNN_LOGE("Pooling1D streaming cache shape mismatch");
+        return -1;
+    }
+
+    Mat bottom_blob_joined = bottom_blob;
+    if (history_w > 0)
+    {
+        bottom_blob_joined.create(history_w + w, h, elemsize, elempack, opt.workspace_allocator);
+        if (bottom_blob_joined.empty())
+            return -100;
+
+        const size_t history_size = history_w * elemsize;
+        const size_t size = w * elemsize;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i = 0; i < h; i++)
+        {
+            unsigned char* outptr = bottom_blob_joined.row<unsigned char>(i);
+
+            if (cache.empty())
+            {
+                // start from zero history, or the lowest value for max pooling
+                const float v = pooling_type == PoolMethod_MAX ? -FLT_MAX : 0.f;
+                float* ptr = (float*)outptr;
+                for (int j = 0; j < history_w; j++)
+                {
+                    ptr[j] = v;
+                }
+            }
+            else
+            {
+                memcpy(outptr, cache.row<const unsigned char>(i), history_size);
+            }
+
+            memcpy(outptr + history_size, bottom_blob.row<const unsigned char>(i), size);
+        }
+    }
+
+    // no padding in streaming mode, one output for every stride frames
+    int ret = forward(bottom_blob_joined, top_blob, opt);
+    if (ret != 0)
+        return ret;
+
+    if (history_w > 0)
+    {
+        top_cache.create(history_w, h, elemsize, elempack, opt.blob_allocator);
+        if (top_cache.empty())
+            return -100;
+
+        const size_t history_size = history_w * elemsize;
+
+        for (int i = 0; i < h; i++)
+        {
+            memcpy(top_cache.row<unsigned char>(i), bottom_blob_joined.row<const unsigned char>(i) + w * elemsize, history_size);
+        }
+    }
+    else
+    {
+        top_cache = Mat();
+    }
+
+    return 0;
+}
+
 void Pooling1D::make_padding(const Mat& bottom_blob, Mat& bottom_blob_bordered, const Option& opt) const
 {
     int w = bottom_blob.w;
@@ -28,6 +28,8 @@ public:
 
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 
+    virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
+
     enum PoolMethod
     {
         PoolMethod_MAX = 0,
@@ -37,6 +39,8 @@ public:
 protected:
     void make_padding(const Mat& bottom_blob, Mat& bottom_blob_bordered, const Option& opt) const;
 
+    int forward_streaming(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
+
 public:
     // param
     int pooling_type;
@@ -49,6 +53,9 @@ public:
     int avgpool_count_include_pad;
     int adaptive_pooling;
     int out_w;
+
+    // take the cached tail of previous input as the 2nd input, output the new tail as the 2nd output
+    int streaming;
 };
 
 } // namespace ncnn
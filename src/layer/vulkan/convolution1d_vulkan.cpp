@@ -33,7 +33,7 @@ int Convolution1D_vulkan::load_param(const ParamDict& pd)
 {
     int ret = Convolution1D::load_param(pd);
 
-    if (dynamic_weight)
+    if (dynamic_weight || streaming)
     {
         support_vulkan = false;
         support_image_storage = false;
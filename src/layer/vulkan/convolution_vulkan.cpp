@@ -47,7 +47,7 @@ int Convolution_vulkan::load_param(const ParamDict& pd)
 {
     int ret = Convolution::load_param(pd);
 
-    if (dynamic_weight)
+    if (dynamic_weight || residual)
     {
         support_vulkan = false;
         support_image_storage = false;
@@ -0,0 +1,256 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#if NCNN_RUNTIME_CPU && NCNN_AMXBF16 && __AVX512F__ && !__AMX_BF16__
+int convolution_im2col_gemm_bf16s_amxbf16(const Mat& bottom_blob, Mat& top_blob, const Mat& BT, const Mat& bias_data, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, int activation_type, const Mat& activation_params, const Option& opt);
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX512BF16 && __AVX512F__ && !__AVX512BF16__
+int convolution_im2col_gemm_bf16s_avx512bf16(const Mat& bottom_blob, Mat& top_blob, const Mat& BT, const Mat& bias_data, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, int activation_type, const Mat& activation_params, const Option& opt);
+#endif
+
+static void convolution_im2col_gemm_transform_kernel_bf16s(const Mat& kernel, Mat& BT, int inch, int outch, int kernel_w, int kernel_h, const Option& opt)
+{
+    // kernel = maxk-inch-outch, one output channel per row along K
+    const int maxk = kernel_w * kernel_h;
+
+    gemm_bf16s_pack_B(kernel.reshape(maxk * inch, outch), 0, BT, (Allocator*)0, opt);
+}
+
+static void convolution_im2col_input_tile_bf16s(const Mat& bottom_blob, Mat& AT, int i, int max_ii, int outw, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h)
+{
+    const int inch = bottom_blob.c;
+    const int maxk = kernel_w * kernel_h;
+    const int K = inch * maxk;
+    const int Kp = AT.w;
+
+    for (int ii = 0; ii < max_ii; ii++)
+    {
+        const int y = (i + ii) / outw;
+        const int x = (i + ii) % outw;
+
+        unsigned short* outptr = AT.row<unsigned short>(ii);
+
+        for (int p = 0; p < inch; p++)
+        {
+            const Mat img = bottom_blob.channel(p);
+
+            for (int u = 0; u < kernel_h; u++)
+            {
+                const unsigned short* sptr = img.row<const unsigned short>(y * stride_h + u * dilation_h) + x * stride_w;
+
+                for (int v = 0; v < kernel_w; v++)
+                {
+                    *outptr++ = sptr[v * dilation_w];
+                }
+            }
+        }
+
+        if (Kp != K)
+            *outptr = 0;
+    }
+}
+
+// activate the fp32 tile of max_ii rows and max_jj output channels starting at channel j
+// and store it into top_blob, j and max_jj are multiples of out_elempack, top_blob is bf16 or fp32
+static void convolution_im2col_gemm_store_tile_bf16s(float* tmp, int nr, Mat& top_blob, int i, int max_ii, int j, int max_jj, int activation_type, const Mat& activation_params)
+{
+    const int out_elempack = top_blob.elempack;
+    const size_t out_elemsize = top_blob.elemsize;
+    const bool output_fp32 = top_blob.elembits() == 32;
+
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    if (out_elempack == 16)
+    {
+        for (int jj = 0; jj < max_jj; jj += 16)
+        {
+            unsigned char* outptr = (unsigned char*)top_blob.channel((j + jj) / 16) + i * out_elemsize;
+
+            for (int ii = 0; ii < max_ii; ii++)
+            {
+                __m512 _v = activation_avx512(_mm512_loadu_ps(tmp + ii * nr + jj), activation_type, activation_params);
+                if (output_fp32)
+                    _mm512_storeu_ps((float*)outptr, _v);
+                else
+                    _mm256_storeu_si256((__m256i*)outptr, float2bfloat_avx512(_v));
+                outptr += out_elemsize;
+            }
+        }
+        return;
+    }
+#endif // __AVX512F__
+    if (out_elempack == 8)
+    {
+        for (int jj = 0; jj < max_jj; jj += 8)
+        {
+            unsigned char* outptr = (unsigned char*)top_blob.channel((j + jj) / 8) + i * out_elemsize;
+
+            for (int ii = 0; ii < max_ii; ii++)
+            {
+                __m256 _v = activation_avx(_mm256_loadu_ps(tmp + ii * nr + jj), activation_type, activation_params);
+                if (output_fp32)
+                    _mm256_storeu_ps((float*)outptr, _v);
+                else
+                    _mm_storeu_si128((__m128i*)outptr, float2bfloat_avx(_v));
+                outptr += out_elemsize;
+            }
+        }
+        return;
+    }
+#endif // __AVX__
+    if (out_elempack == 4)
+    {
+        for (int jj = 0; jj < max_jj; jj += 4)
+        {
+            unsigned char* outptr = (unsigned char*)top_blob.channel((j + jj) / 4) + i * out_elemsize;
+
+            for (int ii = 0; ii < max_ii; ii++)
+            {
+                __m128 _v = activation_sse(_mm_loadu_ps(tmp + ii * nr + jj), activation_type, activation_params);
+                if (output_fp32)
+                    _mm_storeu_ps((float*)outptr, _v);
+                else
+                    _mm_storel_epi64((__m128i*)outptr, float2bfloat_sse(_v, _v));
+                outptr += out_elemsize;
+            }
+        }
+        return;
+    }
+#endif // __SSE2__
+
+    // elempack 1, activate the tile rows in place and then scatter them along the output channels
+    for (int ii = 0; ii < max_ii; ii++)
+    {
+        float* ptr = tmp + ii * nr;
+
+        int jj = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+        for (; jj + 15 < max_jj; jj += 16)
+        {
+            _mm512_storeu_ps(ptr + jj, activation_avx512(_mm512_loadu_ps(ptr + jj), activation_type, activation_params));
+        }
+#endif // __AVX512F__
+        for (; jj + 7 < max_jj; jj += 8)
+        {
+            _mm256_storeu_ps(ptr + jj, activation_avx(_mm256_loadu_ps(ptr + jj), activation_type, activation_params));
+        }
+#endif // __AVX__
+        for (; jj + 3 < max_jj; jj += 4)
+        {
+            _mm_storeu_ps(ptr + jj, activation_sse(_mm_loadu_ps(ptr + jj), activation_type, activation_params));
+        }
+#endif // __SSE2__
+        for (; jj < max_jj; jj++)
+        {
+            ptr[jj] = activation_ss(ptr[jj], activation_type, activation_params);
+        }
+    }
+
+    for (int jj = 0; jj < max_jj; jj++)
+    {
+        if (output_fp32)
+        {
+            float* outptr = (float*)top_blob.channel(j + jj) + i;
+            for (int ii = 0; ii < max_ii; ii++)
+            {
+                outptr[ii] = tmp[ii * nr + jj];
+            }
+        }
+        else
+        {
+            unsigned short* outptr = (unsigned short*)top_blob.channel(j + jj) + i;
+            for (int ii = 0; ii < max_ii; ii++)
+            {
+                outptr[ii] = float32_to_bfloat16(tmp[ii * nr + jj]);
+            }
+        }
+    }
+}
+
+// bottom_blob is bordered bf16 with elempack 1, top_blob is bf16 or fp32 of any elempack
+static int convolution_im2col_gemm_bf16s(const Mat& bottom_blob, Mat& top_blob, const Mat& BT, const Mat& bias_data, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, int activation_type, const Mat& activation_params, const Option& opt)
+{
+#if NCNN_RUNTIME_CPU && NCNN_AMXBF16 && __AVX512F__ && !__AMX_BF16__
+    if (ncnn::cpu_support_x86_amx_bf16())
+    {
+        return convolution_im2col_gemm_bf16s_amxbf16(bottom_blob, top_blob, BT, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, activation_type, activation_params, opt);
+    }
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX512BF16 && __AVX512F__ && !__AVX512BF16__
+    if (ncnn::cpu_support_x86_avx512_bf16())
+    {
+        return convolution_im2col_gemm_bf16s_avx512bf16(bottom_blob, top_blob, BT, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, activation_type, activation_params, opt);
+    }
+#endif
+
+    const int inch = bottom_blob.c;
+    const int outw = top_blob.w;
+    const int outh = top_blob.h;
+    const int out_elempack = top_blob.elempack;
+    const int outch = top_blob.c * out_elempack;
+
+    const int maxk = kernel_w * kernel_h;
+    const int M = outw * outh;
+    const int Kp = (inch * maxk + 1) / 2 * 2;
+
+    const int nr = gemm_bf16s_get_nr();
+    const int nn_N = BT.h;
+
+    // keep the unfolded rows of each thread within half of l2 cache, and give every thread some rows
+    int TILE_M = (int)(get_cpu_level2_cache_size() / 2 / (Kp * sizeof(unsigned short)));
+    TILE_M = std::min(TILE_M, (M + opt.num_threads - 1) / opt.num_threads + 3);
+#if __AMX_BF16__
+    // whole amx tiles of 16 rows
+    TILE_M = std::max(16, std::min(TILE_M / 16 * 16, 64));
+#else
+    TILE_M = std::max(4, std::min(TILE_M / 4 * 4, 64));
+#endif
+
+    const int nn_M = (M + TILE_M - 1) / TILE_M;
+
+    Mat ATX(Kp, TILE_M, opt.num_threads, (size_t)2u, opt.workspace_allocator);
+    Mat CX(nr, TILE_M, opt.num_threads, (size_t)4u, opt.workspace_allocator);
+    if (ATX.empty() || CX.empty())
+        return -100;
+
+    const float* bias = bias_data.empty() ? 0 : (const float*)bias_data;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int ppi = 0; ppi < nn_M; ppi++)
+    {
+        const int i = ppi * TILE_M;
+        const int max_ii = std::min(M - i, TILE_M);
+
+        Mat AT = ATX.channel(get_omp_thread_num());
+        float* tmp = CX.channel(get_omp_thread_num());
+
+        convolution_im2col_input_tile_bf16s(bottom_blob, AT, i, max_ii, outw, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h);
+
+        for (int jb = 0; jb < nn_N; jb++)
+        {
+            gemm_bf16s_kernel(AT, BT, bias, tmp, nr, outch, 0, max_ii, jb, jb + 1);
+
+            const int max_jj = std::min(outch - jb * nr, nr);
+
+            convolution_im2col_gemm_store_tile_bf16s(tmp, nr, top_blob, i, max_ii, jb * nr, max_jj, activation_type, activation_params);
+        }
+    }
+
+    return 0;
+}
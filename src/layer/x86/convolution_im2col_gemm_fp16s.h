@@ -0,0 +1,154 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX512FP16 && __AVX512F__ && !__AVX512FP16__
+int convolution_im2col_gemm_fp16s_avx512fp16(const Mat& bottom_blob, Mat& top_blob, const Mat& BT, const Mat& bias_data, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, int activation_type, const Mat& activation_params, const Option& opt);
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_F16C && __AVX__ && !__F16C__
+int convolution_im2col_gemm_fp16s_f16c(const Mat& bottom_blob, Mat& top_blob, const Mat& BT, const Mat& bias_data, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, int activation_type, const Mat& activation_params, const Option& opt);
+#endif
+
+static void convolution_im2col_gemm_transform_kernel_fp16s(const Mat& kernel, Mat& BT, int inch, int outch, int kernel_w, int kernel_h, const Option& opt)
+{
+    // kernel = maxk-inch-outch, one output channel per row along K
+    const int maxk = kernel_w * kernel_h;
+
+    gemm_fp16s_pack_B(kernel.reshape(maxk * inch, outch), 0, BT, (Allocator*)0, opt);
+}
+
+static void convolution_im2col_input_tile_fp16s(const Mat& bottom_blob, Mat& AT, int i, int max_ii, int outw, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h)
+{
+    const int inch = bottom_blob.c;
+
+    for (int ii = 0; ii < max_ii; ii++)
+    {
+        const int y = (i + ii) / outw;
+        const int x = (i + ii) % outw;
+
+        float* outptr = AT.row(ii);
+
+        for (int p = 0; p < inch; p++)
+        {
+            const Mat img = bottom_blob.channel(p);
+
+            for (int u = 0; u < kernel_h; u++)
+            {
+                const float* sptr = img.row(y * stride_h + u * dilation_h) + x * stride_w;
+
+                for (int v = 0; v < kernel_w; v++)
+                {
+                    *outptr++ = sptr[v * dilation_w];
+                }
+            }
+        }
+    }
+}
+
+// bottom_blob is bordered fp32 with elempack 1, top_blob is fp16 or fp32 of any elempack
+static int convolution_im2col_gemm_fp16s(const Mat& bottom_blob, Mat& top_blob, const Mat& BT, const Mat& bias_data, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, int activation_type, const Mat& activation_params, const Option& opt)
+{
+#if NCNN_RUNTIME_CPU && NCNN_AVX512FP16 && __AVX512F__ && !__AVX512FP16__
+    if (ncnn::cpu_support_x86_avx512_fp16() && opt.use_fp16_arithmetic && opt.use_x86_fp16_arithmetic)
+    {
+        return convolution_im2col_gemm_fp16s_avx512fp16(bottom_blob, top_blob, BT, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, activation_type, activation_params, opt);
+    }
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_F16C && __AVX__ && !__F16C__
+    if (ncnn::cpu_support_x86_f16c())
+    {
+        return convolution_im2col_gemm_fp16s_f16c(bottom_blob, top_blob, BT, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, activation_type, activation_params, opt);
+    }
+
+    return -1;
+#else // NCNN_RUNTIME_CPU
+
+    const int inch = bottom_blob.c;
+    const int outw = top_blob.w;
+    const int outh = top_blob.h;
+    const int out_elempack = top_blob.elempack;
+    const int outch = top_blob.c * out_elempack;
+    const bool out_fp32 = top_blob.elemsize / out_elempack == 4u;
+    const bool fp16_arithmetic = opt.use_fp16_arithmetic && opt.use_x86_fp16_arithmetic;
+
+    const int maxk = kernel_w * kernel_h;
+    const int M = outw * outh;
+    const int K = inch * maxk;
+
+    const int nr = gemm_fp16s_get_nr();
+    const int nn_N = BT.h;
+
+    // keep the unfolded rows of each thread within half of l2 cache, and give every thread some rows
+    int TILE_M = (int)(get_cpu_level2_cache_size() / 2 / (K * sizeof(float)));
+    TILE_M = std::min(TILE_M, (M + opt.num_threads - 1) / opt.num_threads + 3);
+    TILE_M = std::max(4, std::min(TILE_M / 4 * 4, 64));
+
+    const int nn_M = (M + TILE_M - 1) / TILE_M;
+
+    Mat ATX(K, TILE_M, opt.num_threads, (size_t)4u, opt.workspace_allocator);
+    Mat CX(nr, TILE_M, opt.num_threads, (size_t)4u, opt.workspace_allocator);
+    if (ATX.empty() || CX.empty())
+        return -100;
+
+    const float* bias = bias_data.empty() ? 0 : (const float*)bias_data;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int ppi = 0; ppi < nn_M; ppi++)
+    {
+        const int i = ppi * TILE_M;
+        const int max_ii = std::min(M - i, TILE_M);
+
+        Mat AT = ATX.channel(get_omp_thread_num());
+        float* tmp = CX.channel(get_omp_thread_num());
+
+        convolution_im2col_input_tile_fp16s(bottom_blob, AT, i, max_ii, outw, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h);
+
+        for (int jb = 0; jb < nn_N; jb++)
+        {
+            gemm_fp16s_kernel(AT, BT, bias, tmp, nr, outch, 0, max_ii, jb, jb + 1, fp16_arithmetic);
+
+            const int max_jj = std::min(outch - jb * nr, nr);
+
+            for (int jj = 0; jj < max_jj; jj++)
+            {
+                const int q = jb * nr + jj;
+
+                if (out_fp32)
+                {
+                    float* outptr = (float*)top_blob.channel(q / out_elempack) + i * out_elempack + q % out_elempack;
+
+                    for (int ii = 0; ii < max_ii; ii++)
+                    {
+                        outptr[0] = activation_ss(tmp[ii * nr + jj], activation_type, activation_params);
+                        outptr += out_elempack;
+                    }
+                }
+                else
+                {
+                    unsigned short* outptr = (unsigned short*)top_blob.channel(q / out_elempack) + i * out_elempack + q % out_elempack;
+
+                    for (int ii = 0; ii < max_ii; ii++)
+                    {
+                        outptr[0] = float32_to_float16(activation_ss(tmp[ii * nr + jj], activation_type, activation_params));
+                        outptr += out_elempack;
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+#endif // NCNN_RUNTIME_CPU
+}
@@ -66,11 +66,27 @@ namespace ncnn {
 #endif // __AVX__
 #endif // __SSE2__
 
+#if NCNN_BF16
+#include "gemm_bf16s_kernel.h"
+#include "convolution_im2col_gemm_bf16s.h"
+#endif
+
+#if NCNN_F16C && __AVX__
+#include "gemm_fp16s_kernel.h"
+#include "convolution_im2col_gemm_fp16s.h"
+#endif
+
 Convolution_x86::Convolution_x86()
 {
 #if __SSE2__
     support_packing = true;
 #endif // __SSE2__
+#if NCNN_BF16
+    support_bf16_storage = true;
+#endif
+#if NCNN_F16C && __AVX__
+    support_fp16_storage = cpu_support_x86_f16c();
+#endif
 
     activation = 0;
     nT = 0;
@@ -277,10 +293,24 @@ static bool test_prefer_winograd23(int num_input, int num_output, int w, int h)
     return false;
 }
 
+// fp32 kernels, remembered per input shape
+enum
+{
+    KERNEL_WINOGRAD23 = 1,
+    KERNEL_WINOGRAD43 = 2,
+    KERNEL_WINOGRAD63 = 3,
+    KERNEL_SGEMM = 4,
+    KERNEL_PACKED = 5
+};
+
 int Convolution_x86::create_pipeline(const Option& opt)
 {
     if (dynamic_weight)
+    {
+        support_bf16_storage = false;
+        support_fp16_storage = false;
         return 0;
+    }
 
     activation = create_activation_layer(activation_type, activation_params, opt);
     nT = opt.num_threads;
@@ -288,10 +318,29 @@ int Convolution_x86::create_pipeline(const Option& opt)
 #if NCNN_INT8
     if (opt.use_int8_inference && weight_data.elemsize == (size_t)1u)
     {
+        support_bf16_storage = false;
+        support_fp16_storage = false;
         return create_pipeline_int8_x86(opt);
     }
 #endif
 
+#if NCNN_BF16
+    if (opt.use_bf16_storage)
+    {
+        return create_pipeline_bf16s(opt);
+    }
+#endif
+
+#if NCNN_F16C && __AVX__
+    if (cpu_support_x86_f16c() && opt.use_fp16_storage && opt.use_x86_fp16_storage)
+    {
+        return create_pipeline_fp16s(opt);
+    }
+
+    // x86 fp16 storage is opt-in, the packed fp32 kernels run on fp32 blobs
+    support_fp16_storage = false;
+#endif
+
     int kernel_size = kernel_w * kernel_h;
     int num_input = weight_data_size / kernel_size / num_output;
 
@@ -363,7 +412,17 @@ int Convolution_x86::create_pipeline(const Option& opt)
 
     if (opt.use_winograd_convolution && prefer_winograd && kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 1 && stride_h == 1)
     {
-        if ((bottom_shapes.empty() || bottom_shapes[0].w == 0 || bottom_shapes[0].h == 0) && (top_shapes.empty() || top_shapes[0].w == 0 || top_shapes[0].h == 0))
+        if (opt.use_kernel_autotune)
+        {
+            // every enabled variant is a candidate
+            if (opt.use_winograd23_convolution)
+                conv3x3s1_winograd23_transform_kernel(weight_data, weight_winograd23_data, num_input, num_output, opt);
+            if (opt.use_winograd43_convolution)
+                conv3x3s1_winograd43_transform_kernel(weight_data, weight_winograd43_data, num_input, num_output, opt);
+            if (opt.use_winograd63_convolution)
+                conv3x3s1_winograd63_transform_kernel(weight_data, weight_winograd63_data, num_input, num_output, opt);
+        }
+        else if ((bottom_shapes.empty() || bottom_shapes[0].w == 0 || bottom_shapes[0].h == 0) && (top_shapes.empty() || top_shapes[0].w == 0 || top_shapes[0].h == 0))
         {
             // dynamic shape
             if ((opt.use_winograd63_convolution) && (num_input <= 32 && num_output <= 32))
@@ -452,23 +511,37 @@ int Convolution_x86::create_pipeline(const Option& opt)
             }
         }
 
-        if (opt.lightmode)
-            weight_data.release();
+        // variants picked by a loaded kernel profile
+        if (opt.use_winograd23_convolution && weight_winograd23_data.empty() && kernel_cache.has_value(KERNEL_WINOGRAD23))
+            conv3x3s1_winograd23_transform_kernel(weight_data, weight_winograd23_data, num_input, num_output, opt);
+        if (opt.use_winograd43_convolution && weight_winograd43_data.empty() && kernel_cache.has_value(KERNEL_WINOGRAD43))
+            conv3x3s1_winograd43_transform_kernel(weight_data, weight_winograd43_data, num_input, num_output, opt);
+        if (opt.use_winograd63_convolution && weight_winograd63_data.empty() && kernel_cache.has_value(KERNEL_WINOGRAD63))
+            conv3x3s1_winograd63_transform_kernel(weight_data, weight_winograd63_data, num_input, num_output, opt);
 
-        return 0;
+        if (!opt.use_kernel_autotune && !kernel_cache.has_value(KERNEL_SGEMM) && !kernel_cache.has_value(KERNEL_PACKED))
+        {
+            if (opt.lightmode)
+                weight_data.release();
+
+            return 0;
+        }
     }
 
     int l2_cache_size = get_cpu_level2_cache_size();
     bool prefer_sgemm = num_input * num_output * kernel_w * kernel_h * dilation_w * dilation_h * stride_w * stride_h * (int)sizeof(float) * 2 > l2_cache_size || (num_input > 16 || num_output > 16);
 
-    if ((opt.use_sgemm_convolution && prefer_sgemm) || (kernel_w == 1 && kernel_h == 1))
+    if ((opt.use_sgemm_convolution && prefer_sgemm) || (kernel_w == 1 && kernel_h == 1) || opt.use_kernel_autotune || kernel_cache.has_value(KERNEL_SGEMM))
     {
         convolution_im2col_gemm_transform_kernel(weight_data, weight_sgemm_data, num_input, num_output, kernel_w, kernel_h, opt);
 
-        if (opt.lightmode)
-            weight_data.release();
+        if (!opt.use_kernel_autotune && !kernel_cache.has_value(KERNEL_PACKED))
+        {
+            if (opt.lightmode)
+                weight_data.release();
 
-        return 0;
+            return 0;
+        }
     }
 
     if ((elempack == 16 && out_elempack == 1 && kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 1 && stride_h == 1)
@@ -509,6 +582,122 @@ int Convolution_x86::destroy_pipeline(const Option& opt)
         convolution_dilation1 = 0;
     }
 
+    kernel_cache.clear();
+
+    return 0;
+}
+
+int Convolution_x86::save_pipeline_data(std::vector<Mat>& pipeline_data) const
+{
+    // dilation sub-layer keeps its own weight
+    if (dynamic_weight || convolution_dilation1)
+        return -1;
+
+    if (weight_data_tm.empty() && weight_sgemm_data.empty() && weight_winograd23_data.empty() && weight_winograd43_data.empty() && weight_winograd63_data.empty())
+        return -1;
+
+    pipeline_data.clear();
+    pipeline_data.push_back(weight_data_tm);
+    pipeline_data.push_back(weight_sgemm_data);
+    pipeline_data.push_back(weight_winograd23_data);
+    pipeline_data.push_back(weight_winograd43_data);
+    pipeline_data.push_back(weight_winograd63_data);
+#if NCNN_INT8
+    pipeline_data.push_back(scale_in_data);
+#endif
+
+    // the weight shape the data is transformed for
+    Mat weight_shape(4, (size_t)4u);
+    int* ps = weight_shape;
+    ps[0] = num_output;
+    ps[1] = weight_data_size;
+    ps[2] = kernel_w;
+    ps[3] = kernel_h;
+    pipeline_data.push_back(weight_shape);
+
+    return 0;
+}
+
+int Convolution_x86::load_pipeline_data(const std::vector<Mat>& pipeline_data, const Option& opt)
+{
+    if (dynamic_weight)
+        return -1;
+
+    if (!opt.use_packing_layout && kernel_w == kernel_h && dilation_w != 1 && dilation_h == dilation_w && stride_w == 1 && stride_h == 1)
+        return -1;
+
+#if NCNN_INT8
+    if (pipeline_data.size() != 7)
+        return -1;
+#else
+    if (pipeline_data.size() != 6)
+        return -1;
+#endif
+
+    const Mat& weight_shape = pipeline_data.back();
+    if (weight_shape.dims != 1 || weight_shape.w != 4 || weight_shape.elemsize != 4u)
+        return -1;
+
+    const int* ps = weight_shape;
+    if (ps[0] != num_output || ps[1] != weight_data_size || ps[2] != kernel_w || ps[3] != kernel_h)
+        return -1;
+
+    activation = create_activation_layer(activation_type, activation_params, opt);
+    nT = opt.num_threads;
+
+    weight_data_tm = pipeline_data[0];
+    weight_sgemm_data = pipeline_data[1];
+    weight_winograd23_data = pipeline_data[2];
+    weight_winograd43_data = pipeline_data[3];
+    weight_winograd63_data = pipeline_data[4];
+#if NCNN_INT8
+    scale_in_data = pipeline_data[5];
+
+    if (opt.use_int8_inference && int8_scale_term)
+    {
+        support_bf16_storage = false;
+        support_fp16_storage = false;
+    }
+#endif
+
+#if NCNN_F16C && __AVX__
+    if (!opt.use_x86_fp16_storage)
+        support_fp16_storage = false;
+#endif
+
+    if (opt.lightmode)
+        weight_data.release();
+
+    return 0;
+}
+
+int Convolution_x86::save_kernel_profile(std::vector<int>& profile) const
+{
+    kernel_cache.save(profile);
+
+    return 0;
+}
+
+int Convolution_x86::load_kernel_profile(const std::vector<int>& profile)
+{
+    if (profile.size() % 8 != 0)
+        return -1;
+
+    const bool winograd_applicable = kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 1 && stride_h == 1;
+
+    for (size_t i = 0; i < profile.size(); i += 8)
+    {
+        const int kernel = profile[i + 4];
+        if (kernel < KERNEL_WINOGRAD23 || kernel > KERNEL_PACKED)
+            return -1;
+
+        if (kernel <= KERNEL_WINOGRAD63 && !winograd_applicable)
+            return -1;
+    }
+
+    kernel_cache.clear();
+    kernel_cache.load(profile);
+
     return 0;
 }
 
@@ -517,6 +706,7 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
 #if NCNN_INT8
     if (opt.use_int8_inference && int8_scale_term)
     {
+        profile_kernel("int8");
         return forward_int8_x86(bottom_blob, top_blob, opt);
     }
 #endif
@@ -565,6 +755,23 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
         return 0;
     }
 
+#if NCNN_BF16
+    // create_pipeline only built the bf16 weights, fp32 input from a parent layer takes this path too
+    if (opt.use_bf16_storage)
+    {
+        profile_kernel("bf16s");
+        return forward_bf16s(bottom_blob, top_blob, opt);
+    }
+#endif
+
+#if NCNN_F16C && __AVX__
+    if (cpu_support_x86_f16c() && opt.use_fp16_storage && opt.use_x86_fp16_storage && !opt.use_bf16_storage)
+    {
+        profile_kernel("fp16s");
+        return forward_fp16s(bottom_blob, top_blob, opt);
+    }
+#endif
+
     int w = bottom_blob.w;
     int h = bottom_blob.h;
     int channels = bottom_blob.c;
@@ -607,12 +814,53 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
     {
         if (outw >= dilation_w && outh >= dilation_h)
         {
+            profile_kernel("dilation");
             return forwardDilation_x86(bottom_blob_bordered, top_blob, opt);
         }
     }
 
     const int num_input = channels * elempack;
 
+    const int _nT = nT ? nT : opt.num_threads;
+
+    // the kernel choice depends on the bordered input shape only
+    // tuned choices are remembered, a loaded profile is final
+    int key[4] = {w, h, elempack, _nT};
+    int value[4] = {0, 0, 0, 0};
+    if (opt.use_kernel_autotune && !kernel_cache.is_frozen())
+    {
+        if (kernel_cache.find(key, value) != 0 || !has_kernel_weight(value[0]))
+        {
+            value[0] = autotune_kernel(bottom_blob_bordered, top_blob, num_input, opt);
+            kernel_cache.insert(key, value);
+        }
+    }
+    else if (!kernel_cache.is_frozen() || kernel_cache.find(key, value) != 0 || !has_kernel_weight(value[0]))
+    {
+        value[0] = select_kernel(w, h, num_input, opt);
+    }
+
+    return forward_kernel(value[0], bottom_blob_bordered, top_blob, opt);
+}
+
+bool Convolution_x86::has_kernel_weight(int kernel) const
+{
+    if (kernel == KERNEL_WINOGRAD23)
+        return !weight_winograd23_data.empty();
+    if (kernel == KERNEL_WINOGRAD43)
+        return !weight_winograd43_data.empty();
+    if (kernel == KERNEL_WINOGRAD63)
+        return !weight_winograd63_data.empty();
+    if (kernel == KERNEL_SGEMM)
+        return !weight_sgemm_data.empty();
+    if (kernel == KERNEL_PACKED)
+        return !weight_data_tm.empty();
+
+    return false;
+}
+
+int Convolution_x86::select_kernel(int w, int h, int num_input, const Option& opt) const
+{
     bool prefer_winograd = (opt.use_winograd23_convolution || opt.use_winograd43_convolution || opt.use_winograd63_convolution) && (num_input > 8 || num_output > 8);
 
     if (opt.use_winograd_convolution && prefer_winograd && kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 1 && stride_h == 1)
@@ -649,6 +897,76 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
             }
         }
 
+        if (prefer_winograd23)
+            return KERNEL_WINOGRAD23;
+        if (prefer_winograd43)
+            return KERNEL_WINOGRAD43;
+        return KERNEL_WINOGRAD63;
+    }
+
+    int l2_cache_size = get_cpu_level2_cache_size();
+    bool prefer_sgemm = num_input * num_output * kernel_w * kernel_h * dilation_w * dilation_h * stride_w * stride_h * (int)sizeof(float) * 2 > l2_cache_size || (num_input > 16 || num_output > 16);
+
+    if ((opt.use_sgemm_convolution && prefer_sgemm) || (kernel_w == 1 && kernel_h == 1))
+        return KERNEL_SGEMM;
+
+    return KERNEL_PACKED;
+}
+
+int Convolution_x86::autotune_kernel(const Mat& bottom_blob_bordered, Mat& top_blob, int num_input, const Option& opt) const
+{
+    // every kernel with transformed weight is a candidate
+    std::vector<int> candidates;
+    for (int kernel = KERNEL_WINOGRAD23; kernel <= KERNEL_PACKED; kernel++)
+    {
+        if (has_kernel_weight(kernel))
+            candidates.push_back(kernel);
+    }
+
+    if (candidates.size() < 2)
+        return candidates.empty() ? select_kernel(bottom_blob_bordered.w, bottom_blob_bordered.h, num_input, opt) : candidates[0];
+
+    int best_kernel = candidates[0];
+    double best_time = 0.0;
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        // take the faster of two runs, the first one warms up cache and workspace
+        double time = 0.0;
+        for (int j = 0; j < 2; j++)
+        {
+            double start = get_current_time();
+            int ret = forward_kernel(candidates[i], bottom_blob_bordered, top_blob, opt);
+            double end = get_current_time();
+            if (ret != 0)
+            {
+                time = -1.0;
+                break;
+            }
+
+            if (j == 0 || end - start < time)
+                time = end - start;
+        }
+
+        if (time < 0.0)
+            continue;
+
+        if (best_time == 0.0 || time < best_time)
+        {
+            best_kernel = candidates[i];
+            best_time = time;
+        }
+    }
+
+    return best_kernel;
+}
+
+int Convolution_x86::forward_kernel(int kernel, const Mat& bottom_blob_bordered, Mat& top_blob, const Option& opt) const
+{
+    const int elempack = bottom_blob_bordered.elempack;
+    const int out_elempack = top_blob.elempack;
+
+    if (kernel == KERNEL_WINOGRAD23 || kernel == KERNEL_WINOGRAD43 || kernel == KERNEL_WINOGRAD63)
+    {
         int _nT = nT ? nT : opt.num_threads;
         if (nT != 0 && opt.num_threads != nT)
         {
@@ -658,21 +976,20 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
         }
 
         int ret = 0;
-        if (prefer_winograd23)
+        if (kernel == KERNEL_WINOGRAD23)
         {
+            profile_kernel("winograd23");
             ret = conv3x3s1_winograd23(bottom_blob_bordered, top_blob, weight_winograd23_data, bias_data, _nT, opt);
         }
-        else if (prefer_winograd43)
+        else if (kernel == KERNEL_WINOGRAD43)
         {
+            profile_kernel("winograd43");
             ret = conv3x3s1_winograd43(bottom_blob_bordered, top_blob, weight_winograd43_data, bias_data, _nT, opt);
         }
-        else if (prefer_winograd63)
-        {
-            ret = conv3x3s1_winograd63(bottom_blob_bordered, top_blob, weight_winograd63_data, bias_data, _nT, opt);
-        }
         else
         {
-            // should never reach here
+            profile_kernel("winograd63");
+            ret = conv3x3s1_winograd63(bottom_blob_bordered, top_blob, weight_winograd63_data, bias_data, _nT, opt);
         }
         if (ret != 0)
             return ret;
@@ -684,10 +1001,7 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
         return 0;
     }
 
-    int l2_cache_size = get_cpu_level2_cache_size();
-    bool prefer_sgemm = num_input * num_output * kernel_w * kernel_h * dilation_w * dilation_h * stride_w * stride_h * (int)sizeof(float) * 2 > l2_cache_size || (num_input > 16 || num_output > 16);
-
-    if ((opt.use_sgemm_convolution && prefer_sgemm) || (kernel_w == 1 && kernel_h == 1))
+    if (kernel == KERNEL_SGEMM)
     {
         int _nT = nT ? nT : opt.num_threads;
         if (nT != 0 && opt.num_threads != nT)
@@ -697,6 +1011,7 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
             NCNN_LOGE("opt.num_threads %d changed, convolution gemm will use load-time value %d", opt.num_threads, nT);
         }
 
+        profile_kernel("sgemm");
         int ret = convolution_im2col_gemm(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, _nT, opt);
         if (ret != 0)
             return ret;
@@ -708,6 +1023,8 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
         return 0;
     }
 
+    profile_kernel("direct");
+
 #if __SSE2__
 #if __AVX__
 #if __AVX512F__
@@ -814,6 +1131,7 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
     }
 #endif // __SSE2__
 
+    profile_kernel("packed");
     convolution_packed(bottom_blob_bordered, top_blob, weight_data_tm, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, activation_type, activation_params, opt);
 
     return 0;
@@ -821,6 +1139,15 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
 
 int Convolution_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
+    if (residual)
+    {
+        int ret = forward(bottom_blobs[0], top_blobs[0], opt);
+        if (ret != 0)
+            return ret;
+
+        return add_residual_x86(bottom_blobs[1], top_blobs[0], opt);
+    }
+
     const Mat& bottom_blob = bottom_blobs[0];
     const Mat& _weight_data = bottom_blobs[1];
     Mat& top_blob = top_blobs[0];
@@ -893,6 +1220,149 @@ int Convolution_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<M
     return 0;
 }
 
+#if NCNN_BF16
+int Convolution_x86::create_pipeline_bf16s(const Option& opt)
+{
+    const int maxk = kernel_w * kernel_h;
+    const int num_input = weight_data_size / maxk / num_output;
+
+    convolution_im2col_gemm_transform_kernel_bf16s(weight_data, weight_data_tm, num_input, num_output, kernel_w, kernel_h, opt);
+
+    if (opt.lightmode)
+        weight_data.release();
+
+    return 0;
+}
+
+int Convolution_x86::forward_bf16s(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    Option opt_unpack = opt;
+    opt_unpack.blob_allocator = opt.workspace_allocator;
+
+    // im2col rows are gathered per input channel, so work on unpacked input
+    Mat bottom_blob_unpacked = bottom_blob;
+    if (bottom_blob.elempack != 1)
+    {
+        convert_packing(bottom_blob, bottom_blob_unpacked, 1, opt_unpack);
+        if (bottom_blob_unpacked.empty())
+            return -100;
+    }
+
+    // fp32 input keeps fp32 output
+    const bool input_bf16 = bottom_blob.elembits() == 16;
+    if (!input_bf16)
+    {
+        Mat bottom_blob_bf16;
+        cast_float32_to_bfloat16(bottom_blob_unpacked, bottom_blob_bf16, opt_unpack);
+        if (bottom_blob_bf16.empty())
+            return -100;
+
+        bottom_blob_unpacked = bottom_blob_bf16;
+    }
+
+    Mat bottom_blob_bordered;
+    make_padding(bottom_blob_unpacked, bottom_blob_bordered, opt);
+    if (bottom_blob_bordered.empty())
+        return -100;
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    const int outw = (bottom_blob_bordered.w - kernel_extent_w) / stride_w + 1;
+    const int outh = (bottom_blob_bordered.h - kernel_extent_h) / stride_h + 1;
+
+    int out_elempack = 1;
+#if __SSE2__
+    if (opt.use_packing_layout)
+    {
+#if __AVX512F__
+        out_elempack = num_output % 16 == 0 ? 16 : num_output % 8 == 0 ? 8 : num_output % 4 == 0 ? 4 : 1;
+#elif __AVX__
+        out_elempack = num_output % 8 == 0 ? 8 : num_output % 4 == 0 ? 4 : 1;
+#else
+        out_elempack = num_output % 4 == 0 ? 4 : 1;
+#endif
+    }
+#endif // __SSE2__
+    size_t out_elemsize = (input_bf16 ? 2u : 4u) * out_elempack;
+
+    top_blob.create(outw, outh, num_output / out_elempack, out_elemsize, out_elempack, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    return convolution_im2col_gemm_bf16s(bottom_blob_bordered, top_blob, weight_data_tm, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, activation_type, activation_params, opt);
+}
+#endif // NCNN_BF16
+
+#if NCNN_F16C && __AVX__
+int Convolution_x86::create_pipeline_fp16s(const Option& opt)
+{
+    const int maxk = kernel_w * kernel_h;
+    const int num_input = weight_data_size / maxk / num_output;
+
+    convolution_im2col_gemm_transform_kernel_fp16s(weight_data, weight_data_tm, num_input, num_output, kernel_w, kernel_h, opt);
+
+    if (opt.lightmode)
+        weight_data.release();
+
+    return 0;
+}
+
+int Convolution_x86::forward_fp16s(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    Option opt_unpack = opt;
+    opt_unpack.blob_allocator = opt.workspace_allocator;
+
+    // im2col rows are gathered per input channel in fp32, so work on unpacked fp32 input
+    Mat bottom_blob_unpacked = bottom_blob;
+    if (bottom_blob.elempack != 1)
+    {
+        convert_packing(bottom_blob, bottom_blob_unpacked, 1, opt_unpack);
+        if (bottom_blob_unpacked.empty())
+            return -100;
+    }
+
+    const bool input_fp16 = bottom_blob.elembits() == 16;
+    if (input_fp16)
+    {
+        Mat bottom_blob_fp32;
+        cast_float16_to_float32(bottom_blob_unpacked, bottom_blob_fp32, opt_unpack);
+        if (bottom_blob_fp32.empty())
+            return -100;
+
+        bottom_blob_unpacked = bottom_blob_fp32;
+    }
+
+    Mat bottom_blob_bordered;
+    make_padding(bottom_blob_unpacked, bottom_blob_bordered, opt);
+    if (bottom_blob_bordered.empty())
+        return -100;
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    const int outw = (bottom_blob_bordered.w - kernel_extent_w) / stride_w + 1;
+    const int outh = (bottom_blob_bordered.h - kernel_extent_h) / stride_h + 1;
+
+    int out_elempack = 1;
+    if (opt.use_packing_layout)
+    {
+#if __AVX512F__
+        out_elempack = num_output % 16 == 0 ? 16 : num_output % 8 == 0 ? 8 : num_output % 4 == 0 ? 4 : 1;
+#else
+        out_elempack = num_output % 8 == 0 ? 8 : num_output % 4 == 0 ? 4 : 1;
+#endif
+    }
+    size_t out_elemsize = (input_fp16 ? 2u : 4u) * out_elempack;
+
+    top_blob.create(outw, outh, num_output / out_elempack, out_elemsize, out_elempack, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    return convolution_im2col_gemm_fp16s(bottom_blob_bordered, top_blob, weight_data_tm, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, activation_type, activation_params, opt);
+}
+#endif // NCNN_F16C && __AVX__
+
 #if NCNN_INT8
 int Convolution_x86::create_pipeline_int8_x86(const Option& opt)
 {
@@ -1049,6 +1519,60 @@ int Convolution_x86::forward_int8_x86(const Mat& bottom_blob, Mat& top_blob, con
 }
 #endif // NCNN_INT8
 
+int Convolution_x86::add_residual_x86(const Mat& residual, Mat& top_blob, const Option& opt) const
+{
+    if (top_blob.elembits() != 32 || residual.elempack != top_blob.elempack || residual.dims != top_blob.dims || residual.w != top_blob.w || residual.h != top_blob.h || residual.d != top_blob.d || residual.c != top_blob.c)
+        return add_residual(residual, top_blob, opt);
+
+    const int channels = top_blob.c;
+    const int size = top_blob.w * top_blob.h * top_blob.d * top_blob.elempack;
+
+    // one pass over the output, add the residual and apply the activation while it is in register
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* ptr = residual.channel(q);
+        float* outptr = top_blob.channel(q);
+
+        int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+        for (; i + 15 < size; i += 16)
+        {
+            __m512 _p = _mm512_add_ps(_mm512_loadu_ps(outptr), _mm512_loadu_ps(ptr));
+            _mm512_storeu_ps(outptr, activation_avx512(_p, residual_activation_type, residual_activation_params));
+            ptr += 16;
+            outptr += 16;
+        }
+#endif // __AVX512F__
+        for (; i + 7 < size; i += 8)
+        {
+            __m256 _p = _mm256_add_ps(_mm256_loadu_ps(outptr), _mm256_loadu_ps(ptr));
+            _mm256_storeu_ps(outptr, activation_avx(_p, residual_activation_type, residual_activation_params));
+            ptr += 8;
+            outptr += 8;
+        }
+#endif // __AVX__
+        for (; i + 3 < size; i += 4)
+        {
+            __m128 _p = _mm_add_ps(_mm_loadu_ps(outptr), _mm_loadu_ps(ptr));
+            _mm_storeu_ps(outptr, activation_sse(_p, residual_activation_type, residual_activation_params));
+            ptr += 4;
+            outptr += 4;
+        }
+#endif // __SSE2__
+        for (; i < size; i++)
+        {
+            *outptr = activation_ss(*outptr + *ptr, residual_activation_type, residual_activation_params);
+            ptr++;
+            outptr++;
+        }
+    }
+
+    return 0;
+}
+
 int Convolution_x86::forwardDilation_x86(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
     int w = bottom_blob.w;
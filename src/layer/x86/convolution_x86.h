@@ -16,6 +16,7 @@
 #define LAYER_CONVOLUTION_X86_H
 
 #include "convolution.h"
+#include "kernel_cache.h"
 
 namespace ncnn {
 
@@ -27,16 +28,36 @@ public:
     virtual int create_pipeline(const Option& opt);
     virtual int destroy_pipeline(const Option& opt);
 
+    virtual int save_pipeline_data(std::vector<Mat>& pipeline_data) const;
+    virtual int load_pipeline_data(const std::vector<Mat>& pipeline_data, const Option& opt);
+
+    virtual int save_kernel_profile(std::vector<int>& profile) const;
+    virtual int load_kernel_profile(const std::vector<int>& profile);
+
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 
     virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
 
 protected:
+#if NCNN_BF16
+    int create_pipeline_bf16s(const Option& opt);
+    int forward_bf16s(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+#endif
+#if NCNN_F16C && __AVX__
+    int create_pipeline_fp16s(const Option& opt);
+    int forward_fp16s(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+#endif
 #if NCNN_INT8
     int create_pipeline_int8_x86(const Option& opt);
     int forward_int8_x86(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 #endif
     int forwardDilation_x86(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+    int add_residual_x86(const Mat& residual, Mat& top_blob, const Option& opt) const;
+
+    bool has_kernel_weight(int kernel) const;
+    int select_kernel(int w, int h, int num_input, const Option& opt) const;
+    int autotune_kernel(const Mat& bottom_blob_bordered, Mat& top_blob, int num_input, const Option& opt) const;
+    int forward_kernel(int kernel, const Mat& bottom_blob_bordered, Mat& top_blob, const Option& opt) const;
 
 public:
     Layer* activation;
@@ -51,6 +72,9 @@ public:
     // forwardDilation
     Layer* convolution_dilation1;
 
+    // fp32 kernel per bordered input shape
+    mutable KernelCache kernel_cache;
+
 #if NCNN_INT8
     Mat scale_in_data;
 #endif
@@ -236,7 +236,11 @@ int ConvolutionDepthWise_x86::create_group_ops(const Option& opt)
             op->load_model(ModelBinFromMatArray(weights));
         }
 
-        op->create_pipeline(opt);
+        // group convolutions see the fp32 blobs of this layer, keep them on the fp32 pipeline
+        Option opt_g = opt;
+        opt_g.use_bf16_storage = false;
+
+        op->create_pipeline(opt_g);
 
         group_ops[g] = op;
     }
@@ -726,6 +730,7 @@ int ConvolutionDepthWise_x86::forward(const Mat& bottom_blob, Mat& top_blob, con
 
         Option opt_g = opt;
         opt_g.blob_allocator = top_blob_unpacked.allocator;
+        opt_g.use_bf16_storage = false;
 
         // forward
         int ret = op->forward(bottom_blob_bordered_g, top_blob_g, opt_g);
@@ -1273,6 +1278,7 @@ int ConvolutionDepthWise_x86::forward_int8_x86(const Mat& bottom_blob, Mat& top_
 
         Option opt_g = opt;
         opt_g.blob_allocator = top_blob_unpacked.allocator;
+        opt_g.use_bf16_storage = false;
 
         // forward
         int ret = op->forward(bottom_blob_bordered_g, top_blob_g, opt_g);
@@ -0,0 +1,208 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "cumulativesum_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif
+#endif // __SSE2__
+
+namespace ncnn {
+
+CumulativeSum_x86::CumulativeSum_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+}
+
+// ptr[i] += prevptr[i]
+static void cumulativesum_add(float* ptr, const float* prevptr, int size)
+{
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    for (; i + 15 < size; i += 16)
+    {
+        _mm512_storeu_ps(ptr, _mm512_add_ps(_mm512_loadu_ps(ptr), _mm512_loadu_ps(prevptr)));
+        ptr += 16;
+        prevptr += 16;
+    }
+#endif // __AVX512F__
+    for (; i + 7 < size; i += 8)
+    {
+        _mm256_storeu_ps(ptr, _mm256_add_ps(_mm256_loadu_ps(ptr), _mm256_loadu_ps(prevptr)));
+        ptr += 8;
+        prevptr += 8;
+    }
+#endif // __AVX__
+    for (; i + 3 < size; i += 4)
+    {
+        _mm_storeu_ps(ptr, _mm_add_ps(_mm_loadu_ps(ptr), _mm_loadu_ps(prevptr)));
+        ptr += 4;
+        prevptr += 4;
+    }
+#endif // __SSE2__
+    for (; i < size; i++)
+    {
+        *ptr += *prevptr;
+        ptr++;
+        prevptr++;
+    }
+}
+
+// running sum of w packs along the row, lane by lane
+static void cumulativesum_row_pack(float* ptr, int w, int elempack)
+{
+    for (int j = 1; j < w; j++)
+    {
+        cumulativesum_add(ptr + j * elempack, ptr + (j - 1) * elempack, elempack);
+    }
+}
+
+// running sum along the packed axis, size positions of elempack lanes per group
+// prevptr is the previous group or null for the first one
+static void cumulativesum_lanes(float* ptr, const float* prevptr, int size, int elempack)
+{
+    for (int i = 0; i < size; i++)
+    {
+        float sum = prevptr ? prevptr[i * elempack + elempack - 1] : 0.f;
+        for (int l = 0; l < elempack; l++)
+        {
+            sum += ptr[l];
+            ptr[l] = sum;
+        }
+        ptr += elempack;
+    }
+}
+
+int CumulativeSum_x86::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+{
+    const int elempack = bottom_top_blob.elempack;
+
+    if (elempack == 1)
+        return CumulativeSum::forward_inplace(bottom_top_blob, opt);
+
+    int dims = bottom_top_blob.dims;
+    int positive_axis = axis < 0 ? dims + axis : axis;
+
+    if (dims == 1)
+    {
+        // packed 1d is the plain sequence
+        float* ptr = bottom_top_blob;
+
+        const int size = bottom_top_blob.w * elempack;
+        for (int i = 1; i < size; i++)
+        {
+            ptr[i] = ptr[i] + ptr[i - 1];
+        }
+
+        return 0;
+    }
+
+    if (dims == 2 && positive_axis == 0)
+    {
+        // sum over the packed rows
+        int w = bottom_top_blob.w;
+        int h = bottom_top_blob.h;
+
+        for (int i = 0; i < h; i++)
+        {
+            const float* prevptr = i == 0 ? 0 : bottom_top_blob.row(i - 1);
+            cumulativesum_lanes(bottom_top_blob.row(i), prevptr, w, elempack);
+        }
+
+        return 0;
+    }
+
+    if (dims == 2 && positive_axis == 1)
+    {
+        int w = bottom_top_blob.w;
+        int h = bottom_top_blob.h;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i = 0; i < h; i++)
+        {
+            cumulativesum_row_pack(bottom_top_blob.row(i), w, elempack);
+        }
+
+        return 0;
+    }
+
+    if (dims == 3 && positive_axis == 0)
+    {
+        // sum over the packed channels
+        int w = bottom_top_blob.w;
+        int h = bottom_top_blob.h;
+        int c = bottom_top_blob.c;
+
+        int size = w * h;
+
+        for (int q = 0; q < c; q++)
+        {
+            const float* prevptr = q == 0 ? 0 : bottom_top_blob.channel(q - 1);
+            cumulativesum_lanes(bottom_top_blob.channel(q), prevptr, size, elempack);
+        }
+
+        return 0;
+    }
+
+    if (dims == 3 && positive_axis == 1)
+    {
+        int w = bottom_top_blob.w;
+        int h = bottom_top_blob.h;
+        int c = bottom_top_blob.c;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = 0; q < c; q++)
+        {
+            Mat this_channel = bottom_top_blob.channel(q);
+
+            for (int i = 1; i < h; i++)
+            {
+                cumulativesum_add(this_channel.row(i), this_channel.row(i - 1), w * elempack);
+            }
+        }
+
+        return 0;
+    }
+
+    if (dims == 3 && positive_axis == 2)
+    {
+        int w = bottom_top_blob.w;
+        int h = bottom_top_blob.h;
+        int c = bottom_top_blob.c;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = 0; q < c; q++)
+        {
+            Mat this_channel = bottom_top_blob.channel(q);
+
+            for (int i = 0; i < h; i++)
+            {
+                cumulativesum_row_pack(this_channel.row(i), w, elempack);
+            }
+        }
+
+        return 0;
+    }
+
+    return -100;
+}
+
+} // namespace ncnn
@@ -0,0 +1,373 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "fusedelementwise_x86.h"
+
+#include "binaryop.h"
+#include "unaryop.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#include "sse_mathfun.h"
+#if __AVX__
+#include <immintrin.h>
+#include "avx_mathfun.h"
+#if __AVX512F__
+#include "avx512_mathfun.h"
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+
+#include "x86_activation.h"
+
+namespace ncnn {
+
+FusedElementwise_x86::FusedElementwise_x86()
+{
+}
+
+// the ops without simd path run through the reference loop
+static bool fused_op_supported(const FusedElementwise::Instruction& ins)
+{
+    switch (ins.op_type)
+    {
+    case FusedElementwise::Operation_UNARYOP:
+    {
+        const int op_type = (int)ins.a;
+        return op_type == UnaryOp::Operation_ABS || op_type == UnaryOp::Operation_NEG || op_type == UnaryOp::Operation_SQUARE
+               || op_type == UnaryOp::Operation_SQRT || op_type == UnaryOp::Operation_RSQRT || op_type == UnaryOp::Operation_EXP
+               || op_type == UnaryOp::Operation_LOG || op_type == UnaryOp::Operation_RECIPROCAL || op_type == UnaryOp::Operation_TANH;
+    }
+    case FusedElementwise::Operation_BINARYOP:
+    case FusedElementwise::Operation_BINARYOP_SCALAR:
+    {
+        const int op_type = (int)ins.a;
+        return op_type == BinaryOp::Operation_ADD || op_type == BinaryOp::Operation_SUB || op_type == BinaryOp::Operation_MUL
+               || op_type == BinaryOp::Operation_DIV || op_type == BinaryOp::Operation_MAX || op_type == BinaryOp::Operation_MIN
+               || op_type == BinaryOp::Operation_RSUB || op_type == BinaryOp::Operation_RDIV;
+    }
+    case FusedElementwise::Operation_GELU:
+        return ins.a != 0.f;
+    default:
+        return true;
+    }
+}
+
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+static NCNN_FORCEINLINE __m512 fused_op_avx512(const FusedElementwise::Instruction& ins, __m512 _x, __m512 _y)
+{
+    const __m512 _zero = _mm512_setzero_ps();
+    const __m512 _one = _mm512_set1_ps(1.f);
+
+    switch (ins.op_type)
+    {
+    case FusedElementwise::Operation_UNARYOP:
+        switch ((int)ins.a)
+        {
+        case UnaryOp::Operation_ABS:
+            return _mm512_max_ps(_x, _mm512_sub_ps(_zero, _x));
+        case UnaryOp::Operation_NEG:
+            return _mm512_sub_ps(_zero, _x);
+        case UnaryOp::Operation_SQUARE:
+            return _mm512_mul_ps(_x, _x);
+        case UnaryOp::Operation_SQRT:
+            return _mm512_sqrt_ps(_x);
+        case UnaryOp::Operation_RSQRT:
+            return _mm512_div_ps(_one, _mm512_sqrt_ps(_x));
+        case UnaryOp::Operation_EXP:
+            return exp512_ps(_x);
+        case UnaryOp::Operation_LOG:
+            return log512_ps(_x);
+        case UnaryOp::Operation_RECIPROCAL:
+            return _mm512_div_ps(_one, _x);
+        default: // UnaryOp::Operation_TANH
+            return tanh_avx512(_x);
+        }
+    case FusedElementwise::Operation_BINARYOP_SCALAR:
+        _y = _mm512_set1_ps(ins.b);
+    // fall through
+    case FusedElementwise::Operation_BINARYOP:
+        switch ((int)ins.a)
+        {
+        case BinaryOp::Operation_ADD:
+            return _mm512_add_ps(_x, _y);
+        case BinaryOp::Operation_SUB:
+            return _mm512_sub_ps(_x, _y);
+        case BinaryOp::Operation_MUL:
+            return _mm512_mul_ps(_x, _y);
+        case BinaryOp::Operation_DIV:
+            return _mm512_div_ps(_x, _y);
+        case BinaryOp::Operation_MAX:
+            return _mm512_max_ps(_x, _y);
+        case BinaryOp::Operation_MIN:
+            return _mm512_min_ps(_x, _y);
+        case BinaryOp::Operation_RSUB:
+            return _mm512_sub_ps(_y, _x);
+        default: // BinaryOp::Operation_RDIV
+            return _mm512_div_ps(_y, _x);
+        }
+    case FusedElementwise::Operation_SIGMOID:
+        return sigmoid_avx512(_x);
+    case FusedElementwise::Operation_RELU:
+        if (ins.a == 0.f)
+            return _mm512_max_ps(_x, _zero);
+        return lrelu_avx512(_x, ins.a);
+    case FusedElementwise::Operation_CLIP:
+        return _mm512_min_ps(_mm512_max_ps(_x, _mm512_set1_ps(ins.a)), _mm512_set1_ps(ins.b));
+    case FusedElementwise::Operation_SWISH:
+        return swish_avx512(_x);
+    case FusedElementwise::Operation_HARDSIGMOID:
+        return _mm512_min_ps(_mm512_max_ps(_mm512_add_ps(_mm512_mul_ps(_x, _mm512_set1_ps(ins.a)), _mm512_set1_ps(ins.b)), _zero), _one);
+    case FusedElementwise::Operation_HARDSWISH:
+        return hardswish_avx512(_x, _mm512_set1_ps(ins.a), _mm512_set1_ps(ins.b));
+    case FusedElementwise::Operation_ELU:
+        return elu_avx512(_x, _mm512_set1_ps(ins.a));
+    case FusedElementwise::Operation_GELU:
+    {
+        // fast gelu only, see fused_op_supported
+        __m512 _x3 = _mm512_mul_ps(_mm512_mul_ps(_x, _x), _x);
+        __m512 _t = _mm512_mul_ps(_mm512_set1_ps(0.79788452f), _mm512_add_ps(_x, _mm512_mul_ps(_mm512_set1_ps(0.044715f), _x3)));
+        return _mm512_mul_ps(_mm512_mul_ps(_mm512_set1_ps(0.5f), _x), _mm512_add_ps(_one, tanh_avx512(_t)));
+    }
+    default: // FusedElementwise::Operation_MISH
+        return mish_avx512(_x);
+    }
+}
+#endif // __AVX512F__
+
+static NCNN_FORCEINLINE __m256 fused_op_avx(const FusedElementwise::Instruction& ins, __m256 _x, __m256 _y)
+{
+    const __m256 _zero = _mm256_setzero_ps();
+    const __m256 _one = _mm256_set1_ps(1.f);
+
+    switch (ins.op_type)
+    {
+    case FusedElementwise::Operation_UNARYOP:
+        switch ((int)ins.a)
+        {
+        case UnaryOp::Operation_ABS:
+            return _mm256_max_ps(_x, _mm256_sub_ps(_zero, _x));
+        case UnaryOp::Operation_NEG:
+            return _mm256_sub_ps(_zero, _x);
+        case UnaryOp::Operation_SQUARE:
+            return _mm256_mul_ps(_x, _x);
+        case UnaryOp::Operation_SQRT:
+            return _mm256_sqrt_ps(_x);
+        case UnaryOp::Operation_RSQRT:
+            return _mm256_div_ps(_one, _mm256_sqrt_ps(_x));
+        case UnaryOp::Operation_EXP:
+            return exp256_ps(_x);
+        case UnaryOp::Operation_LOG:
+            return log256_ps(_x);
+        case UnaryOp::Operation_RECIPROCAL:
+            return _mm256_div_ps(_one, _x);
+        default: // UnaryOp::Operation_TANH
+            return tanh_avx(_x);
+        }
+    case FusedElementwise::Operation_BINARYOP_SCALAR:
+        _y = _mm256_set1_ps(ins.b);
+    // fall through
+    case FusedElementwise::Operation_BINARYOP:
+        switch ((int)ins.a)
+        {
+        case BinaryOp::Operation_ADD:
+            return _mm256_add_ps(_x, _y);
+        case BinaryOp::Operation_SUB:
+            return _mm256_sub_ps(_x, _y);
+        case BinaryOp::Operation_MUL:
+            return _mm256_mul_ps(_x, _y);
+        case BinaryOp::Operation_DIV:
+            return _mm256_div_ps(_x, _y);
+        case BinaryOp::Operation_MAX:
+            return _mm256_max_ps(_x, _y);
+        case BinaryOp::Operation_MIN:
+            return _mm256_min_ps(_x, _y);
+        case BinaryOp::Operation_RSUB:
+            return _mm256_sub_ps(_y, _x);
+        default: // BinaryOp::Operation_RDIV
+            return _mm256_div_ps(_y, _x);
+        }
+    case FusedElementwise::Operation_SIGMOID:
+        return sigmoid_avx(_x);
+    case FusedElementwise::Operation_RELU:
+        if (ins.a == 0.f)
+            return _mm256_max_ps(_x, _zero);
+        return lrelu_avx(_x, ins.a);
+    case FusedElementwise::Operation_CLIP:
+        return _mm256_min_ps(_mm256_max_ps(_x, _mm256_set1_ps(ins.a)), _mm256_set1_ps(ins.b));
+    case FusedElementwise::Operation_SWISH:
+        return swish_avx(_x);
+    case FusedElementwise::Operation_HARDSIGMOID:
+        return _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(_mm256_mul_ps(_x, _mm256_set1_ps(ins.a)), _mm256_set1_ps(ins.b)), _zero), _one);
+    case FusedElementwise::Operation_HARDSWISH:
+        return hardswish_avx(_x, _mm256_set1_ps(ins.a), _mm256_set1_ps(ins.b));
+    case FusedElementwise::Operation_ELU:
+        return elu_avx(_x, _mm256_set1_ps(ins.a));
+    case FusedElementwise::Operation_GELU:
+    {
+        // fast gelu only, see fused_op_supported
+        __m256 _x3 = _mm256_mul_ps(_mm256_mul_ps(_x, _x), _x);
+        __m256 _t = _mm256_mul_ps(_mm256_set1_ps(0.79788452f), _mm256_add_ps(_x, _mm256_mul_ps(_mm256_set1_ps(0.044715f), _x3)));
+        return _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), _x), _mm256_add_ps(_one, tanh_avx(_t)));
+    }
+    default: // FusedElementwise::Operation_MISH
+        return mish_avx(_x);
+    }
+}
+#endif // __AVX__
+
+static NCNN_FORCEINLINE __m128 fused_op_sse(const FusedElementwise::Instruction& ins, __m128 _x, __m128 _y)
+{
+    const __m128 _zero = _mm_setzero_ps();
+    const __m128 _one = _mm_set1_ps(1.f);
+
+    switch (ins.op_type)
+    {
+    case FusedElementwise::Operation_UNARYOP:
+        switch ((int)ins.a)
+        {
+        case UnaryOp::Operation_ABS:
+            return _mm_max_ps(_x, _mm_sub_ps(_zero, _x));
+        case UnaryOp::Operation_NEG:
+            return _mm_sub_ps(_zero, _x);
+        case UnaryOp::Operation_SQUARE:
+            return _mm_mul_ps(_x, _x);
+        case UnaryOp::Operation_SQRT:
+            return _mm_sqrt_ps(_x);
+        case UnaryOp::Operation_RSQRT:
+            return _mm_div_ps(_one, _mm_sqrt_ps(_x));
+        case UnaryOp::Operation_EXP:
+            return exp_ps(_x);
+        case UnaryOp::Operation_LOG:
+            return log_ps(_x);
+        case UnaryOp::Operation_RECIPROCAL:
+            return _mm_div_ps(_one, _x);
+        default: // UnaryOp::Operation_TANH
+            return tanh_sse(_x);
+        }
+    case FusedElementwise::Operation_BINARYOP_SCALAR:
+        _y = _mm_set1_ps(ins.b);
+    // fall through
+    case FusedElementwise::Operation_BINARYOP:
+        switch ((int)ins.a)
+        {
+        case BinaryOp::Operation_ADD:
+            return _mm_add_ps(_x, _y);
+        case BinaryOp::Operation_SUB:
+            return _mm_sub_ps(_x, _y);
+        case BinaryOp::Operation_MUL:
+            return _mm_mul_ps(_x, _y);
+        case BinaryOp::Operation_DIV:
+            return _mm_div_ps(_x, _y);
+        case BinaryOp::Operation_MAX:
+            return _mm_max_ps(_x, _y);
+        case BinaryOp::Operation_MIN:
+            return _mm_min_ps(_x, _y);
+        case BinaryOp::Operation_RSUB:
+            return _mm_sub_ps(_y, _x);
+        default: // BinaryOp::Operation_RDIV
+            return _mm_div_ps(_y, _x);
+        }
+    case FusedElementwise::Operation_SIGMOID:
+        return sigmoid_sse(_x);
+    case FusedElementwise::Operation_RELU:
+        if (ins.a == 0.f)
+            return _mm_max_ps(_x, _zero);
+        return lrelu_sse(_x, ins.a);
+    case FusedElementwise::Operation_CLIP:
+        return _mm_min_ps(_mm_max_ps(_x, _mm_set1_ps(ins.a)), _mm_set1_ps(ins.b));
+    case FusedElementwise::Operation_SWISH:
+        return swish_sse(_x);
+    case FusedElementwise::Operation_HARDSIGMOID:
+        return _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(_x, _mm_set1_ps(ins.a)), _mm_set1_ps(ins.b)), _zero), _one);
+    case FusedElementwise::Operation_HARDSWISH:
+        return hardswish_sse(_x, _mm_set1_ps(ins.a), _mm_set1_ps(ins.b));
+    case FusedElementwise::Operation_ELU:
+        return elu_sse(_x, _mm_set1_ps(ins.a));
+    case FusedElementwise::Operation_GELU:
+    {
+        // fast gelu only, see fused_op_supported
+        __m128 _x3 = _mm_mul_ps(_mm_mul_ps(_x, _x), _x);
+        __m128 _t = _mm_mul_ps(_mm_set1_ps(0.79788452f), _mm_add_ps(_x, _mm_mul_ps(_mm_set1_ps(0.044715f), _x3)));
+        return _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), _x), _mm_add_ps(_one, tanh_sse(_t)));
+    }
+    default: // FusedElementwise::Operation_MISH
+        return mish_sse(_x);
+    }
+}
+#endif // __SSE2__
+
+static void fused_run_instruction(const FusedElementwise::Instruction& ins, const float* a, const float* b, float* out, int n)
+{
+    if (!fused_op_supported(ins))
+    {
+        FusedElementwise::run_instruction(ins, a, b, out, n);
+        return;
+    }
+
+    const bool binary = ins.op_type == FusedElementwise::Operation_BINARYOP;
+
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    for (; i + 15 < n; i += 16)
+    {
+        __m512 _x = _mm512_loadu_ps(a + i);
+        __m512 _y = binary ? _mm512_loadu_ps(b + i) : _mm512_setzero_ps();
+        _mm512_storeu_ps(out + i, fused_op_avx512(ins, _x, _y));
+    }
+#endif // __AVX512F__
+    for (; i + 7 < n; i += 8)
+    {
+        __m256 _x = _mm256_loadu_ps(a + i);
+        __m256 _y = binary ? _mm256_loadu_ps(b + i) : _mm256_setzero_ps();
+        _mm256_storeu_ps(out + i, fused_op_avx(ins, _x, _y));
+    }
+#endif // __AVX__
+    for (; i + 3 < n; i += 4)
+    {
+        __m128 _x = _mm_loadu_ps(a + i);
+        __m128 _y = binary ? _mm_loadu_ps(b + i) : _mm_setzero_ps();
+        _mm_storeu_ps(out + i, fused_op_sse(ins, _x, _y));
+    }
+#endif // __SSE2__
+    if (i < n)
+    {
+        FusedElementwise::run_instruction(ins, a + i, binary ? b + i : 0, out + i, n - i);
+    }
+}
+
+void FusedElementwise_x86::run_program(const float* ptr, float* outptr, int n) const
+{
+    const int instruction_count = (int)instructions.size();
+
+    // register i + 1 lives in regs[i], the last one is written to outptr directly
+    float regs[MAX_INSTRUCTION_COUNT - 1][TILE_SIZE];
+
+    for (int i = 0; i < instruction_count; i++)
+    {
+        const Instruction& ins = instructions[i];
+
+        const float* a = ins.src0 == 0 ? ptr : regs[ins.src0 - 1];
+        const float* b = ins.src1 == 0 ? ptr : regs[ins.src1 - 1];
+        float* out = i == instruction_count - 1 ? outptr : regs[i];
+
+        fused_run_instruction(ins, a, b, out, n);
+    }
+}
+
+} // namespace ncnn
@@ -0,0 +1,110 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#if NCNN_RUNTIME_CPU && NCNN_AMXBF16 && __AVX512F__ && !__AMX_BF16__
+void gemm_bf16s_amxbf16(const Mat& AT, const Mat& BT, int N, const Mat& C, Mat& top_blob, int broadcast_type_C, float alpha, int output_transpose, const Option& opt);
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX512BF16 && __AVX512F__ && !__AVX512BF16__
+void gemm_bf16s_avx512bf16(const Mat& AT, const Mat& BT, int N, const Mat& C, Mat& top_blob, int broadcast_type_C, float alpha, int output_transpose, const Option& opt);
+#endif
+
+static inline float gemm_bf16s_get_C(const float* pC, int broadcast_type_C, int N, int i, int j)
+{
+    if (broadcast_type_C == 0)
+        return pC[0];
+    if (broadcast_type_C == 1 || broadcast_type_C == 2)
+        return pC[i];
+    if (broadcast_type_C == 3)
+        return pC[i * N + j];
+    // broadcast_type_C == 4
+    return pC[j];
+}
+
+// top = alpha * (AT * BT^T + C)
+// AT is (Kp, M) bf16, BT is from gemm_bf16s_pack_B with N columns, C is unpacked fp32 pre-multiplied with beta
+// top_blob is unpacked bf16 or fp32, (N, M) or (M, N) when output_transpose
+static void gemm_bf16s(const Mat& AT, const Mat& BT, int N, const Mat& C, Mat& top_blob, int broadcast_type_C, float alpha, int output_transpose, const Option& opt)
+{
+#if NCNN_RUNTIME_CPU && NCNN_AMXBF16 && __AVX512F__ && !__AMX_BF16__
+    if (ncnn::cpu_support_x86_amx_bf16())
+    {
+        gemm_bf16s_amxbf16(AT, BT, N, C, top_blob, broadcast_type_C, alpha, output_transpose, opt);
+        return;
+    }
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX512BF16 && __AVX512F__ && !__AVX512BF16__
+    if (ncnn::cpu_support_x86_avx512_bf16())
+    {
+        gemm_bf16s_avx512bf16(AT, BT, N, C, top_blob, broadcast_type_C, alpha, output_transpose, opt);
+        return;
+    }
+#endif
+
+    const int M = AT.h;
+
+    const float* pC = C.empty() ? 0 : (const float*)C;
+
+    const int out_hstep = top_blob.dims == 3 ? (int)top_blob.cstep : top_blob.w;
+    const bool out_fp32 = top_blob.elemsize == 4u;
+
+    const int nr = gemm_bf16s_get_nr();
+#if __AMX_BF16__
+    // one amx tile holds 16 rows
+    const int TILE_M = 16;
+#else
+    const int TILE_M = 8;
+#endif
+
+    const int nn_M = (M + TILE_M - 1) / TILE_M;
+    const int nn_N = BT.h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int ppij = 0; ppij < nn_M * nn_N; ppij++)
+    {
+        const int i0 = ppij / nn_N * TILE_M;
+        const int jb = ppij % nn_N;
+
+        const int max_ii = std::min(M - i0, TILE_M);
+        const int j0 = jb * nr;
+        const int max_jj = std::min(N - j0, nr);
+
+        float tmp[TILE_M * 16];
+        gemm_bf16s_kernel(AT, BT, 0, tmp, nr, N, i0, i0 + max_ii, jb, jb + 1);
+
+        for (int ii = 0; ii < max_ii; ii++)
+        {
+            const int i = i0 + ii;
+
+            for (int jj = 0; jj < max_jj; jj++)
+            {
+                const int j = j0 + jj;
+
+                float sum = tmp[ii * nr + jj];
+
+                if (pC)
+                    sum += gemm_bf16s_get_C(pC, broadcast_type_C, N, i, j);
+
+                sum *= alpha;
+
+                const int offset = output_transpose ? j * out_hstep + i : i * out_hstep + j;
+                if (out_fp32)
+                    ((float*)top_blob.data)[offset] = sum;
+                else
+                    ((unsigned short*)top_blob.data)[offset] = float32_to_bfloat16(sum);
+            }
+        }
+    }
+}
@@ -0,0 +1,458 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// bf16 storage gemm with fp32 accumulation, shared by gemm, innerproduct and convolution
+// B is packed into tiles of nr columns with k pairs interleaved, so that one tile row
+// feeds vdpbf16ps directly, the emulated path splits the pairs with shift and mask
+
+static int gemm_bf16s_get_nr()
+{
+#if __AVX512F__
+    return 16;
+#elif __AVX__
+    return 8;
+#else
+    return 4;
+#endif
+}
+
+static inline unsigned short gemm_bf16s_load(const Mat& X, int offset)
+{
+    if (X.elemsize == 2u)
+        return ((const unsigned short*)X.data)[offset];
+
+    return float32_to_bfloat16(((const float*)X.data)[offset]);
+}
+
+// convert the rows of X to bf16 rows along K, zero padded to even K
+// X is (K, rows) when trans == 0, or (rows, K) when trans == 1, fp32 or bf16 with elempack 1
+static int gemm_bf16s_pack_A(const Mat& X, int trans, Mat& XT, Allocator* allocator, const Option& opt)
+{
+    const int X_h = X.dims == 3 ? X.c : X.h;
+    const int X_hstep = X.dims == 3 ? (int)X.cstep : X.w;
+
+    const int rows = trans ? X.w : X_h;
+    const int K = trans ? X_h : X.w;
+    const int Kp = (K + 1) / 2 * 2;
+
+    XT.create(Kp, rows, (size_t)2u, allocator);
+    if (XT.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int i = 0; i < rows; i++)
+    {
+        unsigned short* outptr = XT.row<unsigned short>(i);
+
+        if (!trans && X.elemsize == 2u)
+        {
+            memcpy(outptr, (const unsigned short*)X.data + i * X_hstep, K * sizeof(unsigned short));
+        }
+        else
+        {
+            for (int k = 0; k < K; k++)
+            {
+                outptr[k] = gemm_bf16s_load(X, trans ? k * X_hstep + i : i * X_hstep + k);
+            }
+        }
+
+        if (Kp != K)
+            outptr[K] = 0;
+    }
+
+    return 0;
+}
+
+// pack the rows of X into bf16 tiles of nr rows with k pairs interleaved, zero padded
+// X is (K, rows) when trans == 0, or (rows, K) when trans == 1, fp32 or bf16 with elempack 1
+static int gemm_bf16s_pack_B(const Mat& X, int trans, Mat& XT, Allocator* allocator, const Option& opt)
+{
+    const int X_h = X.dims == 3 ? X.c : X.h;
+    const int X_hstep = X.dims == 3 ? (int)X.cstep : X.w;
+
+    const int rows = trans ? X.w : X_h;
+    const int K = trans ? X_h : X.w;
+    const int Kp = (K + 1) / 2 * 2;
+
+    const int nr = gemm_bf16s_get_nr();
+    const int nn = (rows + nr - 1) / nr;
+
+    XT.create(Kp * nr, nn, (size_t)2u, allocator);
+    if (XT.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int jb = 0; jb < nn; jb++)
+    {
+        unsigned short* outptr = XT.row<unsigned short>(jb);
+
+        for (int k = 0; k < Kp; k += 2)
+        {
+            for (int jj = 0; jj < nr; jj++)
+            {
+                const int j = jb * nr + jj;
+
+                outptr[0] = j < rows && k < K ? gemm_bf16s_load(X, trans ? k * X_hstep + j : j * X_hstep + k) : 0;
+                outptr[1] = j < rows && k + 1 < K ? gemm_bf16s_load(X, trans ? (k + 1) * X_hstep + j : j * X_hstep + k + 1) : 0;
+                outptr += 2;
+            }
+        }
+    }
+
+    return 0;
+}
+
+#if __AMX_BF16__
+// tmm0 accumulates rows x 16 fp32
+// tmm1 tmm2 hold A and B of a 32 deep k block, tmm3 tmm4 hold A and B of the k tail
+static void gemm_bf16s_amx_tile_config(int rows, int tail)
+{
+    amx_tilecfg cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.palette_id = 1;
+    cfg.rows[0] = (unsigned char)rows;
+    cfg.colsb[0] = 64;
+    cfg.rows[1] = (unsigned char)rows;
+    cfg.colsb[1] = 64;
+    cfg.rows[2] = 16;
+    cfg.colsb[2] = 64;
+    if (tail > 0)
+    {
+        cfg.rows[3] = (unsigned char)rows;
+        cfg.colsb[3] = (unsigned short)(tail * 2);
+        cfg.rows[4] = (unsigned char)(tail / 2);
+        cfg.colsb[4] = 64;
+    }
+    _tile_loadconfig(&cfg);
+}
+
+// amx variant of gemm_bf16s_kernel, one tile covers 16 rows of AT and one 16 column tile of BT
+// a BT tile row of 16 interleaved k pairs is exactly the vnni layout tdpbf16ps expects for B
+static void gemm_bf16s_kernel_amx(const Mat& AT, const Mat& BT, const float* bias, float* C, int ldc, int N, int i0, int i1, int jb0, int jb1)
+{
+    const int Kp = AT.w;
+    const int tail = Kp % 32;
+    const int A_stride = (int)(AT.w * AT.elemsize);
+
+    float tmp[16 * 16];
+
+    int config_rows = 0;
+    for (int i = i0; i < i1; i += 16)
+    {
+        const int rows = std::min(i1 - i, 16);
+        if (rows != config_rows)
+        {
+            gemm_bf16s_amx_tile_config(rows, tail);
+            config_rows = rows;
+        }
+
+        const unsigned short* pA = AT.row<const unsigned short>(i);
+
+        for (int jb = jb0; jb < jb1; jb++)
+        {
+            const unsigned short* pB = BT.row<const unsigned short>(jb);
+            const int j = jb * 16;
+            const int max_jj = std::min(N - j, 16);
+
+            _tile_zero(0);
+
+            int k = 0;
+            for (; k + 31 < Kp; k += 32)
+            {
+                _tile_loadd(1, pA + k, A_stride);
+                _tile_loadd(2, pB + k * 16, 64);
+                _tile_dpbf16ps(0, 1, 2);
+            }
+            if (tail > 0)
+            {
+                _tile_loadd(3, pA + k, A_stride);
+                _tile_loadd(4, pB + k * 16, 64);
+                _tile_dpbf16ps(0, 3, 4);
+            }
+
+            _tile_stored(0, tmp, 64);
+
+            const __mmask16 _mask = (__mmask16)((1u << max_jj) - 1);
+            const __m512 _bias = bias ? _mm512_maskz_loadu_ps(_mask, bias + j) : _mm512_setzero_ps();
+
+            float* outptr = C + (i - i0) * ldc + (jb - jb0) * 16;
+            for (int ii = 0; ii < rows; ii++)
+            {
+                _mm512_mask_storeu_ps(outptr, _mask, _mm512_add_ps(_mm512_loadu_ps(tmp + ii * 16), _bias));
+                outptr += ldc;
+            }
+        }
+    }
+
+    _tile_release();
+}
+#endif // __AMX_BF16__
+
+// C = AT * BT^T + bias in fp32, for the rows [i0, i1) of AT and the column tiles [jb0, jb1) of BT
+// AT is (Kp, M) bf16, BT is from gemm_bf16s_pack_B, bias is per column and may be null
+// C points to the output of row i0 and tile jb0, only the first N columns of the whole output are written
+static void gemm_bf16s_kernel(const Mat& AT, const Mat& BT, const float* bias, float* C, int ldc, int N, int i0, int i1, int jb0, int jb1)
+{
+    const int Kp = AT.w;
+    const int nr = gemm_bf16s_get_nr();
+
+#if __AMX_BF16__
+    // tile setup does not pay off for shallow k or a few rows
+    if (Kp >= 32 && i1 - i0 >= 4)
+    {
+        gemm_bf16s_kernel_amx(AT, BT, bias, C, ldc, N, i0, i1, jb0, jb1);
+        return;
+    }
+#endif // __AMX_BF16__
+
+    for (int jb = jb0; jb < jb1; jb++)
+    {
+        const unsigned short* pB0 = BT.row<const unsigned short>(jb);
+        const int j = jb * nr;
+        const int max_jj = std::min(N - j, nr);
+
+        float* outptr0 = C + (jb - jb0) * nr;
+
+        int i = i0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+        const __mmask16 _mask = (__mmask16)((1u << max_jj) - 1);
+        const __m512 _bias = bias ? _mm512_maskz_loadu_ps(_mask, bias + j) : _mm512_setzero_ps();
+#if !__AVX512BF16__
+        const __m512i _himask = _mm512_set1_epi32((int)0xffff0000);
+#endif
+        for (; i + 3 < i1; i += 4)
+        {
+            const unsigned short* pA0 = AT.row<const unsigned short>(i);
+            const unsigned short* pA1 = AT.row<const unsigned short>(i + 1);
+            const unsigned short* pA2 = AT.row<const unsigned short>(i + 2);
+            const unsigned short* pA3 = AT.row<const unsigned short>(i + 3);
+            const unsigned short* pB = pB0;
+
+            __m512 _sum0 = _bias;
+            __m512 _sum1 = _bias;
+            __m512 _sum2 = _bias;
+            __m512 _sum3 = _bias;
+
+            for (int k = 0; k < Kp; k += 2)
+            {
+                __m512i _b = _mm512_loadu_si512((const __m512i*)pB);
+#if __AVX512BF16__
+                _sum0 = _mm512_dpbf16_ps(_sum0, (__m512bh)_mm512_set1_epi32(*(const int*)(pA0 + k)), (__m512bh)_b);
+                _sum1 = _mm512_dpbf16_ps(_sum1, (__m512bh)_mm512_set1_epi32(*(const int*)(pA1 + k)), (__m512bh)_b);
+                _sum2 = _mm512_dpbf16_ps(_sum2, (__m512bh)_mm512_set1_epi32(*(const int*)(pA2 + k)), (__m512bh)_b);
+                _sum3 = _mm512_dpbf16_ps(_sum3, (__m512bh)_mm512_set1_epi32(*(const int*)(pA3 + k)), (__m512bh)_b);
+#else
+                __m512 _b0 = _mm512_castsi512_ps(_mm512_slli_epi32(_b, 16));
+                __m512 _b1 = _mm512_castsi512_ps(_mm512_and_si512(_b, _himask));
+                _sum0 = _mm512_fmadd_ps(_mm512_set1_ps(bfloat16_to_float32(pA0[k])), _b0, _sum0);
+                _sum1 = _mm512_fmadd_ps(_mm512_set1_ps(bfloat16_to_float32(pA1[k])), _b0, _sum1);
+                _sum2 = _mm512_fmadd_ps(_mm512_set1_ps(bfloat16_to_float32(pA2[k])), _b0, _sum2);
+                _sum3 = _mm512_fmadd_ps(_mm512_set1_ps(bfloat16_to_float32(pA3[k])), _b0, _sum3);
+                _sum0 = _mm512_fmadd_ps(_mm512_set1_ps(bfloat16_to_float32(pA0[k + 1])), _b1, _sum0);
+                _sum1 = _mm512_fmadd_ps(_mm512_set1_ps(bfloat16_to_float32(pA1[k + 1])), _b1, _sum1);
+                _sum2 = _mm512_fmadd_ps(_mm512_set1_ps(bfloat16_to_float32(pA2[k + 1])), _b1, _sum2);
+                _sum3 = _mm512_fmadd_ps(_mm512_set1_ps(bfloat16_to_float32(pA3[k + 1])), _b1, _sum3);
+#endif
+                pB += 32;
+            }
+
+            float* outptr = outptr0 + (i - i0) * ldc;
+            _mm512_mask_storeu_ps(outptr, _mask, _sum0);
+            _mm512_mask_storeu_ps(outptr + ldc, _mask, _sum1);
+            _mm512_mask_storeu_ps(outptr + ldc * 2, _mask, _sum2);
+            _mm512_mask_storeu_ps(outptr + ldc * 3, _mask, _sum3);
+        }
+        for (; i < i1; i++)
+        {
+            const unsigned short* pA = AT.row<const unsigned short>(i);
+            const unsigned short* pB = pB0;
+
+            __m512 _sum = _bias;
+
+            for (int k = 0; k < Kp; k += 2)
+            {
+                __m512i _b = _mm512_loadu_si512((const __m512i*)pB);
+#if __AVX512BF16__
+                _sum = _mm512_dpbf16_ps(_sum, (__m512bh)_mm512_set1_epi32(*(const int*)(pA + k)), (__m512bh)_b);
+#else
+                __m512 _b0 = _mm512_castsi512_ps(_mm512_slli_epi32(_b, 16));
+                __m512 _b1 = _mm512_castsi512_ps(_mm512_and_si512(_b, _himask));
+                _sum = _mm512_fmadd_ps(_mm512_set1_ps(bfloat16_to_float32(pA[k])), _b0, _sum);
+                _sum = _mm512_fmadd_ps(_mm512_set1_ps(bfloat16_to_float32(pA[k + 1])), _b1, _sum);
+#endif
+                pB += 32;
+            }
+
+            _mm512_mask_storeu_ps(outptr0 + (i - i0) * ldc, _mask, _sum);
+        }
+#else  // __AVX512F__
+        float tmp[8];
+        for (int jj = 0; jj < 8; jj++)
+        {
+            tmp[jj] = bias && jj < max_jj ? bias[j + jj] : 0.f;
+        }
+        const __m256 _bias = _mm256_loadu_ps(tmp);
+        const __m256 _himask = _mm256_castsi256_ps(_mm256_set1_epi32((int)0xffff0000));
+        for (; i + 3 < i1; i += 4)
+        {
+            const unsigned short* pA0 = AT.row<const unsigned short>(i);
+            const unsigned short* pA1 = AT.row<const unsigned short>(i + 1);
+            const unsigned short* pA2 = AT.row<const unsigned short>(i + 2);
+            const unsigned short* pA3 = AT.row<const unsigned short>(i + 3);
+            const unsigned short* pB = pB0;
+
+            __m256 _sum0 = _bias;
+            __m256 _sum1 = _bias;
+            __m256 _sum2 = _bias;
+            __m256 _sum3 = _bias;
+
+            for (int k = 0; k < Kp; k += 2)
+            {
+                __m256i _b = _mm256_loadu_si256((const __m256i*)pB);
+#if __AVX2__
+                __m256 _b0 = _mm256_castsi256_ps(_mm256_slli_epi32(_b, 16));
+#else
+                __m128i _b0l = _mm_slli_epi32(_mm256_castsi256_si128(_b), 16);
+                __m128i _b0h = _mm_slli_epi32(_mm256_extractf128_si256(_b, 1), 16);
+                __m256 _b0 = _mm256_castsi256_ps(_mm256_insertf128_si256(_mm256_castsi128_si256(_b0l), _b0h, 1));
+#endif
+                __m256 _b1 = _mm256_and_ps(_mm256_castsi256_ps(_b), _himask);
+                _sum0 = _mm256_comp_fmadd_ps(_mm256_set1_ps(bfloat16_to_float32(pA0[k])), _b0, _sum0);
+                _sum1 = _mm256_comp_fmadd_ps(_mm256_set1_ps(bfloat16_to_float32(pA1[k])), _b0, _sum1);
+                _sum2 = _mm256_comp_fmadd_ps(_mm256_set1_ps(bfloat16_to_float32(pA2[k])), _b0, _sum2);
+                _sum3 = _mm256_comp_fmadd_ps(_mm256_set1_ps(bfloat16_to_float32(pA3[k])), _b0, _sum3);
+                _sum0 = _mm256_comp_fmadd_ps(_mm256_set1_ps(bfloat16_to_float32(pA0[k + 1])), _b1, _sum0);
+                _sum1 = _mm256_comp_fmadd_ps(_mm256_set1_ps(bfloat16_to_float32(pA1[k + 1])), _b1, _sum1);
+                _sum2 = _mm256_comp_fmadd_ps(_mm256_set1_ps(bfloat16_to_float32(pA2[k + 1])), _b1, _sum2);
+                _sum3 = _mm256_comp_fmadd_ps(_mm256_set1_ps(bfloat16_to_float32(pA3[k + 1])), _b1, _sum3);
+                pB += 16;
+            }
+
+            float* outptr = outptr0 + (i - i0) * ldc;
+            if (max_jj == 8)
+            {
+                _mm256_storeu_ps(outptr, _sum0);
+                _mm256_storeu_ps(outptr + ldc, _sum1);
+                _mm256_storeu_ps(outptr + ldc * 2, _sum2);
+                _mm256_storeu_ps(outptr + ldc * 3, _sum3);
+            }
+            else
+            {
+                _mm256_storeu_ps(tmp, _sum0);
+                memcpy(outptr, tmp, max_jj * sizeof(float));
+                _mm256_storeu_ps(tmp, _sum1);
+                memcpy(outptr + ldc, tmp, max_jj * sizeof(float));
+                _mm256_storeu_ps(tmp, _sum2);
+                memcpy(outptr + ldc * 2, tmp, max_jj * sizeof(float));
+                _mm256_storeu_ps(tmp, _sum3);
+                memcpy(outptr + ldc * 3, tmp, max_jj * sizeof(float));
+            }
+        }
+        for (; i < i1; i++)
+        {
+            const unsigned short* pA = AT.row<const unsigned short>(i);
+            const unsigned short* pB = pB0;
+
+            __m256 _sum = _bias;
+
+            for (int k = 0; k < Kp; k += 2)
+            {
+                __m256i _b = _mm256_loadu_si256((const __m256i*)pB);
+#if __AVX2__
+                __m256 _b0 = _mm256_castsi256_ps(_mm256_slli_epi32(_b, 16));
+#else
+                __m128i _b0l = _mm_slli_epi32(_mm256_castsi256_si128(_b), 16);
+                __m128i _b0h = _mm_slli_epi32(_mm256_extractf128_si256(_b, 1), 16);
+                __m256 _b0 = _mm256_castsi256_ps(_mm256_insertf128_si256(_mm256_castsi128_si256(_b0l), _b0h, 1));
+#endif
+                __m256 _b1 = _mm256_and_ps(_mm256_castsi256_ps(_b), _himask);
+                _sum = _mm256_comp_fmadd_ps(_mm256_set1_ps(bfloat16_to_float32(pA[k])), _b0, _sum);
+                _sum = _mm256_comp_fmadd_ps(_mm256_set1_ps(bfloat16_to_float32(pA[k + 1])), _b1, _sum);
+                pB += 16;
+            }
+
+            float* outptr = outptr0 + (i - i0) * ldc;
+            if (max_jj == 8)
+            {
+                _mm256_storeu_ps(outptr, _sum);
+            }
+            else
+            {
+                _mm256_storeu_ps(tmp, _sum);
+                memcpy(outptr, tmp, max_jj * sizeof(float));
+            }
+        }
+#endif // __AVX512F__
+#else  // __AVX__
+        float tmp[4];
+        for (int jj = 0; jj < 4; jj++)
+        {
+            tmp[jj] = bias && jj < max_jj ? bias[j + jj] : 0.f;
+        }
+        const __m128 _bias = _mm_loadu_ps(tmp);
+        const __m128i _himask = _mm_set1_epi32((int)0xffff0000);
+        for (; i < i1; i++)
+        {
+            const unsigned short* pA = AT.row<const unsigned short>(i);
+            const unsigned short* pB = pB0;
+
+            __m128 _sum = _bias;
+
+            for (int k = 0; k < Kp; k += 2)
+            {
+                __m128i _b = _mm_loadu_si128((const __m128i*)pB);
+                __m128 _b0 = _mm_castsi128_ps(_mm_slli_epi32(_b, 16));
+                __m128 _b1 = _mm_castsi128_ps(_mm_and_si128(_b, _himask));
+                _sum = _mm_comp_fmadd_ps(_mm_set1_ps(bfloat16_to_float32(pA[k])), _b0, _sum);
+                _sum = _mm_comp_fmadd_ps(_mm_set1_ps(bfloat16_to_float32(pA[k + 1])), _b1, _sum);
+                pB += 8;
+            }
+
+            float* outptr = outptr0 + (i - i0) * ldc;
+            if (max_jj == 4)
+            {
+                _mm_storeu_ps(outptr, _sum);
+            }
+            else
+            {
+                _mm_storeu_ps(tmp, _sum);
+                memcpy(outptr, tmp, max_jj * sizeof(float));
+            }
+        }
+#endif // __AVX__
+#endif // __SSE2__
+        for (; i < i1; i++)
+        {
+            const unsigned short* pA = AT.row<const unsigned short>(i);
+            float* outptr = outptr0 + (i - i0) * ldc;
+
+            for (int jj = 0; jj < max_jj; jj++)
+            {
+                const unsigned short* pB = pB0 + jj * 2;
+
+                float sum = bias ? bias[j + jj] : 0.f;
+                for (int k = 0; k < Kp; k += 2)
+                {
+                    sum += bfloat16_to_float32(pA[k]) * bfloat16_to_float32(pB[0]);
+                    sum += bfloat16_to_float32(pA[k + 1]) * bfloat16_to_float32(pB[1]);
+                    pB += nr * 2;
+                }
+
+                outptr[jj] = sum;
+            }
+        }
+    }
+}
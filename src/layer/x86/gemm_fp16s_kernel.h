@@ -0,0 +1,305 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// fp16 weight gemm with fp32 activation rows, shared by gemm and convolution
+// B is packed into fp16 tiles of nr columns along K and widened with f16c in the kernel
+// avx512fp16 multiplies in fp16 and flushes the partial sums into fp32 every few k
+
+static int gemm_fp16s_get_nr()
+{
+#if __AVX512F__
+    return 16;
+#else
+    return 8;
+#endif
+}
+
+static inline float gemm_fp16s_load(const Mat& X, int offset)
+{
+    if (X.elemsize == 2u)
+        return float16_to_float32(((const unsigned short*)X.data)[offset]);
+
+    return ((const float*)X.data)[offset];
+}
+
+// convert the rows of X to fp32 rows along K
+// X is (K, rows) when trans == 0, or (rows, K) when trans == 1, fp32 or fp16 with elempack 1
+static int gemm_fp16s_pack_A(const Mat& X, int trans, Mat& XT, Allocator* allocator, const Option& opt)
+{
+    const int X_h = X.dims == 3 ? X.c : X.h;
+    const int X_hstep = X.dims == 3 ? (int)X.cstep : X.w;
+
+    const int rows = trans ? X.w : X_h;
+    const int K = trans ? X_h : X.w;
+
+    XT.create(K, rows, (size_t)4u, allocator);
+    if (XT.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int i = 0; i < rows; i++)
+    {
+        float* outptr = XT.row(i);
+
+        if (!trans && X.elemsize == 4u)
+        {
+            memcpy(outptr, (const float*)X.data + i * X_hstep, K * sizeof(float));
+        }
+        else
+        {
+            for (int k = 0; k < K; k++)
+            {
+                outptr[k] = gemm_fp16s_load(X, trans ? k * X_hstep + i : i * X_hstep + k);
+            }
+        }
+    }
+
+    return 0;
+}
+
+// pack the rows of X into fp16 tiles of nr rows along K, zero padded
+// X is (K, rows) when trans == 0, or (rows, K) when trans == 1, fp32 or fp16 with elempack 1
+static int gemm_fp16s_pack_B(const Mat& X, int trans, Mat& XT, Allocator* allocator, const Option& opt)
+{
+    const int X_h = X.dims == 3 ? X.c : X.h;
+    const int X_hstep = X.dims == 3 ? (int)X.cstep : X.w;
+
+    const int rows = trans ? X.w : X_h;
+    const int K = trans ? X_h : X.w;
+
+    const int nr = gemm_fp16s_get_nr();
+    const int nn = (rows + nr - 1) / nr;
+
+    XT.create(K * nr, nn, (size_t)2u, allocator);
+    if (XT.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int jb = 0; jb < nn; jb++)
+    {
+        unsigned short* outptr = XT.row<unsigned short>(jb);
+
+        for (int k = 0; k < K; k++)
+        {
+            for (int jj = 0; jj < nr; jj++)
+            {
+                const int j = jb * nr + jj;
+
+                if (j >= rows)
+                    outptr[jj] = 0;
+                else if (X.elemsize == 2u)
+                    outptr[jj] = ((const unsigned short*)X.data)[trans ? k * X_hstep + j : j * X_hstep + k];
+                else
+                    outptr[jj] = float32_to_float16(((const float*)X.data)[trans ? k * X_hstep + j : j * X_hstep + k]);
+            }
+
+            outptr += nr;
+        }
+    }
+
+    return 0;
+}
+
+#if __F16C__
+// C = AT * BT^T + bias in fp32, for the rows [i0, i1) of AT and the column tiles [jb0, jb1) of BT
+// AT is (K, M) fp32, BT is from gemm_fp16s_pack_B, bias is per column and may be null
+// C points to the output of row i0 and tile jb0, only the first N columns of the whole output are written
+// fp16_arithmetic multiplies in fp16 on avx512_fp16, AT values beyond the fp16 range overflow then
+static void gemm_fp16s_kernel(const Mat& AT, const Mat& BT, const float* bias, float* C, int ldc, int N, int i0, int i1, int jb0, int jb1, bool fp16_arithmetic)
+{
+    const int K = AT.w;
+    const int nr = gemm_fp16s_get_nr();
+
+#if !__AVX512FP16__
+    (void)fp16_arithmetic;
+#endif
+
+    for (int jb = jb0; jb < jb1; jb++)
+    {
+        const unsigned short* pB0 = BT.row<const unsigned short>(jb);
+        const int j = jb * nr;
+        const int max_jj = std::min(N - j, nr);
+
+        float* outptr0 = C + (jb - jb0) * nr;
+
+        int i = i0;
+#if __AVX512F__
+        const __mmask16 _mask = (__mmask16)((1u << max_jj) - 1);
+        const __m512 _bias = bias ? _mm512_maskz_loadu_ps(_mask, bias + j) : _mm512_setzero_ps();
+        for (; i + 3 < i1; i += 4)
+        {
+            const float* pA0 = AT.row(i);
+            const float* pA1 = AT.row(i + 1);
+            const float* pA2 = AT.row(i + 2);
+            const float* pA3 = AT.row(i + 3);
+            const unsigned short* pB = pB0;
+
+            __m512 _sum0 = _bias;
+            __m512 _sum1 = _bias;
+            __m512 _sum2 = _bias;
+            __m512 _sum3 = _bias;
+
+            int k = 0;
+#if __AVX512FP16__
+            // short fp16 runs keep the rounding error of the partial sums small
+            for (; fp16_arithmetic && k + 7 < K; k += 8)
+            {
+                __m256h _sh0 = _mm256_setzero_ph();
+                __m256h _sh1 = _mm256_setzero_ph();
+                __m256h _sh2 = _mm256_setzero_ph();
+                __m256h _sh3 = _mm256_setzero_ph();
+
+                for (int kk = 0; kk < 8; kk++)
+                {
+                    __m256h _b = _mm256_castsi256_ph(_mm256_loadu_si256((const __m256i*)pB));
+                    _sh0 = _mm256_fmadd_ph(_mm256_set1_ph((_Float16)pA0[k + kk]), _b, _sh0);
+                    _sh1 = _mm256_fmadd_ph(_mm256_set1_ph((_Float16)pA1[k + kk]), _b, _sh1);
+                    _sh2 = _mm256_fmadd_ph(_mm256_set1_ph((_Float16)pA2[k + kk]), _b, _sh2);
+                    _sh3 = _mm256_fmadd_ph(_mm256_set1_ph((_Float16)pA3[k + kk]), _b, _sh3);
+                    pB += 16;
+                }
+
+                _sum0 = _mm512_add_ps(_sum0, _mm512_cvtxph_ps(_sh0));
+                _sum1 = _mm512_add_ps(_sum1, _mm512_cvtxph_ps(_sh1));
+                _sum2 = _mm512_add_ps(_sum2, _mm512_cvtxph_ps(_sh2));
+                _sum3 = _mm512_add_ps(_sum3, _mm512_cvtxph_ps(_sh3));
+            }
+#endif // __AVX512FP16__
+            for (; k < K; k++)
+            {
+                __m512 _b = _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*)pB));
+                _sum0 = _mm512_fmadd_ps(_mm512_set1_ps(pA0[k]), _b, _sum0);
+                _sum1 = _mm512_fmadd_ps(_mm512_set1_ps(pA1[k]), _b, _sum1);
+                _sum2 = _mm512_fmadd_ps(_mm512_set1_ps(pA2[k]), _b, _sum2);
+                _sum3 = _mm512_fmadd_ps(_mm512_set1_ps(pA3[k]), _b, _sum3);
+                pB += 16;
+            }
+
+            float* outptr = outptr0 + (i - i0) * ldc;
+            _mm512_mask_storeu_ps(outptr, _mask, _sum0);
+            _mm512_mask_storeu_ps(outptr + ldc, _mask, _sum1);
+            _mm512_mask_storeu_ps(outptr + ldc * 2, _mask, _sum2);
+            _mm512_mask_storeu_ps(outptr + ldc * 3, _mask, _sum3);
+        }
+        for (; i < i1; i++)
+        {
+            const float* pA = AT.row(i);
+            const unsigned short* pB = pB0;
+
+            __m512 _sum = _bias;
+
+            int k = 0;
+#if __AVX512FP16__
+            for (; fp16_arithmetic && k + 7 < K; k += 8)
+            {
+                __m256h _sh = _mm256_setzero_ph();
+
+                for (int kk = 0; kk < 8; kk++)
+                {
+                    __m256h _b = _mm256_castsi256_ph(_mm256_loadu_si256((const __m256i*)pB));
+                    _sh = _mm256_fmadd_ph(_mm256_set1_ph((_Float16)pA[k + kk]), _b, _sh);
+                    pB += 16;
+                }
+
+                _sum = _mm512_add_ps(_sum, _mm512_cvtxph_ps(_sh));
+            }
+#endif // __AVX512FP16__
+            for (; k < K; k++)
+            {
+                __m512 _b = _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*)pB));
+                _sum = _mm512_fmadd_ps(_mm512_set1_ps(pA[k]), _b, _sum);
+                pB += 16;
+            }
+
+            _mm512_mask_storeu_ps(outptr0 + (i - i0) * ldc, _mask, _sum);
+        }
+#else  // __AVX512F__
+        float tmp[8];
+        for (int jj = 0; jj < 8; jj++)
+        {
+            tmp[jj] = bias && jj < max_jj ? bias[j + jj] : 0.f;
+        }
+        const __m256 _bias = _mm256_loadu_ps(tmp);
+        for (; i + 3 < i1; i += 4)
+        {
+            const float* pA0 = AT.row(i);
+            const float* pA1 = AT.row(i + 1);
+            const float* pA2 = AT.row(i + 2);
+            const float* pA3 = AT.row(i + 3);
+            const unsigned short* pB = pB0;
+
+            __m256 _sum0 = _bias;
+            __m256 _sum1 = _bias;
+            __m256 _sum2 = _bias;
+            __m256 _sum3 = _bias;
+
+            for (int k = 0; k < K; k++)
+            {
+                __m256 _b = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)pB));
+                _sum0 = _mm256_comp_fmadd_ps(_mm256_set1_ps(pA0[k]), _b, _sum0);
+                _sum1 = _mm256_comp_fmadd_ps(_mm256_set1_ps(pA1[k]), _b, _sum1);
+                _sum2 = _mm256_comp_fmadd_ps(_mm256_set1_ps(pA2[k]), _b, _sum2);
+                _sum3 = _mm256_comp_fmadd_ps(_mm256_set1_ps(pA3[k]), _b, _sum3);
+                pB += 8;
+            }
+
+            float* outptr = outptr0 + (i - i0) * ldc;
+            if (max_jj == 8)
+            {
+                _mm256_storeu_ps(outptr, _sum0);
+                _mm256_storeu_ps(outptr + ldc, _sum1);
+                _mm256_storeu_ps(outptr + ldc * 2, _sum2);
+                _mm256_storeu_ps(outptr + ldc * 3, _sum3);
+            }
+            else
+            {
+                _mm256_storeu_ps(tmp, _sum0);
+                memcpy(outptr, tmp, max_jj * sizeof(float));
+                _mm256_storeu_ps(tmp, _sum1);
+                memcpy(outptr + ldc, tmp, max_jj * sizeof(float));
+                _mm256_storeu_ps(tmp, _sum2);
+                memcpy(outptr + ldc * 2, tmp, max_jj * sizeof(float));
+                _mm256_storeu_ps(tmp, _sum3);
+                memcpy(outptr + ldc * 3, tmp, max_jj * sizeof(float));
+            }
+        }
+        for (; i < i1; i++)
+        {
+            const float* pA = AT.row(i);
+            const unsigned short* pB = pB0;
+
+            __m256 _sum = _bias;
+
+            for (int k = 0; k < K; k++)
+            {
+                __m256 _b = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)pB));
+                _sum = _mm256_comp_fmadd_ps(_mm256_set1_ps(pA[k]), _b, _sum);
+                pB += 8;
+            }
+
+            float* outptr = outptr0 + (i - i0) * ldc;
+            if (max_jj == 8)
+            {
+                _mm256_storeu_ps(outptr, _sum);
+            }
+            else
+            {
+                _mm256_storeu_ps(tmp, _sum);
+                memcpy(outptr, tmp, max_jj * sizeof(float));
+            }
+        }
+#endif // __AVX512F__
+    }
+}
+#endif // __F16C__
@@ -0,0 +1,672 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#if NCNN_RUNTIME_CPU && NCNN_AMXINT8 && __AVX512F__ && !__AMX_INT8__
+void gemm_int8_amxint8(const Mat& AT, const Mat& AT_scales, const Mat& BT, const Mat& BT_scales, const Mat& C, Mat& top_blob, int broadcast_type_C, float alpha, int output_transpose, const Option& opt);
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX512VNNI && __AVX512F__ && !__AVX512VNNI__
+void gemm_int8_avx512vnni(const Mat& AT, const Mat& AT_scales, const Mat& BT, const Mat& BT_scales, const Mat& C, Mat& top_blob, int broadcast_type_C, float alpha, int output_transpose, const Option& opt);
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVXVNNI && __AVX2__ && !__AVX512F__ && !__AVXVNNI__ && !__AVX512VNNI__
+void gemm_int8_avxvnni(const Mat& AT, const Mat& AT_scales, const Mat& BT, const Mat& BT_scales, const Mat& C, Mat& top_blob, int broadcast_type_C, float alpha, int output_transpose, const Option& opt);
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__ && !__AVXVNNI__ && !__AVX512VNNI__
+void gemm_int8_avx2(const Mat& AT, const Mat& AT_scales, const Mat& BT, const Mat& BT_scales, const Mat& C, Mat& top_blob, int broadcast_type_C, float alpha, int output_transpose, const Option& opt);
+#endif
+
+static float gemm_int8_get_absmax(const float* ptr, int size)
+{
+    float absmax = 0.f;
+
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    __m512 _absmax_avx512 = _mm512_set1_ps(0.f);
+    for (; i + 15 < size; i += 16)
+    {
+        __m512 _p = _mm512_loadu_ps(ptr);
+        _absmax_avx512 = _mm512_max_ps(_absmax_avx512, abs512_ps(_p));
+        ptr += 16;
+    }
+    absmax = std::max(absmax, _mm512_comp_reduce_max_ps(_absmax_avx512));
+#endif // __AVX512F__
+    __m256 _absmax_avx = _mm256_set1_ps(0.f);
+    for (; i + 7 < size; i += 8)
+    {
+        __m256 _p = _mm256_loadu_ps(ptr);
+        _absmax_avx = _mm256_max_ps(_absmax_avx, abs256_ps(_p));
+        ptr += 8;
+    }
+    absmax = std::max(absmax, _mm256_reduce_max_ps(_absmax_avx));
+#endif // __AVX__
+    __m128 _absmax = _mm_set1_ps(0.f);
+    for (; i + 3 < size; i += 4)
+    {
+        __m128 _p = _mm_loadu_ps(ptr);
+        _absmax = _mm_max_ps(_absmax, abs_ps(_p));
+        ptr += 4;
+    }
+    absmax = std::max(absmax, _mm_reduce_max_ps(_absmax));
+#endif // __SSE2__
+    for (; i < size; i++)
+    {
+        absmax = std::max(absmax, (float)fabs(*ptr));
+        ptr++;
+    }
+
+    return absmax;
+}
+
+static void gemm_int8_scale2int8(const float* ptr, int size, float scale, signed char* outptr)
+{
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    __m512 _scale_avx512 = _mm512_set1_ps(scale);
+    for (; i + 15 < size; i += 16)
+    {
+        __m512 _p = _mm512_loadu_ps(ptr);
+        _p = _mm512_mul_ps(_p, _scale_avx512);
+        _mm_storeu_si128((__m128i*)outptr, float2int8_avx512(_p));
+        ptr += 16;
+        outptr += 16;
+    }
+#endif // __AVX512F__
+    __m256 _scale_avx = _mm256_set1_ps(scale);
+    for (; i + 7 < size; i += 8)
+    {
+        __m256 _p = _mm256_loadu_ps(ptr);
+        _p = _mm256_mul_ps(_p, _scale_avx);
+        *(int64_t*)outptr = float2int8_avx(_p);
+        ptr += 8;
+        outptr += 8;
+    }
+#endif // __AVX__
+    __m128 _scale = _mm_set1_ps(scale);
+    for (; i + 3 < size; i += 4)
+    {
+        __m128 _p = _mm_loadu_ps(ptr);
+        _p = _mm_mul_ps(_p, _scale);
+        *(int32_t*)outptr = float2int8_sse(_p);
+        ptr += 4;
+        outptr += 4;
+    }
+#endif // __SSE2__
+    for (; i < size; i++)
+    {
+        *outptr++ = float2int8(*ptr++ * scale);
+    }
+}
+
+// quantize the rows of X to int8 rows along K
+// X is (K, rows) when trans == 0, or (rows, K) when trans == 1
+// use the given scales, or the absmax of each row when scales is empty
+static int gemm_quantize_int8(const Mat& X, int trans, const Mat& scales, Mat& XT, Mat& XT_scales, const Option& opt)
+{
+    const int X_h = X.dims == 3 ? X.c : X.h;
+    const int X_hstep = X.dims == 3 ? (int)X.cstep : X.w;
+
+    const int rows = trans ? X.w : X_h;
+    const int K = trans ? X_h : X.w;
+
+    XT.create(K, rows, (size_t)1u, opt.workspace_allocator);
+    if (XT.empty())
+        return -100;
+
+    if (X.elemsize == 1u)
+    {
+        // already int8, only the layout changes
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i = 0; i < rows; i++)
+        {
+            signed char* outptr = XT.row<signed char>(i);
+
+            if (trans)
+            {
+                const signed char* ptr = (const signed char*)X.data + i;
+                for (int k = 0; k < K; k++)
+                {
+                    outptr[k] = ptr[k * X_hstep];
+                }
+            }
+            else
+            {
+                memcpy(outptr, (const signed char*)X.data + i * X_hstep, K);
+            }
+        }
+
+        XT_scales = scales;
+        return 0;
+    }
+
+    if (scales.empty())
+    {
+        XT_scales.create(rows, (size_t)4u, opt.workspace_allocator);
+        if (XT_scales.empty())
+            return -100;
+
+        if (trans)
+        {
+            XT_scales.fill(0.f);
+
+            float* absmax = XT_scales;
+            for (int k = 0; k < K; k++)
+            {
+                const float* ptr = (const float*)X.data + k * X_hstep;
+                for (int i = 0; i < rows; i++)
+                {
+                    absmax[i] = std::max(absmax[i], (float)fabs(ptr[i]));
+                }
+            }
+
+            for (int i = 0; i < rows; i++)
+            {
+                absmax[i] = absmax[i] == 0.f ? 1.f : 127.f / absmax[i];
+            }
+        }
+        else
+        {
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int i = 0; i < rows; i++)
+            {
+                const float absmax = gemm_int8_get_absmax((const float*)X.data + i * X_hstep, K);
+                XT_scales[i] = absmax == 0.f ? 1.f : 127.f / absmax;
+            }
+        }
+    }
+    else
+    {
+        XT_scales = scales;
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int i = 0; i < rows; i++)
+    {
+        signed char* outptr = XT.row<signed char>(i);
+        const float scale = XT_scales[i];
+
+        if (trans)
+        {
+            const float* ptr = (const float*)X.data + i;
+            for (int k = 0; k < K; k++)
+            {
+                outptr[k] = float2int8(ptr[k * X_hstep] * scale);
+            }
+        }
+        else
+        {
+            gemm_int8_scale2int8((const float*)X.data + i * X_hstep, K, scale, outptr);
+        }
+    }
+
+    return 0;
+}
+
+#if __SSE2__
+static NCNN_FORCEINLINE __m128i gemm_int8_cvtepi8_epi16(__m128i _v)
+{
+#if __SSE4_1__
+    return _mm_cvtepi8_epi16(_v);
+#else
+    return _mm_unpacklo_epi8(_v, _mm_cmpgt_epi8(_mm_setzero_si128(), _v));
+#endif
+}
+#endif // __SSE2__
+
+// dot one int8 row of A with four int8 rows of B
+static void gemm_int8_dot_1x4(const signed char* pA, const signed char* pB0, const signed char* pB1, const signed char* pB2, const signed char* pB3, int K, int* sums)
+{
+    int sum0 = 0;
+    int sum1 = 0;
+    int sum2 = 0;
+    int sum3 = 0;
+
+    int k = 0;
+#if __SSE2__
+#if __AVX2__
+#if __AVX512F__
+    {
+        __m512i _sum0 = _mm512_setzero_si512();
+        __m512i _sum1 = _mm512_setzero_si512();
+        __m512i _sum2 = _mm512_setzero_si512();
+        __m512i _sum3 = _mm512_setzero_si512();
+        for (; k + 31 < K; k += 32)
+        {
+            __m512i _a = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(pA + k)));
+            __m512i _b0 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(pB0 + k)));
+            __m512i _b1 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(pB1 + k)));
+            __m512i _b2 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(pB2 + k)));
+            __m512i _b3 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(pB3 + k)));
+#if __AVX512VNNI__
+            _sum0 = _mm512_dpwssd_epi32(_sum0, _a, _b0);
+            _sum1 = _mm512_dpwssd_epi32(_sum1, _a, _b1);
+            _sum2 = _mm512_dpwssd_epi32(_sum2, _a, _b2);
+            _sum3 = _mm512_dpwssd_epi32(_sum3, _a, _b3);
+#else
+            _sum0 = _mm512_add_epi32(_sum0, _mm512_madd_epi16(_a, _b0));
+            _sum1 = _mm512_add_epi32(_sum1, _mm512_madd_epi16(_a, _b1));
+            _sum2 = _mm512_add_epi32(_sum2, _mm512_madd_epi16(_a, _b2));
+            _sum3 = _mm512_add_epi32(_sum3, _mm512_madd_epi16(_a, _b3));
+#endif // __AVX512VNNI__
+        }
+        sum0 += _mm512_reduce_add_epi32(_sum0);
+        sum1 += _mm512_reduce_add_epi32(_sum1);
+        sum2 += _mm512_reduce_add_epi32(_sum2);
+        sum3 += _mm512_reduce_add_epi32(_sum3);
+    }
+#endif // __AVX512F__
+    {
+        __m256i _sum0 = _mm256_setzero_si256();
+        __m256i _sum1 = _mm256_setzero_si256();
+        __m256i _sum2 = _mm256_setzero_si256();
+        __m256i _sum3 = _mm256_setzero_si256();
+        for (; k + 15 < K; k += 16)
+        {
+            __m256i _a = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(pA + k)));
+            __m256i _b0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(pB0 + k)));
+            __m256i _b1 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(pB1 + k)));
+            __m256i _b2 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(pB2 + k)));
+            __m256i _b3 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(pB3 + k)));
+#if __AVXVNNI__ || __AVX512VNNI__
+            _sum0 = _mm256_dpwssd_epi32(_sum0, _a, _b0);
+            _sum1 = _mm256_dpwssd_epi32(_sum1, _a, _b1);
+            _sum2 = _mm256_dpwssd_epi32(_sum2, _a, _b2);
+            _sum3 = _mm256_dpwssd_epi32(_sum3, _a, _b3);
+#else
+            _sum0 = _mm256_add_epi32(_sum0, _mm256_madd_epi16(_a, _b0));
+            _sum1 = _mm256_add_epi32(_sum1, _mm256_madd_epi16(_a, _b1));
+            _sum2 = _mm256_add_epi32(_sum2, _mm256_madd_epi16(_a, _b2));
+            _sum3 = _mm256_add_epi32(_sum3, _mm256_madd_epi16(_a, _b3));
+#endif // __AVXVNNI__ || __AVX512VNNI__
+        }
+        sum0 += _mm_reduce_add_epi32(_mm_add_epi32(_mm256_castsi256_si128(_sum0), _mm256_extracti128_si256(_sum0, 1)));
+        sum1 += _mm_reduce_add_epi32(_mm_add_epi32(_mm256_castsi256_si128(_sum1), _mm256_extracti128_si256(_sum1, 1)));
+        sum2 += _mm_reduce_add_epi32(_mm_add_epi32(_mm256_castsi256_si128(_sum2), _mm256_extracti128_si256(_sum2, 1)));
+        sum3 += _mm_reduce_add_epi32(_mm_add_epi32(_mm256_castsi256_si128(_sum3), _mm256_extracti128_si256(_sum3, 1)));
+    }
+#endif // __AVX2__
+    {
+        __m128i _sum0 = _mm_setzero_si128();
+        __m128i _sum1 = _mm_setzero_si128();
+        __m128i _sum2 = _mm_setzero_si128();
+        __m128i _sum3 = _mm_setzero_si128();
+        for (; k + 7 < K; k += 8)
+        {
+            __m128i _a = gemm_int8_cvtepi8_epi16(_mm_loadl_epi64((const __m128i*)(pA + k)));
+            __m128i _b0 = gemm_int8_cvtepi8_epi16(_mm_loadl_epi64((const __m128i*)(pB0 + k)));
+            __m128i _b1 = gemm_int8_cvtepi8_epi16(_mm_loadl_epi64((const __m128i*)(pB1 + k)));
+            __m128i _b2 = gemm_int8_cvtepi8_epi16(_mm_loadl_epi64((const __m128i*)(pB2 + k)));
+            __m128i _b3 = gemm_int8_cvtepi8_epi16(_mm_loadl_epi64((const __m128i*)(pB3 + k)));
+            _sum0 = _mm_add_epi32(_sum0, _mm_madd_epi16(_a, _b0));
+            _sum1 = _mm_add_epi32(_sum1, _mm_madd_epi16(_a, _b1));
+            _sum2 = _mm_add_epi32(_sum2, _mm_madd_epi16(_a, _b2));
+            _sum3 = _mm_add_epi32(_sum3, _mm_madd_epi16(_a, _b3));
+        }
+        sum0 += _mm_reduce_add_epi32(_sum0);
+        sum1 += _mm_reduce_add_epi32(_sum1);
+        sum2 += _mm_reduce_add_epi32(_sum2);
+        sum3 += _mm_reduce_add_epi32(_sum3);
+    }
+#endif // __SSE2__
+    for (; k < K; k++)
+    {
+        sum0 += pA[k] * pB0[k];
+        sum1 += pA[k] * pB1[k];
+        sum2 += pA[k] * pB2[k];
+        sum3 += pA[k] * pB3[k];
+    }
+
+    sums[0] = sum0;
+    sums[1] = sum1;
+    sums[2] = sum2;
+    sums[3] = sum3;
+}
+
+static int gemm_int8_dot_1x1(const signed char* pA, const signed char* pB, int K)
+{
+    int sum = 0;
+
+    int k = 0;
+#if __SSE2__
+#if __AVX2__
+#if __AVX512F__
+    {
+        __m512i _sum = _mm512_setzero_si512();
+        for (; k + 31 < K; k += 32)
+        {
+            __m512i _a = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(pA + k)));
+            __m512i _b = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(pB + k)));
+#if __AVX512VNNI__
+            _sum = _mm512_dpwssd_epi32(_sum, _a, _b);
+#else
+            _sum = _mm512_add_epi32(_sum, _mm512_madd_epi16(_a, _b));
+#endif // __AVX512VNNI__
+        }
+        sum += _mm512_reduce_add_epi32(_sum);
+    }
+#endif // __AVX512F__
+    {
+        __m256i _sum = _mm256_setzero_si256();
+        for (; k + 15 < K; k += 16)
+        {
+            __m256i _a = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(pA + k)));
+            __m256i _b = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(pB + k)));
+#if __AVXVNNI__ || __AVX512VNNI__
+            _sum = _mm256_dpwssd_epi32(_sum, _a, _b);
+#else
+            _sum = _mm256_add_epi32(_sum, _mm256_madd_epi16(_a, _b));
+#endif // __AVXVNNI__ || __AVX512VNNI__
+        }
+        sum += _mm_reduce_add_epi32(_mm_add_epi32(_mm256_castsi256_si128(_sum), _mm256_extracti128_si256(_sum, 1)));
+    }
+#endif // __AVX2__
+    {
+        __m128i _sum = _mm_setzero_si128();
+        for (; k + 7 < K; k += 8)
+        {
+            __m128i _a = gemm_int8_cvtepi8_epi16(_mm_loadl_epi64((const __m128i*)(pA + k)));
+            __m128i _b = gemm_int8_cvtepi8_epi16(_mm_loadl_epi64((const __m128i*)(pB + k)));
+            _sum = _mm_add_epi32(_sum, _mm_madd_epi16(_a, _b));
+        }
+        sum += _mm_reduce_add_epi32(_sum);
+    }
+#endif // __SSE2__
+    for (; k < K; k++)
+    {
+        sum += pA[k] * pB[k];
+    }
+
+    return sum;
+}
+
+static inline float gemm_int8_get_C(const float* pC, int broadcast_type_C, int N, int i, int j)
+{
+    if (broadcast_type_C == 0)
+        return pC[0];
+    if (broadcast_type_C == 1 || broadcast_type_C == 2)
+        return pC[i];
+    if (broadcast_type_C == 3)
+        return pC[i * N + j];
+    // broadcast_type_C == 4
+    return pC[j];
+}
+
+#if __AMX_INT8__
+// tmm0 accumulates rows x 16 int32
+// tmm1 tmm2 hold A and B of a 64 deep k block, tmm3 tmm4 hold A and B of the k tail
+static void gemm_int8_amx_tile_config(int rows, int tail)
+{
+    amx_tilecfg cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.palette_id = 1;
+    cfg.rows[0] = (unsigned char)rows;
+    cfg.colsb[0] = 64;
+    cfg.rows[1] = (unsigned char)rows;
+    cfg.colsb[1] = 64;
+    cfg.rows[2] = 16;
+    cfg.colsb[2] = 64;
+    if (tail > 0)
+    {
+        cfg.rows[3] = (unsigned char)rows;
+        cfg.colsb[3] = (unsigned short)tail;
+        cfg.rows[4] = (unsigned char)(tail / 4);
+        cfg.colsb[4] = 64;
+    }
+    _tile_loadconfig(&cfg);
+}
+
+// amx variant of gemm_int8, the rows of BT are regrouped into 16 column tiles with k quads
+// interleaved as tdpbssd expects, A rows are copied per block to a zero padded k
+static int gemm_int8_amx(const Mat& AT, const Mat& AT_scales, const Mat& BT, const Mat& BT_scales, const Mat& C, Mat& top_blob, int broadcast_type_C, float alpha, int output_transpose, const Option& opt)
+{
+    const int M = AT.h;
+    const int N = BT.h;
+    const int K = AT.w;
+    const int Kp = (K + 3) / 4 * 4;
+    const int tail = Kp % 64;
+
+    const int nn_M = (M + 15) / 16;
+    const int nn_N = (N + 15) / 16;
+
+    Mat BTX(Kp * 16, nn_N, (size_t)1u, opt.workspace_allocator);
+    Mat ATX(Kp, 16, opt.num_threads, (size_t)1u, opt.workspace_allocator);
+    if (BTX.empty() || ATX.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int jb = 0; jb < nn_N; jb++)
+    {
+        signed char* outptr = BTX.row<signed char>(jb);
+
+        for (int k = 0; k < Kp; k += 4)
+        {
+            for (int jj = 0; jj < 16; jj++)
+            {
+                const int j = jb * 16 + jj;
+                const signed char* ptr = j < N ? BT.row<const signed char>(j) : 0;
+
+                for (int q = 0; q < 4; q++)
+                {
+                    outptr[q] = ptr && k + q < K ? ptr[k + q] : 0;
+                }
+                outptr += 4;
+            }
+        }
+    }
+
+    const float* pC = C.empty() ? 0 : (const float*)C;
+
+    const int out_hstep = top_blob.dims == 3 ? (int)top_blob.cstep : top_blob.w;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int ppi = 0; ppi < nn_M; ppi++)
+    {
+        const int i0 = ppi * 16;
+        const int rows = std::min(M - i0, 16);
+
+        Mat AX = ATX.channel(get_omp_thread_num());
+        for (int ii = 0; ii < rows; ii++)
+        {
+            signed char* outptr = AX.row<signed char>(ii);
+            memcpy(outptr, AT.row<const signed char>(i0 + ii), K);
+            for (int k = K; k < Kp; k++)
+            {
+                outptr[k] = 0;
+            }
+        }
+
+        gemm_int8_amx_tile_config(rows, tail);
+
+        const signed char* pA = AX;
+
+        int tmp[16 * 16];
+
+        for (int jb = 0; jb < nn_N; jb++)
+        {
+            const signed char* pB = BTX.row<const signed char>(jb);
+
+            _tile_zero(0);
+
+            int k = 0;
+            for (; k + 63 < Kp; k += 64)
+            {
+                _tile_loadd(1, pA + k, Kp);
+                _tile_loadd(2, pB + k * 16, 64);
+                _tile_dpbssd(0, 1, 2);
+            }
+            if (tail > 0)
+            {
+                _tile_loadd(3, pA + k, Kp);
+                _tile_loadd(4, pB + k * 16, 64);
+                _tile_dpbssd(0, 3, 4);
+            }
+
+            _tile_stored(0, tmp, 64);
+
+            const int j0 = jb * 16;
+            const int max_jj = std::min(N - j0, 16);
+
+            for (int ii = 0; ii < rows; ii++)
+            {
+                const int i = i0 + ii;
+
+                for (int jj = 0; jj < max_jj; jj++)
+                {
+                    const int j = j0 + jj;
+
+                    float sum = tmp[ii * 16 + jj] / (AT_scales[i] * BT_scales[j]);
+
+                    if (pC)
+                        sum += gemm_int8_get_C(pC, broadcast_type_C, N, i, j);
+
+                    sum *= alpha;
+
+                    if (output_transpose)
+                        top_blob[j * out_hstep + i] = sum;
+                    else
+                        top_blob[i * out_hstep + j] = sum;
+                }
+            }
+        }
+
+        _tile_release();
+    }
+
+    return 0;
+}
+#endif // __AMX_INT8__
+
+// top = alpha * (dequantize(AT * BT^T) + C)
+// AT is (K, M) int8, BT is (K, N) int8, C is pre-multiplied with beta
+// top_blob is unpacked fp32, (N, M) or (M, N) when output_transpose
+static void gemm_int8(const Mat& AT, const Mat& AT_scales, const Mat& BT, const Mat& BT_scales, const Mat& C, Mat& top_blob, int broadcast_type_C, float alpha, int output_transpose, const Option& opt)
+{
+#if NCNN_RUNTIME_CPU && NCNN_AMXINT8 && __AVX512F__ && !__AMX_INT8__
+    if (ncnn::cpu_support_x86_amx_int8())
+    {
+        gemm_int8_amxint8(AT, AT_scales, BT, BT_scales, C, top_blob, broadcast_type_C, alpha, output_transpose, opt);
+        return;
+    }
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX512VNNI && __AVX512F__ && !__AVX512VNNI__
+    if (ncnn::cpu_support_x86_avx512_vnni())
+    {
+        gemm_int8_avx512vnni(AT, AT_scales, BT, BT_scales, C, top_blob, broadcast_type_C, alpha, output_transpose, opt);
+        return;
+    }
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVXVNNI && __AVX2__ && !__AVX512F__ && !__AVXVNNI__ && !__AVX512VNNI__
+    if (ncnn::cpu_support_x86_avx_vnni())
+    {
+        gemm_int8_avxvnni(AT, AT_scales, BT, BT_scales, C, top_blob, broadcast_type_C, alpha, output_transpose, opt);
+        return;
+    }
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__ && !__AVXVNNI__ && !__AVX512VNNI__
+    if (ncnn::cpu_support_x86_avx2())
+    {
+        gemm_int8_avx2(AT, AT_scales, BT, BT_scales, C, top_blob, broadcast_type_C, alpha, output_transpose, opt);
+        return;
+    }
+#endif
+
+    const int M = AT.h;
+    const int N = BT.h;
+    const int K = AT.w;
+
+#if __AMX_INT8__
+    // tile setup does not pay off for shallow k or a few rows
+    if (K >= 64 && M >= 4)
+    {
+        if (gemm_int8_amx(AT, AT_scales, BT, BT_scales, C, top_blob, broadcast_type_C, alpha, output_transpose, opt) == 0)
+            return;
+    }
+#endif // __AMX_INT8__
+
+    const float* pC = C.empty() ? 0 : (const float*)C;
+
+    const int out_hstep = top_blob.dims == 3 ? (int)top_blob.cstep : top_blob.w;
+
+    // a few rows of A share each group of four rows of B while it is hot in cache
+    const int TILE_M = 8;
+    const int nn_M = (M + TILE_M - 1) / TILE_M;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int ppi = 0; ppi < nn_M; ppi++)
+    {
+        const int i0 = ppi * TILE_M;
+        const int max_ii = std::min(M - i0, TILE_M);
+
+        int j = 0;
+        for (; j + 3 < N; j += 4)
+        {
+            const signed char* pB0 = BT.row<const signed char>(j);
+            const signed char* pB1 = BT.row<const signed char>(j + 1);
+            const signed char* pB2 = BT.row<const signed char>(j + 2);
+            const signed char* pB3 = BT.row<const signed char>(j + 3);
+
+            for (int ii = 0; ii < max_ii; ii++)
+            {
+                const int i = i0 + ii;
+
+                int sums[4];
+                gemm_int8_dot_1x4(AT.row<const signed char>(i), pB0, pB1, pB2, pB3, K, sums);
+
+                for (int jj = 0; jj < 4; jj++)
+                {
+                    float sum = sums[jj] / (AT_scales[i] * BT_scales[j + jj]);
+
+                    if (pC)
+                        sum += gemm_int8_get_C(pC, broadcast_type_C, N, i, j + jj);
+
+                    sum *= alpha;
+
+                    if (output_transpose)
+                        top_blob[(j + jj) * out_hstep + i] = sum;
+                    else
+                        top_blob[i * out_hstep + j + jj] = sum;
+                }
+            }
+        }
+        for (; j < N; j++)
+        {
+            const signed char* pB = BT.row<const signed char>(j);
+
+            for (int ii = 0; ii < max_ii; ii++)
+            {
+                const int i = i0 + ii;
+
+                float sum = gemm_int8_dot_1x1(AT.row<const signed char>(i), pB, K) / (AT_scales[i] * BT_scales[j]);
+
+                if (pC)
+                    sum += gemm_int8_get_C(pC, broadcast_type_C, N, i, j);
+
+                sum *= alpha;
+
+                if (output_transpose)
+                    top_blob[j * out_hstep + i] = sum;
+                else
+                    top_blob[i * out_hstep + j] = sum;
+            }
+        }
+    }
+}
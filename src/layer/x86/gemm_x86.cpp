@@ -16,21 +16,47 @@
 
 #if __SSE2__
 #include <emmintrin.h>
+#include "sse_mathfun.h"
 #if __AVX__
 #include <immintrin.h>
+#include "avx_mathfun.h"
+#if __AVX512F__
+#include "avx512_mathfun.h"
+#endif // __AVX512F__
 #endif // __AVX__
 #endif // __SSE2__
 #include "x86_usability.h"
 
+#include "benchmark.h"
 #include "cpu.h"
 
 namespace ncnn {
 
+#if NCNN_INT8
+#include "gemm_int8.h"
+#endif
+
+#if NCNN_BF16
+#include "gemm_bf16s_kernel.h"
+#include "gemm_bf16s.h"
+#endif
+
+#if NCNN_F16C && __AVX__
+#include "gemm_fp16s_kernel.h"
+#include "gemm_fp16s.h"
+#endif
+
 Gemm_x86::Gemm_x86()
 {
 #if __SSE2__
     support_packing = true;
 #endif // __SSE2__
+#if NCNN_BF16
+    support_bf16_storage = true;
+#endif
+#if NCNN_F16C && __AVX__
+    support_fp16_storage = cpu_support_x86_f16c();
+#endif
 
     nT = 0;
 }
@@ -7222,6 +7248,39 @@ static int gemm_AT_BT_x86(const Mat& AT, const Mat& BT, const Mat& C, Mat& top_b
 
 int Gemm_x86::create_pipeline(const Option& opt)
 {
+#if NCNN_INT8
+    if (int8_scale_term)
+    {
+        support_bf16_storage = false;
+        support_fp16_storage = false;
+        return create_pipeline_int8(opt);
+    }
+#endif
+
+#if NCNN_BF16
+    if (opt.use_bf16_storage)
+    {
+        return create_pipeline_bf16s(opt);
+    }
+#endif
+
+#if NCNN_F16C && __AVX__
+    // fp16 storage only pays off with constant weights
+    if (!constantA && !constantB)
+    {
+        support_fp16_storage = false;
+    }
+    else if (cpu_support_x86_f16c() && opt.use_fp16_storage && opt.use_x86_fp16_storage)
+    {
+        return create_pipeline_fp16s(opt);
+    }
+    else
+    {
+        // x86 fp16 storage is opt-in, the packed fp32 kernels run on fp32 blobs
+        support_fp16_storage = false;
+    }
+#endif
+
     if (constantA)
     {
         const int M = constantM;
@@ -7353,8 +7412,129 @@ int Gemm_x86::create_pipeline(const Option& opt)
     return 0;
 }
 
+int Gemm_x86::save_pipeline_data(std::vector<Mat>& pipeline_data) const
+{
+    if (!constantA && !constantB && !constantC)
+        return -1;
+
+    pipeline_data.clear();
+    pipeline_data.push_back(AT_data);
+    pipeline_data.push_back(BT_data);
+    pipeline_data.push_back(CT_data);
+
+    // the matrix shape the data is transformed for
+    Mat weight_shape(6, (size_t)4u);
+    int* ps = weight_shape;
+    ps[0] = constantM;
+    ps[1] = constantN;
+    ps[2] = constantK;
+    ps[3] = transA;
+    ps[4] = transB;
+    ps[5] = constant_broadcast_type_C;
+    pipeline_data.push_back(weight_shape);
+
+    return 0;
+}
+
+int Gemm_x86::load_pipeline_data(const std::vector<Mat>& pipeline_data, const Option& opt)
+{
+    if (!constantA && !constantB && !constantC)
+        return -1;
+
+    if (pipeline_data.size() != 4)
+        return -1;
+
+    const Mat& weight_shape = pipeline_data.back();
+    if (weight_shape.dims != 1 || weight_shape.w != 6 || weight_shape.elemsize != 4u)
+        return -1;
+
+    const int* ps = weight_shape;
+    if (ps[0] != constantM || ps[1] != constantN || ps[2] != constantK || ps[3] != transA || ps[4] != transB || ps[5] != constant_broadcast_type_C)
+        return -1;
+
+#if NCNN_INT8
+    if (int8_scale_term)
+    {
+        support_bf16_storage = false;
+        support_fp16_storage = false;
+    }
+#endif
+
+#if NCNN_F16C && __AVX__
+    if ((!constantA && !constantB) || !opt.use_x86_fp16_storage)
+        support_fp16_storage = false;
+#endif
+
+    AT_data = pipeline_data[0];
+    BT_data = pipeline_data[1];
+    CT_data = pipeline_data[2];
+
+    if (opt.lightmode)
+    {
+        if (constantA)
+            A_data.release();
+        if (constantB)
+            B_data.release();
+        if (constantC && constant_broadcast_type_C != -1)
+            C_data.release();
+    }
+
+    nT = opt.num_threads;
+
+    return 0;
+}
+
+int Gemm_x86::save_kernel_profile(std::vector<int>& profile) const
+{
+    kernel_cache.save(profile);
+
+    return 0;
+}
+
+int Gemm_x86::load_kernel_profile(const std::vector<int>& profile)
+{
+    if (profile.size() % 8 != 0)
+        return -1;
+
+    for (size_t i = 0; i < profile.size(); i += 8)
+    {
+        // tile m n k
+        if (profile[i + 4] <= 0 || profile[i + 5] <= 0 || profile[i + 6] <= 0)
+            return -1;
+    }
+
+    kernel_cache.clear();
+    kernel_cache.load(profile);
+
+    return 0;
+}
+
 int Gemm_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
+#if NCNN_INT8
+    if (int8_scale_term)
+    {
+        return forward_int8(bottom_blobs, top_blobs, opt);
+    }
+#endif
+
+#if NCNN_BF16
+    // create_pipeline only built the bf16 constants, fp32 input from a parent layer takes this path too
+    if (opt.use_bf16_storage)
+    {
+        profile_kernel("bf16s");
+        return forward_bf16s(bottom_blobs, top_blobs, opt);
+    }
+#endif
+
+#if NCNN_F16C && __AVX__
+    if (cpu_support_x86_f16c() && opt.use_fp16_storage && opt.use_x86_fp16_storage && !opt.use_bf16_storage && (constantA || constantB))
+    {
+        profile_kernel("fp16s");
+        return forward_fp16s(bottom_blobs, top_blobs, opt);
+    }
+#endif
+
     int M;
     int N;
     if (constantA && constantB)
@@ -7503,43 +7683,915 @@ int Gemm_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& to
         NCNN_LOGE("opt.num_threads %d changed, gemm will use load-time value %d", opt.num_threads, nT);
     }
 
+    // tile size for this shape, packed operands keep their load-time tiles
+    int tile[4] = {constant_TILE_M, constant_TILE_N, constant_TILE_K, 0};
+    if (!constantA || !constantB)
+    {
+        int K;
+        if (constantA || constantB)
+        {
+            K = constantK;
+        }
+        else
+        {
+            const Mat& A = bottom_blobs[0];
+            K = transA ? (A.dims == 3 ? A.c : A.h) * A.elempack : A.w;
+        }
+
+        // tuned tiles are remembered, a loaded profile is final
+        int key[4] = {M, N, K, _nT};
+        const bool autotune = opt.use_kernel_autotune && !kernel_cache.is_frozen();
+        if ((!autotune && !kernel_cache.is_frozen()) || kernel_cache.find(key, tile) != 0)
+        {
+            get_optimal_tile_mnk(M, N, K, constant_TILE_M, constant_TILE_N, constant_TILE_K, tile[0], tile[1], tile[2], _nT);
+            tile[3] = 0;
+
+            if (autotune)
+            {
+                autotune_tile(bottom_blobs, C, top_blob, broadcast_type_C, M, N, K, tile, _nT, opt);
+                kernel_cache.insert(key, tile);
+            }
+        }
+
+        if (constantA)
+        {
+            tile[0] = constant_TILE_M;
+            tile[2] = constant_TILE_K;
+        }
+        if (constantB)
+        {
+            tile[1] = constant_TILE_N;
+            tile[2] = constant_TILE_K;
+        }
+    }
+
+    int ret = forward_tile(bottom_blobs, C, top_blob, broadcast_type_C, tile, _nT, opt);
+    if (ret != 0)
+        return ret;
+
+    // multiply top_blob with alpha
+    if (alpha != 1.f)
+    {
+        const int size = top_blob.total() * out_elempack;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i = 0; i < size; i++)
+        {
+            top_blob[i] *= alpha;
+        }
+    }
+
+    return 0;
+}
+
+void Gemm_x86::autotune_tile(const std::vector<Mat>& bottom_blobs, const Mat& C, Mat& top_blob, int broadcast_type_C, int M, int N, int K, int* tile, int nT, const Option& opt) const
+{
+    // scale one tile edge at a time, only edges not fixed by packed operands
+    static const int scales[7][3] = {
+        {2, 2, 2},
+        {4, 2, 2},
+        {1, 2, 2},
+        {2, 4, 2},
+        {2, 1, 2},
+        {2, 2, 4},
+        {2, 2, 1},
+    };
+
+    const int dims[3] = {M, N, K};
+    const bool tunable[3] = {!constantA, !constantB, !constantA && !constantB};
+
+    int best_tile[4] = {tile[0], tile[1], tile[2], tile[3]};
+    double best_time = 0.0;
+    for (int i = 0; i < 7; i++)
+    {
+        int candidate[4] = {tile[0], tile[1], tile[2], tile[3]};
+
+        bool valid = true;
+        for (int j = 0; j < 3; j++)
+        {
+            if (scales[i][j] == 2)
+                continue;
+
+            candidate[j] = tile[j] * scales[i][j] / 2;
+            if (!tunable[j] || candidate[j] < 1 || (scales[i][j] > 2 && tile[j] >= dims[j]))
+                valid = false;
+        }
+
+        if (!valid)
+            continue;
+
+        // take the faster of two runs, the first one warms up cache and workspace
+        double time = 0.0;
+        for (int j = 0; j < 2; j++)
+        {
+            double start = get_current_time();
+            int ret = forward_tile(bottom_blobs, C, top_blob, broadcast_type_C, candidate, nT, opt);
+            double end = get_current_time();
+            if (ret != 0)
+            {
+                time = -1.0;
+                break;
+            }
+
+            if (j == 0 || end - start < time)
+                time = end - start;
+        }
+
+        if (time < 0.0)
+            continue;
+
+        if (best_time == 0.0 || time < best_time)
+        {
+            best_tile[0] = candidate[0];
+            best_tile[1] = candidate[1];
+            best_tile[2] = candidate[2];
+            best_time = time;
+        }
+    }
+
+    tile[0] = best_tile[0];
+    tile[1] = best_tile[1];
+    tile[2] = best_tile[2];
+}
+
+int Gemm_x86::forward_tile(const std::vector<Mat>& bottom_blobs, const Mat& C, Mat& top_blob, int broadcast_type_C, const int* tile, int nT, const Option& opt) const
+{
     int ret = 0;
     if (constantA && constantB)
     {
-        ret = gemm_AT_BT_x86(AT_data, BT_data, C, top_blob, broadcast_type_C, constantM, constantN, constantK, output_transpose, constant_TILE_M, constant_TILE_N, constant_TILE_K, _nT, opt);
+        profile_kernel("packed_ab");
+        ret = gemm_AT_BT_x86(AT_data, BT_data, C, top_blob, broadcast_type_C, constantM, constantN, constantK, output_transpose, tile[0], tile[1], tile[2], nT, opt);
     }
     else if (constantA)
     {
         const Mat& B = bottom_blobs[0];
-        ret = gemm_AT_x86(AT_data, B, C, top_blob, broadcast_type_C, constantM, constantK, transB, output_transpose, constant_TILE_M, constant_TILE_N, constant_TILE_K, _nT, opt);
+        profile_kernel("packed_a");
+        ret = gemm_AT_x86(AT_data, B, C, top_blob, broadcast_type_C, constantM, constantK, transB, output_transpose, tile[0], tile[1], tile[2], nT, opt);
     }
     else if (constantB)
     {
         const Mat& A = bottom_blobs[0];
-        ret = gemm_BT_x86(A, BT_data, C, top_blob, broadcast_type_C, constantN, constantK, transA, output_transpose, constant_TILE_M, constant_TILE_N, constant_TILE_K, _nT, opt);
+        profile_kernel("packed_b");
+        ret = gemm_BT_x86(A, BT_data, C, top_blob, broadcast_type_C, constantN, constantK, transA, output_transpose, tile[0], tile[1], tile[2], nT, opt);
     }
     else
     {
         const Mat& A = bottom_blobs[0];
         const Mat& B = bottom_blobs[1];
-        ret = gemm_x86(A, B, C, top_blob, broadcast_type_C, transA, transB, output_transpose, constant_TILE_M, constant_TILE_N, constant_TILE_K, _nT, opt);
+        profile_kernel("gemm");
+        ret = gemm_x86(A, B, C, top_blob, broadcast_type_C, transA, transB, output_transpose, tile[0], tile[1], tile[2], nT, opt);
     }
-    if (ret != 0)
-        return ret;
+    return ret;
+}
 
-    // multiply top_blob with alpha
-    if (alpha != 1.f)
+#if NCNN_BF16
+int Gemm_x86::create_pipeline_bf16s(const Option& opt)
+{
+    // bf16 rows of A along K, bf16 tiles of B along N
+    if (constantA)
     {
-        const int size = top_blob.total() * out_elempack;
+        int ret = gemm_bf16s_pack_A(A_data, transA, AT_data, (Allocator*)0, opt);
+        if (ret != 0)
+            return ret;
 
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int i = 0; i < size; i++)
+        if (opt.lightmode)
+            A_data.release();
+    }
+
+    if (constantB)
+    {
+        int ret = gemm_bf16s_pack_B(B_data, transB ? 0 : 1, BT_data, (Allocator*)0, opt);
+        if (ret != 0)
+            return ret;
+
+        if (opt.lightmode)
+            B_data.release();
+    }
+
+    if (constantC && constant_broadcast_type_C != -1)
+    {
+        CT_data = C_data;
+
+        // pre-multiply C with beta
+        if (beta != 1.f)
         {
-            top_blob[i] *= alpha;
+            Mat C2;
+            C2.create_like(C_data);
+            if (C2.empty())
+                return -100;
+
+            const int size = C_data.total();
+            for (int i = 0; i < size; i++)
+            {
+                C2[i] = C_data[i] * beta;
+            }
+
+            CT_data = C2;
+        }
+
+        if (opt.lightmode)
+            C_data.release();
+    }
+
+    if (constantA || constantB || constantC)
+    {
+        nT = opt.num_threads;
+    }
+
+    return 0;
+}
+
+int Gemm_x86::forward_bf16s(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    Option opt_unpack = opt;
+    opt_unpack.blob_allocator = opt.workspace_allocator;
+
+    Mat AT = AT_data;
+    if (!constantA)
+    {
+        Mat A;
+        convert_packing(bottom_blobs[0], A, 1, opt_unpack);
+        if (A.empty())
+            return -100;
+
+        int ret = gemm_bf16s_pack_A(A, transA, AT, opt.workspace_allocator, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    Mat BT = BT_data;
+    int N = constantN;
+    if (!constantB)
+    {
+        Mat B;
+        convert_packing(constantA ? bottom_blobs[0] : bottom_blobs[1], B, 1, opt_unpack);
+        if (B.empty())
+            return -100;
+
+        N = transB ? (B.dims == 3 ? B.c : B.h) : B.w;
+
+        int ret = gemm_bf16s_pack_B(B, transB ? 0 : 1, BT, opt.workspace_allocator, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    const int M = AT.h;
+
+    Mat C;
+    int broadcast_type_C = 0;
+    if (constantC)
+    {
+        C = CT_data;
+        broadcast_type_C = constant_broadcast_type_C;
+    }
+    else
+    {
+        if (constantA && constantB)
+        {
+            C = bottom_blobs.size() == 1 ? bottom_blobs[0] : Mat();
+        }
+        else if (constantA)
+        {
+            C = bottom_blobs.size() == 2 ? bottom_blobs[1] : Mat();
+        }
+        else if (constantB)
+        {
+            C = bottom_blobs.size() == 2 ? bottom_blobs[1] : Mat();
+        }
+        else
+        {
+            C = bottom_blobs.size() == 3 ? bottom_blobs[2] : Mat();
         }
+
+        if (!C.empty())
+        {
+            Mat C_unpacked;
+            convert_packing(C, C_unpacked, 1, opt_unpack);
+            if (C_unpacked.empty())
+                return -100;
+
+            if (C_unpacked.elembits() == 16)
+            {
+                Mat C_fp32;
+                cast_bfloat16_to_float32(C_unpacked, C_fp32, opt_unpack);
+                if (C_fp32.empty())
+                    return -100;
+
+                C_unpacked = C_fp32;
+            }
+
+            C = C_unpacked;
+
+            if (C.dims == 1 && C.w == 1)
+            {
+                // scalar
+                broadcast_type_C = 0;
+            }
+            if (C.dims == 1 && C.w == M)
+            {
+                // M
+                // auto broadcast from h to w is the ncnn-style convention
+                broadcast_type_C = 1;
+            }
+            if (C.dims == 1 && C.w == N)
+            {
+                // N
+                broadcast_type_C = 4;
+            }
+            if (C.dims == 2 && C.w == 1 && C.h == M)
+            {
+                // Mx1
+                broadcast_type_C = 2;
+            }
+            if (C.dims == 2 && C.w == N && C.h == M)
+            {
+                // MxN
+                broadcast_type_C = 3;
+            }
+            if (C.dims == 2 && C.w == N && C.h == 1)
+            {
+                // 1xN
+                broadcast_type_C = 4;
+            }
+
+            // pre-multiply C with beta
+            if (beta != 1.f)
+            {
+                Mat C2;
+                C2.create_like(C, opt.workspace_allocator);
+                if (C2.empty())
+                    return -100;
+
+                const int size = C.total();
+                for (int i = 0; i < size; i++)
+                {
+                    C2[i] = C[i] * beta;
+                }
+
+                C = C2;
+            }
+        }
+    }
+
+    int out_elempack = 1;
+#if __SSE2__
+    if (opt.use_packing_layout)
+    {
+        int outh = output_transpose ? N : M;
+#if __AVX512F__
+        out_elempack = outh % 16 == 0 ? 16 : outh % 8 == 0 ? 8 : outh % 4 == 0 ? 4 : 1;
+#elif __AVX__
+        out_elempack = outh % 8 == 0 ? 8 : outh % 4 == 0 ? 4 : 1;
+#else
+        out_elempack = outh % 4 == 0 ? 4 : 1;
+#endif
+    }
+#endif // __SSE2__
+    if (output_elempack)
+        out_elempack = output_elempack;
+
+    // output_elemtype 1 or fp32 input keeps fp32 output
+    const bool input_fp32 = !bottom_blobs.empty() && bottom_blobs[0].elembits() == 32;
+    const size_t out_elemsize = output_elemtype == 1 || input_fp32 ? 4u : 2u;
+
+    Mat& top_blob = top_blobs[0];
+
+    // write into the preallocated top_blob when no repacking is needed
+    Mat top_blob_unpacked;
+    if (out_elempack == 1)
+        top_blob_unpacked = top_blob;
+
+    Allocator* top_allocator = out_elempack == 1 ? opt.blob_allocator : opt.workspace_allocator;
+    if (output_transpose)
+    {
+        if (output_N1M)
+            top_blob_unpacked.create(M, 1, N, out_elemsize, top_allocator);
+        else
+            top_blob_unpacked.create(M, N, out_elemsize, top_allocator);
+    }
+    else
+    {
+        if (output_N1M)
+            top_blob_unpacked.create(N, 1, M, out_elemsize, top_allocator);
+        else
+            top_blob_unpacked.create(N, M, out_elemsize, top_allocator);
+    }
+    if (top_blob_unpacked.empty())
+        return -100;
+
+    gemm_bf16s(AT, BT, N, C, top_blob_unpacked, broadcast_type_C, alpha, output_transpose, opt);
+
+    if (out_elempack == 1)
+    {
+        top_blob = top_blob_unpacked;
+    }
+    else
+    {
+        convert_packing(top_blob_unpacked, top_blob, out_elempack, opt);
+        if (top_blob.empty())
+            return -100;
+    }
+
+    return 0;
+}
+#endif // NCNN_BF16
+
+#if NCNN_F16C && __AVX__
+int Gemm_x86::create_pipeline_fp16s(const Option& opt)
+{
+    // fp32 rows of A along K, fp16 tiles of B along N
+    if (constantA)
+    {
+        int ret = gemm_fp16s_pack_A(A_data, transA, AT_data, (Allocator*)0, opt);
+        if (ret != 0)
+            return ret;
+
+        if (opt.lightmode)
+            A_data.release();
+    }
+
+    if (constantB)
+    {
+        int ret = gemm_fp16s_pack_B(B_data, transB ? 0 : 1, BT_data, (Allocator*)0, opt);
+        if (ret != 0)
+            return ret;
+
+        if (opt.lightmode)
+            B_data.release();
+    }
+
+    if (constantC && constant_broadcast_type_C != -1)
+    {
+        CT_data = C_data;
+
+        // pre-multiply C with beta
+        if (beta != 1.f)
+        {
+            Mat C2;
+            C2.create_like(C_data);
+            if (C2.empty())
+                return -100;
+
+            const int size = C_data.total();
+            for (int i = 0; i < size; i++)
+            {
+                C2[i] = C_data[i] * beta;
+            }
+
+            CT_data = C2;
+        }
+
+        if (opt.lightmode)
+            C_data.release();
+    }
+
+    if (constantA || constantB || constantC)
+    {
+        nT = opt.num_threads;
+    }
+
+    return 0;
+}
+
+int Gemm_x86::forward_fp16s(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    Option opt_unpack = opt;
+    opt_unpack.blob_allocator = opt.workspace_allocator;
+
+    Mat AT = AT_data;
+    if (!constantA)
+    {
+        Mat A;
+        convert_packing(bottom_blobs[0], A, 1, opt_unpack);
+        if (A.empty())
+            return -100;
+
+        int ret = gemm_fp16s_pack_A(A, transA, AT, opt.workspace_allocator, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    Mat BT = BT_data;
+    int N = constantN;
+    if (!constantB)
+    {
+        Mat B;
+        convert_packing(constantA ? bottom_blobs[0] : bottom_blobs[1], B, 1, opt_unpack);
+        if (B.empty())
+            return -100;
+
+        N = transB ? (B.dims == 3 ? B.c : B.h) : B.w;
+
+        int ret = gemm_fp16s_pack_B(B, transB ? 0 : 1, BT, opt.workspace_allocator, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    const int M = AT.h;
+
+    Mat C;
+    int broadcast_type_C = 0;
+    if (constantC)
+    {
+        C = CT_data;
+        broadcast_type_C = constant_broadcast_type_C;
+    }
+    else
+    {
+        if (constantA && constantB)
+        {
+            C = bottom_blobs.size() == 1 ? bottom_blobs[0] : Mat();
+        }
+        else if (constantA)
+        {
+            C = bottom_blobs.size() == 2 ? bottom_blobs[1] : Mat();
+        }
+        else if (constantB)
+        {
+            C = bottom_blobs.size() == 2 ? bottom_blobs[1] : Mat();
+        }
+        else
+        {
+            C = bottom_blobs.size() == 3 ? bottom_blobs[2] : Mat();
+        }
+
+        if (!C.empty())
+        {
+            Mat C_unpacked;
+            convert_packing(C, C_unpacked, 1, opt_unpack);
+            if (C_unpacked.empty())
+                return -100;
+
+            if (C_unpacked.elembits() == 16)
+            {
+                Mat C_fp32;
+                cast_float16_to_float32(C_unpacked, C_fp32, opt_unpack);
+                if (C_fp32.empty())
+                    return -100;
+
+                C_unpacked = C_fp32;
+            }
+
+            C = C_unpacked;
+
+            if (C.dims == 1 && C.w == 1)
+            {
+                // scalar
+                broadcast_type_C = 0;
+            }
+            if (C.dims == 1 && C.w == M)
+            {
+                // M
+                // auto broadcast from h to w is the ncnn-style convention
+                broadcast_type_C = 1;
+            }
+            if (C.dims == 1 && C.w == N)
+            {
+                // N
+                broadcast_type_C = 4;
+            }
+            if (C.dims == 2 && C.w == 1 && C.h == M)
+            {
+                // Mx1
+                broadcast_type_C = 2;
+            }
+            if (C.dims == 2 && C.w == N && C.h == M)
+            {
+                // MxN
+                broadcast_type_C = 3;
+            }
+            if (C.dims == 2 && C.w == N && C.h == 1)
+            {
+                // 1xN
+                broadcast_type_C = 4;
+            }
+
+            // pre-multiply C with beta
+            if (beta != 1.f)
+            {
+                Mat C2;
+                C2.create_like(C, opt.workspace_allocator);
+                if (C2.empty())
+                    return -100;
+
+                const int size = C.total();
+                for (int i = 0; i < size; i++)
+                {
+                    C2[i] = C[i] * beta;
+                }
+
+                C = C2;
+            }
+        }
+    }
+
+    int out_elempack = 1;
+#if __SSE2__
+    if (opt.use_packing_layout)
+    {
+        int outh = output_transpose ? N : M;
+#if __AVX512F__
+        out_elempack = outh % 16 == 0 ? 16 : outh % 8 == 0 ? 8 : outh % 4 == 0 ? 4 : 1;
+#elif __AVX__
+        out_elempack = outh % 8 == 0 ? 8 : outh % 4 == 0 ? 4 : 1;
+#else
+        out_elempack = outh % 4 == 0 ? 4 : 1;
+#endif
+    }
+#endif // __SSE2__
+    if (output_elempack)
+        out_elempack = output_elempack;
+
+    // fp16 output follows fp16 input, output_elemtype 1 keeps fp32 output
+    const bool input_fp16 = !bottom_blobs.empty() && bottom_blobs[0].elembits() == 16;
+    const size_t out_elemsize = output_elemtype != 1 && input_fp16 ? 2u : 4u;
+
+    Mat& top_blob = top_blobs[0];
+
+    // write into the preallocated top_blob when no repacking is needed
+    Mat top_blob_unpacked;
+    if (out_elempack == 1)
+        top_blob_unpacked = top_blob;
+
+    Allocator* top_allocator = out_elempack == 1 ? opt.blob_allocator : opt.workspace_allocator;
+    if (output_transpose)
+    {
+        if (output_N1M)
+            top_blob_unpacked.create(M, 1, N, out_elemsize, top_allocator);
+        else
+            top_blob_unpacked.create(M, N, out_elemsize, top_allocator);
+    }
+    else
+    {
+        if (output_N1M)
+            top_blob_unpacked.create(N, 1, M, out_elemsize, top_allocator);
+        else
+            top_blob_unpacked.create(N, M, out_elemsize, top_allocator);
+    }
+    if (top_blob_unpacked.empty())
+        return -100;
+
+    gemm_fp16s(AT, BT, N, C, top_blob_unpacked, broadcast_type_C, alpha, output_transpose, opt);
+
+    if (out_elempack == 1)
+    {
+        top_blob = top_blob_unpacked;
+    }
+    else
+    {
+        convert_packing(top_blob_unpacked, top_blob, out_elempack, opt);
+        if (top_blob.empty())
+            return -100;
+    }
+
+    return 0;
+}
+#endif // NCNN_F16C && __AVX__
+
+#if NCNN_INT8
+int Gemm_x86::create_pipeline_int8(const Option& opt)
+{
+    Option opt_tm = opt;
+    opt_tm.workspace_allocator = 0;
+
+    // int8 rows along K, scales stay in A_data_int8_scales and B_data_int8_scales
+    if (constantA)
+    {
+        Mat AT_data_scales;
+        int ret = gemm_quantize_int8(A_data, transA, A_data_int8_scales, AT_data, AT_data_scales, opt_tm);
+        if (ret != 0)
+            return ret;
+
+        if (opt.lightmode)
+            A_data.release();
+    }
+
+    if (constantB)
+    {
+        Mat BT_data_scales;
+        int ret = gemm_quantize_int8(B_data, transB ? 0 : 1, B_data_int8_scales, BT_data, BT_data_scales, opt_tm);
+        if (ret != 0)
+            return ret;
+
+        if (opt.lightmode)
+            B_data.release();
+    }
+
+    if (constantC && constant_broadcast_type_C != -1)
+    {
+        CT_data = C_data;
+
+        // pre-multiply C with beta
+        if (beta != 1.f)
+        {
+            Mat C2;
+            C2.create_like(C_data);
+            if (C2.empty())
+                return -100;
+
+            const int size = C_data.total();
+            for (int i = 0; i < size; i++)
+            {
+                C2[i] = C_data[i] * beta;
+            }
+
+            CT_data = C2;
+        }
+
+        if (opt.lightmode)
+            C_data.release();
+    }
+
+    if (constantA || constantB || constantC)
+    {
+        nT = opt.num_threads;
+    }
+
+    return 0;
+}
+
+int Gemm_x86::forward_int8(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    Option opt_unpack = opt;
+    opt_unpack.blob_allocator = opt.workspace_allocator;
+
+    Mat AT = AT_data;
+    Mat AT_scales = A_data_int8_scales;
+    if (!constantA)
+    {
+        Mat A;
+        convert_packing(bottom_blobs[0], A, 1, opt_unpack);
+        if (A.empty())
+            return -100;
+
+        // dynamic quantize per row of A
+        int ret = gemm_quantize_int8(A, transA, Mat(), AT, AT_scales, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    Mat BT = BT_data;
+    Mat BT_scales = B_data_int8_scales;
+    if (!constantB)
+    {
+        Mat B;
+        convert_packing(constantA ? bottom_blobs[0] : bottom_blobs[1], B, 1, opt_unpack);
+        if (B.empty())
+            return -100;
+
+        // dynamic quantize per column of B
+        int ret = gemm_quantize_int8(B, transB ? 0 : 1, Mat(), BT, BT_scales, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    const int M = AT.h;
+    const int N = BT.h;
+
+    Mat C;
+    int broadcast_type_C = 0;
+    if (constantC)
+    {
+        C = CT_data;
+        broadcast_type_C = constant_broadcast_type_C;
+    }
+    else
+    {
+        if (constantA && constantB)
+        {
+            C = bottom_blobs.size() == 1 ? bottom_blobs[0] : Mat();
+        }
+        else if (constantA)
+        {
+            C = bottom_blobs.size() == 2 ? bottom_blobs[1] : Mat();
+        }
+        else if (constantB)
+        {
+            C = bottom_blobs.size() == 2 ? bottom_blobs[1] : Mat();
+        }
+        else
+        {
+            C = bottom_blobs.size() == 3 ? bottom_blobs[2] : Mat();
+        }
+
+        if (!C.empty())
+        {
+            Mat C_unpacked;
+            convert_packing(C, C_unpacked, 1, opt_unpack);
+            if (C_unpacked.empty())
+                return -100;
+
+            C = C_unpacked;
+
+            if (C.dims == 1 && C.w == 1)
+            {
+                // scalar
+                broadcast_type_C = 0;
+            }
+            if (C.dims == 1 && C.w == M)
+            {
+                // M
+                // auto broadcast from h to w is the ncnn-style convention
+                broadcast_type_C = 1;
+            }
+            if (C.dims == 1 && C.w == N)
+            {
+                // N
+                broadcast_type_C = 4;
+            }
+            if (C.dims == 2 && C.w == 1 && C.h == M)
+            {
+                // Mx1
+                broadcast_type_C = 2;
+            }
+            if (C.dims == 2 && C.w == N && C.h == M)
+            {
+                // MxN
+                broadcast_type_C = 3;
+            }
+            if (C.dims == 2 && C.w == N && C.h == 1)
+            {
+                // 1xN
+                broadcast_type_C = 4;
+            }
+
+            // pre-multiply C with beta
+            if (beta != 1.f)
+            {
+                Mat C2;
+                C2.create_like(C, opt.workspace_allocator);
+                if (C2.empty())
+                    return -100;
+
+                const int size = C.total();
+                for (int i = 0; i < size; i++)
+                {
+                    C2[i] = C[i] * beta;
+                }
+
+                C = C2;
+            }
+        }
+    }
+
+    int out_elempack = 1;
+#if __SSE2__
+    if (opt.use_packing_layout)
+    {
+        int outh = output_transpose ? N : M;
+#if __AVX512F__
+        out_elempack = outh % 16 == 0 ? 16 : outh % 8 == 0 ? 8 : outh % 4 == 0 ? 4 : 1;
+#elif __AVX__
+        out_elempack = outh % 8 == 0 ? 8 : outh % 4 == 0 ? 4 : 1;
+#else
+        out_elempack = outh % 4 == 0 ? 4 : 1;
+#endif
+    }
+#endif // __SSE2__
+    if (output_elempack)
+        out_elempack = output_elempack;
+
+    Mat& top_blob = top_blobs[0];
+
+    // write into the preallocated top_blob when no repacking is needed
+    Mat top_blob_unpacked;
+    if (out_elempack == 1)
+        top_blob_unpacked = top_blob;
+
+    Allocator* top_allocator = out_elempack == 1 ? opt.blob_allocator : opt.workspace_allocator;
+    if (output_transpose)
+    {
+        if (output_N1M)
+            top_blob_unpacked.create(M, 1, N, 4u, top_allocator);
+        else
+            top_blob_unpacked.create(M, N, 4u, top_allocator);
+    }
+    else
+    {
+        if (output_N1M)
+            top_blob_unpacked.create(N, 1, M, 4u, top_allocator);
+        else
+            top_blob_unpacked.create(N, M, 4u, top_allocator);
+    }
+    if (top_blob_unpacked.empty())
+        return -100;
+
+    profile_kernel("int8");
+    gemm_int8(AT, AT_scales, BT, BT_scales, C, top_blob_unpacked, broadcast_type_C, alpha, output_transpose, opt);
+
+    if (out_elempack == 1)
+    {
+        top_blob = top_blob_unpacked;
+    }
+    else
+    {
+        convert_packing(top_blob_unpacked, top_blob, out_elempack, opt);
+        if (top_blob.empty())
+            return -100;
     }
 
     return 0;
 }
+#endif // NCNN_INT8
 
 } // namespace ncnn
@@ -16,6 +16,7 @@
 #define LAYER_GEMM_X86_H
 
 #include "gemm.h"
+#include "kernel_cache.h"
 
 namespace ncnn {
 
@@ -26,13 +27,39 @@ public:
 
     virtual int create_pipeline(const Option& opt);
 
+    virtual int save_pipeline_data(std::vector<Mat>& pipeline_data) const;
+    virtual int load_pipeline_data(const std::vector<Mat>& pipeline_data, const Option& opt);
+
+    virtual int save_kernel_profile(std::vector<int>& profile) const;
+    virtual int load_kernel_profile(const std::vector<int>& profile);
+
     virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
 
+protected:
+#if NCNN_BF16
+    int create_pipeline_bf16s(const Option& opt);
+    int forward_bf16s(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
+#endif
+#if NCNN_F16C && __AVX__
+    int create_pipeline_fp16s(const Option& opt);
+    int forward_fp16s(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
+#endif
+#if NCNN_INT8
+    int create_pipeline_int8(const Option& opt);
+    int forward_int8(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
+#endif
+
+    void autotune_tile(const std::vector<Mat>& bottom_blobs, const Mat& C, Mat& top_blob, int broadcast_type_C, int M, int N, int K, int* tile, int nT, const Option& opt) const;
+    int forward_tile(const std::vector<Mat>& bottom_blobs, const Mat& C, Mat& top_blob, int broadcast_type_C, const int* tile, int nT, const Option& opt) const;
+
 public:
     int nT;
     Mat AT_data;
     Mat BT_data;
     Mat CT_data;
+
+    // fp32 tile size per M N K
+    mutable KernelCache kernel_cache;
 };
 
 } // namespace ncnn
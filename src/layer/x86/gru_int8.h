@@ -0,0 +1,722 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__
+void gru_transform_weight_int8_avx2(const Mat& weight_xc, const Mat& weight_xc_int8_scales, const Mat& weight_hc, const Mat& weight_hc_int8_scales, const Mat& bias_c, Mat& weight_data_tm, Mat& weight_data_tm_int8_descales, Mat& bias_c_tm, int size, int num_output, int num_directions, const Option& opt);
+void gru_int8_avx2(const Mat& bottom_blob_int8, const Mat& bottom_blob_int8_descales, Mat& top_blob, int reverse, const Mat& weight_data_tm, const Mat& weight_data_tm_int8_descales, const Mat& bias_c, Mat& hidden_state, const Option& opt);
+#endif
+
+// the packed layout is the same for sse2 and avx2 kernels
+static void gru_transform_weight_int8(const Mat& weight_xc, const Mat& weight_xc_int8_scales, const Mat& weight_hc, const Mat& weight_hc_int8_scales, const Mat& bias_c, Mat& weight_data_tm, Mat& weight_data_tm_int8_descales, Mat& bias_c_tm, int size, int num_output, int num_directions, const Option& opt)
+{
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__
+    if (ncnn::cpu_support_x86_avx2())
+    {
+        gru_transform_weight_int8_avx2(weight_xc, weight_xc_int8_scales, weight_hc, weight_hc_int8_scales, bias_c, weight_data_tm, weight_data_tm_int8_descales, bias_c_tm, size, num_output, num_directions, opt);
+        return;
+    }
+#endif
+
+#if __SSE2__
+    weight_data_tm.create(size * 12 + num_output * 12, num_output / 4 + num_output % 4, num_directions, 1u, 1);
+    weight_data_tm_int8_descales.create(12 + 12, num_output / 4 + num_output % 4, num_directions);
+#else
+    weight_data_tm.create(size * 3 + num_output * 3, num_output, num_directions, 1u, 1);
+    weight_data_tm_int8_descales.create(3 + 3, num_output, num_directions);
+#endif
+    bias_c_tm.create(num_output, 1, num_directions, 16u, 4);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int dr = 0; dr < num_directions; dr++)
+    {
+        const Mat weight_xc_dr = weight_xc.channel(dr);
+        const Mat weight_hc_dr = weight_hc.channel(dr);
+        const Mat bias_c_dr = bias_c.channel(dr);
+        const float* weight_xc_int8_scales_ptr = weight_xc_int8_scales.row(dr);
+        const float* weight_hc_int8_scales_ptr = weight_hc_int8_scales.row(dr);
+
+        Mat weight_data_tm_dr = weight_data_tm.channel(dr);
+        Mat bias_c_tm_dr = bias_c_tm.channel(dr);
+        Mat weight_data_tm_int8_descales_dr = weight_data_tm_int8_descales.channel(dr);
+
+        const float* bias_c_R = bias_c_dr.row(0);
+        const float* bias_c_U = bias_c_dr.row(1);
+        const float* bias_c_WN = bias_c_dr.row(2);
+        const float* bias_c_BN = bias_c_dr.row(3);
+
+        float* bias_c_RUBNWN = bias_c_tm_dr.row(0);
+
+        int q = 0;
+#if __SSE2__
+        for (; q + 3 < num_output; q += 4)
+        {
+            _mm_storeu_ps(bias_c_RUBNWN, _mm_loadu_ps(bias_c_R + q));
+            _mm_storeu_ps(bias_c_RUBNWN + 4, _mm_loadu_ps(bias_c_U + q));
+            _mm_storeu_ps(bias_c_RUBNWN + 8, _mm_loadu_ps(bias_c_BN + q));
+            _mm_storeu_ps(bias_c_RUBNWN + 12, _mm_loadu_ps(bias_c_WN + q));
+
+            bias_c_RUBNWN += 16;
+
+            const signed char* weight_xc_R[4];
+            const signed char* weight_xc_U[4];
+            const signed char* weight_xc_N[4];
+            const signed char* weight_hc_R[4];
+            const signed char* weight_hc_U[4];
+            const signed char* weight_hc_N[4];
+            for (int k = 0; k < 4; k++)
+            {
+                weight_xc_R[k] = weight_xc_dr.row<const signed char>(num_output * 0 + q + k);
+                weight_xc_U[k] = weight_xc_dr.row<const signed char>(num_output * 1 + q + k);
+                weight_xc_N[k] = weight_xc_dr.row<const signed char>(num_output * 2 + q + k);
+                weight_hc_R[k] = weight_hc_dr.row<const signed char>(num_output * 0 + q + k);
+                weight_hc_U[k] = weight_hc_dr.row<const signed char>(num_output * 1 + q + k);
+                weight_hc_N[k] = weight_hc_dr.row<const signed char>(num_output * 2 + q + k);
+            }
+
+            signed char* kptr = weight_data_tm_dr.row<signed char>(q / 4);
+            float* descales_ptr = weight_data_tm_int8_descales_dr.row(q / 4);
+
+            // R0 R0 R1 R1 R2 R2 R3 R3 U0 U0 U1 U1 U2 U2 U3 U3 for every two input
+            int i = 0;
+            for (; i + 1 < size; i += 2)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    kptr[k * 2] = weight_xc_R[k][i];
+                    kptr[k * 2 + 1] = weight_xc_R[k][i + 1];
+                    kptr[8 + k * 2] = weight_xc_U[k][i];
+                    kptr[8 + k * 2 + 1] = weight_xc_U[k][i + 1];
+                }
+
+                kptr += 16;
+            }
+            for (; i < size; i++)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    kptr[k] = weight_xc_R[k][i];
+                    kptr[4 + k] = weight_xc_U[k][i];
+                }
+
+                kptr += 8;
+            }
+
+            i = 0;
+            for (; i + 1 < num_output; i += 2)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    kptr[k * 2] = weight_hc_R[k][i];
+                    kptr[k * 2 + 1] = weight_hc_R[k][i + 1];
+                    kptr[8 + k * 2] = weight_hc_U[k][i];
+                    kptr[8 + k * 2 + 1] = weight_hc_U[k][i + 1];
+                }
+
+                kptr += 16;
+            }
+            for (; i < num_output; i++)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    kptr[k] = weight_hc_R[k][i];
+                    kptr[4 + k] = weight_hc_U[k][i];
+                }
+
+                kptr += 8;
+            }
+
+            // N0 N0 N1 N1 N2 N2 N3 N3 for every two hidden, then for every two input
+            i = 0;
+            for (; i + 1 < num_output; i += 2)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    kptr[k * 2] = weight_hc_N[k][i];
+                    kptr[k * 2 + 1] = weight_hc_N[k][i + 1];
+                }
+
+                kptr += 8;
+            }
+            for (; i < num_output; i++)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    kptr[k] = weight_hc_N[k][i];
+                }
+
+                kptr += 4;
+            }
+
+            i = 0;
+            for (; i + 1 < size; i += 2)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    kptr[k * 2] = weight_xc_N[k][i];
+                    kptr[k * 2 + 1] = weight_xc_N[k][i + 1];
+                }
+
+                kptr += 8;
+            }
+            for (; i < size; i++)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    kptr[k] = weight_xc_N[k][i];
+                }
+
+                kptr += 4;
+            }
+
+            for (int k = 0; k < 4; k++)
+            {
+                descales_ptr[k] = 1.f / weight_xc_int8_scales_ptr[num_output * 0 + q + k];
+                descales_ptr[4 + k] = 1.f / weight_xc_int8_scales_ptr[num_output * 1 + q + k];
+                descales_ptr[8 + k] = 1.f / weight_hc_int8_scales_ptr[num_output * 0 + q + k];
+                descales_ptr[12 + k] = 1.f / weight_hc_int8_scales_ptr[num_output * 1 + q + k];
+                descales_ptr[16 + k] = 1.f / weight_hc_int8_scales_ptr[num_output * 2 + q + k];
+                descales_ptr[20 + k] = 1.f / weight_xc_int8_scales_ptr[num_output * 2 + q + k];
+            }
+        }
+#endif // __SSE2__
+        for (; q < num_output; q++)
+        {
+            bias_c_RUBNWN[0] = bias_c_R[q];
+            bias_c_RUBNWN[1] = bias_c_U[q];
+            bias_c_RUBNWN[2] = bias_c_BN[q];
+            bias_c_RUBNWN[3] = bias_c_WN[q];
+
+            bias_c_RUBNWN += 4;
+
+            const signed char* weight_xc_R = weight_xc_dr.row<const signed char>(num_output * 0 + q);
+            const signed char* weight_xc_U = weight_xc_dr.row<const signed char>(num_output * 1 + q);
+            const signed char* weight_xc_N = weight_xc_dr.row<const signed char>(num_output * 2 + q);
+
+            const signed char* weight_hc_R = weight_hc_dr.row<const signed char>(num_output * 0 + q);
+            const signed char* weight_hc_U = weight_hc_dr.row<const signed char>(num_output * 1 + q);
+            const signed char* weight_hc_N = weight_hc_dr.row<const signed char>(num_output * 2 + q);
+
+#if __SSE2__
+            signed char* kptr = weight_data_tm_dr.row<signed char>(q / 4 + q % 4);
+            float* descales_ptr = weight_data_tm_int8_descales_dr.row(q / 4 + q % 4);
+#else
+            signed char* kptr = weight_data_tm_dr.row<signed char>(q);
+            float* descales_ptr = weight_data_tm_int8_descales_dr.row(q);
+#endif // __SSE2__
+
+            for (int i = 0; i < size; i++)
+            {
+                kptr[0] = weight_xc_R[i];
+                kptr[1] = weight_xc_U[i];
+                kptr += 2;
+            }
+
+            for (int i = 0; i < num_output; i++)
+            {
+                kptr[0] = weight_hc_R[i];
+                kptr[1] = weight_hc_U[i];
+                kptr += 2;
+            }
+
+            for (int i = 0; i < num_output; i++)
+            {
+                kptr[0] = weight_hc_N[i];
+                kptr += 1;
+            }
+
+            for (int i = 0; i < size; i++)
+            {
+                kptr[0] = weight_xc_N[i];
+                kptr += 1;
+            }
+
+            descales_ptr[0] = 1.f / weight_xc_int8_scales_ptr[num_output * 0 + q];
+            descales_ptr[1] = 1.f / weight_xc_int8_scales_ptr[num_output * 1 + q];
+            descales_ptr[2] = 1.f / weight_hc_int8_scales_ptr[num_output * 0 + q];
+            descales_ptr[3] = 1.f / weight_hc_int8_scales_ptr[num_output * 1 + q];
+            descales_ptr[4] = 1.f / weight_hc_int8_scales_ptr[num_output * 2 + q];
+            descales_ptr[5] = 1.f / weight_xc_int8_scales_ptr[num_output * 2 + q];
+        }
+    }
+}
+
+static float gru_dynamic_quantize_get_absmax(const float* ptr, int size)
+{
+    float absmax = 0.f;
+
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    __m512 _absmax_avx512 = _mm512_set1_ps(0.f);
+    for (; i + 15 < size; i += 16)
+    {
+        __m512 _p = _mm512_loadu_ps(ptr);
+        _absmax_avx512 = _mm512_max_ps(_absmax_avx512, abs512_ps(_p));
+        ptr += 16;
+    }
+    absmax = std::max(absmax, _mm512_comp_reduce_max_ps(_absmax_avx512));
+#endif // __AVX512F__
+    __m256 _absmax_avx = _mm256_set1_ps(0.f);
+    for (; i + 7 < size; i += 8)
+    {
+        __m256 _p = _mm256_loadu_ps(ptr);
+        _absmax_avx = _mm256_max_ps(_absmax_avx, abs256_ps(_p));
+        ptr += 8;
+    }
+    absmax = std::max(absmax, _mm256_reduce_max_ps(_absmax_avx));
+#endif // __AVX__
+    __m128 _absmax = _mm_set1_ps(0.f);
+    for (; i + 3 < size; i += 4)
+    {
+        __m128 _p = _mm_loadu_ps(ptr);
+        _absmax = _mm_max_ps(_absmax, abs_ps(_p));
+        ptr += 4;
+    }
+    absmax = std::max(absmax, _mm_reduce_max_ps(_absmax));
+#endif // __SSE2__
+    for (; i < size; i++)
+    {
+        absmax = std::max(absmax, (float)fabs(*ptr));
+        ptr++;
+    }
+
+    return absmax;
+}
+
+static void gru_dynamic_quantize_scale2int8(const float* ptr, int size, float scale, signed char* outptr)
+{
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    __m512 _scale_avx512 = _mm512_set1_ps(scale);
+    for (; i + 15 < size; i += 16)
+    {
+        __m512 _p = _mm512_loadu_ps(ptr);
+        _p = _mm512_mul_ps(_p, _scale_avx512);
+        _mm_storeu_si128((__m128i*)outptr, float2int8_avx512(_p));
+        ptr += 16;
+        outptr += 16;
+    }
+#endif // __AVX512F__
+    __m256 _scale_avx = _mm256_set1_ps(scale);
+    for (; i + 7 < size; i += 8)
+    {
+        __m256 _p = _mm256_loadu_ps(ptr);
+        _p = _mm256_mul_ps(_p, _scale_avx);
+        *(int64_t*)outptr = float2int8_avx(_p);
+        ptr += 8;
+        outptr += 8;
+    }
+#endif // __AVX__
+    __m128 _scale = _mm_set1_ps(scale);
+    for (; i + 3 < size; i += 4)
+    {
+        __m128 _p = _mm_loadu_ps(ptr);
+        _p = _mm_mul_ps(_p, _scale);
+        *(int32_t*)outptr = float2int8_sse(_p);
+        ptr += 4;
+        outptr += 4;
+    }
+#endif // __SSE2__
+    for (; i < size; i++)
+    {
+        *outptr++ = float2int8(*ptr++ * scale);
+    }
+}
+
+#if __SSE2__
+#if __AVX2__
+// R0 R1 R2 R3 U0 U1 U2 U3 dot x
+static NCNN_FORCEINLINE __m256i gru_int8_dot_RU(const signed char*& kptr, const signed char* x, int size)
+{
+    __m256i _RU = _mm256_setzero_si256();
+    __m256i _sum1 = _mm256_setzero_si256();
+
+    int i = 0;
+    for (; i + 3 < size; i += 4)
+    {
+        __m256i _w0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)kptr));
+        __m256i _w1 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(kptr + 16)));
+        __m256i _xi0 = _mm256_cvtepi8_epi16(_mm_set1_epi16(((const short*)(x + i))[0]));
+        __m256i _xi1 = _mm256_cvtepi8_epi16(_mm_set1_epi16(((const short*)(x + i + 2))[0]));
+        _RU = _mm256_add_epi32(_RU, _mm256_madd_epi16(_w0, _xi0));
+        _sum1 = _mm256_add_epi32(_sum1, _mm256_madd_epi16(_w1, _xi1));
+
+        kptr += 32;
+    }
+    for (; i + 1 < size; i += 2)
+    {
+        __m256i _w = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)kptr));
+        __m256i _xi = _mm256_cvtepi8_epi16(_mm_set1_epi16(((const short*)(x + i))[0]));
+        _RU = _mm256_add_epi32(_RU, _mm256_madd_epi16(_w, _xi));
+
+        kptr += 16;
+    }
+    for (; i < size; i++)
+    {
+        __m256i _w = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)kptr));
+        __m256i _xi = _mm256_set1_epi32(x[i]);
+        _RU = _mm256_add_epi32(_RU, _mm256_mullo_epi32(_w, _xi));
+
+        kptr += 8;
+    }
+
+    return _mm256_add_epi32(_RU, _sum1);
+}
+#else  // __AVX2__
+// R0 R1 R2 R3 and U0 U1 U2 U3 dot x
+static NCNN_FORCEINLINE void gru_int8_dot_RU(const signed char*& kptr, const signed char* x, int size, __m128i& _R, __m128i& _U)
+{
+    _R = _mm_setzero_si128();
+    _U = _mm_setzero_si128();
+
+    int i = 0;
+    for (; i + 1 < size; i += 2)
+    {
+        __m128i _w = _mm_loadu_si128((const __m128i*)kptr);
+        __m128i _xi = _mm_set1_epi16(((const short*)(x + i))[0]);
+
+        __m128i _extw = _mm_cmpgt_epi8(_mm_setzero_si128(), _w);
+        __m128i _wR = _mm_unpacklo_epi8(_w, _extw);
+        __m128i _wU = _mm_unpackhi_epi8(_w, _extw);
+        _xi = _mm_unpacklo_epi8(_xi, _mm_cmpgt_epi8(_mm_setzero_si128(), _xi));
+
+        _R = _mm_add_epi32(_R, _mm_madd_epi16(_wR, _xi));
+        _U = _mm_add_epi32(_U, _mm_madd_epi16(_wU, _xi));
+
+        kptr += 16;
+    }
+    for (; i < size; i++)
+    {
+        __m128i _w = _mm_loadl_epi64((const __m128i*)kptr);
+        __m128i _xi = _mm_set1_epi16(x[i]);
+
+        _w = _mm_unpacklo_epi8(_w, _mm_cmpgt_epi8(_mm_setzero_si128(), _w));
+
+        __m128i _sl = _mm_mullo_epi16(_w, _xi);
+        __m128i _sh = _mm_mulhi_epi16(_w, _xi);
+        _R = _mm_add_epi32(_R, _mm_unpacklo_epi16(_sl, _sh));
+        _U = _mm_add_epi32(_U, _mm_unpackhi_epi16(_sl, _sh));
+
+        kptr += 8;
+    }
+}
+#endif // __AVX2__
+
+// N0 N1 N2 N3 dot x
+static NCNN_FORCEINLINE __m128i gru_int8_dot_N(const signed char*& kptr, const signed char* x, int size)
+{
+    __m128i _N = _mm_setzero_si128();
+
+    int i = 0;
+#if __AVX2__
+    __m256i _N01 = _mm256_setzero_si256();
+    for (; i + 3 < size; i += 4)
+    {
+        __m256i _w = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)kptr));
+        __m128i _xi0 = _mm_set1_epi16(((const short*)(x + i))[0]);
+        __m128i _xi1 = _mm_set1_epi16(((const short*)(x + i + 2))[0]);
+        __m256i _xi = _mm256_cvtepi8_epi16(_mm_unpacklo_epi64(_xi0, _xi1));
+        _N01 = _mm256_add_epi32(_N01, _mm256_madd_epi16(_w, _xi));
+
+        kptr += 16;
+    }
+    _N = _mm_add_epi32(_mm256_castsi256_si128(_N01), _mm256_extracti128_si256(_N01, 1));
+#endif // __AVX2__
+    for (; i + 1 < size; i += 2)
+    {
+        __m128i _w = _mm_loadl_epi64((const __m128i*)kptr);
+        __m128i _xi = _mm_set1_epi16(((const short*)(x + i))[0]);
+
+        _w = _mm_unpacklo_epi8(_w, _mm_cmpgt_epi8(_mm_setzero_si128(), _w));
+        _xi = _mm_unpacklo_epi8(_xi, _mm_cmpgt_epi8(_mm_setzero_si128(), _xi));
+
+        _N = _mm_add_epi32(_N, _mm_madd_epi16(_w, _xi));
+
+        kptr += 8;
+    }
+    for (; i < size; i++)
+    {
+        __m128i _w = _mm_cvtsi32_si128(((const int*)kptr)[0]);
+        __m128i _xi = _mm_set1_epi16(x[i]);
+
+        _w = _mm_unpacklo_epi8(_w, _mm_cmpgt_epi8(_mm_setzero_si128(), _w));
+
+        __m128i _sl = _mm_mullo_epi16(_w, _xi);
+        __m128i _sh = _mm_mulhi_epi16(_w, _xi);
+        _N = _mm_add_epi32(_N, _mm_unpacklo_epi16(_sl, _sh));
+
+        kptr += 4;
+    }
+
+    return _N;
+}
+#endif // __SSE2__
+
+static void gru_int8(const Mat& bottom_blob_int8, const Mat& bottom_blob_int8_descales, Mat& top_blob, int reverse, const Mat& weight_data_tm, const Mat& weight_data_tm_int8_descales, const Mat& bias_c, Mat& hidden_state, const Option& opt)
+{
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__
+    if (ncnn::cpu_support_x86_avx2())
+    {
+        gru_int8_avx2(bottom_blob_int8, bottom_blob_int8_descales, top_blob, reverse, weight_data_tm, weight_data_tm_int8_descales, bias_c, hidden_state, opt);
+        return;
+    }
+#endif
+
+    int size = bottom_blob_int8.w;
+    int T = bottom_blob_int8.h;
+
+    int num_output = top_blob.w;
+
+    // 2 x num_output
+#if __SSE2__
+    Mat gates(4 * 2, num_output / 4 + num_output % 4, 4u, opt.workspace_allocator);
+#else
+    Mat gates(2, num_output, 4u, opt.workspace_allocator);
+#endif
+
+    Mat hidden_state_int8(num_output, (size_t)1u, 1, opt.workspace_allocator);
+    float hidden_state_int8_descale = 1.f;
+
+    // unroll
+    for (int t = 0; t < T; t++)
+    {
+        int ti = reverse ? T - 1 - t : t;
+
+        // dynamic quantize hidden_state
+        {
+            const float* ptr = hidden_state;
+
+            const float absmax = gru_dynamic_quantize_get_absmax(ptr, num_output);
+
+            if (absmax == 0.f)
+            {
+                hidden_state_int8.fill<signed char>(0);
+            }
+            else
+            {
+                hidden_state_int8_descale = absmax / 127.f;
+
+                const float scale = 127.f / absmax;
+                gru_dynamic_quantize_scale2int8(ptr, num_output, scale, hidden_state_int8);
+            }
+        }
+
+        const signed char* x = bottom_blob_int8.row<const signed char>(ti);
+        const signed char* hs = hidden_state_int8;
+        const float descale_x = bottom_blob_int8_descales[ti];
+        const float descale_h = hidden_state_int8_descale;
+
+        int remain_num_output_start = 0;
+#if __SSE2__
+        int nn_num_output = num_output >> 2;
+        remain_num_output_start = nn_num_output << 2;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int qq = 0; qq < nn_num_output; qq++)
+        {
+            int q = qq * 4;
+
+            // gate reset update
+            const float* bias_c_RUBNWN = (const float*)bias_c + q * 4;
+
+            const signed char* kptr = weight_data_tm.row<const signed char>(q / 4);
+
+            const float* descales_ptr = weight_data_tm_int8_descales.row(q / 4);
+
+#if __AVX2__
+            __m256i _RUx = gru_int8_dot_RU(kptr, x, size);
+            __m256i _RUh = gru_int8_dot_RU(kptr, hs, num_output);
+
+            __m256 _descale_xc_RU = _mm256_mul_ps(_mm256_set1_ps(descale_x), _mm256_loadu_ps(descales_ptr));
+            __m256 _descale_hc_RU = _mm256_mul_ps(_mm256_set1_ps(descale_h), _mm256_loadu_ps(descales_ptr + 8));
+
+            __m256 _gru_RU = _mm256_loadu_ps(bias_c_RUBNWN);
+            _gru_RU = _mm256_comp_fmadd_ps(_mm256_cvtepi32_ps(_RUx), _descale_xc_RU, _gru_RU);
+            _gru_RU = _mm256_comp_fmadd_ps(_mm256_cvtepi32_ps(_RUh), _descale_hc_RU, _gru_RU);
+
+            // sigmoid(R)
+            // sigmoid(U)
+            _gru_RU = sigmoid_avx(_gru_RU);
+
+            __m128 _gru_R = _mm256_castps256_ps128(_gru_RU);
+            __m128 _gru_U = _mm256_extractf128_ps(_gru_RU, 1);
+#else
+            __m128i _Rx;
+            __m128i _Ux;
+            __m128i _Rh;
+            __m128i _Uh;
+            gru_int8_dot_RU(kptr, x, size, _Rx, _Ux);
+            gru_int8_dot_RU(kptr, hs, num_output, _Rh, _Uh);
+
+            __m128 _descale_x = _mm_set1_ps(descale_x);
+            __m128 _descale_h = _mm_set1_ps(descale_h);
+
+            __m128 _gru_R = _mm_loadu_ps(bias_c_RUBNWN);
+            __m128 _gru_U = _mm_loadu_ps(bias_c_RUBNWN + 4);
+            _gru_R = _mm_comp_fmadd_ps(_mm_cvtepi32_ps(_Rx), _mm_mul_ps(_descale_x, _mm_loadu_ps(descales_ptr)), _gru_R);
+            _gru_U = _mm_comp_fmadd_ps(_mm_cvtepi32_ps(_Ux), _mm_mul_ps(_descale_x, _mm_loadu_ps(descales_ptr + 4)), _gru_U);
+            _gru_R = _mm_comp_fmadd_ps(_mm_cvtepi32_ps(_Rh), _mm_mul_ps(_descale_h, _mm_loadu_ps(descales_ptr + 8)), _gru_R);
+            _gru_U = _mm_comp_fmadd_ps(_mm_cvtepi32_ps(_Uh), _mm_mul_ps(_descale_h, _mm_loadu_ps(descales_ptr + 12)), _gru_U);
+
+            // sigmoid(R)
+            // sigmoid(U)
+            _gru_R = sigmoid_sse(_gru_R);
+            _gru_U = sigmoid_sse(_gru_U);
+#endif // __AVX2__
+
+            // gate new
+            __m128i _Nh = gru_int8_dot_N(kptr, hs, num_output);
+            __m128i _Nx = gru_int8_dot_N(kptr, x, size);
+
+            __m128 _gru_N = _mm_loadu_ps(bias_c_RUBNWN + 8);
+            _gru_N = _mm_comp_fmadd_ps(_mm_cvtepi32_ps(_Nh), _mm_mul_ps(_mm_set1_ps(descale_h), _mm_loadu_ps(descales_ptr + 16)), _gru_N);
+            _gru_N = _mm_comp_fmadd_ps(_gru_R, _gru_N, _mm_loadu_ps(bias_c_RUBNWN + 12));
+            _gru_N = _mm_comp_fmadd_ps(_mm_cvtepi32_ps(_Nx), _mm_mul_ps(_mm_set1_ps(descale_x), _mm_loadu_ps(descales_ptr + 20)), _gru_N);
+
+            // tanh(N)
+            _gru_N = tanh_sse(_gru_N);
+
+            float* gates_data = gates.row(q / 4);
+
+            _mm_storeu_ps(gates_data, _gru_U);
+            _mm_storeu_ps(gates_data + 4, _gru_N);
+        }
+#endif // __SSE2__
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = remain_num_output_start; q < num_output; q++)
+        {
+            // gate reset update
+            const float* bias_c_RUBNWN = (const float*)bias_c + q * 4;
+
+#if __SSE2__
+            const signed char* kptr = weight_data_tm.row<const signed char>(q / 4 + q % 4);
+            const float* descales_ptr = weight_data_tm_int8_descales.row(q / 4 + q % 4);
+#else
+            const signed char* kptr = weight_data_tm.row<const signed char>(q);
+            const float* descales_ptr = weight_data_tm_int8_descales.row(q);
+#endif
+
+            int Rx = 0;
+            int Ux = 0;
+            for (int i = 0; i < size; i++)
+            {
+                int xi = x[i];
+
+                Rx += kptr[0] * xi;
+                Ux += kptr[1] * xi;
+
+                kptr += 2;
+            }
+
+            int Rh = 0;
+            int Uh = 0;
+            for (int i = 0; i < num_output; i++)
+            {
+                int h_cont = hs[i];
+
+                Rh += kptr[0] * h_cont;
+                Uh += kptr[1] * h_cont;
+
+                kptr += 2;
+            }
+
+            float R = bias_c_RUBNWN[0] + Rx * (descale_x * descales_ptr[0]) + Rh * (descale_h * descales_ptr[2]);
+            float U = bias_c_RUBNWN[1] + Ux * (descale_x * descales_ptr[1]) + Uh * (descale_h * descales_ptr[3]);
+
+            // sigmoid(R)
+            // sigmoid(U)
+            R = 1.f / (1.f + expf(-R));
+            U = 1.f / (1.f + expf(-U));
+
+            // gate new
+            int Nh = 0;
+            for (int i = 0; i < num_output; i++)
+            {
+                int h_cont = hs[i];
+
+                Nh += kptr[0] * h_cont;
+
+                kptr += 1;
+            }
+
+            int Nx = 0;
+            for (int i = 0; i < size; i++)
+            {
+                int xi = x[i];
+
+                Nx += kptr[0] * xi;
+
+                kptr += 1;
+            }
+
+            float N = bias_c_RUBNWN[2] + Nh * (descale_h * descales_ptr[4]);
+            N = bias_c_RUBNWN[3] + R * N + Nx * (descale_x * descales_ptr[5]);
+
+            // tanh(N)
+            N = tanhf(N);
+
+#if __SSE2__
+            float* gates_data = gates.row(q / 4 + q % 4);
+#else
+            float* gates_data = gates.row(q);
+#endif
+
+            gates_data[0] = U;
+            gates_data[1] = N;
+        }
+
+        // h_t := (1 - update) .* new + update .* h_{t-1}
+        float* output_data = top_blob.row(ti);
+
+        float* hidden_ptr = hidden_state;
+
+#if __SSE2__
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int qq = 0; qq < nn_num_output; qq++)
+        {
+            int q = qq * 4;
+
+            const float* gates_data = gates.row(q / 4);
+
+            __m128 _gru_U = _mm_loadu_ps(gates_data);
+            __m128 _gru_N = _mm_loadu_ps(gates_data + 4);
+
+            __m128 _gru_H = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.f), _gru_U), _gru_N), _mm_mul_ps(_gru_U, _mm_loadu_ps(hidden_ptr + q)));
+
+            _mm_storeu_ps(hidden_ptr + q, _gru_H);
+            _mm_storeu_ps(output_data + q, _gru_H);
+        }
+#endif // __SSE2__
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = remain_num_output_start; q < num_output; q++)
+        {
+#if __SSE2__
+            const float* gates_data = gates.row(q / 4 + q % 4);
+#else
+            const float* gates_data = gates.row(q);
+#endif
+
+            float U = gates_data[0];
+            float N = gates_data[1];
+
+            float H = (1 - U) * N + U * hidden_ptr[q];
+
+            hidden_ptr[q] = H;
+            output_data[q] = H;
+        }
+    }
+}
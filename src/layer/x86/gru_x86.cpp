@@ -0,0 +1,982 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "gru_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#include "sse_mathfun.h"
+#if __AVX__
+#include <immintrin.h>
+#include "avx_mathfun.h"
+#if __AVX512F__
+#include "avx512_mathfun.h"
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+
+#include "x86_activation.h"
+#include "x86_usability.h"
+
+#include "cpu.h"
+
+namespace ncnn {
+
+#if NCNN_INT8
+#include "gru_int8.h"
+#endif
+
+GRU_x86::GRU_x86()
+{
+    one_blob_only = false;
+    support_inplace = false;
+}
+
+int GRU_x86::create_pipeline(const Option& opt)
+{
+#if NCNN_INT8
+    if (int8_scale_term)
+    {
+        return create_pipeline_int8(opt);
+    }
+#endif
+
+    // pack RUN
+    int num_directions = direction == 2 ? 2 : 1;
+    int size = weight_data_size / num_directions / num_output / 3;
+
+#if __SSE2__
+    weight_xc_data_packed.create(size * 12, num_output / 4 + num_output % 4, num_directions);
+    weight_hc_data_packed.create(num_output * 12, num_output / 4 + num_output % 4, num_directions);
+#else
+    weight_xc_data_packed.create(size * 3, num_output, num_directions);
+    weight_hc_data_packed.create(num_output * 3, num_output, num_directions);
+#endif
+    bias_c_data_packed.create(num_output, 1, num_directions, 16u, 4);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int dr = 0; dr < num_directions; dr++)
+    {
+        const Mat weight_xc = weight_xc_data.channel(dr);
+        const Mat bias_c = bias_c_data.channel(dr);
+        const Mat weight_hc = weight_hc_data.channel(dr);
+
+        Mat weight_xc_data_packed_dr = weight_xc_data_packed.channel(dr);
+        Mat bias_c_data_packed_dr = bias_c_data_packed.channel(dr);
+        Mat weight_hc_data_packed_dr = weight_hc_data_packed.channel(dr);
+
+        const float* bias_c_R = bias_c.row(0);
+        const float* bias_c_U = bias_c.row(1);
+        const float* bias_c_WN = bias_c.row(2);
+        const float* bias_c_BN = bias_c.row(3);
+
+        float* bias_c_RUBNWN = bias_c_data_packed_dr.row(0);
+
+        int q = 0;
+#if __SSE2__
+        for (; q + 3 < num_output; q += 4)
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                bias_c_RUBNWN[k] = bias_c_R[q + k];
+                bias_c_RUBNWN[4 + k] = bias_c_U[q + k];
+                bias_c_RUBNWN[8 + k] = bias_c_BN[q + k];
+                bias_c_RUBNWN[12 + k] = bias_c_WN[q + k];
+            }
+
+            bias_c_RUBNWN += 16;
+
+            float* weight_xc_RUN = weight_xc_data_packed_dr.row(q / 4);
+            float* weight_hc_RUN = weight_hc_data_packed_dr.row(q / 4);
+
+            // R0 R1 R2 R3 U0 U1 U2 U3 for every input, then N0 N1 N2 N3 for every input
+            for (int i = 0; i < size; i++)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    weight_xc_RUN[k] = weight_xc.row(num_output * 0 + q + k)[i];
+                    weight_xc_RUN[4 + k] = weight_xc.row(num_output * 1 + q + k)[i];
+                }
+
+                weight_xc_RUN += 8;
+            }
+
+            for (int i = 0; i < num_output; i++)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    weight_hc_RUN[k] = weight_hc.row(num_output * 0 + q + k)[i];
+                    weight_hc_RUN[4 + k] = weight_hc.row(num_output * 1 + q + k)[i];
+                }
+
+                weight_hc_RUN += 8;
+            }
+
+            for (int i = 0; i < size; i++)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    weight_xc_RUN[k] = weight_xc.row(num_output * 2 + q + k)[i];
+                }
+
+                weight_xc_RUN += 4;
+            }
+
+            for (int i = 0; i < num_output; i++)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    weight_hc_RUN[k] = weight_hc.row(num_output * 2 + q + k)[i];
+                }
+
+                weight_hc_RUN += 4;
+            }
+        }
+#endif // __SSE2__
+        for (; q < num_output; q++)
+        {
+            bias_c_RUBNWN[0] = bias_c_R[q];
+            bias_c_RUBNWN[1] = bias_c_U[q];
+            bias_c_RUBNWN[2] = bias_c_BN[q];
+            bias_c_RUBNWN[3] = bias_c_WN[q];
+
+            bias_c_RUBNWN += 4;
+
+            const float* weight_xc_R = weight_xc.row(num_output * 0 + q);
+            const float* weight_xc_U = weight_xc.row(num_output * 1 + q);
+            const float* weight_xc_N = weight_xc.row(num_output * 2 + q);
+
+            const float* weight_hc_R = weight_hc.row(num_output * 0 + q);
+            const float* weight_hc_U = weight_hc.row(num_output * 1 + q);
+            const float* weight_hc_N = weight_hc.row(num_output * 2 + q);
+
+#if __SSE2__
+            float* weight_xc_RUN = weight_xc_data_packed_dr.row(q / 4 + q % 4);
+            float* weight_hc_RUN = weight_hc_data_packed_dr.row(q / 4 + q % 4);
+#else
+            float* weight_xc_RUN = weight_xc_data_packed_dr.row(q);
+            float* weight_hc_RUN = weight_hc_data_packed_dr.row(q);
+#endif // __SSE2__
+
+            for (int i = 0; i < size; i++)
+            {
+                weight_xc_RUN[0] = weight_xc_R[i];
+                weight_xc_RUN[1] = weight_xc_U[i];
+
+                weight_xc_RUN += 2;
+            }
+
+            for (int i = 0; i < num_output; i++)
+            {
+                weight_hc_RUN[0] = weight_hc_R[i];
+                weight_hc_RUN[1] = weight_hc_U[i];
+
+                weight_hc_RUN += 2;
+            }
+
+            for (int i = 0; i < size; i++)
+            {
+                weight_xc_RUN[0] = weight_xc_N[i];
+
+                weight_xc_RUN += 1;
+            }
+
+            for (int i = 0; i < num_output; i++)
+            {
+                weight_hc_RUN[0] = weight_hc_N[i];
+
+                weight_hc_RUN += 1;
+            }
+        }
+    }
+
+    if (opt.lightmode)
+    {
+        weight_xc_data.release();
+        bias_c_data.release();
+        weight_hc_data.release();
+    }
+
+    return 0;
+}
+
+static int gru(const Mat& bottom_blob, Mat& top_blob, int reverse, const Mat& weight_xc, const Mat& bias_c, const Mat& weight_hc, Mat& hidden_state, const Option& opt)
+{
+    int size = bottom_blob.w;
+    int T = bottom_blob.h;
+
+    int num_output = top_blob.w;
+
+    // 2 x num_output
+#if __SSE2__
+    Mat gates(4 * 2, num_output / 4 + num_output % 4, 4u, opt.workspace_allocator);
+#else
+    Mat gates(2, num_output, 4u, opt.workspace_allocator);
+#endif
+    if (gates.empty())
+        return -100;
+
+    // unroll
+    for (int t = 0; t < T; t++)
+    {
+        int ti = reverse ? T - 1 - t : t;
+
+        const float* x = bottom_blob.row(ti);
+        const float* hidden_ptr = hidden_state;
+
+        int remain_num_output_start = 0;
+#if __SSE2__
+        int nn_num_output = num_output >> 2;
+        remain_num_output_start = nn_num_output << 2;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int qq = 0; qq < nn_num_output; qq++)
+        {
+            int q = qq * 4;
+
+            // gate reset update
+            const float* bias_c_RUBNWN = (const float*)bias_c + q * 4;
+
+            const float* weight_xc_RUN = weight_xc.row(q / 4);
+            const float* weight_hc_RUN = weight_hc.row(q / 4);
+
+#if __AVX__
+            __m256 _RU = _mm256_loadu_ps(bias_c_RUBNWN);
+            __m256 _sum1 = _mm256_setzero_ps();
+            __m256 _sum2 = _mm256_setzero_ps();
+            __m256 _sum3 = _mm256_setzero_ps();
+#if __AVX512F__
+            __m512 _RU01 = _mm512_setzero_ps();
+            __m512 _sum01 = _mm512_setzero_ps();
+#endif // __AVX512F__
+
+            int i = 0;
+#if __AVX512F__
+            for (; i + 3 < size; i += 4)
+            {
+                __m512 _xi01 = _mm512_insertf32x8(_mm512_castps256_ps512(_mm256_set1_ps(x[i])), _mm256_set1_ps(x[i + 1]), 1);
+                __m512 _xi23 = _mm512_insertf32x8(_mm512_castps256_ps512(_mm256_set1_ps(x[i + 2])), _mm256_set1_ps(x[i + 3]), 1);
+                __m512 _weight_xc_RU01 = _mm512_loadu_ps(weight_xc_RUN);
+                __m512 _weight_xc_RU23 = _mm512_loadu_ps(weight_xc_RUN + 16);
+                _RU01 = _mm512_fmadd_ps(_weight_xc_RU01, _xi01, _RU01);
+                _sum01 = _mm512_fmadd_ps(_weight_xc_RU23, _xi23, _sum01);
+
+                weight_xc_RUN += 32;
+            }
+#endif // __AVX512F__
+            for (; i + 3 < size; i += 4)
+            {
+                __m256 _xi0 = _mm256_broadcast_ss(x + i);
+                __m256 _xi1 = _mm256_broadcast_ss(x + i + 1);
+                __m256 _xi2 = _mm256_broadcast_ss(x + i + 2);
+                __m256 _xi3 = _mm256_broadcast_ss(x + i + 3);
+                __m256 _weight_xc_RU0 = _mm256_loadu_ps(weight_xc_RUN);
+                __m256 _weight_xc_RU1 = _mm256_loadu_ps(weight_xc_RUN + 8);
+                __m256 _weight_xc_RU2 = _mm256_loadu_ps(weight_xc_RUN + 16);
+                __m256 _weight_xc_RU3 = _mm256_loadu_ps(weight_xc_RUN + 24);
+                _RU = _mm256_comp_fmadd_ps(_weight_xc_RU0, _xi0, _RU);
+                _sum1 = _mm256_comp_fmadd_ps(_weight_xc_RU1, _xi1, _sum1);
+                _sum2 = _mm256_comp_fmadd_ps(_weight_xc_RU2, _xi2, _sum2);
+                _sum3 = _mm256_comp_fmadd_ps(_weight_xc_RU3, _xi3, _sum3);
+
+                weight_xc_RUN += 32;
+            }
+            for (; i < size; i++)
+            {
+                __m256 _xi = _mm256_broadcast_ss(x + i);
+                __m256 _weight_xc_RU = _mm256_loadu_ps(weight_xc_RUN);
+                _RU = _mm256_comp_fmadd_ps(_weight_xc_RU, _xi, _RU);
+
+                weight_xc_RUN += 8;
+            }
+
+            i = 0;
+#if __AVX512F__
+            for (; i + 3 < num_output; i += 4)
+            {
+                __m512 _h_cont01 = _mm512_insertf32x8(_mm512_castps256_ps512(_mm256_set1_ps(hidden_ptr[i])), _mm256_set1_ps(hidden_ptr[i + 1]), 1);
+                __m512 _h_cont23 = _mm512_insertf32x8(_mm512_castps256_ps512(_mm256_set1_ps(hidden_ptr[i + 2])), _mm256_set1_ps(hidden_ptr[i + 3]), 1);
+                __m512 _weight_hc_RU01 = _mm512_loadu_ps(weight_hc_RUN);
+                __m512 _weight_hc_RU23 = _mm512_loadu_ps(weight_hc_RUN + 16);
+                _RU01 = _mm512_fmadd_ps(_weight_hc_RU01, _h_cont01, _RU01);
+                _sum01 = _mm512_fmadd_ps(_weight_hc_RU23, _h_cont23, _sum01);
+
+                weight_hc_RUN += 32;
+            }
+#endif // __AVX512F__
+            for (; i + 3 < num_output; i += 4)
+            {
+                __m256 _h_cont0 = _mm256_broadcast_ss(hidden_ptr + i);
+                __m256 _h_cont1 = _mm256_broadcast_ss(hidden_ptr + i + 1);
+                __m256 _h_cont2 = _mm256_broadcast_ss(hidden_ptr + i + 2);
+                __m256 _h_cont3 = _mm256_broadcast_ss(hidden_ptr + i + 3);
+                __m256 _weight_hc_RU0 = _mm256_loadu_ps(weight_hc_RUN);
+                __m256 _weight_hc_RU1 = _mm256_loadu_ps(weight_hc_RUN + 8);
+                __m256 _weight_hc_RU2 = _mm256_loadu_ps(weight_hc_RUN + 16);
+                __m256 _weight_hc_RU3 = _mm256_loadu_ps(weight_hc_RUN + 24);
+                _RU = _mm256_comp_fmadd_ps(_weight_hc_RU0, _h_cont0, _RU);
+                _sum1 = _mm256_comp_fmadd_ps(_weight_hc_RU1, _h_cont1, _sum1);
+                _sum2 = _mm256_comp_fmadd_ps(_weight_hc_RU2, _h_cont2, _sum2);
+                _sum3 = _mm256_comp_fmadd_ps(_weight_hc_RU3, _h_cont3, _sum3);
+
+                weight_hc_RUN += 32;
+            }
+            for (; i < num_output; i++)
+            {
+                __m256 _h_cont = _mm256_broadcast_ss(hidden_ptr + i);
+                __m256 _weight_hc_RU = _mm256_loadu_ps(weight_hc_RUN);
+                _RU = _mm256_comp_fmadd_ps(_weight_hc_RU, _h_cont, _RU);
+
+                weight_hc_RUN += 8;
+            }
+
+#if __AVX512F__
+            _RU01 = _mm512_add_ps(_RU01, _sum01);
+            _RU = _mm256_add_ps(_RU, _mm512_extractf32x8_ps(_RU01, 0));
+            _RU = _mm256_add_ps(_RU, _mm512_extractf32x8_ps(_RU01, 1));
+#endif // __AVX512F__
+            _RU = _mm256_add_ps(_RU, _sum1);
+            _sum2 = _mm256_add_ps(_sum2, _sum3);
+            _RU = _mm256_add_ps(_RU, _sum2);
+
+            // sigmoid(R)
+            // sigmoid(U)
+            _RU = sigmoid_avx(_RU);
+
+            __m128 _R = _mm256_castps256_ps128(_RU);
+            __m128 _U = _mm256_extractf128_ps(_RU, 1);
+#else  // __AVX__
+            __m128 _R = _mm_loadu_ps(bias_c_RUBNWN);
+            __m128 _U = _mm_loadu_ps(bias_c_RUBNWN + 4);
+            __m128 _sum1 = _mm_setzero_ps();
+            __m128 _sum2 = _mm_setzero_ps();
+
+            int i = 0;
+            for (; i + 1 < size; i += 2)
+            {
+                __m128 _xi0 = _mm_load1_ps(x + i);
+                __m128 _xi1 = _mm_load1_ps(x + i + 1);
+                __m128 _weight_xc_R0 = _mm_loadu_ps(weight_xc_RUN);
+                __m128 _weight_xc_U0 = _mm_loadu_ps(weight_xc_RUN + 4);
+                __m128 _weight_xc_R1 = _mm_loadu_ps(weight_xc_RUN + 8);
+                __m128 _weight_xc_U1 = _mm_loadu_ps(weight_xc_RUN + 12);
+                _R = _mm_comp_fmadd_ps(_weight_xc_R0, _xi0, _R);
+                _U = _mm_comp_fmadd_ps(_weight_xc_U0, _xi0, _U);
+                _sum1 = _mm_comp_fmadd_ps(_weight_xc_R1, _xi1, _sum1);
+                _sum2 = _mm_comp_fmadd_ps(_weight_xc_U1, _xi1, _sum2);
+
+                weight_xc_RUN += 16;
+            }
+            for (; i < size; i++)
+            {
+                __m128 _xi = _mm_load1_ps(x + i);
+                __m128 _weight_xc_R = _mm_loadu_ps(weight_xc_RUN);
+                __m128 _weight_xc_U = _mm_loadu_ps(weight_xc_RUN + 4);
+                _R = _mm_comp_fmadd_ps(_weight_xc_R, _xi, _R);
+                _U = _mm_comp_fmadd_ps(_weight_xc_U, _xi, _U);
+
+                weight_xc_RUN += 8;
+            }
+
+            i = 0;
+            for (; i + 1 < num_output; i += 2)
+            {
+                __m128 _h_cont0 = _mm_load1_ps(hidden_ptr + i);
+                __m128 _h_cont1 = _mm_load1_ps(hidden_ptr + i + 1);
+                __m128 _weight_hc_R0 = _mm_loadu_ps(weight_hc_RUN);
+                __m128 _weight_hc_U0 = _mm_loadu_ps(weight_hc_RUN + 4);
+                __m128 _weight_hc_R1 = _mm_loadu_ps(weight_hc_RUN + 8);
+                __m128 _weight_hc_U1 = _mm_loadu_ps(weight_hc_RUN + 12);
+                _R = _mm_comp_fmadd_ps(_weight_hc_R0, _h_cont0, _R);
+                _U = _mm_comp_fmadd_ps(_weight_hc_U0, _h_cont0, _U);
+                _sum1 = _mm_comp_fmadd_ps(_weight_hc_R1, _h_cont1, _sum1);
+                _sum2 = _mm_comp_fmadd_ps(_weight_hc_U1, _h_cont1, _sum2);
+
+                weight_hc_RUN += 16;
+            }
+            for (; i < num_output; i++)
+            {
+                __m128 _h_cont = _mm_load1_ps(hidden_ptr + i);
+                __m128 _weight_hc_R = _mm_loadu_ps(weight_hc_RUN);
+                __m128 _weight_hc_U = _mm_loadu_ps(weight_hc_RUN + 4);
+                _R = _mm_comp_fmadd_ps(_weight_hc_R, _h_cont, _R);
+                _U = _mm_comp_fmadd_ps(_weight_hc_U, _h_cont, _U);
+
+                weight_hc_RUN += 8;
+            }
+
+            _R = _mm_add_ps(_R, _sum1);
+            _U = _mm_add_ps(_U, _sum2);
+
+            // sigmoid(R)
+            // sigmoid(U)
+            _R = sigmoid_sse(_R);
+            _U = sigmoid_sse(_U);
+#endif // __AVX__
+
+            // gate new
+            __m128 _N = _mm_loadu_ps(bias_c_RUBNWN + 8);
+            __m128 _sumN1 = _mm_setzero_ps();
+            __m128 _sumN2 = _mm_setzero_ps();
+            __m128 _sumN3 = _mm_setzero_ps();
+
+            i = 0;
+            for (; i + 3 < num_output; i += 4)
+            {
+                __m128 _h_cont0 = _mm_load1_ps(hidden_ptr + i);
+                __m128 _h_cont1 = _mm_load1_ps(hidden_ptr + i + 1);
+                __m128 _h_cont2 = _mm_load1_ps(hidden_ptr + i + 2);
+                __m128 _h_cont3 = _mm_load1_ps(hidden_ptr + i + 3);
+                __m128 _weight_hc_N0 = _mm_loadu_ps(weight_hc_RUN);
+                __m128 _weight_hc_N1 = _mm_loadu_ps(weight_hc_RUN + 4);
+                __m128 _weight_hc_N2 = _mm_loadu_ps(weight_hc_RUN + 8);
+                __m128 _weight_hc_N3 = _mm_loadu_ps(weight_hc_RUN + 12);
+                _N = _mm_comp_fmadd_ps(_weight_hc_N0, _h_cont0, _N);
+                _sumN1 = _mm_comp_fmadd_ps(_weight_hc_N1, _h_cont1, _sumN1);
+                _sumN2 = _mm_comp_fmadd_ps(_weight_hc_N2, _h_cont2, _sumN2);
+                _sumN3 = _mm_comp_fmadd_ps(_weight_hc_N3, _h_cont3, _sumN3);
+
+                weight_hc_RUN += 16;
+            }
+            for (; i < num_output; i++)
+            {
+                __m128 _h_cont = _mm_load1_ps(hidden_ptr + i);
+                __m128 _weight_hc_N = _mm_loadu_ps(weight_hc_RUN);
+                _N = _mm_comp_fmadd_ps(_weight_hc_N, _h_cont, _N);
+
+                weight_hc_RUN += 4;
+            }
+
+            _N = _mm_add_ps(_N, _sumN1);
+            _sumN2 = _mm_add_ps(_sumN2, _sumN3);
+            _N = _mm_add_ps(_N, _sumN2);
+
+            _N = _mm_comp_fmadd_ps(_R, _N, _mm_loadu_ps(bias_c_RUBNWN + 12));
+            _sumN1 = _mm_setzero_ps();
+            _sumN2 = _mm_setzero_ps();
+            _sumN3 = _mm_setzero_ps();
+
+            i = 0;
+            for (; i + 3 < size; i += 4)
+            {
+                __m128 _xi0 = _mm_load1_ps(x + i);
+                __m128 _xi1 = _mm_load1_ps(x + i + 1);
+                __m128 _xi2 = _mm_load1_ps(x + i + 2);
+                __m128 _xi3 = _mm_load1_ps(x + i + 3);
+                __m128 _weight_xc_N0 = _mm_loadu_ps(weight_xc_RUN);
+                __m128 _weight_xc_N1 = _mm_loadu_ps(weight_xc_RUN + 4);
+                __m128 _weight_xc_N2 = _mm_loadu_ps(weight_xc_RUN + 8);
+                __m128 _weight_xc_N3 = _mm_loadu_ps(weight_xc_RUN + 12);
+                _N = _mm_comp_fmadd_ps(_weight_xc_N0, _xi0, _N);
+                _sumN1 = _mm_comp_fmadd_ps(_weight_xc_N1, _xi1, _sumN1);
+                _sumN2 = _mm_comp_fmadd_ps(_weight_xc_N2, _xi2, _sumN2);
+                _sumN3 = _mm_comp_fmadd_ps(_weight_xc_N3, _xi3, _sumN3);
+
+                weight_xc_RUN += 16;
+            }
+            for (; i < size; i++)
+            {
+                __m128 _xi = _mm_load1_ps(x + i);
+                __m128 _weight_xc_N = _mm_loadu_ps(weight_xc_RUN);
+                _N = _mm_comp_fmadd_ps(_weight_xc_N, _xi, _N);
+
+                weight_xc_RUN += 4;
+            }
+
+            _N = _mm_add_ps(_N, _sumN1);
+            _sumN2 = _mm_add_ps(_sumN2, _sumN3);
+            _N = _mm_add_ps(_N, _sumN2);
+
+            // tanh(N)
+            _N = tanh_sse(_N);
+
+            float* gates_data = gates.row(q / 4);
+
+            _mm_storeu_ps(gates_data, _U);
+            _mm_storeu_ps(gates_data + 4, _N);
+        }
+#endif // __SSE2__
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = remain_num_output_start; q < num_output; q++)
+        {
+            // gate reset update
+            const float* bias_c_RUBNWN = (const float*)bias_c + q * 4;
+
+#if __SSE2__
+            const float* weight_xc_RUN = weight_xc.row(q / 4 + q % 4);
+            const float* weight_hc_RUN = weight_hc.row(q / 4 + q % 4);
+#else
+            const float* weight_xc_RUN = weight_xc.row(q);
+            const float* weight_hc_RUN = weight_hc.row(q);
+#endif
+
+            float R = bias_c_RUBNWN[0];
+            float U = bias_c_RUBNWN[1];
+
+            for (int i = 0; i < size; i++)
+            {
+                float xi = x[i];
+
+                R += weight_xc_RUN[0] * xi;
+                U += weight_xc_RUN[1] * xi;
+
+                weight_xc_RUN += 2;
+            }
+
+            for (int i = 0; i < num_output; i++)
+            {
+                float h_cont = hidden_ptr[i];
+
+                R += weight_hc_RUN[0] * h_cont;
+                U += weight_hc_RUN[1] * h_cont;
+
+                weight_hc_RUN += 2;
+            }
+
+            // sigmoid(R)
+            // sigmoid(U)
+            R = 1.f / (1.f + expf(-R));
+            U = 1.f / (1.f + expf(-U));
+
+            // gate new
+            float N = bias_c_RUBNWN[2];
+
+            for (int i = 0; i < num_output; i++)
+            {
+                float h_cont = hidden_ptr[i];
+
+                N += weight_hc_RUN[0] * h_cont;
+
+                weight_hc_RUN += 1;
+            }
+
+            N = bias_c_RUBNWN[3] + R * N;
+
+            for (int i = 0; i < size; i++)
+            {
+                float xi = x[i];
+
+                N += weight_xc_RUN[0] * xi;
+
+                weight_xc_RUN += 1;
+            }
+
+            // tanh(N)
+            N = tanhf(N);
+
+#if __SSE2__
+            float* gates_data = gates.row(q / 4 + q % 4);
+#else
+            float* gates_data = gates.row(q);
+#endif
+
+            gates_data[0] = U;
+            gates_data[1] = N;
+        }
+
+        // h_t := (1 - update) .* new + update .* h_{t-1}
+        float* output_data = top_blob.row(ti);
+
+        float* hidden_outptr = hidden_state;
+
+#if __SSE2__
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int qq = 0; qq < nn_num_output; qq++)
+        {
+            int q = qq * 4;
+
+            const float* gates_data = gates.row(q / 4);
+
+            __m128 _U = _mm_loadu_ps(gates_data);
+            __m128 _N = _mm_loadu_ps(gates_data + 4);
+
+            __m128 _H = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.f), _U), _N), _mm_mul_ps(_U, _mm_loadu_ps(hidden_outptr + q)));
+
+            _mm_storeu_ps(hidden_outptr + q, _H);
+            _mm_storeu_ps(output_data + q, _H);
+        }
+#endif // __SSE2__
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = remain_num_output_start; q < num_output; q++)
+        {
+#if __SSE2__
+            const float* gates_data = gates.row(q / 4 + q % 4);
+#else
+            const float* gates_data = gates.row(q);
+#endif
+
+            float U = gates_data[0];
+            float N = gates_data[1];
+
+            float H = (1 - U) * N + U * hidden_outptr[q];
+
+            hidden_outptr[q] = H;
+            output_data[q] = H;
+        }
+    }
+
+    return 0;
+}
+
+int GRU_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+#if NCNN_INT8
+    if (int8_scale_term)
+    {
+        return forward_int8(bottom_blob, top_blob, opt);
+    }
+#endif
+
+    int T = bottom_blob.h;
+
+    int num_directions = direction == 2 ? 2 : 1;
+
+    // initial hidden state
+    Mat hidden(num_output, 4u, opt.workspace_allocator);
+    if (hidden.empty())
+        return -100;
+    hidden.fill(0.f);
+
+    top_blob.create(num_output * num_directions, T, 4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    // Uni directional
+    if (direction == 0 || direction == 1)
+    {
+        int ret = gru(bottom_blob, top_blob, direction, weight_xc_data_packed.channel(0), bias_c_data_packed.channel(0), weight_hc_data_packed.channel(0), hidden, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    if (direction == 2)
+    {
+        Mat top_blob_forward(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_forward.empty())
+            return -100;
+
+        Mat top_blob_reverse(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_reverse.empty())
+            return -100;
+
+        {
+            int ret = gru(bottom_blob, top_blob_forward, 0, weight_xc_data_packed.channel(0), bias_c_data_packed.channel(0), weight_hc_data_packed.channel(0), hidden, opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        hidden.fill(0.0f);
+
+        {
+            int ret = gru(bottom_blob, top_blob_reverse, 1, weight_xc_data_packed.channel(1), bias_c_data_packed.channel(1), weight_hc_data_packed.channel(1), hidden, opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        // concat w
+        for (int i = 0; i < T; i++)
+        {
+            const float* pf = top_blob_forward.row(i);
+            const float* pr = top_blob_reverse.row(i);
+            float* ptr = top_blob.row(i);
+
+            memcpy(ptr, pf, num_output * sizeof(float));
+            memcpy(ptr + num_output, pr, num_output * sizeof(float));
+        }
+    }
+
+    return 0;
+}
+
+int GRU_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+#if NCNN_INT8
+    if (int8_scale_term)
+    {
+        return forward_int8(bottom_blobs, top_blobs, opt);
+    }
+#endif
+
+    const Mat& bottom_blob = bottom_blobs[0];
+    int T = bottom_blob.h;
+    int num_directions = direction == 2 ? 2 : 1;
+
+    Mat hidden;
+    Allocator* hidden_allocator = top_blobs.size() == 2 ? opt.blob_allocator : opt.workspace_allocator;
+    if (bottom_blobs.size() == 2)
+    {
+        hidden = bottom_blobs[1].clone(hidden_allocator);
+    }
+    else
+    {
+        hidden.create(num_output, num_directions, 4u, hidden_allocator);
+        if (hidden.empty())
+            return -100;
+        hidden.fill(0.f);
+    }
+
+    Mat& top_blob = top_blobs[0];
+    top_blob.create(num_output * num_directions, T, 4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    // Uni directional
+    if (direction == 0 || direction == 1)
+    {
+        int ret = gru(bottom_blob, top_blob, direction, weight_xc_data_packed.channel(0), bias_c_data_packed.channel(0), weight_hc_data_packed.channel(0), hidden, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    if (direction == 2)
+    {
+        Mat top_blob_forward(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_forward.empty())
+            return -100;
+
+        Mat top_blob_reverse(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_reverse.empty())
+            return -100;
+
+        Mat hidden0 = hidden.row_range(0, 1);
+        {
+            int ret = gru(bottom_blob, top_blob_forward, 0, weight_xc_data_packed.channel(0), bias_c_data_packed.channel(0), weight_hc_data_packed.channel(0), hidden0, opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        Mat hidden1 = hidden.row_range(1, 1);
+        {
+            int ret = gru(bottom_blob, top_blob_reverse, 1, weight_xc_data_packed.channel(1), bias_c_data_packed.channel(1), weight_hc_data_packed.channel(1), hidden1, opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        // concat w
+        for (int i = 0; i < T; i++)
+        {
+            const float* pf = top_blob_forward.row(i);
+            const float* pr = top_blob_reverse.row(i);
+            float* ptr = top_blob.row(i);
+
+            memcpy(ptr, pf, num_output * sizeof(float));
+            memcpy(ptr + num_output, pr, num_output * sizeof(float));
+        }
+    }
+
+    if (top_blobs.size() == 2)
+    {
+        top_blobs[1] = hidden;
+    }
+
+    return 0;
+}
+
+#if NCNN_INT8
+int GRU_x86::create_pipeline_int8(const Option& opt)
+{
+    // pack RUN
+    const int num_directions = direction == 2 ? 2 : 1;
+    const int size = weight_data_size / num_directions / num_output / 3;
+
+    gru_transform_weight_int8(weight_xc_data, weight_xc_data_int8_scales, weight_hc_data, weight_hc_data_int8_scales, bias_c_data, weight_data_tm, weight_data_tm_int8_descales, bias_c_data_packed, size, num_output, num_directions, opt);
+
+    if (opt.lightmode)
+    {
+        weight_xc_data.release();
+        bias_c_data.release();
+        weight_hc_data.release();
+        weight_xc_data_int8_scales.release();
+        weight_hc_data_int8_scales.release();
+    }
+
+    return 0;
+}
+
+static void gru_dynamic_quantize(const Mat& bottom_blob, Mat& bottom_blob_int8, Mat& bottom_blob_int8_descales, const Option& opt)
+{
+    int size = bottom_blob.w;
+    int T = bottom_blob.h;
+
+    // dynamic quantize bottom_blob
+    bottom_blob_int8_descales.create(T, (size_t)4u, 1, opt.blob_allocator);
+
+    bottom_blob_int8.create(size, T, (size_t)1u, opt.blob_allocator);
+
+    // fp32
+    for (int t = 0; t < T; t++)
+    {
+        const float* ptr = bottom_blob.row(t);
+        signed char* outptr = bottom_blob_int8.row<signed char>(t);
+
+        const float absmax = gru_dynamic_quantize_get_absmax(ptr, size);
+
+        bottom_blob_int8_descales[t] = absmax / 127.f;
+
+        const float scale = 127.f / absmax;
+        gru_dynamic_quantize_scale2int8(ptr, size, scale, outptr);
+    }
+}
+
+int GRU_x86::forward_int8(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    int T = bottom_blob.h;
+
+    int num_directions = direction == 2 ? 2 : 1;
+
+    // initial hidden state
+    Mat hidden(num_output, 4u, opt.workspace_allocator);
+    if (hidden.empty())
+        return -100;
+    hidden.fill(0.f);
+
+    top_blob.create(num_output * num_directions, T, 4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    // dynamic quantize bottom_blob
+    Mat bottom_blob_int8;
+    Mat bottom_blob_int8_descales;
+    {
+        Option opt_quant = opt;
+        opt_quant.blob_allocator = opt.workspace_allocator;
+        opt_quant.use_packing_layout = false;
+        gru_dynamic_quantize(bottom_blob, bottom_blob_int8, bottom_blob_int8_descales, opt_quant);
+    }
+
+    // Uni directional
+    if (direction == 0 || direction == 1)
+    {
+        gru_int8(bottom_blob_int8, bottom_blob_int8_descales, top_blob, direction, weight_data_tm.channel(0), weight_data_tm_int8_descales.channel(0), bias_c_data_packed.channel(0), hidden, opt);
+    }
+
+    if (direction == 2)
+    {
+        Mat top_blob_forward(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_forward.empty())
+            return -100;
+
+        Mat top_blob_reverse(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_reverse.empty())
+            return -100;
+
+        {
+            gru_int8(bottom_blob_int8, bottom_blob_int8_descales, top_blob_forward, 0, weight_data_tm.channel(0), weight_data_tm_int8_descales.channel(0), bias_c_data_packed.channel(0), hidden, opt);
+        }
+
+        hidden.fill(0.f);
+
+        {
+            gru_int8(bottom_blob_int8, bottom_blob_int8_descales, top_blob_reverse, 1, weight_data_tm.channel(1), weight_data_tm_int8_descales.channel(1), bias_c_data_packed.channel(1), hidden, opt);
+        }
+
+        // concat w
+        for (int i = 0; i < T; i++)
+        {
+            const float* pf = top_blob_forward.row(i);
+            const float* pr = top_blob_reverse.row(i);
+            float* ptr = top_blob.row(i);
+
+            memcpy(ptr, pf, num_output * sizeof(float));
+            memcpy(ptr + num_output, pr, num_output * sizeof(float));
+        }
+    }
+
+    return 0;
+}
+
+int GRU_x86::forward_int8(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const Mat& bottom_blob = bottom_blobs[0];
+
+    int T = bottom_blob.h;
+    int num_directions = direction == 2 ? 2 : 1;
+
+    Mat hidden;
+    Allocator* hidden_allocator = top_blobs.size() == 2 ? opt.blob_allocator : opt.workspace_allocator;
+    if (bottom_blobs.size() == 2)
+    {
+        hidden = bottom_blobs[1].clone(hidden_allocator);
+    }
+    else
+    {
+        hidden.create(num_output, num_directions, 4u, hidden_allocator);
+        if (hidden.empty())
+            return -100;
+        hidden.fill(0.f);
+    }
+
+    Mat& top_blob = top_blobs[0];
+    top_blob.create(num_output * num_directions, T, 4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    // dynamic quantize bottom_blob
+    Mat bottom_blob_int8;
+    Mat bottom_blob_int8_descales;
+    {
+        Option opt_quant = opt;
+        opt_quant.blob_allocator = opt.workspace_allocator;
+        opt_quant.use_packing_layout = false;
+        gru_dynamic_quantize(bottom_blob, bottom_blob_int8, bottom_blob_int8_descales, opt_quant);
+    }
+
+    // Uni directional
+    if (direction == 0 || direction == 1)
+    {
+        gru_int8(bottom_blob_int8, bottom_blob_int8_descales, top_blob, direction, weight_data_tm.channel(0), weight_data_tm_int8_descales.channel(0), bias_c_data_packed.channel(0), hidden, opt);
+    }
+
+    if (direction == 2)
+    {
+        Mat top_blob_forward(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_forward.empty())
+            return -100;
+
+        Mat top_blob_reverse(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_reverse.empty())
+            return -100;
+
+        Mat hidden0 = hidden.row_range(0, 1);
+        {
+            gru_int8(bottom_blob_int8, bottom_blob_int8_descales, top_blob_forward, 0, weight_data_tm.channel(0), weight_data_tm_int8_descales.channel(0), bias_c_data_packed.channel(0), hidden0, opt);
+        }
+
+        Mat hidden1 = hidden.row_range(1, 1);
+        {
+            gru_int8(bottom_blob_int8, bottom_blob_int8_descales, top_blob_reverse, 1, weight_data_tm.channel(1), weight_data_tm_int8_descales.channel(1), bias_c_data_packed.channel(1), hidden1, opt);
+        }
+
+        // concat w
+        for (int i = 0; i < T; i++)
+        {
+            const float* pf = top_blob_forward.row(i);
+            const float* pr = top_blob_reverse.row(i);
+            float* ptr = top_blob.row(i);
+
+            memcpy(ptr, pf, num_output * sizeof(float));
+            memcpy(ptr + num_output, pr, num_output * sizeof(float));
+        }
+    }
+
+    if (top_blobs.size() == 2)
+    {
+        top_blobs[1] = hidden;
+    }
+
+    return 0;
+}
+#endif // NCNN_INT8
+
+} // namespace ncnn
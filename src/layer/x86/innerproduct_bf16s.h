@@ -0,0 +1,102 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#if NCNN_RUNTIME_CPU && NCNN_AMXBF16 && __AVX512F__ && !__AMX_BF16__
+void innerproduct_gemm_bf16s_amxbf16(const Mat& AT, Mat& top_blob, const Mat& weight_data_tm, const Mat& bias_data, int activation_type, const Mat& activation_params, const Option& opt);
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX512BF16 && __AVX512F__ && !__AVX512BF16__
+void innerproduct_gemm_bf16s_avx512bf16(const Mat& AT, Mat& top_blob, const Mat& weight_data_tm, const Mat& bias_data, int activation_type, const Mat& activation_params, const Option& opt);
+#endif
+
+static void innerproduct_transform_kernel_bf16s(const Mat& weight_data, Mat& weight_data_tm, int num_input, int num_output, const Option& opt)
+{
+    gemm_bf16s_pack_B(weight_data.reshape(num_input, num_output), 0, weight_data_tm, (Allocator*)0, opt);
+}
+
+// top_blob (num_output, M) bf16 or fp32 = activation(AT * weight^T + bias)
+// AT is (Kp, M) bf16 rows of input, top_blob is 1d of any elempack when M == 1, or 2d unpacked
+static void innerproduct_gemm_bf16s(const Mat& AT, Mat& top_blob, const Mat& weight_data_tm, const Mat& bias_data, int activation_type, const Mat& activation_params, const Option& opt)
+{
+#if NCNN_RUNTIME_CPU && NCNN_AMXBF16 && __AVX512F__ && !__AMX_BF16__
+    if (ncnn::cpu_support_x86_amx_bf16())
+    {
+        innerproduct_gemm_bf16s_amxbf16(AT, top_blob, weight_data_tm, bias_data, activation_type, activation_params, opt);
+        return;
+    }
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX512BF16 && __AVX512F__ && !__AVX512BF16__
+    if (ncnn::cpu_support_x86_avx512_bf16())
+    {
+        innerproduct_gemm_bf16s_avx512bf16(AT, top_blob, weight_data_tm, bias_data, activation_type, activation_params, opt);
+        return;
+    }
+#endif
+
+    const int M = AT.h;
+    const int num_output = top_blob.w * top_blob.elempack;
+
+    const float* bias = bias_data.empty() ? 0 : (const float*)bias_data;
+
+    const int nr = gemm_bf16s_get_nr();
+#if __AMX_BF16__
+    // one amx tile holds 16 rows
+    const int TILE_M = 16;
+#else
+    const int TILE_M = 8;
+#endif
+
+    const int nn_M = (M + TILE_M - 1) / TILE_M;
+    const int nn_N = weight_data_tm.h;
+
+    // gemv splits over output tiles, gemm over rows and output tiles
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int ppij = 0; ppij < nn_M * nn_N; ppij++)
+    {
+        const int i0 = ppij / nn_N * TILE_M;
+        const int jb = ppij % nn_N;
+
+        const int max_ii = std::min(M - i0, TILE_M);
+        const int j = jb * nr;
+        const int max_jj = std::min(num_output - j, nr);
+
+        float tmp[TILE_M * 16];
+        gemm_bf16s_kernel(AT, weight_data_tm, bias, tmp, nr, num_output, i0, i0 + max_ii, jb, jb + 1);
+
+        for (int ii = 0; ii < max_ii; ii++)
+        {
+            const float* ptr = tmp + ii * nr;
+
+            if (top_blob.elembits() == 32)
+            {
+                float* outptr = (float*)top_blob.data + (i0 + ii) * num_output + j;
+
+                for (int jj = 0; jj < max_jj; jj++)
+                {
+                    outptr[jj] = activation_ss(ptr[jj], activation_type, activation_params);
+                }
+            }
+            else
+            {
+                unsigned short* outptr = (unsigned short*)top_blob.data + (i0 + ii) * num_output + j;
+
+                for (int jj = 0; jj < max_jj; jj++)
+                {
+                    outptr[jj] = float32_to_bfloat16(activation_ss(ptr[jj], activation_type, activation_params));
+                }
+            }
+        }
+    }
+}
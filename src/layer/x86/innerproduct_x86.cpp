@@ -26,6 +26,7 @@
 
 #include "layer_type.h"
 
+#include "benchmark.h"
 #include "cpu.h"
 
 namespace ncnn {
@@ -40,11 +41,19 @@ namespace ncnn {
 #undef NCNN_IMPL_FP16S
 #endif
 
+#if NCNN_BF16
+#include "gemm_bf16s_kernel.h"
+#include "innerproduct_bf16s.h"
+#endif
+
 InnerProduct_x86::InnerProduct_x86()
 {
 #if __SSE2__
     support_packing = true;
 #endif // __SSE2__
+#if NCNN_BF16
+    support_bf16_storage = true;
+#endif
 
     flatten = 0;
 }
@@ -65,10 +74,18 @@ int InnerProduct_x86::create_pipeline(const Option& opt)
 #if NCNN_INT8
     if (opt.use_int8_inference && weight_data.elemsize == (size_t)1u)
     {
+        support_bf16_storage = false;
         return create_pipeline_int8_x86(opt);
     }
 #endif
 
+#if NCNN_BF16
+    if (opt.use_bf16_storage)
+    {
+        return create_pipeline_bf16s(opt);
+    }
+#endif
+
 #if NCNN_F16C && __AVX__
     if (cpu_support_x86_f16c() && opt.use_fp16_storage)
     {
@@ -98,18 +115,92 @@ int InnerProduct_x86::destroy_pipeline(const Option& opt)
     return 0;
 }
 
+int InnerProduct_x86::save_pipeline_data(std::vector<Mat>& pipeline_data) const
+{
+    if (weight_data_tm.empty())
+        return -1;
+
+    pipeline_data.clear();
+    pipeline_data.push_back(weight_data_tm);
+#if NCNN_INT8
+    pipeline_data.push_back(scale_in_data);
+#endif
+
+    // the weight shape the data is transformed for
+    Mat weight_shape(2, (size_t)4u);
+    int* ps = weight_shape;
+    ps[0] = num_output;
+    ps[1] = weight_data_size;
+    pipeline_data.push_back(weight_shape);
+
+    return 0;
+}
+
+int InnerProduct_x86::load_pipeline_data(const std::vector<Mat>& pipeline_data, const Option& opt)
+{
+#if NCNN_INT8
+    if (pipeline_data.size() != 3)
+        return -1;
+#else
+    if (pipeline_data.size() != 2)
+        return -1;
+#endif
+
+    const Mat& weight_shape = pipeline_data.back();
+    if (weight_shape.dims != 1 || weight_shape.w != 2 || weight_shape.elemsize != 4u)
+        return -1;
+
+    const int* ps = weight_shape;
+    if (ps[0] != num_output || ps[1] != weight_data_size)
+        return -1;
+
+    {
+        flatten = ncnn::create_layer_cpu(ncnn::LayerType::Flatten);
+
+        ncnn::ParamDict pd;
+
+        flatten->load_param(pd);
+
+        flatten->create_pipeline(opt);
+    }
+
+    weight_data_tm = pipeline_data[0];
+#if NCNN_INT8
+    scale_in_data = pipeline_data[1];
+
+    if (opt.use_int8_inference && int8_scale_term)
+        support_bf16_storage = false;
+#endif
+
+    if (opt.lightmode)
+        weight_data.release();
+
+    return 0;
+}
+
 int InnerProduct_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
 #if NCNN_INT8
     if (opt.use_int8_inference && int8_scale_term)
     {
+        profile_kernel("int8");
         return forward_int8_x86(bottom_blob, top_blob, opt);
     }
 #endif
 
+#if NCNN_BF16
+    // create_pipeline only built the bf16 weights, fp32 input from a parent layer takes this path too
+    if (opt.use_bf16_storage)
+    {
+        profile_kernel("bf16s");
+        return forward_bf16s(bottom_blob, top_blob, opt);
+    }
+#endif
+
 #if NCNN_F16C && __AVX__
     if (cpu_support_x86_f16c() && opt.use_fp16_storage)
     {
+        profile_kernel("fp16s");
         return forward_fp16s(bottom_blob, top_blob, opt);
     }
 #endif
@@ -127,6 +218,7 @@ int InnerProduct_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Optio
         if (top_blob.empty())
             return -100;
 
+        profile_kernel("gemm");
         innerproduct_gemm_sse(bottom_blob, top_blob, weight_data_tm, bias_data, activation_type, activation_params, opt);
 
         return 0;
@@ -166,6 +258,7 @@ int InnerProduct_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Optio
     if (top_blob.empty())
         return -100;
 
+    profile_kernel("gemv");
     innerproduct_sse(bottom_blob_flattened, top_blob, weight_data_tm, bias_data, activation_type, activation_params, opt);
 
     return 0;
@@ -240,6 +333,86 @@ int InnerProduct_x86::forward_fp16s(const Mat& bottom_blob, Mat& top_blob, const
 }
 #endif // NCNN_F16C && __AVX__
 
+#if NCNN_BF16
+int InnerProduct_x86::create_pipeline_bf16s(const Option& opt)
+{
+    const int num_input = weight_data_size / num_output;
+
+    innerproduct_transform_kernel_bf16s(weight_data, weight_data_tm, num_input, num_output, opt);
+
+    if (opt.lightmode)
+        weight_data.release();
+
+    return 0;
+}
+
+int InnerProduct_x86::forward_bf16s(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    const int num_input = weight_data_size / num_output;
+
+    Option opt_unpack = opt;
+    opt_unpack.blob_allocator = opt.workspace_allocator;
+
+    Mat bottom_blob_unpacked;
+    convert_packing(bottom_blob, bottom_blob_unpacked, 1, opt_unpack);
+    if (bottom_blob_unpacked.empty())
+        return -100;
+
+    // fp32 input keeps fp32 output
+    const size_t out_elemsize = bottom_blob.elembits() == 16 ? 2u : 4u;
+
+    if (bottom_blob.dims == 2 && bottom_blob.w == num_input)
+    {
+        // gemm
+        int h = bottom_blob_unpacked.h;
+
+        Mat AT;
+        int ret = gemm_bf16s_pack_A(bottom_blob_unpacked, 0, AT, opt.workspace_allocator, opt);
+        if (ret != 0)
+            return ret;
+
+        top_blob.create(num_output, h, out_elemsize, 1, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+
+        innerproduct_gemm_bf16s(AT, top_blob, weight_data_tm, bias_data, activation_type, activation_params, opt);
+
+        return 0;
+    }
+
+    // flatten
+    Mat bottom_blob_flattened = bottom_blob_unpacked.reshape(num_input, opt.workspace_allocator);
+    if (bottom_blob_flattened.empty())
+        return -100;
+
+    Mat AT;
+    int ret = gemm_bf16s_pack_A(bottom_blob_flattened, 0, AT, opt.workspace_allocator, opt);
+    if (ret != 0)
+        return ret;
+
+    int out_elempack = 1;
+#if __SSE2__
+    if (opt.use_packing_layout)
+    {
+#if __AVX512F__
+        out_elempack = num_output % 16 == 0 ? 16 : num_output % 8 == 0 ? 8 : num_output % 4 == 0 ? 4 : 1;
+#elif __AVX__
+        out_elempack = num_output % 8 == 0 ? 8 : num_output % 4 == 0 ? 4 : 1;
+#else
+        out_elempack = num_output % 4 == 0 ? 4 : 1;
+#endif
+    }
+#endif // __SSE2__
+    top_blob.create(num_output / out_elempack, out_elemsize * out_elempack, out_elempack, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    innerproduct_gemm_bf16s(AT, top_blob, weight_data_tm, bias_data, activation_type, activation_params, opt);
+
+    return 0;
+}
+#endif // NCNN_BF16
+
 #if NCNN_INT8
 int InnerProduct_x86::create_pipeline_int8_x86(const Option& opt)
 {
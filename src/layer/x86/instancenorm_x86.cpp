@@ -0,0 +1,102 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "instancenorm_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
+#endif // __SSE2__
+#include "x86_usability.h"
+
+#include "cpu.h"
+
+namespace ncnn {
+
+#include "norm_welford.h"
+
+InstanceNorm_x86::InstanceNorm_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+#if NCNN_BF16
+    support_bf16_storage = true;
+#endif
+#if NCNN_F16C && __F16C__
+    support_fp16_storage = cpu_support_x86_f16c();
+#endif
+}
+
+int InstanceNorm_x86::create_pipeline(const Option& opt)
+{
+#if NCNN_F16C && __F16C__
+    // x86 fp16 storage is opt-in
+    support_fp16_storage = cpu_support_x86_f16c() && opt.use_x86_fp16_storage;
+#endif
+
+    return InstanceNorm::create_pipeline(opt);
+}
+
+int InstanceNorm_x86::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+{
+    // x = (x - mean) / (sqrt(var + eps)) * gamma + beta
+
+    const int storage = norm_storage_type(bottom_top_blob, opt);
+
+    int w = bottom_top_blob.w;
+    int h = bottom_top_blob.h;
+    int c = bottom_top_blob.c;
+    int elempack = bottom_top_blob.elempack;
+    int size = w * h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < c; q++)
+    {
+        void* ptr = bottom_top_blob.channel(q).data;
+
+        float mean[16];
+        float m2[16];
+        norm_welford(ptr, size, elempack, storage, mean, m2);
+
+        float a[16];
+        float b[16];
+        for (int l = 0; l < elempack; l++)
+        {
+            float var = m2[l] / size;
+
+            if (affine)
+            {
+                float gamma = gamma_data[q * elempack + l];
+                float beta = beta_data[q * elempack + l];
+
+                a[l] = gamma / (sqrtf(var + eps));
+                b[l] = -mean[l] * a[l] + beta;
+            }
+            else
+            {
+                a[l] = 1.f / (sqrtf(var + eps));
+                b[l] = -mean[l] * a[l];
+            }
+        }
+
+        norm_apply(ptr, ptr, size, elempack, storage, a, b, 0);
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -57,10 +57,14 @@ int MultiHeadAttention_x86::create_pipeline(const Option& opt)
         pd.set(11, 0);        // output_N1M
         pd.set(12, 1);        // output_elempack
         pd.set(14, 0);        // output_transpose
+        pd.set(18, int8_scale_term);
         q_gemm->load_param(pd);
-        Mat weights[2];
+        Mat weights[3];
         weights[0] = q_weight_data;
         weights[1] = q_bias_data;
+#if NCNN_INT8
+        weights[2] = q_weight_data_int8_scales;
+#endif
         q_gemm->load_model(ModelBinFromMatArray(weights));
         q_gemm->create_pipeline(opt);
 
@@ -86,10 +90,14 @@ int MultiHeadAttention_x86::create_pipeline(const Option& opt)
         pd.set(11, 0);        // output_N1M
         pd.set(12, 1);        // output_elempack
         pd.set(14, 0);        // output_transpose
+        pd.set(18, int8_scale_term);
         k_gemm->load_param(pd);
-        Mat weights[2];
+        Mat weights[3];
         weights[0] = k_weight_data;
         weights[1] = k_bias_data;
+#if NCNN_INT8
+        weights[2] = k_weight_data_int8_scales;
+#endif
         k_gemm->load_model(ModelBinFromMatArray(weights));
         k_gemm->create_pipeline(opt);
 
@@ -115,10 +123,14 @@ int MultiHeadAttention_x86::create_pipeline(const Option& opt)
         pd.set(11, 0);        // output_N1M
         pd.set(12, 1);        // output_elempack
         pd.set(14, 0);        // output_transpose
+        pd.set(18, int8_scale_term);
         v_gemm->load_param(pd);
-        Mat weights[2];
+        Mat weights[3];
         weights[0] = v_weight_data;
         weights[1] = v_bias_data;
+#if NCNN_INT8
+        weights[2] = v_weight_data_int8_scales;
+#endif
         v_gemm->load_model(ModelBinFromMatArray(weights));
         v_gemm->create_pipeline(opt);
 
@@ -194,10 +206,14 @@ int MultiHeadAttention_x86::create_pipeline(const Option& opt)
         pd.set(9, embed_dim); // K = maxk*inch
         pd.set(10, 4);        // constant_broadcast_type_C
         pd.set(11, 0);        // output_N1M
+        pd.set(18, int8_scale_term);
         o_gemm->load_param(pd);
-        Mat weights[2];
+        Mat weights[3];
         weights[0] = out_weight_data;
         weights[1] = out_bias_data;
+#if NCNN_INT8
+        weights[2] = out_weight_data_int8_scales;
+#endif
         o_gemm->load_model(ModelBinFromMatArray(weights));
         o_gemm->create_pipeline(opt);
 
@@ -264,12 +280,62 @@ int MultiHeadAttention_x86::destroy_pipeline(const Option& opt)
     return 0;
 }
 
+// xk and xv are (seqlen, embed_dim), append the current ones to the past along seqlen
+static int concat_kv_cache(const Mat& past, const Mat& cur, Mat& out, const Option& opt)
+{
+    if (past.empty())
+    {
+        out = cur;
+        return 0;
+    }
+
+    Mat past_unpacked = past;
+    if (past.elempack != 1)
+    {
+        Option opt_unpack = opt;
+        opt_unpack.blob_allocator = opt.workspace_allocator;
+        convert_packing(past, past_unpacked, 1, opt_unpack);
+        if (past_unpacked.empty())
+            return -100;
+    }
+
+    if (past_unpacked.h != cur.h || past_unpacked.elemsize != cur.elemsize)
+    {
+        NCNN_LOGE("kv cache shape %d %d does not match the current %d %d", past_unpacked.w, past_unpacked.h, cur.w, cur.h);
+        return -1;
+    }
+
+    const int past_seqlen = past_unpacked.w;
+    const int cur_seqlen = cur.w;
+    const size_t elemsize = cur.elemsize;
+
+    out.create(past_seqlen + cur_seqlen, cur.h, elemsize, opt.blob_allocator);
+    if (out.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int i = 0; i < cur.h; i++)
+    {
+        unsigned char* outptr = out.row<unsigned char>(i);
+
+        memcpy(outptr, past_unpacked.row<const unsigned char>(i), past_seqlen * elemsize);
+        memcpy(outptr + past_seqlen * elemsize, cur.row<const unsigned char>(i), cur_seqlen * elemsize);
+    }
+
+    return 0;
+}
+
 int MultiHeadAttention_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
+    // the past xk and xv come last when kv_cache enabled
+    const size_t input_count = kv_cache ? bottom_blobs.size() - 2 : bottom_blobs.size();
+
     const Mat& q_blob = bottom_blobs[0];
-    const Mat& k_blob = (bottom_blobs.size() == 1 || (bottom_blobs.size() == 2 && attn_mask)) ? q_blob : bottom_blobs[1];
-    const Mat& v_blob = (bottom_blobs.size() == 1 || (bottom_blobs.size() == 2 && attn_mask)) ? q_blob : (bottom_blobs.size() == 2 || (bottom_blobs.size() == 3 && attn_mask)) ? k_blob : bottom_blobs[2];
-    const Mat& attn_mask_blob = attn_mask ? bottom_blobs[bottom_blobs.size() - 1] : Mat();
+    const Mat& k_blob = (input_count == 1 || (input_count == 2 && attn_mask)) ? q_blob : bottom_blobs[1];
+    const Mat& v_blob = (input_count == 1 || (input_count == 2 && attn_mask)) ? q_blob : (input_count == 2 || (input_count == 3 && attn_mask)) ? k_blob : bottom_blobs[2];
+    const Mat& attn_mask_blob = attn_mask ? bottom_blobs[input_count - 1] : Mat();
+    const Mat& past_xk_blob = kv_cache ? bottom_blobs[input_count] : Mat();
+    const Mat& past_xv_blob = kv_cache ? bottom_blobs[input_count + 1] : Mat();
 
     Mat attn_mask_blob_unpacked;
     if (attn_mask && attn_mask_blob.elempack != 1)
@@ -285,7 +351,8 @@ int MultiHeadAttention_x86::forward(const std::vector<Mat>& bottom_blobs, std::v
 
     const int embed_dim_per_head = embed_dim / num_heads;
     const int src_seqlen = q_blob.h * q_blob.elempack;
-    const int dst_seqlen = k_blob.h * k_blob.elempack;
+    const int past_seqlen = past_xk_blob.empty() ? 0 : past_xk_blob.w;
+    const int dst_seqlen = past_seqlen + k_blob.h * k_blob.elempack;
 
     Mat q_affine;
     int retq = q_gemm->forward(q_blob, q_affine, opt);
@@ -297,6 +364,15 @@ int MultiHeadAttention_x86::forward(const std::vector<Mat>& bottom_blobs, std::v
     if (retk != 0)
         return retk;
 
+    if (kv_cache)
+    {
+        int retck = concat_kv_cache(past_xk_blob, k_affine, top_blobs[1], opt);
+        if (retck != 0)
+            return retck;
+
+        k_affine = top_blobs[1];
+    }
+
     Mat qk_cross(dst_seqlen, src_seqlen * num_heads, 4u, opt.blob_allocator);
     if (qk_cross.empty())
         return -100;
@@ -338,6 +414,15 @@ int MultiHeadAttention_x86::forward(const std::vector<Mat>& bottom_blobs, std::v
     if (retv != 0)
         return retv;
 
+    if (kv_cache)
+    {
+        int retcv = concat_kv_cache(past_xv_blob, v_affine, top_blobs[2], opt);
+        if (retcv != 0)
+            return retcv;
+
+        v_affine = top_blobs[2];
+    }
+
     Mat qkv_cross(src_seqlen, embed_dim_per_head * num_heads, 4u, opt.blob_allocator);
     if (qkv_cross.empty())
         return -100;
@@ -0,0 +1,141 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "mvn_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
+#endif // __SSE2__
+#include "x86_usability.h"
+
+#include "cpu.h"
+
+namespace ncnn {
+
+#include "norm_welford.h"
+
+MVN_x86::MVN_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+#if NCNN_BF16
+    support_bf16_storage = true;
+#endif
+#if NCNN_F16C && __F16C__
+    support_fp16_storage = cpu_support_x86_f16c();
+#endif
+}
+
+int MVN_x86::create_pipeline(const Option& opt)
+{
+#if NCNN_F16C && __F16C__
+    // x86 fp16 storage is opt-in
+    support_fp16_storage = cpu_support_x86_f16c() && opt.use_x86_fp16_storage;
+#endif
+
+    return MVN::create_pipeline(opt);
+}
+
+int MVN_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    const int storage = norm_storage_type(bottom_blob, opt);
+
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+    size_t elemsize = bottom_blob.elemsize;
+    int elempack = bottom_blob.elempack;
+    int size = w * h;
+
+    top_blob.create(w, h, channels, elemsize, elempack, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    // mean and m2 per channel lane
+    Mat stats(elempack * 2, channels, (size_t)4u, opt.workspace_allocator);
+    if (stats.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        float* mean = stats.row(q);
+        float* m2 = mean + elempack;
+
+        norm_welford(bottom_blob.channel(q).data, size, elempack, storage, mean, m2);
+    }
+
+    if (across_channels)
+    {
+        // merge every channel lane with chan's formula
+        float mean = 0.f;
+        float m2 = 0.f;
+        int count = 0;
+        for (int q = 0; q < channels; q++)
+        {
+            const float* pmean = stats.row(q);
+            const float* pm2 = pmean + elempack;
+
+            for (int l = 0; l < elempack; l++)
+            {
+                float delta = pmean[l] - mean;
+                mean += delta * size / (count + size);
+                m2 += pm2[l] + delta * delta * ((float)count * size / (count + size));
+                count += size;
+            }
+        }
+
+        for (int q = 0; q < channels; q++)
+        {
+            float* pmean = stats.row(q);
+            float* pm2 = pmean + elempack;
+
+            for (int l = 0; l < elempack; l++)
+            {
+                pmean[l] = mean;
+                pm2[l] = m2 / count * size;
+            }
+        }
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* mean = stats.row(q);
+        const float* m2 = mean + elempack;
+
+        float a[16];
+        float b[16];
+        for (int l = 0; l < elempack; l++)
+        {
+            a[l] = 1.f;
+            if (normalize_variance)
+            {
+                float norm_var = sqrtf(m2[l] / size) + eps;
+                a[l] = 1.f / norm_var;
+            }
+            b[l] = -mean[l] * a[l];
+        }
+
+        norm_apply(bottom_blob.channel(q).data, top_blob.channel(q).data, size, elempack, storage, a, b, 0);
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -0,0 +1,538 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// shared by the x86 InstanceNorm, RMSNorm and MVN
+
+// blocks of up to norm_block_size floats are widened from 16-bit storage on the stack,
+// statistics are gathered block by block in one sweep over memory and merged with chan's formula
+static const int norm_block_size = 1024;
+
+// 0 = fp32, 1 = fp16, 2 = bf16
+static int norm_storage_type(const Mat& m, const Option& opt)
+{
+    if (m.elembits() != 16)
+        return 0;
+
+    return opt.use_bf16_storage ? 2 : 1;
+}
+
+static const float* norm_load_block(const void* ptr, float* tmp, int count, int storage)
+{
+    if (storage == 0)
+        return (const float*)ptr;
+
+    const unsigned short* p = (const unsigned short*)ptr;
+
+    int i = 0;
+    if (storage == 1)
+    {
+#if __F16C__
+        for (; i + 7 < count; i += 8)
+        {
+            _mm256_storeu_ps(tmp + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(p + i))));
+        }
+#endif // __F16C__
+        for (; i < count; i++)
+        {
+            tmp[i] = float16_to_float32(p[i]);
+        }
+    }
+    else
+    {
+#if __SSE2__
+        for (; i + 3 < count; i += 4)
+        {
+            _mm_storeu_ps(tmp + i, bfloat2float_sse(_mm_loadl_epi64((const __m128i*)(p + i))));
+        }
+#endif // __SSE2__
+        for (; i < count; i++)
+        {
+            tmp[i] = bfloat16_to_float32(p[i]);
+        }
+    }
+
+    return tmp;
+}
+
+static void norm_store_block(const float* tmp, void* ptr, int count, int storage)
+{
+    if (storage == 0)
+    {
+        if (tmp != ptr)
+            memcpy(ptr, tmp, count * sizeof(float));
+        return;
+    }
+
+    unsigned short* p = (unsigned short*)ptr;
+
+    int i = 0;
+    if (storage == 1)
+    {
+#if __F16C__
+        for (; i + 7 < count; i += 8)
+        {
+            _mm_storeu_si128((__m128i*)(p + i), _mm256_cvtps_ph(_mm256_loadu_ps(tmp + i), _MM_FROUND_TRUNC));
+        }
+#endif // __F16C__
+        for (; i < count; i++)
+        {
+            p[i] = float32_to_float16(tmp[i]);
+        }
+    }
+    else
+    {
+#if __SSE2__
+        for (; i + 7 < count; i += 8)
+        {
+            _mm_storeu_si128((__m128i*)(p + i), float2bfloat_sse(_mm_loadu_ps(tmp + i), _mm_loadu_ps(tmp + i + 4)));
+        }
+#endif // __SSE2__
+        for (; i < count; i++)
+        {
+            p[i] = float32_to_bfloat16(tmp[i]);
+        }
+    }
+}
+
+static float norm_block_sum(const float* ptr, int size)
+{
+    float sum = 0.f;
+
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    __m512 _sum_avx512 = _mm512_setzero_ps();
+    for (; i + 15 < size; i += 16)
+    {
+        _sum_avx512 = _mm512_add_ps(_sum_avx512, _mm512_loadu_ps(ptr + i));
+    }
+    sum += _mm512_comp_reduce_add_ps(_sum_avx512);
+#endif // __AVX512F__
+    __m256 _sum_avx = _mm256_setzero_ps();
+    for (; i + 7 < size; i += 8)
+    {
+        _sum_avx = _mm256_add_ps(_sum_avx, _mm256_loadu_ps(ptr + i));
+    }
+    sum += _mm256_reduce_add_ps(_sum_avx);
+#endif // __AVX__
+    __m128 _sum = _mm_setzero_ps();
+    for (; i + 3 < size; i += 4)
+    {
+        _sum = _mm_add_ps(_sum, _mm_loadu_ps(ptr + i));
+    }
+    sum += _mm_reduce_add_ps(_sum);
+#endif // __SSE2__
+    for (; i < size; i++)
+    {
+        sum += ptr[i];
+    }
+
+    return sum;
+}
+
+// sum of (x - mean)^2, or of x^2 when mean is zero
+static float norm_block_sqsum(const float* ptr, int size, float mean)
+{
+    float sqsum = 0.f;
+
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    __m512 _sqsum_avx512 = _mm512_setzero_ps();
+    __m512 _mean_avx512 = _mm512_set1_ps(mean);
+    for (; i + 15 < size; i += 16)
+    {
+        __m512 _p = _mm512_sub_ps(_mm512_loadu_ps(ptr + i), _mean_avx512);
+        _sqsum_avx512 = _mm512_fmadd_ps(_p, _p, _sqsum_avx512);
+    }
+    sqsum += _mm512_comp_reduce_add_ps(_sqsum_avx512);
+#endif // __AVX512F__
+    __m256 _sqsum_avx = _mm256_setzero_ps();
+    __m256 _mean_avx = _mm256_set1_ps(mean);
+    for (; i + 7 < size; i += 8)
+    {
+        __m256 _p = _mm256_sub_ps(_mm256_loadu_ps(ptr + i), _mean_avx);
+        _sqsum_avx = _mm256_comp_fmadd_ps(_p, _p, _sqsum_avx);
+    }
+    sqsum += _mm256_reduce_add_ps(_sqsum_avx);
+#endif // __AVX__
+    __m128 _sqsum = _mm_setzero_ps();
+    __m128 _mean = _mm_set1_ps(mean);
+    for (; i + 3 < size; i += 4)
+    {
+        __m128 _p = _mm_sub_ps(_mm_loadu_ps(ptr + i), _mean);
+        _sqsum = _mm_comp_fmadd_ps(_p, _p, _sqsum);
+    }
+    sqsum += _mm_reduce_add_ps(_sqsum);
+#endif // __SSE2__
+    for (; i < size; i++)
+    {
+        float v = ptr[i] - mean;
+        sqsum += v * v;
+    }
+
+    return sqsum;
+}
+
+// merge the statistics of n positions into the running mean / m2 of count positions, per lane of elempack
+static void norm_welford_block(const float* ptr, int n, int elempack, float* mean, float* m2, int count)
+{
+    const float block_scale = 1.f / n;
+    const float mean_scale = (float)n / (count + n);
+    const float m2_scale = (float)count * n / (count + n);
+
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    if (elempack == 16)
+    {
+        __m512 _sum = _mm512_setzero_ps();
+        for (int i = 0; i < n; i++)
+        {
+            _sum = _mm512_add_ps(_sum, _mm512_loadu_ps(ptr + i * 16));
+        }
+        __m512 _block_mean = _mm512_mul_ps(_sum, _mm512_set1_ps(block_scale));
+
+        __m512 _block_m2 = _mm512_setzero_ps();
+        for (int i = 0; i < n; i++)
+        {
+            __m512 _p = _mm512_sub_ps(_mm512_loadu_ps(ptr + i * 16), _block_mean);
+            _block_m2 = _mm512_fmadd_ps(_p, _p, _block_m2);
+        }
+
+        __m512 _mean = _mm512_loadu_ps(mean);
+        __m512 _delta = _mm512_sub_ps(_block_mean, _mean);
+        _mean = _mm512_fmadd_ps(_delta, _mm512_set1_ps(mean_scale), _mean);
+        __m512 _m2 = _mm512_add_ps(_mm512_loadu_ps(m2), _block_m2);
+        _m2 = _mm512_fmadd_ps(_mm512_mul_ps(_delta, _delta), _mm512_set1_ps(m2_scale), _m2);
+        _mm512_storeu_ps(mean, _mean);
+        _mm512_storeu_ps(m2, _m2);
+        return;
+    }
+#endif // __AVX512F__
+    if (elempack == 8)
+    {
+        __m256 _sum = _mm256_setzero_ps();
+        for (int i = 0; i < n; i++)
+        {
+            _sum = _mm256_add_ps(_sum, _mm256_loadu_ps(ptr + i * 8));
+        }
+        __m256 _block_mean = _mm256_mul_ps(_sum, _mm256_set1_ps(block_scale));
+
+        __m256 _block_m2 = _mm256_setzero_ps();
+        for (int i = 0; i < n; i++)
+        {
+            __m256 _p = _mm256_sub_ps(_mm256_loadu_ps(ptr + i * 8), _block_mean);
+            _block_m2 = _mm256_comp_fmadd_ps(_p, _p, _block_m2);
+        }
+
+        __m256 _mean = _mm256_loadu_ps(mean);
+        __m256 _delta = _mm256_sub_ps(_block_mean, _mean);
+        _mean = _mm256_comp_fmadd_ps(_delta, _mm256_set1_ps(mean_scale), _mean);
+        __m256 _m2 = _mm256_add_ps(_mm256_loadu_ps(m2), _block_m2);
+        _m2 = _mm256_comp_fmadd_ps(_mm256_mul_ps(_delta, _delta), _mm256_set1_ps(m2_scale), _m2);
+        _mm256_storeu_ps(mean, _mean);
+        _mm256_storeu_ps(m2, _m2);
+        return;
+    }
+#endif // __AVX__
+    if (elempack == 4)
+    {
+        __m128 _sum = _mm_setzero_ps();
+        for (int i = 0; i < n; i++)
+        {
+            _sum = _mm_add_ps(_sum, _mm_loadu_ps(ptr + i * 4));
+        }
+        __m128 _block_mean = _mm_mul_ps(_sum, _mm_set1_ps(block_scale));
+
+        __m128 _block_m2 = _mm_setzero_ps();
+        for (int i = 0; i < n; i++)
+        {
+            __m128 _p = _mm_sub_ps(_mm_loadu_ps(ptr + i * 4), _block_mean);
+            _block_m2 = _mm_comp_fmadd_ps(_p, _p, _block_m2);
+        }
+
+        __m128 _mean = _mm_loadu_ps(mean);
+        __m128 _delta = _mm_sub_ps(_block_mean, _mean);
+        _mean = _mm_comp_fmadd_ps(_delta, _mm_set1_ps(mean_scale), _mean);
+        __m128 _m2 = _mm_add_ps(_mm_loadu_ps(m2), _block_m2);
+        _m2 = _mm_comp_fmadd_ps(_mm_mul_ps(_delta, _delta), _mm_set1_ps(m2_scale), _m2);
+        _mm_storeu_ps(mean, _mean);
+        _mm_storeu_ps(m2, _m2);
+        return;
+    }
+#endif // __SSE2__
+
+    if (elempack == 1)
+    {
+        float block_mean = norm_block_sum(ptr, n) * block_scale;
+        float block_m2 = norm_block_sqsum(ptr, n, block_mean);
+
+        float delta = block_mean - mean[0];
+        mean[0] += delta * mean_scale;
+        m2[0] += block_m2 + delta * delta * m2_scale;
+        return;
+    }
+
+    for (int l = 0; l < elempack; l++)
+    {
+        float sum = 0.f;
+        for (int i = 0; i < n; i++)
+        {
+            sum += ptr[i * elempack + l];
+        }
+        float block_mean = sum * block_scale;
+
+        float block_m2 = 0.f;
+        for (int i = 0; i < n; i++)
+        {
+            float v = ptr[i * elempack + l] - block_mean;
+            block_m2 += v * v;
+        }
+
+        float delta = block_mean - mean[l];
+        mean[l] += delta * mean_scale;
+        m2[l] += block_m2 + delta * delta * m2_scale;
+    }
+}
+
+// accumulate x^2 of n positions, per lane of elempack
+static void norm_sqsum_block(const float* ptr, int n, int elempack, float* sqsum)
+{
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    if (elempack == 16)
+    {
+        __m512 _sqsum = _mm512_loadu_ps(sqsum);
+        for (int i = 0; i < n; i++)
+        {
+            __m512 _p = _mm512_loadu_ps(ptr + i * 16);
+            _sqsum = _mm512_fmadd_ps(_p, _p, _sqsum);
+        }
+        _mm512_storeu_ps(sqsum, _sqsum);
+        return;
+    }
+#endif // __AVX512F__
+    if (elempack == 8)
+    {
+        __m256 _sqsum = _mm256_loadu_ps(sqsum);
+        for (int i = 0; i < n; i++)
+        {
+            __m256 _p = _mm256_loadu_ps(ptr + i * 8);
+            _sqsum = _mm256_comp_fmadd_ps(_p, _p, _sqsum);
+        }
+        _mm256_storeu_ps(sqsum, _sqsum);
+        return;
+    }
+#endif // __AVX__
+    if (elempack == 4)
+    {
+        __m128 _sqsum = _mm_loadu_ps(sqsum);
+        for (int i = 0; i < n; i++)
+        {
+            __m128 _p = _mm_loadu_ps(ptr + i * 4);
+            _sqsum = _mm_comp_fmadd_ps(_p, _p, _sqsum);
+        }
+        _mm_storeu_ps(sqsum, _sqsum);
+        return;
+    }
+#endif // __SSE2__
+
+    if (elempack == 1)
+    {
+        sqsum[0] += norm_block_sqsum(ptr, n, 0.f);
+        return;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        for (int l = 0; l < elempack; l++)
+        {
+            sqsum[l] += ptr[i * elempack + l] * ptr[i * elempack + l];
+        }
+    }
+}
+
+// outptr = ptr * a + b with a b per lane of elempack, and times gamma per position when given
+static void norm_apply_block(const float* ptr, float* outptr, int n, int elempack, const float* a, const float* b, const float* gamma)
+{
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    if (elempack == 16)
+    {
+        __m512 _a = _mm512_loadu_ps(a);
+        __m512 _b = _mm512_loadu_ps(b);
+        for (int i = 0; i < n; i++)
+        {
+            __m512 _p = _mm512_fmadd_ps(_mm512_loadu_ps(ptr + i * 16), _a, _b);
+            if (gamma)
+                _p = _mm512_mul_ps(_p, _mm512_set1_ps(gamma[i]));
+            _mm512_storeu_ps(outptr + i * 16, _p);
+        }
+        return;
+    }
+#endif // __AVX512F__
+    if (elempack == 8)
+    {
+        __m256 _a = _mm256_loadu_ps(a);
+        __m256 _b = _mm256_loadu_ps(b);
+        for (int i = 0; i < n; i++)
+        {
+            __m256 _p = _mm256_comp_fmadd_ps(_mm256_loadu_ps(ptr + i * 8), _a, _b);
+            if (gamma)
+                _p = _mm256_mul_ps(_p, _mm256_set1_ps(gamma[i]));
+            _mm256_storeu_ps(outptr + i * 8, _p);
+        }
+        return;
+    }
+#endif // __AVX__
+    if (elempack == 4)
+    {
+        __m128 _a = _mm_loadu_ps(a);
+        __m128 _b = _mm_loadu_ps(b);
+        for (int i = 0; i < n; i++)
+        {
+            __m128 _p = _mm_comp_fmadd_ps(_mm_loadu_ps(ptr + i * 4), _a, _b);
+            if (gamma)
+                _p = _mm_mul_ps(_p, _mm_set1_ps(gamma[i]));
+            _mm_storeu_ps(outptr + i * 4, _p);
+        }
+        return;
+    }
+#endif // __SSE2__
+
+    if (elempack == 1)
+    {
+        int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+        __m512 _a_avx512 = _mm512_set1_ps(a[0]);
+        __m512 _b_avx512 = _mm512_set1_ps(b[0]);
+        for (; i + 15 < n; i += 16)
+        {
+            __m512 _p = _mm512_fmadd_ps(_mm512_loadu_ps(ptr + i), _a_avx512, _b_avx512);
+            if (gamma)
+                _p = _mm512_mul_ps(_p, _mm512_loadu_ps(gamma + i));
+            _mm512_storeu_ps(outptr + i, _p);
+        }
+#endif // __AVX512F__
+        __m256 _a_avx = _mm256_set1_ps(a[0]);
+        __m256 _b_avx = _mm256_set1_ps(b[0]);
+        for (; i + 7 < n; i += 8)
+        {
+            __m256 _p = _mm256_comp_fmadd_ps(_mm256_loadu_ps(ptr + i), _a_avx, _b_avx);
+            if (gamma)
+                _p = _mm256_mul_ps(_p, _mm256_loadu_ps(gamma + i));
+            _mm256_storeu_ps(outptr + i, _p);
+        }
+#endif // __AVX__
+        __m128 _a = _mm_set1_ps(a[0]);
+        __m128 _b = _mm_set1_ps(b[0]);
+        for (; i + 3 < n; i += 4)
+        {
+            __m128 _p = _mm_comp_fmadd_ps(_mm_loadu_ps(ptr + i), _a, _b);
+            if (gamma)
+                _p = _mm_mul_ps(_p, _mm_loadu_ps(gamma + i));
+            _mm_storeu_ps(outptr + i, _p);
+        }
+#endif // __SSE2__
+        for (; i < n; i++)
+        {
+            float v = ptr[i] * a[0] + b[0];
+            outptr[i] = gamma ? v * gamma[i] : v;
+        }
+        return;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        for (int l = 0; l < elempack; l++)
+        {
+            float v = ptr[i * elempack + l] * a[l] + b[l];
+            outptr[i * elempack + l] = gamma ? v * gamma[i] : v;
+        }
+    }
+}
+
+// mean and m2 of each lane over size positions of elempack lanes, with one sweep over ptr
+static void norm_welford(const void* ptr, int size, int elempack, int storage, float* mean, float* m2)
+{
+    const size_t elemsize = storage == 0 ? 4u : 2u;
+    const int block_n = norm_block_size / elempack;
+
+    float tmp[norm_block_size];
+
+    for (int l = 0; l < elempack; l++)
+    {
+        mean[l] = 0.f;
+        m2[l] = 0.f;
+    }
+
+    for (int i = 0; i < size; i += block_n)
+    {
+        const int n = std::min(block_n, size - i);
+
+        const float* p = norm_load_block((const unsigned char*)ptr + i * elempack * elemsize, tmp, n * elempack, storage);
+        norm_welford_block(p, n, elempack, mean, m2, i);
+    }
+}
+
+// sum of squares of each lane over size positions of elempack lanes
+static void norm_sqsum(const void* ptr, int size, int elempack, int storage, float* sqsum)
+{
+    const size_t elemsize = storage == 0 ? 4u : 2u;
+    const int block_n = norm_block_size / elempack;
+
+    float tmp[norm_block_size];
+
+    for (int l = 0; l < elempack; l++)
+    {
+        sqsum[l] = 0.f;
+    }
+
+    for (int i = 0; i < size; i += block_n)
+    {
+        const int n = std::min(block_n, size - i);
+
+        const float* p = norm_load_block((const unsigned char*)ptr + i * elempack * elemsize, tmp, n * elempack, storage);
+        norm_sqsum_block(p, n, elempack, sqsum);
+    }
+}
+
+// outptr = ptr * a + b, times gamma per position when given, ptr and outptr may alias
+static void norm_apply(const void* ptr, void* outptr, int size, int elempack, int storage, const float* a, const float* b, const float* gamma)
+{
+    const size_t elemsize = storage == 0 ? 4u : 2u;
+    const int block_n = norm_block_size / elempack;
+
+    float tmp[norm_block_size];
+
+    for (int i = 0; i < size; i += block_n)
+    {
+        const int n = std::min(block_n, size - i);
+        const size_t offset = i * elempack * elemsize;
+
+        const float* p = norm_load_block((const unsigned char*)ptr + offset, tmp, n * elempack, storage);
+        float* outp = storage == 0 ? (float*)((unsigned char*)outptr + offset) : tmp;
+
+        norm_apply_block(p, outp, n, elempack, a, b, gamma ? gamma + i : 0);
+
+        norm_store_block(outp, (unsigned char*)outptr + offset, n * elempack, storage);
+    }
+}
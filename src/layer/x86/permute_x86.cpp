@@ -0,0 +1,224 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "permute_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif
+#endif // __SSE2__
+
+namespace ncnn {
+
+Permute_x86::Permute_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+}
+
+// output w h d c taken from input axis w0 h1 d2 c3, in the order_type listing of Permute
+static const char* const permute_orders_2d[2] = {"wh", "hw"};
+static const char* const permute_orders_3d[6] = {"whc", "hwc", "wch", "cwh", "hcw", "chw"};
+static const char* const permute_orders_4d[24] = {
+    "whdc", "hwdc", "wdhc", "dwhc", "hdwc", "dhwc",
+    "whcd", "hwcd", "wchd", "cwhd", "hcwd", "chwd",
+    "wdch", "dwch", "wcdh", "cwdh", "dcwh", "cdwh",
+    "hdcw", "dhcw", "hcdw", "chdw", "dchw", "cdhw"
+};
+
+static int permute_axis_index(char a)
+{
+    return a == 'w' ? 0 : a == 'h' ? 1 : a == 'd' ? 2 : 3;
+}
+
+static void permute_copy_pack(const float* ptr, float* outptr, int elempack)
+{
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    if (elempack == 16)
+    {
+        _mm512_storeu_ps(outptr, _mm512_loadu_ps(ptr));
+        return;
+    }
+#endif // __AVX512F__
+    if (elempack == 8)
+    {
+        _mm256_storeu_ps(outptr, _mm256_loadu_ps(ptr));
+        return;
+    }
+#endif // __AVX__
+    if (elempack == 4)
+    {
+        _mm_storeu_ps(outptr, _mm_loadu_ps(ptr));
+        return;
+    }
+#endif // __SSE2__
+    for (int l = 0; l < elempack; l++)
+    {
+        outptr[l] = ptr[l];
+    }
+}
+
+int Permute_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    const int elempack = bottom_blob.elempack;
+
+    if (elempack == 1)
+        return Permute::forward(bottom_blob, top_blob, opt);
+
+    const int dims = bottom_blob.dims;
+
+    if (dims == 1 || order_type == 0)
+    {
+        top_blob = bottom_blob;
+        return 0;
+    }
+
+    const char* order = 0;
+    if (dims == 2 && order_type < 2)
+        order = permute_orders_2d[order_type];
+    if (dims == 3 && order_type < 6)
+        order = permute_orders_3d[order_type];
+    if (dims == 4 && order_type < 24)
+        order = permute_orders_4d[order_type];
+
+    if (!order)
+    {
+        top_blob = bottom_blob;
+        return 0;
+    }
+
+    const int w = bottom_blob.w;
+    const int h = bottom_blob.h;
+    const int d = bottom_blob.d;
+    const int channels = bottom_blob.c;
+    const size_t elemsize = bottom_blob.elemsize;
+
+    // unpacked sizes and element offsets of each input axis, the outermost one is packed
+    const int packed_axis = dims == 2 ? 1 : 3;
+    const int group_stride = dims == 2 ? w * elempack : (int)bottom_blob.cstep * elempack;
+
+    int sizes[4] = {w, dims == 2 ? h * elempack : h, d, dims == 2 ? 1 : channels * elempack};
+    int strides[4] = {elempack, w * elempack, w * h * elempack, 0};
+
+    std::vector<int> offsets[4];
+    for (int a = 0; a < 4; a++)
+    {
+        offsets[a].resize(sizes[a]);
+        for (int x = 0; x < sizes[a]; x++)
+        {
+            offsets[a][x] = a == packed_axis ? x / elempack * group_stride + x % elempack : x * strides[a];
+        }
+    }
+
+    // source axis of output w h d c
+    const int out_axes_2d[4] = {0, 1, -1, -1};
+    const int out_axes_3d[4] = {0, 1, -1, 2};
+    const int out_axes_4d[4] = {0, 1, 2, 3};
+    const int* out_axes = dims == 2 ? out_axes_2d : dims == 3 ? out_axes_3d : out_axes_4d;
+
+    int src[4];
+    int outsizes[4];
+    for (int k = 0; k < 4; k++)
+    {
+        src[k] = out_axes[k] == -1 ? -1 : permute_axis_index(order[out_axes[k]]);
+        outsizes[k] = src[k] == -1 ? 1 : sizes[src[k]];
+    }
+
+    const int out_packed_axis = dims == 2 ? 1 : 3;
+    const int outer = outsizes[out_packed_axis];
+
+    int out_elempack = 1;
+#if __SSE2__
+    if (opt.use_packing_layout)
+    {
+#if __AVX512F__
+        out_elempack = outer % 16 == 0 ? 16 : outer % 8 == 0 ? 8 : outer % 4 == 0 ? 4 : 1;
+#elif __AVX__
+        out_elempack = outer % 8 == 0 ? 8 : outer % 4 == 0 ? 4 : 1;
+#else
+        out_elempack = outer % 4 == 0 ? 4 : 1;
+#endif
+    }
+#endif // __SSE2__
+    size_t out_elemsize = elemsize / elempack * out_elempack;
+
+    const int outw = outsizes[0];
+    const int outh = outsizes[1];
+    const int outd = outsizes[2];
+
+    if (dims == 2)
+        top_blob.create(outw, outh / out_elempack, out_elemsize, out_elempack, opt.blob_allocator);
+    if (dims == 3)
+        top_blob.create(outw, outh, outer / out_elempack, out_elemsize, out_elempack, opt.blob_allocator);
+    if (dims == 4)
+        top_blob.create(outw, outh, outd, outer / out_elempack, out_elemsize, out_elempack, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    // lanes stay contiguous when the packed axis remains outermost with the same pack
+    const bool copy_pack = src[out_packed_axis] == packed_axis && out_elempack == elempack;
+
+    // offsets of output w h d, the output outer axis selects the group
+    const int* woffsets = &offsets[src[0]][0];
+    const int* hoffsets = dims == 2 ? 0 : &offsets[src[1]][0];
+    const int* doffsets = src[2] == -1 ? 0 : &offsets[src[2]][0];
+    const int* coffsets = &offsets[src[out_packed_axis]][0];
+
+    const int outgroups = outer / out_elempack;
+    const int inner_h = dims == 2 ? 1 : outh;
+
+    const float* ptr = bottom_blob;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < outgroups; q++)
+    {
+        float* outptr = dims == 2 ? top_blob.row(q) : top_blob.channel(q);
+
+        for (int z = 0; z < outd; z++)
+        {
+            const int zoffset = doffsets ? doffsets[z] : 0;
+
+            for (int i = 0; i < inner_h; i++)
+            {
+                const int yoffset = zoffset + (hoffsets ? hoffsets[i] : 0);
+
+                for (int j = 0; j < outw; j++)
+                {
+                    const int offset = yoffset + woffsets[j];
+
+                    if (copy_pack)
+                    {
+                        permute_copy_pack(ptr + offset + coffsets[q * out_elempack], outptr, out_elempack);
+                        outptr += out_elempack;
+                        continue;
+                    }
+
+                    for (int l = 0; l < out_elempack; l++)
+                    {
+                        *outptr++ = ptr[offset + coffsets[q * out_elempack + l]];
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -0,0 +1,722 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "reduction_x86.h"
+
+#include <float.h>
+
+#if __SSE2__
+#include <emmintrin.h>
+#include "sse_mathfun.h"
+#if __AVX__
+#include <immintrin.h>
+#include "avx_mathfun.h"
+#if __AVX512F__
+#include "avx512_mathfun.h"
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+
+#include "x86_usability.h"
+
+namespace ncnn {
+
+Reduction_x86::Reduction_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+}
+
+// outptr = op(outptr, ptr) elementwise
+template<typename Op>
+static void reduction_op_vector(const float* ptr, float* outptr, int size)
+{
+    const Op op;
+
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    for (; i + 15 < size; i += 16)
+    {
+        _mm512_storeu_ps(outptr, op.func_pack16(_mm512_loadu_ps(outptr), _mm512_loadu_ps(ptr)));
+        ptr += 16;
+        outptr += 16;
+    }
+#endif // __AVX512F__
+    for (; i + 7 < size; i += 8)
+    {
+        _mm256_storeu_ps(outptr, op.func_pack8(_mm256_loadu_ps(outptr), _mm256_loadu_ps(ptr)));
+        ptr += 8;
+        outptr += 8;
+    }
+#endif // __AVX__
+    for (; i + 3 < size; i += 4)
+    {
+        _mm_storeu_ps(outptr, op.func_pack4(_mm_loadu_ps(outptr), _mm_loadu_ps(ptr)));
+        ptr += 4;
+        outptr += 4;
+    }
+#endif // __SSE2__
+    for (; i < size; i++)
+    {
+        *outptr = op.func(*outptr, *ptr);
+        ptr++;
+        outptr++;
+    }
+}
+
+// accumulate a row of w packs into outptr, into one pack when reduce_w
+template<typename Op>
+static void reduction_op_row(const float* ptr, float* outptr, int w, bool reduce_w, int elempack)
+{
+    if (!reduce_w)
+    {
+        reduction_op_vector<Op>(ptr, outptr, w * elempack);
+        return;
+    }
+
+    const Op op;
+
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    if (elempack == 16)
+    {
+        __m512 _sum = _mm512_loadu_ps(outptr);
+        for (int j = 0; j < w; j++)
+        {
+            _sum = op.func_pack16(_sum, _mm512_loadu_ps(ptr));
+            ptr += 16;
+        }
+        _mm512_storeu_ps(outptr, _sum);
+        return;
+    }
+#endif // __AVX512F__
+    if (elempack == 8)
+    {
+        __m256 _sum = _mm256_loadu_ps(outptr);
+        for (int j = 0; j < w; j++)
+        {
+            _sum = op.func_pack8(_sum, _mm256_loadu_ps(ptr));
+            ptr += 8;
+        }
+        _mm256_storeu_ps(outptr, _sum);
+        return;
+    }
+#endif // __AVX__
+    if (elempack == 4)
+    {
+        __m128 _sum = _mm_loadu_ps(outptr);
+        for (int j = 0; j < w; j++)
+        {
+            _sum = op.func_pack4(_sum, _mm_loadu_ps(ptr));
+            ptr += 4;
+        }
+        _mm_storeu_ps(outptr, _sum);
+        return;
+    }
+#endif // __SSE2__
+
+    for (int l = 0; l < elempack; l++)
+    {
+        float sum = outptr[l];
+        for (int j = 0; j < w; j++)
+        {
+            sum = op.func(sum, ptr[j * elempack + l]);
+        }
+        outptr[l] = sum;
+    }
+}
+
+// reduce the w h d block of one packed group, reduced axes collapse to 1
+template<typename Op>
+static void reduction_op_group(const float* ptr, float* outptr, int w, int h, int d, bool reduce_w, bool reduce_h, bool reduce_d, int elempack)
+{
+    const int outw = reduce_w ? 1 : w;
+    const int outh = reduce_h ? 1 : h;
+
+    for (int z = 0; z < d; z++)
+    {
+        for (int i = 0; i < h; i++)
+        {
+            const float* p = ptr + (z * h + i) * w * elempack;
+            float* outp = outptr + ((reduce_d ? 0 : z) * outh + (reduce_h ? 0 : i)) * outw * elempack;
+
+            reduction_op_row<Op>(p, outp, w, reduce_w, elempack);
+        }
+    }
+}
+
+template<typename MathOp>
+static void reduction_post_process(float* ptr, int size, float coeff)
+{
+    const MathOp mathop;
+
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    __m512 _coeff_avx512 = _mm512_set1_ps(coeff);
+    for (; i + 15 < size; i += 16)
+    {
+        _mm512_storeu_ps(ptr, _mm512_mul_ps(mathop.func_pack16(_mm512_loadu_ps(ptr)), _coeff_avx512));
+        ptr += 16;
+    }
+#endif // __AVX512F__
+    __m256 _coeff_avx = _mm256_set1_ps(coeff);
+    for (; i + 7 < size; i += 8)
+    {
+        _mm256_storeu_ps(ptr, _mm256_mul_ps(mathop.func_pack8(_mm256_loadu_ps(ptr)), _coeff_avx));
+        ptr += 8;
+    }
+#endif // __AVX__
+    __m128 _coeff = _mm_set1_ps(coeff);
+    for (; i + 3 < size; i += 4)
+    {
+        _mm_storeu_ps(ptr, _mm_mul_ps(mathop.func_pack4(_mm_loadu_ps(ptr)), _coeff));
+        ptr += 4;
+    }
+#endif // __SSE2__
+    for (; i < size; i++)
+    {
+        *ptr = mathop.func(*ptr) * coeff;
+        ptr++;
+    }
+}
+
+template<typename Op, typename Op2, typename MathOp>
+static int reduction_pack(const Mat& a, Mat& b, float v0, bool reduce_w, bool reduce_h, bool reduce_d, bool reduce_c, bool post_process, float coeff, int keepdims, const Option& opt)
+{
+    const int dims = a.dims;
+    const size_t elemsize = a.elemsize;
+    const int elempack = a.elempack;
+
+    // view as groups of packed w h d blocks, the packed axis indexes the groups
+    int w = dims == 1 ? 1 : a.w;
+    int h = dims <= 2 ? 1 : a.h;
+    int d = dims <= 3 ? 1 : a.d;
+    int groups = dims == 1 ? a.w : dims == 2 ? a.h : a.c;
+    int group_stride = dims == 1 ? 1 : dims == 2 ? a.w : (int)a.cstep;
+
+    if (dims == 1)
+    {
+        reduce_w = false;
+        reduce_c = true;
+    }
+    if (dims == 2)
+    {
+        reduce_c = reduce_h;
+        reduce_h = false;
+    }
+
+    const int outw = reduce_w ? 1 : w;
+    const int outh = reduce_h ? 1 : h;
+    const int outd = reduce_d ? 1 : d;
+    const int inner_size = outw * outh * outd;
+
+    Mat reduced(inner_size * groups, elemsize, elempack, reduce_c ? opt.workspace_allocator : opt.blob_allocator);
+    if (reduced.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < groups; q++)
+    {
+        const float* ptr = (const float*)a.data + q * group_stride * elempack;
+        float* outptr = (float*)reduced.data + q * inner_size * elempack;
+
+        for (int i = 0; i < inner_size * elempack; i++)
+        {
+            outptr[i] = v0;
+        }
+
+        reduction_op_group<Op>(ptr, outptr, w, h, d, reduce_w, reduce_h, reduce_d, elempack);
+    }
+
+    // output shape in w h d c order, the kept packed axis counts packed groups
+    int outshape[4];
+    int outdims = 0;
+    {
+        const int sizes[4] = {w, dims == 2 ? groups : h, d, groups};
+        const bool reduces[4] = {reduce_w, dims == 2 ? reduce_c : reduce_h, reduce_d, reduce_c};
+        const int axes_index_2d[2] = {0, 1};
+        const int axes_index_3d[3] = {0, 1, 3};
+        const int axes_index_4d[4] = {0, 1, 2, 3};
+        const int* axes_index = dims == 2 ? axes_index_2d : dims == 3 ? axes_index_3d : axes_index_4d;
+
+        for (int k = 0; dims > 1 && k < dims; k++)
+        {
+            const int ai = axes_index[k];
+            if (keepdims)
+                outshape[outdims++] = reduces[ai] ? 1 : sizes[ai];
+            else if (!reduces[ai])
+                outshape[outdims++] = sizes[ai];
+        }
+
+        if (outdims == 0)
+            outshape[outdims++] = 1;
+    }
+
+    Mat out = reduced;
+    if (reduce_c)
+    {
+        // fold the groups, then the lanes
+        out.create(inner_size, (size_t)4u, opt.blob_allocator);
+        if (out.empty())
+            return -100;
+
+        const Op2 op2;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i = 0; i < inner_size; i++)
+        {
+            float* sumptr = (float*)reduced.data + i * elempack;
+
+            for (int q = 1; q < groups; q++)
+            {
+                reduction_op_vector<Op2>((const float*)reduced.data + (q * inner_size + i) * elempack, sumptr, elempack);
+            }
+
+            float sum = sumptr[0];
+            for (int l = 1; l < elempack; l++)
+            {
+                sum = op2.func(sum, sumptr[l]);
+            }
+            out[i] = sum;
+        }
+    }
+
+    if (post_process || fabsf(coeff - 1.f) > FLT_EPSILON)
+    {
+        reduction_post_process<MathOp>(out, out.w * out.elempack, coeff);
+    }
+
+    if (outdims == 1)
+        b = out.reshape(outshape[0], opt.blob_allocator);
+    if (outdims == 2)
+        b = out.reshape(outshape[0], outshape[1], opt.blob_allocator);
+    if (outdims == 3)
+        b = out.reshape(outshape[0], outshape[1], outshape[2], opt.blob_allocator);
+    if (outdims == 4)
+        b = out.reshape(outshape[0], outshape[1], outshape[2], outshape[3], opt.blob_allocator);
+    if (b.empty())
+        return -100;
+
+    return 0;
+}
+
+namespace Reduction_x86_functor {
+
+struct post_process_identity
+{
+    NCNN_FORCEINLINE float func(const float& x) const
+    {
+        return x;
+    }
+#if __SSE2__
+    NCNN_FORCEINLINE __m128 func_pack4(const __m128& x) const
+    {
+        return x;
+    }
+#if __AVX__
+    NCNN_FORCEINLINE __m256 func_pack8(const __m256& x) const
+    {
+        return x;
+    }
+#if __AVX512F__
+    NCNN_FORCEINLINE __m512 func_pack16(const __m512& x) const
+    {
+        return x;
+    }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+struct post_process_sqrt
+{
+    // flush subnormal input to zero as the reference does
+    NCNN_FORCEINLINE float func(const float& x) const
+    {
+        return (float)sqrtf(x < FLT_MIN ? 0.f : x);
+    }
+#if __SSE2__
+    NCNN_FORCEINLINE __m128 func_pack4(const __m128& x) const
+    {
+        return _mm_sqrt_ps(_mm_and_ps(_mm_cmpge_ps(x, _mm_set1_ps(FLT_MIN)), x));
+    }
+#if __AVX__
+    NCNN_FORCEINLINE __m256 func_pack8(const __m256& x) const
+    {
+        return _mm256_sqrt_ps(_mm256_and_ps(_mm256_cmp_ps(x, _mm256_set1_ps(FLT_MIN), _CMP_GE_OQ), x));
+    }
+#if __AVX512F__
+    NCNN_FORCEINLINE __m512 func_pack16(const __m512& x) const
+    {
+        __mmask16 _mask = _mm512_cmp_ps_mask(x, _mm512_set1_ps(FLT_MIN), _CMP_GE_OQ);
+        return _mm512_sqrt_ps(_mm512_maskz_mov_ps(_mask, x));
+    }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+struct post_process_log
+{
+    NCNN_FORCEINLINE float func(const float& x) const
+    {
+        return (float)logf(x);
+    }
+#if __SSE2__
+    NCNN_FORCEINLINE __m128 func_pack4(const __m128& x) const
+    {
+        return log_ps(x);
+    }
+#if __AVX__
+    NCNN_FORCEINLINE __m256 func_pack8(const __m256& x) const
+    {
+        return log256_ps(x);
+    }
+#if __AVX512F__
+    NCNN_FORCEINLINE __m512 func_pack16(const __m512& x) const
+    {
+        return log512_ps(x);
+    }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+struct reduction_op_add
+{
+    NCNN_FORCEINLINE float func(const float& x, const float& y) const
+    {
+        return x + y;
+    }
+#if __SSE2__
+    NCNN_FORCEINLINE __m128 func_pack4(const __m128& x, const __m128& y) const
+    {
+        return _mm_add_ps(x, y);
+    }
+#if __AVX__
+    NCNN_FORCEINLINE __m256 func_pack8(const __m256& x, const __m256& y) const
+    {
+        return _mm256_add_ps(x, y);
+    }
+#if __AVX512F__
+    NCNN_FORCEINLINE __m512 func_pack16(const __m512& x, const __m512& y) const
+    {
+        return _mm512_add_ps(x, y);
+    }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+struct reduction_op_mul
+{
+    NCNN_FORCEINLINE float func(const float& x, const float& y) const
+    {
+        return x * y;
+    }
+#if __SSE2__
+    NCNN_FORCEINLINE __m128 func_pack4(const __m128& x, const __m128& y) const
+    {
+        return _mm_mul_ps(x, y);
+    }
+#if __AVX__
+    NCNN_FORCEINLINE __m256 func_pack8(const __m256& x, const __m256& y) const
+    {
+        return _mm256_mul_ps(x, y);
+    }
+#if __AVX512F__
+    NCNN_FORCEINLINE __m512 func_pack16(const __m512& x, const __m512& y) const
+    {
+        return _mm512_mul_ps(x, y);
+    }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+struct reduction_op_asum
+{
+    NCNN_FORCEINLINE float func(const float& x, const float& y) const
+    {
+        return x + (float)fabsf(y);
+    }
+#if __SSE2__
+    NCNN_FORCEINLINE __m128 func_pack4(const __m128& x, const __m128& y) const
+    {
+        return _mm_add_ps(x, abs_ps(y));
+    }
+#if __AVX__
+    NCNN_FORCEINLINE __m256 func_pack8(const __m256& x, const __m256& y) const
+    {
+        return _mm256_add_ps(x, abs256_ps(y));
+    }
+#if __AVX512F__
+    NCNN_FORCEINLINE __m512 func_pack16(const __m512& x, const __m512& y) const
+    {
+        return _mm512_add_ps(x, abs512_ps(y));
+    }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+struct reduction_op_sumsq
+{
+    NCNN_FORCEINLINE float func(const float& x, const float& y) const
+    {
+        return x + y * y;
+    }
+#if __SSE2__
+    NCNN_FORCEINLINE __m128 func_pack4(const __m128& x, const __m128& y) const
+    {
+        return _mm_comp_fmadd_ps(y, y, x);
+    }
+#if __AVX__
+    NCNN_FORCEINLINE __m256 func_pack8(const __m256& x, const __m256& y) const
+    {
+        return _mm256_comp_fmadd_ps(y, y, x);
+    }
+#if __AVX512F__
+    NCNN_FORCEINLINE __m512 func_pack16(const __m512& x, const __m512& y) const
+    {
+        return _mm512_fmadd_ps(y, y, x);
+    }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+struct reduction_op_sumsexp
+{
+    NCNN_FORCEINLINE float func(const float& x, const float& y) const
+    {
+        return x + (float)expf(y);
+    }
+#if __SSE2__
+    NCNN_FORCEINLINE __m128 func_pack4(const __m128& x, const __m128& y) const
+    {
+        return _mm_add_ps(x, exp_ps(y));
+    }
+#if __AVX__
+    NCNN_FORCEINLINE __m256 func_pack8(const __m256& x, const __m256& y) const
+    {
+        return _mm256_add_ps(x, exp256_ps(y));
+    }
+#if __AVX512F__
+    NCNN_FORCEINLINE __m512 func_pack16(const __m512& x, const __m512& y) const
+    {
+        return _mm512_add_ps(x, exp512_ps(y));
+    }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+struct reduction_op_max
+{
+    NCNN_FORCEINLINE float func(const float& x, const float& y) const
+    {
+        return std::max(x, y);
+    }
+#if __SSE2__
+    NCNN_FORCEINLINE __m128 func_pack4(const __m128& x, const __m128& y) const
+    {
+        return _mm_max_ps(x, y);
+    }
+#if __AVX__
+    NCNN_FORCEINLINE __m256 func_pack8(const __m256& x, const __m256& y) const
+    {
+        return _mm256_max_ps(x, y);
+    }
+#if __AVX512F__
+    NCNN_FORCEINLINE __m512 func_pack16(const __m512& x, const __m512& y) const
+    {
+        return _mm512_max_ps(x, y);
+    }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+struct reduction_op_min
+{
+    NCNN_FORCEINLINE float func(const float& x, const float& y) const
+    {
+        return std::min(x, y);
+    }
+#if __SSE2__
+    NCNN_FORCEINLINE __m128 func_pack4(const __m128& x, const __m128& y) const
+    {
+        return _mm_min_ps(x, y);
+    }
+#if __AVX__
+    NCNN_FORCEINLINE __m256 func_pack8(const __m256& x, const __m256& y) const
+    {
+        return _mm256_min_ps(x, y);
+    }
+#if __AVX512F__
+    NCNN_FORCEINLINE __m512 func_pack16(const __m512& x, const __m512& y) const
+    {
+        return _mm512_min_ps(x, y);
+    }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+} // namespace Reduction_x86_functor
+
+int Reduction_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    using namespace Reduction_x86_functor;
+
+    const int elempack = bottom_blob.elempack;
+
+    if (elempack == 1)
+        return Reduction::forward(bottom_blob, top_blob, opt);
+
+    int dims = bottom_blob.dims;
+    int axes_flag[4] = {0};
+    bool reduce_w = false;
+    bool reduce_h = false;
+    bool reduce_d = false;
+    bool reduce_c = false;
+
+    if (reduce_all)
+    {
+        reduce_w = true;
+        reduce_h = true;
+        reduce_d = true;
+        reduce_c = true;
+    }
+    else
+    {
+        const int* axes_ptr = axes;
+        int reduced_axes_num = axes.w;
+
+        for (int i = 0; i < reduced_axes_num; i++)
+        {
+            int axis = axes_ptr[i];
+            // handle negative axis
+            if (axis < 0)
+                axis += dims;
+            axes_flag[axis] = 1;
+        }
+
+        if (dims == 1)
+        {
+            reduce_w = true;
+        }
+        else if (dims == 2)
+        {
+            if (axes_flag[0] == 1) reduce_h = true;
+            if (axes_flag[1] == 1) reduce_w = true;
+        }
+        else if (dims == 3)
+        {
+            if (axes_flag[0] == 1) reduce_c = true;
+            if (axes_flag[1] == 1) reduce_h = true;
+            if (axes_flag[2] == 1) reduce_w = true;
+        }
+        else if (dims == 4)
+        {
+            if (axes_flag[0] == 1) reduce_c = true;
+            if (axes_flag[1] == 1) reduce_d = true;
+            if (axes_flag[2] == 1) reduce_h = true;
+            if (axes_flag[3] == 1) reduce_w = true;
+        }
+    }
+
+    if (dims == 3)
+        reduce_d = false;
+
+    if (!reduce_w && !reduce_h && !reduce_d && !reduce_c)
+    {
+        // nothing to reduce, keep the reference behavior
+        Mat bottom_blob_unpacked;
+        Option opt_pack1 = opt;
+        opt_pack1.blob_allocator = opt.workspace_allocator;
+
+        convert_packing(bottom_blob, bottom_blob_unpacked, 1, opt_pack1);
+        if (bottom_blob_unpacked.empty())
+            return -100;
+
+        return Reduction::forward(bottom_blob_unpacked, top_blob, opt);
+    }
+
+    if (operation == ReductionOp_SUM)
+        return reduction_pack<reduction_op_add, reduction_op_add, post_process_identity>(bottom_blob, top_blob, 0.f, reduce_w, reduce_h, reduce_d, reduce_c, false, coeff, keepdims, opt);
+
+    if (operation == ReductionOp_ASUM)
+        return reduction_pack<reduction_op_asum, reduction_op_add, post_process_identity>(bottom_blob, top_blob, 0.f, reduce_w, reduce_h, reduce_d, reduce_c, false, coeff, keepdims, opt);
+
+    if (operation == ReductionOp_SUMSQ)
+        return reduction_pack<reduction_op_sumsq, reduction_op_add, post_process_identity>(bottom_blob, top_blob, 0.f, reduce_w, reduce_h, reduce_d, reduce_c, false, coeff, keepdims, opt);
+
+    if (operation == ReductionOp_MEAN)
+    {
+        // scale over the unpacked sizes
+        int scale = 1;
+        if (dims == 1)
+        {
+            scale = bottom_blob.w * elempack;
+        }
+        else if (dims == 2)
+        {
+            if (reduce_w) scale *= bottom_blob.w;
+            if (reduce_h) scale *= bottom_blob.h * elempack;
+        }
+        else
+        {
+            if (reduce_w) scale *= bottom_blob.w;
+            if (reduce_h) scale *= bottom_blob.h;
+            if (reduce_d) scale *= bottom_blob.d;
+            if (reduce_c) scale *= bottom_blob.c * elempack;
+        }
+
+        float coeff_mean = coeff / scale;
+        return reduction_pack<reduction_op_add, reduction_op_add, post_process_identity>(bottom_blob, top_blob, 0.f, reduce_w, reduce_h, reduce_d, reduce_c, true, coeff_mean, keepdims, opt);
+    }
+
+    if (operation == ReductionOp_MAX)
+        return reduction_pack<reduction_op_max, reduction_op_max, post_process_identity>(bottom_blob, top_blob, -FLT_MAX, reduce_w, reduce_h, reduce_d, reduce_c, false, coeff, keepdims, opt);
+
+    if (operation == ReductionOp_MIN)
+        return reduction_pack<reduction_op_min, reduction_op_min, post_process_identity>(bottom_blob, top_blob, FLT_MAX, reduce_w, reduce_h, reduce_d, reduce_c, false, coeff, keepdims, opt);
+
+    if (operation == ReductionOp_PROD)
+        return reduction_pack<reduction_op_mul, reduction_op_mul, post_process_identity>(bottom_blob, top_blob, 1.f, reduce_w, reduce_h, reduce_d, reduce_c, false, coeff, keepdims, opt);
+
+    if (operation == ReductionOp_L1)
+        return reduction_pack<reduction_op_asum, reduction_op_add, post_process_identity>(bottom_blob, top_blob, 0.f, reduce_w, reduce_h, reduce_d, reduce_c, false, 1.f, keepdims, opt);
+
+    if (operation == ReductionOp_L2)
+        return reduction_pack<reduction_op_sumsq, reduction_op_add, post_process_sqrt>(bottom_blob, top_blob, 0.f, reduce_w, reduce_h, reduce_d, reduce_c, true, 1.f, keepdims, opt);
+
+    if (operation == ReductionOp_LogSum)
+        return reduction_pack<reduction_op_add, reduction_op_add, post_process_log>(bottom_blob, top_blob, 0.f, reduce_w, reduce_h, reduce_d, reduce_c, true, 1.f, keepdims, opt);
+
+    if (operation == ReductionOp_LogSumExp)
+        return reduction_pack<reduction_op_sumsexp, reduction_op_add, post_process_log>(bottom_blob, top_blob, 0.f, reduce_w, reduce_h, reduce_d, reduce_c, true, 1.f, keepdims, opt);
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -0,0 +1,130 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "rmsnorm_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
+#endif // __SSE2__
+#include "x86_usability.h"
+
+#include "cpu.h"
+
+namespace ncnn {
+
+#include "norm_welford.h"
+
+RMSNorm_x86::RMSNorm_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+#if NCNN_BF16
+    support_bf16_storage = true;
+#endif
+#if NCNN_F16C && __F16C__
+    support_fp16_storage = cpu_support_x86_f16c();
+#endif
+}
+
+int RMSNorm_x86::create_pipeline(const Option& opt)
+{
+#if NCNN_F16C && __F16C__
+    // x86 fp16 storage is opt-in
+    support_fp16_storage = cpu_support_x86_f16c() && opt.use_x86_fp16_storage;
+#endif
+
+    return RMSNorm::create_pipeline(opt);
+}
+
+// x = x / sqrt(rms + eps) * gamma over size positions of elempack lanes
+static void rmsnorm(void* ptr, int size, int elempack, int storage, float eps, const float* gamma)
+{
+    float sqsum[16];
+    norm_sqsum(ptr, size, elempack, storage, sqsum);
+
+    float a[16];
+    float b[16];
+    for (int l = 0; l < elempack; l++)
+    {
+        a[l] = 1.f / sqrtf(sqsum[l] / size + eps);
+        b[l] = 0.f;
+    }
+
+    norm_apply(ptr, ptr, size, elempack, storage, a, b, gamma);
+}
+
+int RMSNorm_x86::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+{
+    const int storage = norm_storage_type(bottom_top_blob, opt);
+
+    const int dims = bottom_top_blob.dims;
+    const int elempack = bottom_top_blob.elempack;
+    const float* gamma = affine ? (const float*)gamma_data : 0;
+
+    if (dims == 1)
+    {
+        // packed 1d is the plain sequence
+        rmsnorm(bottom_top_blob.data, bottom_top_blob.w * elempack, 1, storage, eps, gamma);
+    }
+
+    if (dims == 2)
+    {
+        int w = bottom_top_blob.w;
+        int h = bottom_top_blob.h;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i = 0; i < h; i++)
+        {
+            rmsnorm(bottom_top_blob.row<unsigned char>(i), w, elempack, storage, eps, gamma);
+        }
+    }
+
+    if (dims == 3)
+    {
+        int w = bottom_top_blob.w;
+        int h = bottom_top_blob.h;
+        int channels = bottom_top_blob.c;
+        int size = w * h;
+
+        if (affine_size == w)
+        {
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q = 0; q < channels; q++)
+            {
+                Mat m = bottom_top_blob.channel(q);
+
+                for (int i = 0; i < h; i++)
+                {
+                    rmsnorm(m.row<unsigned char>(i), w, elempack, storage, eps, gamma);
+                }
+            }
+        }
+        else // if (affine_size == size)
+        {
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q = 0; q < channels; q++)
+            {
+                rmsnorm(bottom_top_blob.channel(q).data, size, elempack, storage, eps, gamma);
+            }
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -0,0 +1,420 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__
+void rnn_transform_weight_int8_avx2(const Mat& weight_xc, const Mat& weight_xc_int8_scales, const Mat& weight_hc, const Mat& weight_hc_int8_scales, Mat& weight_data_tm, Mat& weight_data_tm_int8_descales, int size, int num_output, int num_directions, const Option& opt);
+void rnn_int8_avx2(const Mat& bottom_blob_int8, const Mat& bottom_blob_int8_descales, Mat& top_blob, int reverse, const Mat& weight_data_tm, const Mat& weight_data_tm_int8_descales, const Mat& bias_c, Mat& hidden_state, const Option& opt);
+#endif
+
+static void rnn_transform_weight_int8(const Mat& weight_xc, const Mat& weight_xc_int8_scales, const Mat& weight_hc, const Mat& weight_hc_int8_scales, Mat& weight_data_tm, Mat& weight_data_tm_int8_descales, int size, int num_output, int num_directions, const Option& opt)
+{
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__
+    if (ncnn::cpu_support_x86_avx2())
+    {
+        rnn_transform_weight_int8_avx2(weight_xc, weight_xc_int8_scales, weight_hc, weight_hc_int8_scales, weight_data_tm, weight_data_tm_int8_descales, size, num_output, num_directions, opt);
+        return;
+    }
+#endif
+
+#if __SSE2__
+    weight_data_tm.create((size + num_output) * 4, num_output / 4 + num_output % 4, num_directions, 1u, 1);
+    weight_data_tm_int8_descales.create(4 + 4, num_output / 4 + num_output % 4, num_directions);
+#else
+    weight_data_tm.create(size + num_output, num_output, num_directions, 1u, 1);
+    weight_data_tm_int8_descales.create(1 + 1, num_output, num_directions);
+#endif
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int dr = 0; dr < num_directions; dr++)
+    {
+        const Mat weight_xc_dr = weight_xc.channel(dr);
+        const Mat weight_hc_dr = weight_hc.channel(dr);
+        const float* weight_xc_int8_scales_ptr = weight_xc_int8_scales.row(dr);
+        const float* weight_hc_int8_scales_ptr = weight_hc_int8_scales.row(dr);
+
+        Mat weight_data_tm_dr = weight_data_tm.channel(dr);
+        Mat weight_data_tm_int8_descales_dr = weight_data_tm_int8_descales.channel(dr);
+
+        int q = 0;
+#if __SSE2__
+        for (; q + 3 < num_output; q += 4)
+        {
+            const signed char* weight_xc_0 = weight_xc_dr.row<const signed char>(q);
+            const signed char* weight_xc_1 = weight_xc_dr.row<const signed char>(q + 1);
+            const signed char* weight_xc_2 = weight_xc_dr.row<const signed char>(q + 2);
+            const signed char* weight_xc_3 = weight_xc_dr.row<const signed char>(q + 3);
+
+            const signed char* weight_hc_0 = weight_hc_dr.row<const signed char>(q);
+            const signed char* weight_hc_1 = weight_hc_dr.row<const signed char>(q + 1);
+            const signed char* weight_hc_2 = weight_hc_dr.row<const signed char>(q + 2);
+            const signed char* weight_hc_3 = weight_hc_dr.row<const signed char>(q + 3);
+
+            signed char* kptr = weight_data_tm_dr.row<signed char>(q / 4);
+            float* descales_ptr = weight_data_tm_int8_descales_dr.row(q / 4);
+
+            int i = 0;
+            for (; i + 1 < size; i += 2)
+            {
+                kptr[0] = weight_xc_0[i];
+                kptr[1] = weight_xc_0[i + 1];
+                kptr[2] = weight_xc_1[i];
+                kptr[3] = weight_xc_1[i + 1];
+                kptr[4] = weight_xc_2[i];
+                kptr[5] = weight_xc_2[i + 1];
+                kptr[6] = weight_xc_3[i];
+                kptr[7] = weight_xc_3[i + 1];
+
+                kptr += 8;
+            }
+            for (; i < size; i++)
+            {
+                kptr[0] = weight_xc_0[i];
+                kptr[1] = weight_xc_1[i];
+                kptr[2] = weight_xc_2[i];
+                kptr[3] = weight_xc_3[i];
+
+                kptr += 4;
+            }
+
+            i = 0;
+            for (; i + 1 < num_output; i += 2)
+            {
+                kptr[0] = weight_hc_0[i];
+                kptr[1] = weight_hc_0[i + 1];
+                kptr[2] = weight_hc_1[i];
+                kptr[3] = weight_hc_1[i + 1];
+                kptr[4] = weight_hc_2[i];
+                kptr[5] = weight_hc_2[i + 1];
+                kptr[6] = weight_hc_3[i];
+                kptr[7] = weight_hc_3[i + 1];
+
+                kptr += 8;
+            }
+            for (; i < num_output; i++)
+            {
+                kptr[0] = weight_hc_0[i];
+                kptr[1] = weight_hc_1[i];
+                kptr[2] = weight_hc_2[i];
+                kptr[3] = weight_hc_3[i];
+
+                kptr += 4;
+            }
+
+            for (int k = 0; k < 4; k++)
+            {
+                descales_ptr[k] = 1.f / weight_xc_int8_scales_ptr[q + k];
+                descales_ptr[4 + k] = 1.f / weight_hc_int8_scales_ptr[q + k];
+            }
+        }
+#endif // __SSE2__
+        for (; q < num_output; q++)
+        {
+            const signed char* weight_xc_0 = weight_xc_dr.row<const signed char>(q);
+            const signed char* weight_hc_0 = weight_hc_dr.row<const signed char>(q);
+
+#if __SSE2__
+            signed char* kptr = weight_data_tm_dr.row<signed char>(q / 4 + q % 4);
+            float* descales_ptr = weight_data_tm_int8_descales_dr.row(q / 4 + q % 4);
+#else
+            signed char* kptr = weight_data_tm_dr.row<signed char>(q);
+            float* descales_ptr = weight_data_tm_int8_descales_dr.row(q);
+#endif // __SSE2__
+
+            for (int i = 0; i < size; i++)
+            {
+                kptr[i] = weight_xc_0[i];
+            }
+
+            kptr += size;
+
+            for (int i = 0; i < num_output; i++)
+            {
+                kptr[i] = weight_hc_0[i];
+            }
+
+            descales_ptr[0] = 1.f / weight_xc_int8_scales_ptr[q];
+            descales_ptr[1] = 1.f / weight_hc_int8_scales_ptr[q];
+        }
+    }
+}
+
+static float rnn_dynamic_quantize_get_absmax(const float* ptr, int size)
+{
+    float absmax = 0.f;
+
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    __m512 _absmax_avx512 = _mm512_set1_ps(0.f);
+    for (; i + 15 < size; i += 16)
+    {
+        __m512 _p = _mm512_loadu_ps(ptr);
+        _absmax_avx512 = _mm512_max_ps(_absmax_avx512, abs512_ps(_p));
+        ptr += 16;
+    }
+    absmax = std::max(absmax, _mm512_comp_reduce_max_ps(_absmax_avx512));
+#endif // __AVX512F__
+    __m256 _absmax_avx = _mm256_set1_ps(0.f);
+    for (; i + 7 < size; i += 8)
+    {
+        __m256 _p = _mm256_loadu_ps(ptr);
+        _absmax_avx = _mm256_max_ps(_absmax_avx, abs256_ps(_p));
+        ptr += 8;
+    }
+    absmax = std::max(absmax, _mm256_reduce_max_ps(_absmax_avx));
+#endif // __AVX__
+    __m128 _absmax = _mm_set1_ps(0.f);
+    for (; i + 3 < size; i += 4)
+    {
+        __m128 _p = _mm_loadu_ps(ptr);
+        _absmax = _mm_max_ps(_absmax, abs_ps(_p));
+        ptr += 4;
+    }
+    absmax = std::max(absmax, _mm_reduce_max_ps(_absmax));
+#endif // __SSE2__
+    for (; i < size; i++)
+    {
+        absmax = std::max(absmax, (float)fabs(*ptr));
+        ptr++;
+    }
+
+    return absmax;
+}
+
+static void rnn_dynamic_quantize_scale2int8(const float* ptr, int size, float scale, signed char* outptr)
+{
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    __m512 _scale_avx512 = _mm512_set1_ps(scale);
+    for (; i + 15 < size; i += 16)
+    {
+        __m512 _p = _mm512_loadu_ps(ptr);
+        _p = _mm512_mul_ps(_p, _scale_avx512);
+        _mm_storeu_si128((__m128i*)outptr, float2int8_avx512(_p));
+        ptr += 16;
+        outptr += 16;
+    }
+#endif // __AVX512F__
+    __m256 _scale_avx = _mm256_set1_ps(scale);
+    for (; i + 7 < size; i += 8)
+    {
+        __m256 _p = _mm256_loadu_ps(ptr);
+        _p = _mm256_mul_ps(_p, _scale_avx);
+        *(int64_t*)outptr = float2int8_avx(_p);
+        ptr += 8;
+        outptr += 8;
+    }
+#endif // __AVX__
+    __m128 _scale = _mm_set1_ps(scale);
+    for (; i + 3 < size; i += 4)
+    {
+        __m128 _p = _mm_loadu_ps(ptr);
+        _p = _mm_mul_ps(_p, _scale);
+        *(int32_t*)outptr = float2int8_sse(_p);
+        ptr += 4;
+        outptr += 4;
+    }
+#endif // __SSE2__
+    for (; i < size; i++)
+    {
+        *outptr++ = float2int8(*ptr++ * scale);
+    }
+}
+
+#if __SSE2__
+// H0 H1 H2 H3 dot x
+static NCNN_FORCEINLINE __m128i rnn_int8_dot4(const signed char*& kptr, const signed char* x, int size)
+{
+    __m128i _H = _mm_setzero_si128();
+
+    int i = 0;
+#if __AVX2__
+    __m256i _H01 = _mm256_setzero_si256();
+    __m256i _sum1 = _mm256_setzero_si256();
+    for (; i + 7 < size; i += 8)
+    {
+        __m256i _w0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)kptr));
+        __m256i _w1 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(kptr + 16)));
+        __m128i _xi0 = _mm_set1_epi16(((const short*)(x + i))[0]);
+        __m128i _xi1 = _mm_set1_epi16(((const short*)(x + i + 2))[0]);
+        __m128i _xi2 = _mm_set1_epi16(((const short*)(x + i + 4))[0]);
+        __m128i _xi3 = _mm_set1_epi16(((const short*)(x + i + 6))[0]);
+        __m256i _xi01 = _mm256_cvtepi8_epi16(_mm_unpacklo_epi64(_xi0, _xi1));
+        __m256i _xi23 = _mm256_cvtepi8_epi16(_mm_unpacklo_epi64(_xi2, _xi3));
+        _H01 = _mm256_add_epi32(_H01, _mm256_madd_epi16(_w0, _xi01));
+        _sum1 = _mm256_add_epi32(_sum1, _mm256_madd_epi16(_w1, _xi23));
+
+        kptr += 32;
+    }
+    for (; i + 3 < size; i += 4)
+    {
+        __m256i _w = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)kptr));
+        __m128i _xi0 = _mm_set1_epi16(((const short*)(x + i))[0]);
+        __m128i _xi1 = _mm_set1_epi16(((const short*)(x + i + 2))[0]);
+        __m256i _xi = _mm256_cvtepi8_epi16(_mm_unpacklo_epi64(_xi0, _xi1));
+        _H01 = _mm256_add_epi32(_H01, _mm256_madd_epi16(_w, _xi));
+
+        kptr += 16;
+    }
+    _H01 = _mm256_add_epi32(_H01, _sum1);
+    _H = _mm_add_epi32(_mm256_castsi256_si128(_H01), _mm256_extracti128_si256(_H01, 1));
+#endif // __AVX2__
+    for (; i + 1 < size; i += 2)
+    {
+        __m128i _w = _mm_loadl_epi64((const __m128i*)kptr);
+        __m128i _xi = _mm_set1_epi16(((const short*)(x + i))[0]);
+
+        _w = _mm_unpacklo_epi8(_w, _mm_cmpgt_epi8(_mm_setzero_si128(), _w));
+        _xi = _mm_unpacklo_epi8(_xi, _mm_cmpgt_epi8(_mm_setzero_si128(), _xi));
+
+        _H = _mm_add_epi32(_H, _mm_madd_epi16(_w, _xi));
+
+        kptr += 8;
+    }
+    for (; i < size; i++)
+    {
+        __m128i _w = _mm_cvtsi32_si128(((const int*)kptr)[0]);
+        __m128i _xi = _mm_set1_epi16(x[i]);
+
+        _w = _mm_unpacklo_epi8(_w, _mm_cmpgt_epi8(_mm_setzero_si128(), _w));
+
+        __m128i _sl = _mm_mullo_epi16(_w, _xi);
+        __m128i _sh = _mm_mulhi_epi16(_w, _xi);
+        _H = _mm_add_epi32(_H, _mm_unpacklo_epi16(_sl, _sh));
+
+        kptr += 4;
+    }
+
+    return _H;
+}
+#endif // __SSE2__
+
+static void rnn_int8(const Mat& bottom_blob_int8, const Mat& bottom_blob_int8_descales, Mat& top_blob, int reverse, const Mat& weight_data_tm, const Mat& weight_data_tm_int8_descales, const Mat& bias_c, Mat& hidden_state, const Option& opt)
+{
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__
+    if (ncnn::cpu_support_x86_avx2())
+    {
+        rnn_int8_avx2(bottom_blob_int8, bottom_blob_int8_descales, top_blob, reverse, weight_data_tm, weight_data_tm_int8_descales, bias_c, hidden_state, opt);
+        return;
+    }
+#endif
+
+    int size = bottom_blob_int8.w;
+    int T = bottom_blob_int8.h;
+
+    int num_output = top_blob.w;
+
+    // num_output
+    Mat gates(num_output, 4u, opt.workspace_allocator);
+
+    Mat hidden_state_int8(num_output, (size_t)1u, 1, opt.workspace_allocator);
+    float hidden_state_int8_descale = 1.f;
+
+    // unroll
+    for (int t = 0; t < T; t++)
+    {
+        int ti = reverse ? T - 1 - t : t;
+
+        // dynamic quantize hidden_state
+        {
+            const float* ptr = hidden_state;
+
+            const float absmax = rnn_dynamic_quantize_get_absmax(ptr, num_output);
+
+            if (absmax == 0.f)
+            {
+                hidden_state_int8.fill<signed char>(0);
+            }
+            else
+            {
+                hidden_state_int8_descale = absmax / 127.f;
+
+                const float scale = 127.f / absmax;
+                rnn_dynamic_quantize_scale2int8(ptr, num_output, scale, hidden_state_int8);
+            }
+        }
+
+        const signed char* x = bottom_blob_int8.row<const signed char>(ti);
+        const signed char* hs = hidden_state_int8;
+        const float descale_x = bottom_blob_int8_descales[ti];
+        const float descale_h = hidden_state_int8_descale;
+
+        int remain_num_output_start = 0;
+#if __SSE2__
+        int nn_num_output = num_output >> 2;
+        remain_num_output_start = nn_num_output << 2;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int qq = 0; qq < nn_num_output; qq++)
+        {
+            int q = qq * 4;
+
+            const signed char* kptr = weight_data_tm.row<const signed char>(q / 4);
+            const float* descales_ptr = weight_data_tm_int8_descales.row(q / 4);
+
+            __m128i _Hx = rnn_int8_dot4(kptr, x, size);
+            __m128i _Hh = rnn_int8_dot4(kptr, hs, num_output);
+
+            __m128 _H = _mm_loadu_ps((const float*)bias_c + q);
+            _H = _mm_comp_fmadd_ps(_mm_cvtepi32_ps(_Hx), _mm_mul_ps(_mm_set1_ps(descale_x), _mm_loadu_ps(descales_ptr)), _H);
+            _H = _mm_comp_fmadd_ps(_mm_cvtepi32_ps(_Hh), _mm_mul_ps(_mm_set1_ps(descale_h), _mm_loadu_ps(descales_ptr + 4)), _H);
+
+            _H = tanh_sse(_H);
+
+            _mm_storeu_ps((float*)gates + q, _H);
+        }
+#endif // __SSE2__
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = remain_num_output_start; q < num_output; q++)
+        {
+#if __SSE2__
+            const signed char* kptr = weight_data_tm.row<const signed char>(q / 4 + q % 4);
+            const float* descales_ptr = weight_data_tm_int8_descales.row(q / 4 + q % 4);
+#else
+            const signed char* kptr = weight_data_tm.row<const signed char>(q);
+            const float* descales_ptr = weight_data_tm_int8_descales.row(q);
+#endif
+
+            int Hx = 0;
+            for (int i = 0; i < size; i++)
+            {
+                Hx += kptr[i] * x[i];
+            }
+
+            kptr += size;
+
+            int Hh = 0;
+            for (int i = 0; i < num_output; i++)
+            {
+                Hh += kptr[i] * hs[i];
+            }
+
+            float H = bias_c[q] + Hx * (descale_x * descales_ptr[0]) + Hh * (descale_h * descales_ptr[1]);
+
+            H = tanhf(H);
+
+            gates[q] = H;
+        }
+
+        float* output_data = top_blob.row(ti);
+
+        float* hidden_ptr = hidden_state;
+
+        memcpy(hidden_ptr, gates, num_output * sizeof(float));
+        memcpy(output_data, gates, num_output * sizeof(float));
+    }
+}
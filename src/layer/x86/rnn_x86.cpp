@@ -0,0 +1,884 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "rnn_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#include "sse_mathfun.h"
+#if __AVX__
+#include <immintrin.h>
+#include "avx_mathfun.h"
+#if __AVX512F__
+#include "avx512_mathfun.h"
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+
+#include "x86_activation.h"
+#include "x86_usability.h"
+
+#include "cpu.h"
+
+namespace ncnn {
+
+#if NCNN_INT8
+#include "rnn_int8.h"
+#endif
+
+RNN_x86::RNN_x86()
+{
+    one_blob_only = false;
+    support_inplace = false;
+}
+
+int RNN_x86::create_pipeline(const Option& opt)
+{
+#if NCNN_INT8
+    if (int8_scale_term)
+    {
+        return create_pipeline_int8(opt);
+    }
+#endif
+
+    // pack hidden units
+    int num_directions = direction == 2 ? 2 : 1;
+    int size = weight_data_size / num_directions / num_output;
+
+#if __AVX512F__
+    weight_xc_data_packed.create(size * 16, num_output / 16 + (num_output % 16) / 8 + (num_output % 8) / 4 + num_output % 4, num_directions);
+    weight_hc_data_packed.create(num_output * 16, num_output / 16 + (num_output % 16) / 8 + (num_output % 8) / 4 + num_output % 4, num_directions);
+#elif __AVX__
+    weight_xc_data_packed.create(size * 8, num_output / 8 + (num_output % 8) / 4 + num_output % 4, num_directions);
+    weight_hc_data_packed.create(num_output * 8, num_output / 8 + (num_output % 8) / 4 + num_output % 4, num_directions);
+#elif __SSE2__
+    weight_xc_data_packed.create(size * 4, num_output / 4 + num_output % 4, num_directions);
+    weight_hc_data_packed.create(num_output * 4, num_output / 4 + num_output % 4, num_directions);
+#else
+    weight_xc_data_packed.create(size, num_output, num_directions);
+    weight_hc_data_packed.create(num_output, num_output, num_directions);
+#endif
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int dr = 0; dr < num_directions; dr++)
+    {
+        const Mat weight_xc = weight_xc_data.channel(dr);
+        const Mat weight_hc = weight_hc_data.channel(dr);
+
+        Mat weight_xc_data_packed_dr = weight_xc_data_packed.channel(dr);
+        Mat weight_hc_data_packed_dr = weight_hc_data_packed.channel(dr);
+
+        int q = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+        for (; q + 15 < num_output; q += 16)
+        {
+            float* weight_xc_ptr = weight_xc_data_packed_dr.row(q / 16);
+            float* weight_hc_ptr = weight_hc_data_packed_dr.row(q / 16);
+
+            for (int i = 0; i < size; i++)
+            {
+                for (int k = 0; k < 16; k++)
+                {
+                    weight_xc_ptr[k] = weight_xc.row(q + k)[i];
+                }
+
+                weight_xc_ptr += 16;
+            }
+
+            for (int i = 0; i < num_output; i++)
+            {
+                for (int k = 0; k < 16; k++)
+                {
+                    weight_hc_ptr[k] = weight_hc.row(q + k)[i];
+                }
+
+                weight_hc_ptr += 16;
+            }
+        }
+#endif // __AVX512F__
+        for (; q + 7 < num_output; q += 8)
+        {
+#if __AVX512F__
+            float* weight_xc_ptr = weight_xc_data_packed_dr.row(q / 16 + (q % 16) / 8);
+            float* weight_hc_ptr = weight_hc_data_packed_dr.row(q / 16 + (q % 16) / 8);
+#else
+            float* weight_xc_ptr = weight_xc_data_packed_dr.row(q / 8);
+            float* weight_hc_ptr = weight_hc_data_packed_dr.row(q / 8);
+#endif
+
+            for (int i = 0; i < size; i++)
+            {
+                for (int k = 0; k < 8; k++)
+                {
+                    weight_xc_ptr[k] = weight_xc.row(q + k)[i];
+                }
+
+                weight_xc_ptr += 8;
+            }
+
+            for (int i = 0; i < num_output; i++)
+            {
+                for (int k = 0; k < 8; k++)
+                {
+                    weight_hc_ptr[k] = weight_hc.row(q + k)[i];
+                }
+
+                weight_hc_ptr += 8;
+            }
+        }
+#endif // __AVX__
+        for (; q + 3 < num_output; q += 4)
+        {
+#if __AVX512F__
+            float* weight_xc_ptr = weight_xc_data_packed_dr.row(q / 16 + (q % 16) / 8 + (q % 8) / 4);
+            float* weight_hc_ptr = weight_hc_data_packed_dr.row(q / 16 + (q % 16) / 8 + (q % 8) / 4);
+#elif __AVX__
+            float* weight_xc_ptr = weight_xc_data_packed_dr.row(q / 8 + (q % 8) / 4);
+            float* weight_hc_ptr = weight_hc_data_packed_dr.row(q / 8 + (q % 8) / 4);
+#else
+            float* weight_xc_ptr = weight_xc_data_packed_dr.row(q / 4);
+            float* weight_hc_ptr = weight_hc_data_packed_dr.row(q / 4);
+#endif
+
+            for (int i = 0; i < size; i++)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    weight_xc_ptr[k] = weight_xc.row(q + k)[i];
+                }
+
+                weight_xc_ptr += 4;
+            }
+
+            for (int i = 0; i < num_output; i++)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    weight_hc_ptr[k] = weight_hc.row(q + k)[i];
+                }
+
+                weight_hc_ptr += 4;
+            }
+        }
+#endif // __SSE2__
+        for (; q < num_output; q++)
+        {
+#if __AVX512F__
+            float* weight_xc_ptr = weight_xc_data_packed_dr.row(q / 16 + (q % 16) / 8 + (q % 8) / 4 + q % 4);
+            float* weight_hc_ptr = weight_hc_data_packed_dr.row(q / 16 + (q % 16) / 8 + (q % 8) / 4 + q % 4);
+#elif __AVX__
+            float* weight_xc_ptr = weight_xc_data_packed_dr.row(q / 8 + (q % 8) / 4 + q % 4);
+            float* weight_hc_ptr = weight_hc_data_packed_dr.row(q / 8 + (q % 8) / 4 + q % 4);
+#elif __SSE2__
+            float* weight_xc_ptr = weight_xc_data_packed_dr.row(q / 4 + q % 4);
+            float* weight_hc_ptr = weight_hc_data_packed_dr.row(q / 4 + q % 4);
+#else
+            float* weight_xc_ptr = weight_xc_data_packed_dr.row(q);
+            float* weight_hc_ptr = weight_hc_data_packed_dr.row(q);
+#endif
+
+            memcpy(weight_xc_ptr, weight_xc.row(q), size * sizeof(float));
+            memcpy(weight_hc_ptr, weight_hc.row(q), num_output * sizeof(float));
+        }
+    }
+
+    // bias is used as is
+    bias_c_data_packed = bias_c_data;
+
+    if (opt.lightmode)
+    {
+        weight_xc_data.release();
+        bias_c_data.release();
+        weight_hc_data.release();
+    }
+
+    return 0;
+}
+
+static int rnn(const Mat& bottom_blob, Mat& top_blob, int reverse, const Mat& weight_xc, const Mat& bias_c, const Mat& weight_hc, Mat& hidden_state, const Option& opt)
+{
+    int size = bottom_blob.w;
+    int T = bottom_blob.h;
+
+    int num_output = top_blob.w;
+
+    // num_output
+    Mat gates(num_output, 4u, opt.workspace_allocator);
+    if (gates.empty())
+        return -100;
+
+    // unroll
+    for (int t = 0; t < T; t++)
+    {
+        int ti = reverse ? T - 1 - t : t;
+
+        const float* x = bottom_blob.row(ti);
+        const float* hidden_ptr = hidden_state;
+
+        int remain_num_output_start = 0;
+#if __SSE2__
+        int nn_num_output = 0;
+#if __AVX__
+#if __AVX512F__
+        nn_num_output = (num_output - remain_num_output_start) >> 4;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int qq = 0; qq < nn_num_output; qq++)
+        {
+            int q = qq * 16;
+
+            const float* weight_xc_ptr = weight_xc.row(q / 16);
+            const float* weight_hc_ptr = weight_hc.row(q / 16);
+
+            __m512 _H = _mm512_loadu_ps((const float*)bias_c + q);
+            __m512 _sum1 = _mm512_setzero_ps();
+            __m512 _sum2 = _mm512_setzero_ps();
+            __m512 _sum3 = _mm512_setzero_ps();
+
+            int i = 0;
+            for (; i + 3 < size; i += 4)
+            {
+                __m512 _xi0 = _mm512_set1_ps(x[i]);
+                __m512 _xi1 = _mm512_set1_ps(x[i + 1]);
+                __m512 _xi2 = _mm512_set1_ps(x[i + 2]);
+                __m512 _xi3 = _mm512_set1_ps(x[i + 3]);
+                __m512 _weight_xc_0 = _mm512_loadu_ps(weight_xc_ptr);
+                __m512 _weight_xc_1 = _mm512_loadu_ps(weight_xc_ptr + 16);
+                __m512 _weight_xc_2 = _mm512_loadu_ps(weight_xc_ptr + 32);
+                __m512 _weight_xc_3 = _mm512_loadu_ps(weight_xc_ptr + 48);
+                _H = _mm512_fmadd_ps(_weight_xc_0, _xi0, _H);
+                _sum1 = _mm512_fmadd_ps(_weight_xc_1, _xi1, _sum1);
+                _sum2 = _mm512_fmadd_ps(_weight_xc_2, _xi2, _sum2);
+                _sum3 = _mm512_fmadd_ps(_weight_xc_3, _xi3, _sum3);
+
+                weight_xc_ptr += 64;
+            }
+            for (; i < size; i++)
+            {
+                __m512 _xi = _mm512_set1_ps(x[i]);
+                __m512 _weight_xc = _mm512_loadu_ps(weight_xc_ptr);
+                _H = _mm512_fmadd_ps(_weight_xc, _xi, _H);
+
+                weight_xc_ptr += 16;
+            }
+
+            i = 0;
+            for (; i + 3 < num_output; i += 4)
+            {
+                __m512 _h_cont0 = _mm512_set1_ps(hidden_ptr[i]);
+                __m512 _h_cont1 = _mm512_set1_ps(hidden_ptr[i + 1]);
+                __m512 _h_cont2 = _mm512_set1_ps(hidden_ptr[i + 2]);
+                __m512 _h_cont3 = _mm512_set1_ps(hidden_ptr[i + 3]);
+                __m512 _weight_hc_0 = _mm512_loadu_ps(weight_hc_ptr);
+                __m512 _weight_hc_1 = _mm512_loadu_ps(weight_hc_ptr + 16);
+                __m512 _weight_hc_2 = _mm512_loadu_ps(weight_hc_ptr + 32);
+                __m512 _weight_hc_3 = _mm512_loadu_ps(weight_hc_ptr + 48);
+                _H = _mm512_fmadd_ps(_weight_hc_0, _h_cont0, _H);
+                _sum1 = _mm512_fmadd_ps(_weight_hc_1, _h_cont1, _sum1);
+                _sum2 = _mm512_fmadd_ps(_weight_hc_2, _h_cont2, _sum2);
+                _sum3 = _mm512_fmadd_ps(_weight_hc_3, _h_cont3, _sum3);
+
+                weight_hc_ptr += 64;
+            }
+            for (; i < num_output; i++)
+            {
+                __m512 _h_cont = _mm512_set1_ps(hidden_ptr[i]);
+                __m512 _weight_hc = _mm512_loadu_ps(weight_hc_ptr);
+                _H = _mm512_fmadd_ps(_weight_hc, _h_cont, _H);
+
+                weight_hc_ptr += 16;
+            }
+
+            _H = _mm512_add_ps(_H, _sum1);
+            _sum2 = _mm512_add_ps(_sum2, _sum3);
+            _H = _mm512_add_ps(_H, _sum2);
+
+            _H = tanh_avx512(_H);
+
+            _mm512_storeu_ps((float*)gates + q, _H);
+        }
+
+        remain_num_output_start += nn_num_output << 4;
+#endif // __AVX512F__
+        nn_num_output = (num_output - remain_num_output_start) >> 3;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int qq = 0; qq < nn_num_output; qq++)
+        {
+            int q = remain_num_output_start + qq * 8;
+
+#if __AVX512F__
+            const float* weight_xc_ptr = weight_xc.row(q / 16 + (q % 16) / 8);
+            const float* weight_hc_ptr = weight_hc.row(q / 16 + (q % 16) / 8);
+#else
+            const float* weight_xc_ptr = weight_xc.row(q / 8);
+            const float* weight_hc_ptr = weight_hc.row(q / 8);
+#endif
+
+            __m256 _H = _mm256_loadu_ps((const float*)bias_c + q);
+            __m256 _sum1 = _mm256_setzero_ps();
+            __m256 _sum2 = _mm256_setzero_ps();
+            __m256 _sum3 = _mm256_setzero_ps();
+
+            int i = 0;
+            for (; i + 3 < size; i += 4)
+            {
+                __m256 _xi0 = _mm256_set1_ps(x[i]);
+                __m256 _xi1 = _mm256_set1_ps(x[i + 1]);
+                __m256 _xi2 = _mm256_set1_ps(x[i + 2]);
+                __m256 _xi3 = _mm256_set1_ps(x[i + 3]);
+                __m256 _weight_xc_0 = _mm256_loadu_ps(weight_xc_ptr);
+                __m256 _weight_xc_1 = _mm256_loadu_ps(weight_xc_ptr + 8);
+                __m256 _weight_xc_2 = _mm256_loadu_ps(weight_xc_ptr + 16);
+                __m256 _weight_xc_3 = _mm256_loadu_ps(weight_xc_ptr + 24);
+                _H = _mm256_comp_fmadd_ps(_weight_xc_0, _xi0, _H);
+                _sum1 = _mm256_comp_fmadd_ps(_weight_xc_1, _xi1, _sum1);
+                _sum2 = _mm256_comp_fmadd_ps(_weight_xc_2, _xi2, _sum2);
+                _sum3 = _mm256_comp_fmadd_ps(_weight_xc_3, _xi3, _sum3);
+
+                weight_xc_ptr += 32;
+            }
+            for (; i < size; i++)
+            {
+                __m256 _xi = _mm256_set1_ps(x[i]);
+                __m256 _weight_xc = _mm256_loadu_ps(weight_xc_ptr);
+                _H = _mm256_comp_fmadd_ps(_weight_xc, _xi, _H);
+
+                weight_xc_ptr += 8;
+            }
+
+            i = 0;
+            for (; i + 3 < num_output; i += 4)
+            {
+                __m256 _h_cont0 = _mm256_set1_ps(hidden_ptr[i]);
+                __m256 _h_cont1 = _mm256_set1_ps(hidden_ptr[i + 1]);
+                __m256 _h_cont2 = _mm256_set1_ps(hidden_ptr[i + 2]);
+                __m256 _h_cont3 = _mm256_set1_ps(hidden_ptr[i + 3]);
+                __m256 _weight_hc_0 = _mm256_loadu_ps(weight_hc_ptr);
+                __m256 _weight_hc_1 = _mm256_loadu_ps(weight_hc_ptr + 8);
+                __m256 _weight_hc_2 = _mm256_loadu_ps(weight_hc_ptr + 16);
+                __m256 _weight_hc_3 = _mm256_loadu_ps(weight_hc_ptr + 24);
+                _H = _mm256_comp_fmadd_ps(_weight_hc_0, _h_cont0, _H);
+                _sum1 = _mm256_comp_fmadd_ps(_weight_hc_1, _h_cont1, _sum1);
+                _sum2 = _mm256_comp_fmadd_ps(_weight_hc_2, _h_cont2, _sum2);
+                _sum3 = _mm256_comp_fmadd_ps(_weight_hc_3, _h_cont3, _sum3);
+
+                weight_hc_ptr += 32;
+            }
+            for (; i < num_output; i++)
+            {
+                __m256 _h_cont = _mm256_set1_ps(hidden_ptr[i]);
+                __m256 _weight_hc = _mm256_loadu_ps(weight_hc_ptr);
+                _H = _mm256_comp_fmadd_ps(_weight_hc, _h_cont, _H);
+
+                weight_hc_ptr += 8;
+            }
+
+            _H = _mm256_add_ps(_H, _sum1);
+            _sum2 = _mm256_add_ps(_sum2, _sum3);
+            _H = _mm256_add_ps(_H, _sum2);
+
+            _H = tanh_avx(_H);
+
+            _mm256_storeu_ps((float*)gates + q, _H);
+        }
+
+        remain_num_output_start += nn_num_output << 3;
+#endif // __AVX__
+        nn_num_output = (num_output - remain_num_output_start) >> 2;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int qq = 0; qq < nn_num_output; qq++)
+        {
+            int q = remain_num_output_start + qq * 4;
+
+#if __AVX512F__
+            const float* weight_xc_ptr = weight_xc.row(q / 16 + (q % 16) / 8 + (q % 8) / 4);
+            const float* weight_hc_ptr = weight_hc.row(q / 16 + (q % 16) / 8 + (q % 8) / 4);
+#elif __AVX__
+            const float* weight_xc_ptr = weight_xc.row(q / 8 + (q % 8) / 4);
+            const float* weight_hc_ptr = weight_hc.row(q / 8 + (q % 8) / 4);
+#else
+            const float* weight_xc_ptr = weight_xc.row(q / 4);
+            const float* weight_hc_ptr = weight_hc.row(q / 4);
+#endif
+
+            __m128 _H = _mm_loadu_ps((const float*)bias_c + q);
+            __m128 _sum1 = _mm_setzero_ps();
+            __m128 _sum2 = _mm_setzero_ps();
+            __m128 _sum3 = _mm_setzero_ps();
+
+            int i = 0;
+            for (; i + 3 < size; i += 4)
+            {
+                __m128 _xi0 = _mm_set1_ps(x[i]);
+                __m128 _xi1 = _mm_set1_ps(x[i + 1]);
+                __m128 _xi2 = _mm_set1_ps(x[i + 2]);
+                __m128 _xi3 = _mm_set1_ps(x[i + 3]);
+                __m128 _weight_xc_0 = _mm_loadu_ps(weight_xc_ptr);
+                __m128 _weight_xc_1 = _mm_loadu_ps(weight_xc_ptr + 4);
+                __m128 _weight_xc_2 = _mm_loadu_ps(weight_xc_ptr + 8);
+                __m128 _weight_xc_3 = _mm_loadu_ps(weight_xc_ptr + 12);
+                _H = _mm_comp_fmadd_ps(_weight_xc_0, _xi0, _H);
+                _sum1 = _mm_comp_fmadd_ps(_weight_xc_1, _xi1, _sum1);
+                _sum2 = _mm_comp_fmadd_ps(_weight_xc_2, _xi2, _sum2);
+                _sum3 = _mm_comp_fmadd_ps(_weight_xc_3, _xi3, _sum3);
+
+                weight_xc_ptr += 16;
+            }
+            for (; i < size; i++)
+            {
+                __m128 _xi = _mm_set1_ps(x[i]);
+                __m128 _weight_xc = _mm_loadu_ps(weight_xc_ptr);
+                _H = _mm_comp_fmadd_ps(_weight_xc, _xi, _H);
+
+                weight_xc_ptr += 4;
+            }
+
+            i = 0;
+            for (; i + 3 < num_output; i += 4)
+            {
+                __m128 _h_cont0 = _mm_set1_ps(hidden_ptr[i]);
+                __m128 _h_cont1 = _mm_set1_ps(hidden_ptr[i + 1]);
+                __m128 _h_cont2 = _mm_set1_ps(hidden_ptr[i + 2]);
+                __m128 _h_cont3 = _mm_set1_ps(hidden_ptr[i + 3]);
+                __m128 _weight_hc_0 = _mm_loadu_ps(weight_hc_ptr);
+                __m128 _weight_hc_1 = _mm_loadu_ps(weight_hc_ptr + 4);
+                __m128 _weight_hc_2 = _mm_loadu_ps(weight_hc_ptr + 8);
+                __m128 _weight_hc_3 = _mm_loadu_ps(weight_hc_ptr + 12);
+                _H = _mm_comp_fmadd_ps(_weight_hc_0, _h_cont0, _H);
+                _sum1 = _mm_comp_fmadd_ps(_weight_hc_1, _h_cont1, _sum1);
+                _sum2 = _mm_comp_fmadd_ps(_weight_hc_2, _h_cont2, _sum2);
+                _sum3 = _mm_comp_fmadd_ps(_weight_hc_3, _h_cont3, _sum3);
+
+                weight_hc_ptr += 16;
+            }
+            for (; i < num_output; i++)
+            {
+                __m128 _h_cont = _mm_set1_ps(hidden_ptr[i]);
+                __m128 _weight_hc = _mm_loadu_ps(weight_hc_ptr);
+                _H = _mm_comp_fmadd_ps(_weight_hc, _h_cont, _H);
+
+                weight_hc_ptr += 4;
+            }
+
+            _H = _mm_add_ps(_H, _sum1);
+            _sum2 = _mm_add_ps(_sum2, _sum3);
+            _H = _mm_add_ps(_H, _sum2);
+
+            _H = tanh_sse(_H);
+
+            _mm_storeu_ps((float*)gates + q, _H);
+        }
+
+        remain_num_output_start += nn_num_output << 2;
+#endif // __SSE2__
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = remain_num_output_start; q < num_output; q++)
+        {
+#if __AVX512F__
+            const float* weight_xc_ptr = weight_xc.row(q / 16 + (q % 16) / 8 + (q % 8) / 4 + q % 4);
+            const float* weight_hc_ptr = weight_hc.row(q / 16 + (q % 16) / 8 + (q % 8) / 4 + q % 4);
+#elif __AVX__
+            const float* weight_xc_ptr = weight_xc.row(q / 8 + (q % 8) / 4 + q % 4);
+            const float* weight_hc_ptr = weight_hc.row(q / 8 + (q % 8) / 4 + q % 4);
+#elif __SSE2__
+            const float* weight_xc_ptr = weight_xc.row(q / 4 + q % 4);
+            const float* weight_hc_ptr = weight_hc.row(q / 4 + q % 4);
+#else
+            const float* weight_xc_ptr = weight_xc.row(q);
+            const float* weight_hc_ptr = weight_hc.row(q);
+#endif
+
+            float H = bias_c[q];
+
+            for (int i = 0; i < size; i++)
+            {
+                H += weight_xc_ptr[i] * x[i];
+            }
+
+            for (int i = 0; i < num_output; i++)
+            {
+                H += weight_hc_ptr[i] * hidden_ptr[i];
+            }
+
+            H = tanhf(H);
+
+            gates[q] = H;
+        }
+
+        float* output_data = top_blob.row(ti);
+
+        memcpy(hidden_state, gates, num_output * sizeof(float));
+        memcpy(output_data, gates, num_output * sizeof(float));
+    }
+
+    return 0;
+}
+
+int RNN_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+#if NCNN_INT8
+    if (int8_scale_term)
+    {
+        return forward_int8(bottom_blob, top_blob, opt);
+    }
+#endif
+
+    int T = bottom_blob.h;
+
+    int num_directions = direction == 2 ? 2 : 1;
+
+    // initial hidden state
+    Mat hidden(num_output, 4u, opt.workspace_allocator);
+    if (hidden.empty())
+        return -100;
+    hidden.fill(0.f);
+
+    top_blob.create(num_output * num_directions, T, 4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    // Uni directional
+    if (direction == 0 || direction == 1)
+    {
+        int ret = rnn(bottom_blob, top_blob, direction, weight_xc_data_packed.channel(0), bias_c_data_packed.channel(0), weight_hc_data_packed.channel(0), hidden, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    if (direction == 2)
+    {
+        Mat top_blob_forward(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_forward.empty())
+            return -100;
+
+        Mat top_blob_reverse(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_reverse.empty())
+            return -100;
+
+        {
+            int ret = rnn(bottom_blob, top_blob_forward, 0, weight_xc_data_packed.channel(0), bias_c_data_packed.channel(0), weight_hc_data_packed.channel(0), hidden, opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        hidden.fill(0.0f);
+
+        {
+            int ret = rnn(bottom_blob, top_blob_reverse, 1, weight_xc_data_packed.channel(1), bias_c_data_packed.channel(1), weight_hc_data_packed.channel(1), hidden, opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        // concat w
+        for (int i = 0; i < T; i++)
+        {
+            const float* pf = top_blob_forward.row(i);
+            const float* pr = top_blob_reverse.row(i);
+            float* ptr = top_blob.row(i);
+
+            memcpy(ptr, pf, num_output * sizeof(float));
+            memcpy(ptr + num_output, pr, num_output * sizeof(float));
+        }
+    }
+
+    return 0;
+}
+
+int RNN_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+#if NCNN_INT8
+    if (int8_scale_term)
+    {
+        return forward_int8(bottom_blobs, top_blobs, opt);
+    }
+#endif
+
+    const Mat& bottom_blob = bottom_blobs[0];
+    int T = bottom_blob.h;
+    int num_directions = direction == 2 ? 2 : 1;
+
+    Mat hidden;
+    Allocator* hidden_allocator = top_blobs.size() == 2 ? opt.blob_allocator : opt.workspace_allocator;
+    if (bottom_blobs.size() == 2)
+    {
+        hidden = bottom_blobs[1].clone(hidden_allocator);
+    }
+    else
+    {
+        hidden.create(num_output, num_directions, 4u, hidden_allocator);
+        if (hidden.empty())
+            return -100;
+        hidden.fill(0.f);
+    }
+
+    Mat& top_blob = top_blobs[0];
+    top_blob.create(num_output * num_directions, T, 4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    // Uni directional
+    if (direction == 0 || direction == 1)
+    {
+        int ret = rnn(bottom_blob, top_blob, direction, weight_xc_data_packed.channel(0), bias_c_data_packed.channel(0), weight_hc_data_packed.channel(0), hidden, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    if (direction == 2)
+    {
+        Mat top_blob_forward(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_forward.empty())
+            return -100;
+
+        Mat top_blob_reverse(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_reverse.empty())
+            return -100;
+
+        Mat hidden0 = hidden.row_range(0, 1);
+        {
+            int ret = rnn(bottom_blob, top_blob_forward, 0, weight_xc_data_packed.channel(0), bias_c_data_packed.channel(0), weight_hc_data_packed.channel(0), hidden0, opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        Mat hidden1 = hidden.row_range(1, 1);
+        {
+            int ret = rnn(bottom_blob, top_blob_reverse, 1, weight_xc_data_packed.channel(1), bias_c_data_packed.channel(1), weight_hc_data_packed.channel(1), hidden1, opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        // concat w
+        for (int i = 0; i < T; i++)
+        {
+            const float* pf = top_blob_forward.row(i);
+            const float* pr = top_blob_reverse.row(i);
+            float* ptr = top_blob.row(i);
+
+            memcpy(ptr, pf, num_output * sizeof(float));
+            memcpy(ptr + num_output, pr, num_output * sizeof(float));
+        }
+    }
+
+    if (top_blobs.size() == 2)
+    {
+        top_blobs[1] = hidden;
+    }
+
+    return 0;
+}
+
+#if NCNN_INT8
+int RNN_x86::create_pipeline_int8(const Option& opt)
+{
+    const int num_directions = direction == 2 ? 2 : 1;
+    const int size = weight_data_size / num_directions / num_output;
+
+    rnn_transform_weight_int8(weight_xc_data, weight_xc_data_int8_scales, weight_hc_data, weight_hc_data_int8_scales, weight_data_tm, weight_data_tm_int8_descales, size, num_output, num_directions, opt);
+
+    // bias is used as is
+    bias_c_data_packed = bias_c_data;
+
+    if (opt.lightmode)
+    {
+        weight_xc_data.release();
+        bias_c_data.release();
+        weight_hc_data.release();
+        weight_xc_data_int8_scales.release();
+        weight_hc_data_int8_scales.release();
+    }
+
+    return 0;
+}
+
+static void rnn_dynamic_quantize(const Mat& bottom_blob, Mat& bottom_blob_int8, Mat& bottom_blob_int8_descales, const Option& opt)
+{
+    int size = bottom_blob.w;
+    int T = bottom_blob.h;
+
+    // dynamic quantize bottom_blob
+    bottom_blob_int8_descales.create(T, (size_t)4u, 1, opt.blob_allocator);
+
+    bottom_blob_int8.create(size, T, (size_t)1u, opt.blob_allocator);
+
+    // fp32
+    for (int t = 0; t < T; t++)
+    {
+        const float* ptr = bottom_blob.row(t);
+        signed char* outptr = bottom_blob_int8.row<signed char>(t);
+
+        const float absmax = rnn_dynamic_quantize_get_absmax(ptr, size);
+
+        bottom_blob_int8_descales[t] = absmax / 127.f;
+
+        const float scale = 127.f / absmax;
+        rnn_dynamic_quantize_scale2int8(ptr, size, scale, outptr);
+    }
+}
+
+int RNN_x86::forward_int8(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    int T = bottom_blob.h;
+
+    int num_directions = direction == 2 ? 2 : 1;
+
+    // initial hidden state
+    Mat hidden(num_output, 4u, opt.workspace_allocator);
+    if (hidden.empty())
+        return -100;
+    hidden.fill(0.f);
+
+    top_blob.create(num_output * num_directions, T, 4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    // dynamic quantize bottom_blob
+    Mat bottom_blob_int8;
+    Mat bottom_blob_int8_descales;
+    {
+        Option opt_quant = opt;
+        opt_quant.blob_allocator = opt.workspace_allocator;
+        opt_quant.use_packing_layout = false;
+        rnn_dynamic_quantize(bottom_blob, bottom_blob_int8, bottom_blob_int8_descales, opt_quant);
+    }
+
+    // Uni directional
+    if (direction == 0 || direction == 1)
+    {
+        rnn_int8(bottom_blob_int8, bottom_blob_int8_descales, top_blob, direction, weight_data_tm.channel(0), weight_data_tm_int8_descales.channel(0), bias_c_data_packed.channel(0), hidden, opt);
+    }
+
+    if (direction == 2)
+    {
+        Mat top_blob_forward(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_forward.empty())
+            return -100;
+
+        Mat top_blob_reverse(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_reverse.empty())
+            return -100;
+
+        {
+            rnn_int8(bottom_blob_int8, bottom_blob_int8_descales, top_blob_forward, 0, weight_data_tm.channel(0), weight_data_tm_int8_descales.channel(0), bias_c_data_packed.channel(0), hidden, opt);
+        }
+
+        hidden.fill(0.f);
+
+        {
+            rnn_int8(bottom_blob_int8, bottom_blob_int8_descales, top_blob_reverse, 1, weight_data_tm.channel(1), weight_data_tm_int8_descales.channel(1), bias_c_data_packed.channel(1), hidden, opt);
+        }
+
+        // concat w
+        for (int i = 0; i < T; i++)
+        {
+            const float* pf = top_blob_forward.row(i);
+            const float* pr = top_blob_reverse.row(i);
+            float* ptr = top_blob.row(i);
+
+            memcpy(ptr, pf, num_output * sizeof(float));
+            memcpy(ptr + num_output, pr, num_output * sizeof(float));
+        }
+    }
+
+    return 0;
+}
+
+int RNN_x86::forward_int8(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const Mat& bottom_blob = bottom_blobs[0];
+
+    int T = bottom_blob.h;
+    int num_directions = direction == 2 ? 2 : 1;
+
+    Mat hidden;
+    Allocator* hidden_allocator = top_blobs.size() == 2 ? opt.blob_allocator : opt.workspace_allocator;
+    if (bottom_blobs.size() == 2)
+    {
+        hidden = bottom_blobs[1].clone(hidden_allocator);
+    }
+    else
+    {
+        hidden.create(num_output, num_directions, 4u, hidden_allocator);
+        if (hidden.empty())
+            return -100;
+        hidden.fill(0.f);
+    }
+
+    Mat& top_blob = top_blobs[0];
+    top_blob.create(num_output * num_directions, T, 4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    // dynamic quantize bottom_blob
+    Mat bottom_blob_int8;
+    Mat bottom_blob_int8_descales;
+    {
+        Option opt_quant = opt;
+        opt_quant.blob_allocator = opt.workspace_allocator;
+        opt_quant.use_packing_layout = false;
+        rnn_dynamic_quantize(bottom_blob, bottom_blob_int8, bottom_blob_int8_descales, opt_quant);
+    }
+
+    // Uni directional
+    if (direction == 0 || direction == 1)
+    {
+        rnn_int8(bottom_blob_int8, bottom_blob_int8_descales, top_blob, direction, weight_data_tm.channel(0), weight_data_tm_int8_descales.channel(0), bias_c_data_packed.channel(0), hidden, opt);
+    }
+
+    if (direction == 2)
+    {
+        Mat top_blob_forward(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_forward.empty())
+            return -100;
+
+        Mat top_blob_reverse(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_reverse.empty())
+            return -100;
+
+        Mat hidden0 = hidden.row_range(0, 1);
+        {
+            rnn_int8(bottom_blob_int8, bottom_blob_int8_descales, top_blob_forward, 0, weight_data_tm.channel(0), weight_data_tm_int8_descales.channel(0), bias_c_data_packed.channel(0), hidden0, opt);
+        }
+
+        Mat hidden1 = hidden.row_range(1, 1);
+        {
+            rnn_int8(bottom_blob_int8, bottom_blob_int8_descales, top_blob_reverse, 1, weight_data_tm.channel(1), weight_data_tm_int8_descales.channel(1), bias_c_data_packed.channel(1), hidden1, opt);
+        }
+
+        // concat w
+        for (int i = 0; i < T; i++)
+        {
+            const float* pf = top_blob_forward.row(i);
+            const float* pr = top_blob_reverse.row(i);
+            float* ptr = top_blob.row(i);
+
+            memcpy(ptr, pf, num_output * sizeof(float));
+            memcpy(ptr + num_output, pr, num_output * sizeof(float));
+        }
+    }
+
+    if (top_blobs.size() == 2)
+    {
+        top_blobs[1] = hidden;
+    }
+
+    return 0;
+}
+#endif // NCNN_INT8
+
+} // namespace ncnn
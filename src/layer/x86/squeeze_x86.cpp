@@ -0,0 +1,55 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "squeeze_x86.h"
+
+namespace ncnn {
+
+Squeeze_x86::Squeeze_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+}
+
+int Squeeze_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    const int elempack = bottom_blob.elempack;
+
+    if (elempack == 1)
+        return Squeeze::forward(bottom_blob, top_blob, opt);
+
+    const int dims = bottom_blob.dims;
+    const int outer = dims == 1 ? bottom_blob.w : dims == 2 ? bottom_blob.h : bottom_blob.c;
+
+    // the packed axis holds more than one element and is never squeezed
+    // the inner axes keep their layout, so reshape on packed groups is exact
+    if (outer > 1)
+        return Squeeze::forward(bottom_blob, top_blob, opt);
+
+    // a single packed group would look squeezable, go through the unpacked layout
+    Mat bottom_blob_unpacked;
+    {
+        Option opt_pack1 = opt;
+        opt_pack1.blob_allocator = opt.workspace_allocator;
+
+        convert_packing(bottom_blob, bottom_blob_unpacked, 1, opt_pack1);
+        if (bottom_blob_unpacked.empty())
+            return -100;
+    }
+
+    return Squeeze::forward(bottom_blob_unpacked, top_blob, opt);
+}
+
+} // namespace ncnn
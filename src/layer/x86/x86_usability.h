@@ -1352,6 +1352,17 @@ static NCNN_FORCEINLINE __m512i float2bfloat_avx512(const __m512& v0, const __m5
     return _v;
 }
 
+#if __AMX_TILE__
+// the 64-byte operand of ldtilecfg, palette 1
+struct amx_tilecfg
+{
+    unsigned char palette_id;
+    unsigned char start_row;
+    unsigned char reserved[14];
+    unsigned short colsb[16];
+    unsigned char rows[16];
+};
+#endif // __AMX_TILE__
 #endif // __AVX512F__
 #endif // __AVX2__
 #endif // __AVX__
@@ -14,9 +14,24 @@
 
 #include "net.h"
 
+#include "benchmark.h"
 #include "cpu.h"
 #include "datareader.h"
 #include "layer_type.h"
+#include "layer/binaryop.h"
+#include "layer/clip.h"
+#include "layer/convolution.h"
+#include "layer/elu.h"
+#include "layer/fusedelementwise.h"
+#include "layer/gelu.h"
+#include "layer/gemm.h"
+#include "layer/gru.h"
+#include "layer/hardsigmoid.h"
+#include "layer/hardswish.h"
+#include "layer/lstm.h"
+#include "layer/relu.h"
+#include "layer/rnn.h"
+#include "layer/unaryop.h"
 #include "modelbin.h"
 #include "paramdict.h"
 
@@ -24,10 +39,6 @@
 #include <stdint.h>
 #include <string.h>
 
-#if NCNN_BENCHMARK
-#include "benchmark.h"
-#endif // NCNN_BENCHMARK
-
 #if NCNN_VULKAN
 #include "command.h"
 #include "pipelinecache.h"
@@ -35,6 +46,99 @@
 
 namespace ncnn {
 
+class LayerProfileSink;
+
+static unsigned int hash_data(unsigned int h, const void* data, size_t size)
+{
+    // fnv-1a over 32bit words
+    const unsigned char* p = (const unsigned char*)data;
+
+    size_t i = 0;
+    for (; i + 3 < size; i += 4)
+    {
+        unsigned int v;
+        memcpy(&v, p + i, 4);
+        h = (h ^ v) * 16777619u;
+        h ^= h >> 15;
+    }
+    for (; i < size; i++)
+    {
+        h = (h ^ p[i]) * 16777619u;
+    }
+
+    return h;
+}
+
+static unsigned int hash_param_dict(const ParamDict& pd)
+{
+    unsigned int h = 2166136261u;
+    for (int i = 0; i < NCNN_MAX_PARAM_COUNT; i++)
+    {
+        const int type = pd.type(i);
+        if (type == 0)
+            continue;
+
+        h = hash_data(h, &i, sizeof(int));
+        h = hash_data(h, &type, sizeof(int));
+
+        if (type <= 3)
+        {
+            // int and float share the storage
+            const int v = pd.get(i, 0);
+            h = hash_data(h, &v, sizeof(int));
+        }
+        else
+        {
+            const Mat v = pd.get(i, Mat());
+            h = hash_data(h, v.data, v.total() * v.elemsize);
+        }
+    }
+
+    return h;
+}
+
+// hash the model data passing through
+// pass through untouched when disabled, so that mapped weights are not paged in
+class DataReaderHashing : public DataReader
+{
+public:
+    DataReaderHashing(const DataReader& _dr, bool _enabled)
+        : dr(_dr), enabled(_enabled)
+    {
+        hash = 2166136261u;
+    }
+
+    virtual size_t read(void* buf, size_t size) const
+    {
+        size_t nread = dr.read(buf, size);
+        if (enabled)
+            hash = hash_data(hash, buf, nread);
+        return nread;
+    }
+
+    virtual size_t reference(size_t size, const void** buf) const
+    {
+        size_t nref = dr.reference(size, buf);
+        if (enabled && nref)
+            hash = hash_data(hash, *buf, nref);
+        return nref;
+    }
+
+    // hash of the data since last call
+    unsigned int take_hash() const
+    {
+        unsigned int h = hash;
+        hash = 2166136261u;
+        return h;
+    }
+
+    const DataReader& dr;
+    bool enabled;
+    mutable unsigned int hash;
+};
+
+class ForwardWorkerPool;
+
 class NetPrivate
 {
 public:
@@ -48,9 +152,22 @@ public:
 
 #endif // NCNN_VULKAN
 
+    // reuse the cached pipeline data if any, otherwise transform weights
+    int create_layer_pipeline(int layer_index) const;
+
+    // read weights in layer order and create pipelines on worker threads
+    int load_model_parallel(const ModelBin& mb, const DataReaderHashing& dr);
+
     friend class Extractor;
+    friend class Session;
     int forward_layer(int layer_index, std::vector<Mat>& blob_mats, const Option& opt) const;
 
+    // run independent branches concurrently
+    int forward_layer_parallel(int layer_index, std::vector<Mat>& blob_mats, const Option& opt) const;
+
+    // run layer by layer over all samples, one blob_mats for each sample
+    int forward_layer_batch(int layer_index, std::vector<std::vector<Mat> >& batch_blob_mats, const Option& opt) const;
+
 #if NCNN_VULKAN
     int forward_layer(int layer_index, std::vector<Mat>& blob_mats, std::vector<VkMat>& blob_mats_gpu, VkCompute& cmd, const Option& opt) const;
     int forward_layer(int layer_index, std::vector<Mat>& blob_mats, std::vector<VkMat>& blob_mats_gpu, std::vector<VkImageMat>& blob_mats_gpu_image, VkCompute& cmd, const Option& opt) const;
@@ -59,16 +176,21 @@ public:
     int convert_layout(Mat& bottom_blob, const Layer* layer, const Option& opt) const;
 
     int do_forward_layer(const Layer* layer, std::vector<Mat>& blob_mats, const Option& opt) const;
+    int do_forward_layer_profile(int layer_index, std::vector<Mat>& blob_mats, const Option& opt, LayerProfileSink* profile_sink) const;
+    int do_forward_layer_batch(const Layer* layer, std::vector<std::vector<Mat> >& batch_blob_mats, const Option& opt) const;
 #if NCNN_VULKAN
     int do_forward_layer(const Layer* layer, std::vector<VkMat>& blob_mats_gpu, VkCompute& cmd, const Option& opt) const;
     int do_forward_layer(const Layer* layer, std::vector<VkImageMat>& blob_mats_gpu_image, VkCompute& cmd, const Option& opt) const;
 #endif // NCNN_VULKAN
 
     void update_input_output_indexes();
+    void update_state_blob_indexes();
 #if NCNN_STRING
     void update_input_output_names();
 #endif // NCNN_STRING
 
+    void fuse_elementwise_layers();
+
     std::vector<Blob> blobs;
     std::vector<Layer*> layers;
 
@@ -85,6 +207,42 @@ public:
     PoolAllocator* local_blob_allocator;
     PoolAllocator* local_workspace_allocator;
 
+    PlannedAllocator* acquire_planned_allocator() const;
+    void reclaim_planned_allocator(PlannedAllocator* allocator) const;
+
+    mutable Mutex planned_allocator_lock;
+    mutable std::vector<PlannedAllocator*> planned_allocators;
+    mutable size_t planned_arena_size;
+
+    // threads for forward_layer_parallel, created on first use
+    mutable Mutex forward_worker_pool_lock;
+    mutable ForwardWorkerPool* forward_worker_pool;
+
+#if NCNN_STDIO
+    // mappings referenced by layer weights
+    std::vector<DataReaderFromMmap*> model_mmaps;
+#endif // NCNN_STDIO
+
+    // content hash of the params and weights of each layer
+    // weights are hashed only for a loaded or to be saved pipeline data cache
+    std::vector<unsigned int> layer_param_hashes;
+    std::vector<unsigned int> layer_weight_hashes;
+    bool pipeline_data_cache_saving;
+
+    // multiheadattention layers with kv_cache enabled in param
+    std::vector<char> layer_kv_cache;
+
+    // kv cache and streaming history bottoms fed by graph inputs
+    // they start empty unless set by the user
+    std::vector<int> state_blob_indexes;
+
+    // transformed weight data for each layer, consumed by load_model
+    std::vector<std::vector<Mat> > pipeline_data_cache;
+    std::vector<unsigned int> pipeline_data_cache_weight_hashes;
+
+    // kernel choice for each layer, consumed by load_model
+    std::vector<std::vector<int> > kernel_profile;
+
 #if NCNN_VULKAN
     const VulkanDevice* vkdev;
 
@@ -101,6 +259,12 @@ NetPrivate::NetPrivate(Option& _opt)
     local_blob_allocator = 0;
     local_workspace_allocator = 0;
 
+    planned_arena_size = 0;
+
+    forward_worker_pool = 0;
+
+    pipeline_data_cache_saving = false;
+
 #if NCNN_VULKAN
     vkdev = 0;
     weight_vkallocator = 0;
@@ -109,6 +273,146 @@ NetPrivate::NetPrivate(Option& _opt)
 #endif // NCNN_VULKAN
 }
 
+PlannedAllocator* NetPrivate::acquire_planned_allocator() const
+{
+    MutexLockGuard lock(planned_allocator_lock);
+
+    for (int i = 0; i < (int)planned_allocators.size(); i++)
+    {
+        PlannedAllocator* allocator = planned_allocators[i];
+        if (allocator)
+        {
+            planned_allocators[i] = 0;
+            return allocator;
+        }
+    }
+
+    // pre-allocated allocator exhausted, create new
+    PlannedAllocator* allocator = new PlannedAllocator;
+    planned_allocators.push_back(0);
+    return allocator;
+}
+
+void NetPrivate::reclaim_planned_allocator(PlannedAllocator* allocator) const
+{
+    MutexLockGuard lock(planned_allocator_lock);
+
+    planned_arena_size = std::max(planned_arena_size, allocator->arena_size());
+
+    for (int i = 0; i < (int)planned_allocators.size(); i++)
+    {
+        if (!planned_allocators[i])
+        {
+            planned_allocators[i] = allocator;
+            return;
+        }
+    }
+
+    NCNN_LOGE("FATAL ERROR! reclaim_planned_allocator get wild allocator %p", allocator);
+}
+
+// workspace bytes of the layer forward running on this thread
+static ThreadLocalStorage tls_layer_allocated_bytes;
+
+// counts the workspace bytes requested by layer forwards
+// owned by the extractor, so workspace mats never outlive it
+class LayerProfileAllocator : public Allocator
+{
+public:
+    LayerProfileAllocator(Allocator* _allocator)
+        : allocator(_allocator)
+    {
+    }
+
+    virtual void* fastMalloc(size_t size)
+    {
+        size_t* allocated_bytes = (size_t*)tls_layer_allocated_bytes.get();
+        if (allocated_bytes)
+            *allocated_bytes += size;
+
+        return allocator ? allocator->fastMalloc(size) : ncnn::fastMalloc(size);
+    }
+
+    virtual void fastFree(void* ptr)
+    {
+        if (allocator)
+            allocator->fastFree(ptr);
+        else
+            ncnn::fastFree(ptr);
+    }
+
+    Allocator* allocator;
+};
+
+// collects layer records of one extract call, shared by branch parallel workers
+class LayerProfileSink
+{
+public:
+    LayerProfileSink(std::vector<LayerProfile>* _profiles, std::vector<LayerProfileAllocator*>* _workspace_allocators)
+        : profiles(_profiles), workspace_allocators(_workspace_allocators)
+    {
+    }
+
+    void append(const LayerProfile& profile)
+    {
+        MutexLockGuard guard(lock);
+        profiles->push_back(profile);
+    }
+
+    // the counting wrapper of allocator, created once per extractor
+    Allocator* get_workspace_allocator(Allocator* allocator)
+    {
+        MutexLockGuard guard(lock);
+        for (size_t i = 0; i < workspace_allocators->size(); i++)
+        {
+            if ((*workspace_allocators)[i]->allocator == allocator)
+                return (*workspace_allocators)[i];
+        }
+
+        LayerProfileAllocator* workspace_allocator = new LayerProfileAllocator(allocator);
+        workspace_allocators->push_back(workspace_allocator);
+        return workspace_allocator;
+    }
+
+    std::vector<LayerProfile>* profiles;
+    std::vector<LayerProfileAllocator*>* workspace_allocators;
+    Mutex lock;
+};
+
+static ThreadLocalStorage tls_layer_profile_sink;
+
+// bind the sink to this thread until leaving scope
+class LayerProfileScope
+{
+public:
+    LayerProfileScope(LayerProfileSink* sink)
+    {
+        prev_sink = tls_layer_profile_sink.get();
+        tls_layer_profile_sink.set(sink);
+    }
+
+    ~LayerProfileScope()
+    {
+        tls_layer_profile_sink.set(prev_sink);
+    }
+
+private:
+    void* prev_sink;
+};
+
+static Mat get_shape(const Mat& m)
+{
+    Mat shape;
+    shape.dims = m.dims;
+    shape.w = m.w;
+    shape.h = m.h;
+    shape.d = m.d;
+    shape.c = m.c;
+    shape.elemsize = m.elemsize;
+    shape.elempack = m.elempack;
+    return shape;
+}
+
 static Option get_masked_option(const Option& opt, int featmask)
 {
     // mask option usage as layer specific featmask
@@ -171,6 +475,228 @@ int NetPrivate::upload_model()
 }
 #endif // NCNN_VULKAN
 
+int NetPrivate::create_layer_pipeline(int layer_index) const
+{
+    Layer* layer = layers[layer_index];
+
+    Option opt1 = get_masked_option(opt, layer->featmask);
+
+    if (layer_index < (int)kernel_profile.size() && !kernel_profile[layer_index].empty())
+    {
+        if (layer->load_kernel_profile(kernel_profile[layer_index]) != 0)
+        {
+#if NCNN_STRING
+            NCNN_LOGE("layer load_kernel_profile %d %s failed, use default kernel choice", layer_index, layer->name.c_str());
+#else
+            NCNN_LOGE("layer load_kernel_profile %d failed, use default kernel choice", layer_index);
+#endif
+        }
+    }
+
+    int ret = -1;
+    if (layer_index < (int)pipeline_data_cache.size() && !pipeline_data_cache[layer_index].empty())
+    {
+        if (pipeline_data_cache_weight_hashes[layer_index] != layer_weight_hashes[layer_index])
+        {
+#if NCNN_STRING
+            NCNN_LOGE("pipeline data cache of layer %d %s does not match the weight, transform again", layer_index, layer->name.c_str());
+#else
+            NCNN_LOGE("pipeline data cache of layer %d does not match the weight, transform again", layer_index);
+#endif
+        }
+        else
+        {
+            // reuse cached weight data
+            ret = layer->load_pipeline_data(pipeline_data_cache[layer_index], opt1);
+        }
+    }
+    if (ret != 0)
+    {
+        ret = layer->create_pipeline(opt1);
+    }
+    if (ret != 0)
+    {
+#if NCNN_STRING
+        NCNN_LOGE("layer create_pipeline %d %s failed", layer_index, layer->name.c_str());
+#else
+        NCNN_LOGE("layer create_pipeline %d failed", layer_index);
+#endif
+        return -1;
+    }
+
+    return 0;
+}
+
+#if NCNN_THREADS
+class ParallelPipelineContext
+{
+public:
+    const NetPrivate* net;
+
+    Mutex lock;
+    ConditionVariable condition;
+
+    // layers with weights loaded, in load order
+    std::vector<int> loaded_layers;
+    size_t next_index;
+
+    bool load_finished;
+    int ret;
+
+    int worker_count;
+};
+
+static void* create_pipeline_parallel_worker(void* args)
+{
+    ParallelPipelineContext* ctx = (ParallelPipelineContext*)args;
+
+    ctx->lock.lock();
+    for (;;)
+    {
+        while (ctx->next_index == ctx->loaded_layers.size() && !ctx->load_finished && ctx->ret == 0)
+        {
+            ctx->condition.wait(ctx->lock);
+        }
+
+        if (ctx->next_index == ctx->loaded_layers.size() || ctx->ret != 0)
+            break;
+
+        int layer_index = ctx->loaded_layers[ctx->next_index];
+        ctx->next_index++;
+
+        ctx->lock.unlock();
+
+        int ret = ctx->net->create_layer_pipeline(layer_index);
+
+        ctx->lock.lock();
+
+        if (ret != 0)
+        {
+            ctx->ret = ret;
+            ctx->condition.broadcast();
+        }
+    }
+    ctx->lock.unlock();
+
+    return 0;
+}
+
+#if defined(_OPENMP) && !NCNN_SIMPLEOMP
+static void* create_pipeline_parallel_pool(void* args)
+{
+    ParallelPipelineContext* ctx = (ParallelPipelineContext*)args;
+
+    // the parallel regions in create_pipeline nest inside the workers and run on one thread
+    // so the weight layout still follows opt.num_threads while the workers are all the threads
+    #pragma omp parallel num_threads(ctx->worker_count)
+    {
+        create_pipeline_parallel_worker(args);
+    }
+
+    return 0;
+}
+#endif // defined(_OPENMP) && !NCNN_SIMPLEOMP
+#endif // NCNN_THREADS
+
+int NetPrivate::load_model_parallel(const ModelBin& mb, const DataReaderHashing& dr)
+{
+    const int layer_count = (int)layers.size();
+
+#if NCNN_THREADS
+    ParallelPipelineContext ctx;
+    ctx.net = this;
+    ctx.loaded_layers.reserve(layer_count);
+    ctx.next_index = 0;
+    ctx.load_finished = false;
+    ctx.ret = 0;
+
+#if defined(_OPENMP) && !NCNN_SIMPLEOMP
+    // openmp workers, the calling thread keeps reading
+    ctx.worker_count = std::max(std::min(opt.num_threads, layer_count), 1);
+    Thread* pool = new Thread(create_pipeline_parallel_pool, (void*)&ctx);
+#else
+    // the calling thread keeps reading and joins the workers at last
+    // layer threads are either serial or drawn from the shared simpleomp pool
+    ctx.worker_count = std::max(std::min(opt.num_threads, layer_count) - 1, 1);
+    std::vector<Thread*> workers(ctx.worker_count);
+    for (int i = 0; i < ctx.worker_count; i++)
+    {
+        workers[i] = new Thread(create_pipeline_parallel_worker, (void*)&ctx);
+    }
+#endif
+#endif // NCNN_THREADS
+
+    int ret = 0;
+    for (int i = 0; i < layer_count; i++)
+    {
+        Layer* layer = layers[i];
+
+        //Here we found inconsistent content in the parameter file.
+        if (!layer)
+        {
+            NCNN_LOGE("load_model error at layer %d, parameter file has inconsistent content.", i);
+            ret = -1;
+            break;
+        }
+
+        int lret = layer->load_model(mb);
+        if (lret != 0)
+        {
+#if NCNN_STRING
+            NCNN_LOGE("layer load_model %d %s failed", i, layer->name.c_str());
+#else
+            NCNN_LOGE("layer load_model %d failed", i);
+#endif
+            ret = -1;
+            break;
+        }
+
+        if (dr.enabled)
+            layer_weight_hashes[i] = dr.take_hash();
+
+#if NCNN_THREADS
+        ctx.lock.lock();
+        ctx.loaded_layers.push_back(i);
+        ctx.condition.signal();
+        bool failed = ctx.ret != 0;
+        ctx.lock.unlock();
+
+        if (failed)
+            break;
+#else
+        ret = create_layer_pipeline(i);
+        if (ret != 0)
+            break;
+#endif // NCNN_THREADS
+    }
+
+#if NCNN_THREADS
+    ctx.lock.lock();
+    ctx.load_finished = true;
+    if (ret != 0)
+        ctx.ret = ret;
+    ctx.condition.broadcast();
+    ctx.lock.unlock();
+
+#if defined(_OPENMP) && !NCNN_SIMPLEOMP
+    pool->join();
+    delete pool;
+#else
+    create_pipeline_parallel_worker((void*)&ctx);
+
+    for (int i = 0; i < ctx.worker_count; i++)
+    {
+        workers[i]->join();
+        delete workers[i];
+    }
+#endif
+
+    ret = ctx.ret;
+#endif // NCNN_THREADS
+
+    return ret;
+}
+
 int NetPrivate::forward_layer(int layer_index, std::vector<Mat>& blob_mats, const Option& opt) const
 {
     const Layer* layer = layers[layer_index];
@@ -190,6 +716,12 @@ int NetPrivate::forward_layer(int layer_index, std::vector<Mat>& blob_mats, cons
         }
     }
 
+    LayerProfileSink* profile_sink = (LayerProfileSink*)tls_layer_profile_sink.get();
+    if (profile_sink)
+    {
+        return do_forward_layer_profile(layer_index, blob_mats, opt, profile_sink);
+    }
+
 #if NCNN_BENCHMARK
     double start = get_current_time();
     Mat bottom_blob;
@@ -236,7 +768,455 @@ int NetPrivate::forward_layer(int layer_index, std::vector<Mat>& blob_mats, cons
     return 0;
 }
 
-#if NCNN_VULKAN
+#if NCNN_THREADS
+class ParallelForwardContext
+{
+public:
+    const NetPrivate* net;
+    std::vector<Mat>* blob_mats;
+    const Option* opt;
+    LayerProfileSink* profile_sink;
+
+    Mutex lock;
+    ConditionVariable condition;
+
+    std::vector<char> needed;
+    // unfinished producers of each layer
+    std::vector<int> pending_counts;
+    std::vector<int> ready_layers;
+
+    int remaining_count;
+    int running_count;
+    int ret;
+
+    // pool workers working on this context, guarded by the pool lock
+    int helper_count;
+};
+
+static void* forward_layer_parallel_worker(void* args)
+{
+    ParallelForwardContext* ctx = (ParallelForwardContext*)args;
+
+    // denormal flags and profiling sink are per thread
+    set_flush_denormals(ctx->opt->flush_denormals);
+    LayerProfileScope profile_scope(ctx->profile_sink);
+
+    const std::vector<Blob>& blobs = ctx->net->blobs;
+    const std::vector<Layer*>& layers = ctx->net->layers;
+
+    ctx->lock.lock();
+    for (;;)
+    {
+        while (ctx->ready_layers.empty() && ctx->running_count > 0 && ctx->remaining_count > 0 && ctx->ret == 0)
+        {
+            ctx->condition.wait(ctx->lock);
+        }
+
+        if (ctx->remaining_count == 0 || ctx->ret != 0)
+            break;
+
+        if (ctx->ready_layers.empty())
+        {
+            NCNN_LOGE("forward_layer_parallel stalled with %d layers left", ctx->remaining_count);
+            ctx->ret = -1;
+            ctx->condition.broadcast();
+            break;
+        }
+
+        // depth first keeps fewer intermediate blobs alive
+        int layer_index = ctx->ready_layers.back();
+        ctx->ready_layers.pop_back();
+        ctx->running_count++;
+
+        // split the thread budget between the layers in flight
+        Option opt = *ctx->opt;
+        const int concurrency = ctx->running_count + (int)ctx->ready_layers.size();
+        opt.num_threads = std::max(opt.num_threads / concurrency, 1);
+
+        ctx->lock.unlock();
+
+        int ret = ctx->net->forward_layer(layer_index, *ctx->blob_mats, opt);
+
+        ctx->lock.lock();
+
+        ctx->running_count--;
+        ctx->remaining_count--;
+
+        if (ret != 0)
+        {
+            ctx->ret = ret;
+        }
+        else
+        {
+            const Layer* layer = layers[layer_index];
+            for (size_t i = 0; i < layer->tops.size(); i++)
+            {
+                int consumer = blobs[layer->tops[i]].consumer;
+                if (consumer == -1 || !ctx->needed[consumer])
+                    continue;
+
+                const Layer* consumer_layer = layers[consumer];
+                for (size_t j = 0; j < consumer_layer->bottoms.size(); j++)
+                {
+                    if (consumer_layer->bottoms[j] != layer->tops[i])
+                        continue;
+
+                    ctx->pending_counts[consumer]--;
+                    if (ctx->pending_counts[consumer] == 0)
+                    {
+                        ctx->ready_layers.push_back(consumer);
+                    }
+                }
+            }
+        }
+
+        ctx->condition.broadcast();
+    }
+    ctx->lock.unlock();
+
+    return 0;
+}
+
+// persistent threads that join the parallel forward of any extractor
+class ForwardWorkerPool
+{
+public:
+    ForwardWorkerPool();
+    ~ForwardWorkerPool();
+
+    // spawn workers until there are count of them
+    void reserve(int count);
+
+    // let up to count idle workers help on ctx
+    void submit(ParallelForwardContext* ctx, int count);
+
+    // drop the jobs of ctx not picked up yet and wait for its helpers
+    void wait(ParallelForwardContext* ctx);
+
+    Mutex lock;
+    ConditionVariable job_condition;
+    ConditionVariable done_condition;
+
+    std::vector<Thread*> workers;
+    std::vector<ParallelForwardContext*> jobs;
+    bool stop;
+};
+
+static void* forward_worker_pool_main(void* args)
+{
+    ForwardWorkerPool* pool = (ForwardWorkerPool*)args;
+
+    pool->lock.lock();
+    for (;;)
+    {
+        while (pool->jobs.empty() && !pool->stop)
+        {
+            pool->job_condition.wait(pool->lock);
+        }
+
+        if (pool->stop)
+            break;
+
+        ParallelForwardContext* ctx = pool->jobs.front();
+        pool->jobs.erase(pool->jobs.begin());
+        ctx->helper_count++;
+
+        pool->lock.unlock();
+
+        forward_layer_parallel_worker((void*)ctx);
+
+        pool->lock.lock();
+
+        ctx->helper_count--;
+        pool->done_condition.broadcast();
+    }
+    pool->lock.unlock();
+
+    return 0;
+}
+
+ForwardWorkerPool::ForwardWorkerPool()
+{
+    stop = false;
+}
+
+ForwardWorkerPool::~ForwardWorkerPool()
+{
+    lock.lock();
+    stop = true;
+    job_condition.broadcast();
+    lock.unlock();
+
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i]->join();
+        delete workers[i];
+    }
+}
+
+void ForwardWorkerPool::reserve(int count)
+{
+    MutexLockGuard guard(lock);
+
+    while ((int)workers.size() < count)
+    {
+        workers.push_back(new Thread(forward_worker_pool_main, (void*)this));
+    }
+}
+
+void ForwardWorkerPool::submit(ParallelForwardContext* ctx, int count)
+{
+    MutexLockGuard guard(lock);
+
+    for (int i = 0; i < count; i++)
+    {
+        jobs.push_back(ctx);
+    }
+
+    job_condition.broadcast();
+}
+
+void ForwardWorkerPool::wait(ParallelForwardContext* ctx)
+{
+    MutexLockGuard guard(lock);
+
+    for (size_t i = 0; i < jobs.size();)
+    {
+        if (jobs[i] == ctx)
+            jobs.erase(jobs.begin() + i);
+        else
+            i++;
+    }
+
+    while (ctx->helper_count > 0)
+    {
+        done_condition.wait(lock);
+    }
+}
+#endif // NCNN_THREADS
+
+int NetPrivate::do_forward_layer_profile(int layer_index, std::vector<Mat>& blob_mats, const Option& opt, LayerProfileSink* profile_sink) const
+{
+    const Layer* layer = layers[layer_index];
+
+    LayerProfile profile;
+    profile.layer_index = layer_index;
+#if NCNN_STRING
+    profile.type = layer->type.c_str();
+    profile.name = layer->name.c_str();
+#endif
+
+    std::vector<const void*> bottom_datas(layer->bottoms.size());
+    profile.bottom_shapes.resize(layer->bottoms.size());
+    for (size_t i = 0; i < layer->bottoms.size(); i++)
+    {
+        const Mat& bottom_blob = blob_mats[layer->bottoms[i]];
+        bottom_datas[i] = bottom_blob.data;
+        profile.bottom_shapes[i] = get_shape(bottom_blob);
+    }
+
+    Option opt1 = layer->featmask ? get_masked_option(opt, layer->featmask) : opt;
+    opt1.workspace_allocator = profile_sink->get_workspace_allocator(opt.workspace_allocator);
+
+    size_t allocated_bytes = 0;
+    tls_layer_allocated_bytes.set(&allocated_bytes);
+    set_current_layer_profile(&profile);
+
+    profile.start = get_current_time();
+    int ret = do_forward_layer(layer, blob_mats, opt1);
+    profile.end = get_current_time();
+
+    set_current_layer_profile(0);
+    tls_layer_allocated_bytes.set(0);
+
+    if (ret != 0)
+        return ret;
+
+    profile.allocated_bytes = allocated_bytes;
+    profile.top_shapes.resize(layer->tops.size());
+    for (size_t i = 0; i < layer->tops.size(); i++)
+    {
+        const Mat& top_blob = blob_mats[layer->tops[i]];
+        profile.top_shapes[i] = get_shape(top_blob);
+
+        // inplace or view of a bottom blob takes no new memory
+        bool reused = false;
+        for (size_t j = 0; j < bottom_datas.size(); j++)
+        {
+            if (top_blob.data == bottom_datas[j])
+                reused = true;
+        }
+        if (!reused)
+            profile.allocated_bytes += top_blob.total() * top_blob.elemsize;
+    }
+
+    profile_sink->append(profile);
+
+    return 0;
+}
+
+int NetPrivate::forward_layer_parallel(int layer_index, std::vector<Mat>& blob_mats, const Option& opt) const
+{
+#if NCNN_THREADS
+    if (opt.num_threads <= 1)
+        return forward_layer(layer_index, blob_mats, opt);
+
+    const int layer_count = (int)layers.size();
+
+    ParallelForwardContext ctx;
+    ctx.net = this;
+    ctx.blob_mats = &blob_mats;
+    ctx.opt = &opt;
+    ctx.profile_sink = (LayerProfileSink*)tls_layer_profile_sink.get();
+    ctx.needed.resize(layer_count, 0);
+    ctx.pending_counts.resize(layer_count, 0);
+    ctx.remaining_count = 0;
+    ctx.running_count = 0;
+    ctx.ret = 0;
+    ctx.helper_count = 0;
+
+    // collect the layers required for this blob
+    std::vector<int> stack(1, layer_index);
+    ctx.needed[layer_index] = 1;
+    while (!stack.empty())
+    {
+        const Layer* layer = layers[stack.back()];
+        stack.pop_back();
+
+        for (size_t i = 0; i < layer->bottoms.size(); i++)
+        {
+            int bottom_blob_index = layer->bottoms[i];
+            if (blob_mats[bottom_blob_index].dims != 0)
+                continue;
+
+            int producer = blobs[bottom_blob_index].producer;
+            if (!ctx.needed[producer])
+            {
+                ctx.needed[producer] = 1;
+                stack.push_back(producer);
+            }
+        }
+    }
+
+    // resolve dependency count and graph width by topological level
+    std::vector<int> levels(layer_count, 0);
+    std::vector<int> level_widths(layer_count + 1, 0);
+    int max_width = 0;
+    for (int i = 0; i < layer_count; i++)
+    {
+        if (!ctx.needed[i])
+            continue;
+
+        const Layer* layer = layers[i];
+
+        int level = 0;
+        for (size_t j = 0; j < layer->bottoms.size(); j++)
+        {
+            int bottom_blob_index = layer->bottoms[j];
+            if (blob_mats[bottom_blob_index].dims != 0)
+                continue;
+
+            ctx.pending_counts[i]++;
+
+            int producer = blobs[bottom_blob_index].producer;
+            if (producer < i)
+                level = std::max(level, levels[producer] + 1);
+        }
+
+        levels[i] = level;
+        level_widths[level]++;
+        max_width = std::max(max_width, level_widths[level]);
+
+        if (ctx.pending_counts[i] == 0)
+            ctx.ready_layers.push_back(i);
+
+        ctx.remaining_count++;
+    }
+
+    const int worker_count = std::min(max_width, opt.num_threads);
+    if (worker_count <= 1)
+    {
+        // plain chain, nothing to overlap
+        return forward_layer(layer_index, blob_mats, opt);
+    }
+
+    ForwardWorkerPool* pool;
+    {
+        MutexLockGuard lock(forward_worker_pool_lock);
+
+        if (!forward_worker_pool)
+            forward_worker_pool = new ForwardWorkerPool;
+
+        pool = forward_worker_pool;
+    }
+
+    // the calling thread works as well
+    pool->reserve(opt.num_threads - 1);
+    pool->submit(&ctx, worker_count - 1);
+
+    forward_layer_parallel_worker((void*)&ctx);
+
+    pool->wait(&ctx);
+
+    return ctx.ret;
+#else
+    return forward_layer(layer_index, blob_mats, opt);
+#endif // NCNN_THREADS
+}
+
+int NetPrivate::forward_layer_batch(int layer_index, std::vector<std::vector<Mat> >& batch_blob_mats, const Option& opt) const
+{
+    const std::vector<Mat>& blob_mats = batch_blob_mats[0];
+
+    // collect the layers not computed yet in topological order
+    std::vector<int> layer_order;
+    std::vector<char> visited(layers.size(), 0);
+    std::vector<std::pair<int, size_t> > stack;
+    stack.push_back(std::make_pair(layer_index, (size_t)0));
+    visited[layer_index] = 1;
+    while (!stack.empty())
+    {
+        const Layer* layer = layers[stack.back().first];
+
+        if (stack.back().second < layer->bottoms.size())
+        {
+            int bottom_blob_index = layer->bottoms[stack.back().second];
+            stack.back().second++;
+
+            int producer = blobs[bottom_blob_index].producer;
+            if (blob_mats[bottom_blob_index].dims == 0 && !visited[producer])
+            {
+                visited[producer] = 1;
+                stack.push_back(std::make_pair(producer, (size_t)0));
+            }
+            continue;
+        }
+
+        layer_order.push_back(stack.back().first);
+        stack.pop_back();
+    }
+
+    for (size_t i = 0; i < layer_order.size(); i++)
+    {
+        const Layer* layer = layers[layer_order[i]];
+
+        int ret = 0;
+        if (layer->featmask)
+        {
+            ret = do_forward_layer_batch(layer, batch_blob_mats, get_masked_option(opt, layer->featmask));
+        }
+        else
+        {
+            ret = do_forward_layer_batch(layer, batch_blob_mats, opt);
+        }
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+#if NCNN_VULKAN
 int NetPrivate::forward_layer(int layer_index, std::vector<Mat>& blob_mats, std::vector<VkMat>& blob_mats_gpu, VkCompute& cmd, const Option& opt) const
 {
     const Layer* layer = layers[layer_index];
@@ -616,6 +1596,10 @@ IMAGE_ALLOCATION_FAILED:
 
 int NetPrivate::convert_layout(Mat& bottom_blob, const Layer* layer, const Option& opt) const
 {
+    // empty optional input, such as the first kv cache, passes through as is
+    if (bottom_blob.dims != 0 && bottom_blob.empty())
+        return 0;
+
     if (bottom_blob.elembits() == 32)
     {
         // clang-format off
@@ -648,6 +1632,15 @@ int NetPrivate::convert_layout(Mat& bottom_blob, const Layer* layer, const Optio
         }
         else
 #endif // NCNN_RVV
+#if NCNN_F16C
+        if (opt.use_fp16_storage && !opt.use_bf16_storage && opt.use_x86_fp16_storage && cpu_support_x86_f16c() && layer->support_fp16_storage)
+        {
+            Mat bottom_blob_fp16;
+            cast_float32_to_float16(bottom_blob, bottom_blob_fp16, opt);
+            bottom_blob = bottom_blob_fp16;
+        }
+        else
+#endif // NCNN_F16C
 #if NCNN_BF16
         if (opt.use_bf16_storage && layer->support_bf16_storage)
         {
@@ -711,6 +1704,18 @@ int NetPrivate::convert_layout(Mat& bottom_blob, const Layer* layer, const Optio
                     dst_elempack = 8;
                 else if (elemcount % 4 == 0)
                     dst_elempack = 4;
+#elif NCNN_AVX512
+                if (elemcount % 16 == 0 && ncnn::cpu_support_x86_avx512())
+                    dst_elempack = 16;
+                else if (elemcount % 8 == 0 && ncnn::cpu_support_x86_avx())
+                    dst_elempack = 8;
+                else if (elemcount % 4 == 0)
+                    dst_elempack = 4;
+#elif NCNN_AVX
+                if (elemcount % 8 == 0 && ncnn::cpu_support_x86_avx())
+                    dst_elempack = 8;
+                else if (elemcount % 4 == 0)
+                    dst_elempack = 4;
 #elif NCNN_RVV
                 const int packn = ncnn::cpu_riscv_vlenb() / 2;
                 if (elemcount % packn == 0)
@@ -776,6 +1781,15 @@ int NetPrivate::convert_layout(Mat& bottom_blob, const Layer* layer, const Optio
         }
         else
 #endif // NCNN_RVV
+#if NCNN_F16C
+        if (opt.use_fp16_storage && !opt.use_bf16_storage && opt.use_x86_fp16_storage && cpu_support_x86_f16c() && !layer->support_fp16_storage)
+        {
+            Mat bottom_blob_fp32;
+            cast_float16_to_float32(bottom_blob, bottom_blob_fp32, opt);
+            bottom_blob = bottom_blob_fp32;
+        }
+        else
+#endif // NCNN_F16C
 #if NCNN_BF16
         if (opt.use_bf16_storage && !layer->support_bf16_storage)
         {
@@ -810,8 +1824,8 @@ int NetPrivate::do_forward_layer(const Layer* layer, std::vector<Mat>& blob_mats
 
         if (opt.lightmode)
         {
-            // deep copy for inplace forward if data is shared
-            if (layer->support_inplace && *bottom_blob_ref.refcount != 1)
+            // deep copy for inplace forward if data is shared or external
+            if (layer->support_inplace && (!bottom_blob_ref.refcount || *bottom_blob_ref.refcount != 1))
             {
                 bottom_blob = bottom_blob_ref.clone(opt.blob_allocator);
                 if (bottom_blob.empty())
@@ -867,8 +1881,8 @@ int NetPrivate::do_forward_layer(const Layer* layer, std::vector<Mat>& blob_mats
 
             if (opt.lightmode)
             {
-                // deep copy for inplace forward if data is shared
-                if (layer->support_inplace && *bottom_blob_ref.refcount != 1)
+                // deep copy for inplace forward if data is shared or external
+                if (layer->support_inplace && (!bottom_blob_ref.refcount || *bottom_blob_ref.refcount != 1))
                 {
                     bottom_blobs[i] = bottom_blob_ref.clone(opt.blob_allocator);
                     if (bottom_blobs[i].empty())
@@ -932,34 +1946,263 @@ int NetPrivate::do_forward_layer(const Layer* layer, std::vector<Mat>& blob_mats
     return 0;
 }
 
-#if NCNN_VULKAN
-int NetPrivate::do_forward_layer(const Layer* layer, std::vector<VkMat>& blob_mats_gpu, VkCompute& cmd, const Option& opt) const
+// how a layer stacks the samples of a batch into one forward
+// 0 = no stacking, run each sample
+// 1 = innerproduct, flattened samples as rows of one 2d blob
+// 2 = gemm with constant B, rows of every sample A stacked into one A
+// 3 = pointwise convolution, spatial positions of every sample side by side
+static int get_batch_stack_type(const Layer* layer, const std::vector<std::vector<Mat> >& batch_blob_mats)
 {
-    if (layer->one_blob_only)
-    {
-        // load bottom blob
-        int bottom_blob_index = layer->bottoms[0];
-        int top_blob_index = layer->tops[0];
+    const int batch = (int)batch_blob_mats.size();
+    if (batch < 2 || layer->bottoms.size() != 1 || layer->tops.size() != 1)
+        return 0;
 
-        VkMat& bottom_blob_ref = blob_mats_gpu[bottom_blob_index];
-        VkMat bottom_blob;
+    const Mat& bottom_blob0 = batch_blob_mats[0][layer->bottoms[0]];
+    if (bottom_blob0.dims == 0)
+        return 0;
 
-        if (opt.lightmode)
-        {
-            // deep copy for inplace forward if data is shared
-            if (layer->support_inplace && *bottom_blob_ref.refcount != 1)
-            {
-                cmd.record_clone(bottom_blob_ref, bottom_blob, opt);
-                //                     NCNN_LOGE("clone %p[+%lu] %p[+%lu]", bottom_blob_ref.buffer(), bottom_blob_ref.buffer_offset(), bottom_blob.buffer(), bottom_blob.buffer_offset());
-            }
-        }
-        if (bottom_blob.dims == 0)
-        {
-            bottom_blob = bottom_blob_ref;
-        }
+    // every sample must have the same shape
+    for (int n = 1; n < batch; n++)
+    {
+        const Mat& bottom_blob = batch_blob_mats[n][layer->bottoms[0]];
+
+        if (bottom_blob.dims != bottom_blob0.dims
+                || bottom_blob.w != bottom_blob0.w
+                || bottom_blob.h != bottom_blob0.h
+                || bottom_blob.d != bottom_blob0.d
+                || bottom_blob.c != bottom_blob0.c
+                || bottom_blob.elemsize != bottom_blob0.elemsize
+                || bottom_blob.elempack != bottom_blob0.elempack)
+            return 0;
+    }
 
-        // forward
-        if (opt.lightmode && layer->support_inplace)
+    if (layer->typeindex == LayerType::InnerProduct)
+    {
+        // innerproduct treats 2d input as rows of samples already
+        return bottom_blob0.dims != 2 ? 1 : 0;
+    }
+
+    if (layer->typeindex == LayerType::Gemm)
+    {
+        const Gemm* gemm = (const Gemm*)layer;
+
+        // rows of A map to rows of the output, C must not vary along M
+        const bool broadcast_C_ok = !gemm->constantC || gemm->constant_broadcast_type_C == -1 || gemm->constant_broadcast_type_C == 0 || gemm->constant_broadcast_type_C == 4;
+        if (gemm->constantB && !gemm->constantA && !gemm->transA && !gemm->output_transpose && !gemm->output_N1M && broadcast_C_ok && bottom_blob0.dims == 2)
+            return 2;
+
+        return 0;
+    }
+
+    if (layer->typeindex == LayerType::Convolution)
+    {
+        const Convolution* convolution = (const Convolution*)layer;
+
+        // 1x1 stride 1 without padding computes every position on its own
+        const bool pointwise = convolution->kernel_w == 1 && convolution->kernel_h == 1
+                               && convolution->stride_w == 1 && convolution->stride_h == 1
+                               && convolution->pad_left == 0 && convolution->pad_right == 0
+                               && convolution->pad_top == 0 && convolution->pad_bottom == 0;
+        if (pointwise && !convolution->dynamic_weight && bottom_blob0.dims == 3)
+            return 3;
+
+        return 0;
+    }
+
+    return 0;
+}
+
+int NetPrivate::do_forward_layer_batch(const Layer* layer, std::vector<std::vector<Mat> >& batch_blob_mats, const Option& opt) const
+{
+    const int batch = (int)batch_blob_mats.size();
+
+    const int stack_type = get_batch_stack_type(layer, batch_blob_mats);
+    if (stack_type == 0)
+    {
+        for (int n = 0; n < batch; n++)
+        {
+            int ret = do_forward_layer(layer, batch_blob_mats[n], opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        return 0;
+    }
+
+    const int bottom_blob_index = layer->bottoms[0];
+    const int top_blob_index = layer->tops[0];
+
+    const Mat& bottom_blob0 = batch_blob_mats[0][bottom_blob_index];
+
+    if (stack_type == 3)
+    {
+        // gather, packed channels stay as they are
+        const int w = bottom_blob0.w;
+        const int h = bottom_blob0.h;
+        const int channels = bottom_blob0.c;
+        const size_t elemsize = bottom_blob0.elemsize;
+        const int elempack = bottom_blob0.elempack;
+        const int size = w * h;
+
+        Mat bottom_blob(size * batch, 1, channels, elemsize, elempack, opt.workspace_allocator);
+        if (bottom_blob.empty())
+            return -100;
+
+        for (int n = 0; n < batch; n++)
+        {
+            const Mat& bottom_blob_n = batch_blob_mats[n][bottom_blob_index];
+
+            for (int q = 0; q < channels; q++)
+            {
+                memcpy(bottom_blob.channel(q).row<unsigned char>(0) + n * size * elemsize, bottom_blob_n.channel(q).data, size * elemsize);
+            }
+
+            if (opt.lightmode)
+            {
+                // delete after taken in light mode
+                batch_blob_mats[n][bottom_blob_index].release();
+            }
+        }
+
+        int ret = convert_layout(bottom_blob, layer, opt);
+        if (ret != 0)
+            return ret;
+
+        // forward
+        Mat top_blob;
+        ret = layer->forward(bottom_blob, top_blob, opt);
+        if (ret != 0)
+            return ret;
+
+        if (top_blob.dims != 3 || top_blob.w != size * batch || top_blob.h != 1)
+        {
+            NCNN_LOGE("%s %s does not keep the spatial positions of each sample", layer->type.c_str(), layer->name.c_str());
+            return -1;
+        }
+
+        // scatter
+        const int out_channels = top_blob.c;
+        const size_t out_elemsize = top_blob.elemsize;
+        const int out_elempack = top_blob.elempack;
+        for (int n = 0; n < batch; n++)
+        {
+            Mat top_blob_n(w, h, out_channels, out_elemsize, out_elempack, opt.blob_allocator);
+            if (top_blob_n.empty())
+                return -100;
+
+            for (int q = 0; q < out_channels; q++)
+            {
+                memcpy(top_blob_n.channel(q).data, top_blob.channel(q).row<const unsigned char>(0) + n * size * out_elemsize, size * out_elemsize);
+            }
+
+            // store top blob
+            batch_blob_mats[n][top_blob_index] = top_blob_n;
+        }
+
+        return 0;
+    }
+
+    // innerproduct takes one flattened sample per row, gemm takes all rows of each sample
+    const int rows = stack_type == 1 ? 1 : bottom_blob0.h * bottom_blob0.elempack;
+    const int size = stack_type == 1 ? bottom_blob0.w * bottom_blob0.h * bottom_blob0.d * bottom_blob0.c * bottom_blob0.elempack : bottom_blob0.w;
+    const size_t elemsize = bottom_blob0.elemsize / bottom_blob0.elempack;
+
+    // gather
+    Mat bottom_blob(size, rows * batch, elemsize, opt.workspace_allocator);
+    if (bottom_blob.empty())
+        return -100;
+
+    for (int n = 0; n < batch; n++)
+    {
+        Mat bottom_blob_unpacked;
+        convert_packing(batch_blob_mats[n][bottom_blob_index], bottom_blob_unpacked, 1, opt);
+        if (bottom_blob_unpacked.empty())
+            return -100;
+
+        Mat bottom_blob_flattened = bottom_blob_unpacked.reshape(size * rows, opt.workspace_allocator);
+        if (bottom_blob_flattened.empty())
+            return -100;
+
+        memcpy(bottom_blob.row<unsigned char>(n * rows), bottom_blob_flattened.data, size * rows * elemsize);
+
+        if (opt.lightmode)
+        {
+            // delete after taken in light mode
+            batch_blob_mats[n][bottom_blob_index].release();
+        }
+    }
+
+    int ret = convert_layout(bottom_blob, layer, opt);
+    if (ret != 0)
+        return ret;
+
+    // forward
+    Mat top_blob;
+    ret = layer->forward(bottom_blob, top_blob, opt);
+    if (ret != 0)
+        return ret;
+
+    Mat top_blob_unpacked;
+    convert_packing(top_blob, top_blob_unpacked, 1, opt);
+    if (top_blob_unpacked.empty())
+        return -100;
+
+    if (top_blob_unpacked.dims != 2 || top_blob_unpacked.h != rows * batch)
+    {
+        NCNN_LOGE("%s %s does not produce the rows of each sample", layer->type.c_str(), layer->name.c_str());
+        return -1;
+    }
+
+    // scatter
+    const int outw = top_blob_unpacked.w;
+    const size_t out_elemsize = top_blob_unpacked.elemsize;
+    for (int n = 0; n < batch; n++)
+    {
+        Mat top_blob_n;
+        if (stack_type == 1)
+            top_blob_n.create(outw, out_elemsize, opt.blob_allocator);
+        else
+            top_blob_n.create(outw, rows, out_elemsize, opt.blob_allocator);
+        if (top_blob_n.empty())
+            return -100;
+
+        memcpy(top_blob_n.data, top_blob_unpacked.row<const unsigned char>(n * rows), outw * rows * out_elemsize);
+
+        // store top blob
+        batch_blob_mats[n][top_blob_index] = top_blob_n;
+    }
+
+    return 0;
+}
+
+#if NCNN_VULKAN
+int NetPrivate::do_forward_layer(const Layer* layer, std::vector<VkMat>& blob_mats_gpu, VkCompute& cmd, const Option& opt) const
+{
+    if (layer->one_blob_only)
+    {
+        // load bottom blob
+        int bottom_blob_index = layer->bottoms[0];
+        int top_blob_index = layer->tops[0];
+
+        VkMat& bottom_blob_ref = blob_mats_gpu[bottom_blob_index];
+        VkMat bottom_blob;
+
+        if (opt.lightmode)
+        {
+            // deep copy for inplace forward if data is shared or external
+            if (layer->support_inplace && (!bottom_blob_ref.refcount || *bottom_blob_ref.refcount != 1))
+            {
+                cmd.record_clone(bottom_blob_ref, bottom_blob, opt);
+                //                     NCNN_LOGE("clone %p[+%lu] %p[+%lu]", bottom_blob_ref.buffer(), bottom_blob_ref.buffer_offset(), bottom_blob.buffer(), bottom_blob.buffer_offset());
+            }
+        }
+        if (bottom_blob.dims == 0)
+        {
+            bottom_blob = bottom_blob_ref;
+        }
+
+        // forward
+        if (opt.lightmode && layer->support_inplace)
         {
             VkMat& bottom_top_blob = bottom_blob;
             int ret = layer->forward_inplace(bottom_top_blob, cmd, opt);
@@ -999,8 +2242,8 @@ int NetPrivate::do_forward_layer(const Layer* layer, std::vector<VkMat>& blob_ma
 
             if (opt.lightmode)
             {
-                // deep copy for inplace forward if data is shared
-                if (layer->support_inplace && *bottom_blob_ref.refcount != 1)
+                // deep copy for inplace forward if data is shared or external
+                if (layer->support_inplace && (!bottom_blob_ref.refcount || *bottom_blob_ref.refcount != 1))
                 {
                     cmd.record_clone(bottom_blob_ref, bottom_blobs[i], opt);
                     //                         NCNN_LOGE("clone %p[+%lu] %p[+%lu]", bottom_blob_ref.buffer(), bottom_blob_ref.buffer_offset(), bottom_blobs[i].buffer(), bottom_blobs[i].buffer_offset());
@@ -1072,8 +2315,8 @@ int NetPrivate::do_forward_layer(const Layer* layer, std::vector<VkImageMat>& bl
 
         if (opt.lightmode)
         {
-            // deep copy for inplace forward if data is shared
-            if (layer->support_inplace && *bottom_blob_ref.refcount != 1)
+            // deep copy for inplace forward if data is shared or external
+            if (layer->support_inplace && (!bottom_blob_ref.refcount || *bottom_blob_ref.refcount != 1))
             {
                 cmd.record_clone(bottom_blob_ref, bottom_blob, opt);
                 //                         NCNN_LOGE("clone %p[+%lu] %p[+%lu]", bottom_blob_ref.buffer(), bottom_blob_ref.buffer_offset(), bottom_blob.buffer(), bottom_blob.buffer_offset());
@@ -1124,8 +2367,8 @@ int NetPrivate::do_forward_layer(const Layer* layer, std::vector<VkImageMat>& bl
 
             if (opt.lightmode)
             {
-                // deep copy for inplace forward if data is shared
-                if (layer->support_inplace && *bottom_blob_ref.refcount != 1)
+                // deep copy for inplace forward if data is shared or external
+                if (layer->support_inplace && (!bottom_blob_ref.refcount || *bottom_blob_ref.refcount != 1))
                 {
                     cmd.record_clone(bottom_blob_ref, bottom_blobs[i], opt);
                     //                             NCNN_LOGE("clone %p[+%lu] %p[+%lu]", bottom_blob_ref.buffer(), bottom_blob_ref.buffer_offset(), bottom_blobs[i].buffer(), bottom_blobs[i].buffer_offset());
@@ -1185,6 +2428,54 @@ int NetPrivate::do_forward_layer(const Layer* layer, std::vector<VkImageMat>& bl
 }
 #endif // NCNN_VULKAN
 
+// multiheadattention with kv cache takes the past xk and xv as the last two bottoms
+// and produces the concatenated ones as the last two tops
+static bool is_kv_cache_layer(const NetPrivate* d, int layer_index)
+{
+    const Layer* layer = d->layers[layer_index];
+    return layer_index < (int)d->layer_kv_cache.size() && d->layer_kv_cache[layer_index] && layer->bottoms.size() >= 3 && layer->tops.size() == 3;
+}
+
+// streaming convolution1d and pooling1d take the cached input tail as the 2nd bottom
+// and produce the new tail as the 2nd top
+static bool is_streaming_layer(const Layer* layer)
+{
+    return (layer->typeindex == LayerType::Convolution1D || layer->typeindex == LayerType::ConvolutionDepthWise1D || layer->typeindex == LayerType::Pooling1D)
+           && layer->bottoms.size() == 2 && layer->tops.size() == 2;
+}
+
+void NetPrivate::update_state_blob_indexes()
+{
+    state_blob_indexes.clear();
+
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        const Layer* layer = layers[i];
+        if (!layer)
+            continue;
+
+        size_t first_state = 0;
+        if (is_kv_cache_layer(this, (int)i))
+            first_state = layer->bottoms.size() - 2;
+        else if (is_streaming_layer(layer))
+            first_state = 1;
+        else
+            continue;
+
+        for (size_t j = first_state; j < layer->bottoms.size(); j++)
+        {
+            const int blob_index = layer->bottoms[j];
+
+            // only graph inputs, the cache may also come from other layers
+            const int producer = blobs[blob_index].producer;
+            if (producer < 0 || !layers[producer] || layers[producer]->typeindex != LayerType::Input)
+                continue;
+
+            state_blob_indexes.push_back(blob_index);
+        }
+    }
+}
+
 void NetPrivate::update_input_output_indexes()
 {
     input_blob_indexes.clear();
@@ -1228,6 +2519,232 @@ void NetPrivate::update_input_output_names()
 }
 #endif // NCNN_STRING
 
+// describe a builtin elementwise layer as one fused instruction
+// return false if the layer can not be fused
+static bool get_fused_instruction(const Layer* layer, FusedElementwise::Instruction& ins)
+{
+    if (layer->featmask != 0 || layer->tops.size() != 1)
+        return false;
+
+    ins.src0 = 0;
+    ins.src1 = 0;
+    ins.a = 0.f;
+    ins.b = 0.f;
+
+    switch (layer->typeindex)
+    {
+    case LayerType::UnaryOp:
+        ins.op_type = FusedElementwise::Operation_UNARYOP;
+        ins.a = (float)((const UnaryOp*)layer)->op_type;
+        return true;
+    case LayerType::BinaryOp:
+    {
+        const BinaryOp* binaryop = (const BinaryOp*)layer;
+        if (binaryop->with_scalar)
+        {
+            ins.op_type = FusedElementwise::Operation_BINARYOP_SCALAR;
+            ins.b = binaryop->b;
+        }
+        else
+        {
+            // both operands must come from the chain, broadcasting is not fused
+            if (layer->bottoms.size() != 2)
+                return false;
+
+            ins.op_type = FusedElementwise::Operation_BINARYOP;
+        }
+        ins.a = (float)binaryop->op_type;
+        return true;
+    }
+    case LayerType::Sigmoid:
+        ins.op_type = FusedElementwise::Operation_SIGMOID;
+        return true;
+    case LayerType::TanH:
+        ins.op_type = FusedElementwise::Operation_UNARYOP;
+        ins.a = (float)UnaryOp::Operation_TANH;
+        return true;
+    case LayerType::ReLU:
+        ins.op_type = FusedElementwise::Operation_RELU;
+        ins.a = ((const ReLU*)layer)->slope;
+        return true;
+    case LayerType::Clip:
+        ins.op_type = FusedElementwise::Operation_CLIP;
+        ins.a = ((const Clip*)layer)->min;
+        ins.b = ((const Clip*)layer)->max;
+        return true;
+    case LayerType::Swish:
+        ins.op_type = FusedElementwise::Operation_SWISH;
+        return true;
+    case LayerType::HardSigmoid:
+        ins.op_type = FusedElementwise::Operation_HARDSIGMOID;
+        ins.a = ((const HardSigmoid*)layer)->alpha;
+        ins.b = ((const HardSigmoid*)layer)->beta;
+        return true;
+    case LayerType::HardSwish:
+        ins.op_type = FusedElementwise::Operation_HARDSWISH;
+        ins.a = ((const HardSwish*)layer)->alpha;
+        ins.b = ((const HardSwish*)layer)->beta;
+        return true;
+    case LayerType::ELU:
+        ins.op_type = FusedElementwise::Operation_ELU;
+        ins.a = ((const ELU*)layer)->alpha;
+        return true;
+    case LayerType::GELU:
+        ins.op_type = FusedElementwise::Operation_GELU;
+        ins.a = (float)((const GELU*)layer)->fast_gelu;
+        return true;
+    case LayerType::Mish:
+        ins.op_type = FusedElementwise::Operation_MISH;
+        return true;
+    default:
+        return false;
+    }
+}
+
+void NetPrivate::fuse_elementwise_layers()
+{
+    const int layer_count = (int)layers.size();
+    const int blob_count = (int)blobs.size();
+
+    // a chain reads one tensor, either a single blob or the tops of one split
+    // keys[i] identifies that tensor for the chain ending at layer i, -1 if layer i is not fused
+    std::vector<FusedElementwise::Instruction> layer_instructions(layer_count);
+    std::vector<int> keys(layer_count, -1);
+    std::vector<int> sizes(layer_count, 0);
+
+    for (int i = 0; i < layer_count; i++)
+    {
+        const Layer* layer = layers[i];
+        if (!layer || !get_fused_instruction(layer, layer_instructions[i]))
+            continue;
+
+        int key = -1;
+        int size = 1;
+        bool conflict = false;
+        for (size_t j = 0; j < layer->bottoms.size(); j++)
+        {
+            const int bottom_blob_index = layer->bottoms[j];
+            const int producer = blobs[bottom_blob_index].producer;
+
+            int k = bottom_blob_index;
+            if (producer >= 0 && keys[producer] >= 0)
+            {
+                k = keys[producer];
+                size += sizes[producer];
+            }
+            else if (producer >= 0 && layers[producer]->typeindex == LayerType::Split)
+            {
+                k = blob_count + producer;
+            }
+
+            if (key == -1)
+                key = k;
+            else if (key != k)
+                conflict = true;
+        }
+
+        if (conflict || size > FusedElementwise::MAX_INSTRUCTION_COUNT)
+            continue;
+
+        keys[i] = key;
+        sizes[i] = size;
+    }
+
+    for (int i = 0; i < layer_count; i++)
+    {
+        if (keys[i] < 0 || sizes[i] < 2)
+            continue;
+
+        // fuse at the end of the chain only
+        const int consumer = blobs[layers[i]->tops[0]].consumer;
+        if (consumer >= 0 && keys[consumer] >= 0)
+            continue;
+
+        // collect the chain members and the blobs it reads
+        std::vector<int> members;
+        std::vector<int> entries;
+        std::vector<int> stack(1, i);
+        while (!stack.empty())
+        {
+            const Layer* layer = layers[stack.back()];
+            members.push_back(stack.back());
+            stack.pop_back();
+
+            for (size_t j = 0; j < layer->bottoms.size(); j++)
+            {
+                const int bottom_blob_index = layer->bottoms[j];
+                const int producer = blobs[bottom_blob_index].producer;
+                if (producer >= 0 && keys[producer] >= 0)
+                    stack.push_back(producer);
+                else if (std::find(entries.begin(), entries.end(), bottom_blob_index) == entries.end())
+                    entries.push_back(bottom_blob_index);
+            }
+        }
+
+        std::sort(members.begin(), members.end());
+
+        // entries are register 0, member k writes register k + 1
+        const int instruction_count = (int)members.size();
+        Mat program(instruction_count * 5);
+        for (int k = 0; k < instruction_count; k++)
+        {
+            const Layer* layer = layers[members[k]];
+
+            int regs[2] = {0, 0};
+            for (size_t j = 0; j < layer->bottoms.size(); j++)
+            {
+                const int producer = blobs[layer->bottoms[j]].producer;
+                std::vector<int>::const_iterator it = std::find(members.begin(), members.end(), producer);
+                if (it != members.end())
+                    regs[j] = (int)(it - members.begin()) + 1;
+            }
+
+            const FusedElementwise::Instruction& ins = layer_instructions[members[k]];
+
+            float* p = (float*)program + k * 5;
+            p[0] = (float)ins.op_type;
+            p[1] = (float)regs[0];
+            p[2] = (float)regs[1];
+            p[3] = ins.a;
+            p[4] = ins.b;
+        }
+
+        Layer* layer = layers[i];
+
+        Layer* fused = create_layer_cpu(LayerType::FusedElementwise);
+#if NCNN_STRING
+        fused->type = "FusedElementwise";
+        fused->name = layer->name;
+#endif // NCNN_STRING
+        fused->bottoms = entries;
+        fused->tops = layer->tops;
+        fused->top_shapes = layer->top_shapes;
+        for (size_t j = 0; j < entries.size(); j++)
+        {
+            fused->bottom_shapes.push_back(blobs[entries[j]].shape);
+        }
+
+        ParamDict pd;
+        pd.set(0, (int)entries.size());
+        pd.set(1, program);
+
+        if (fused->load_param(pd) != 0)
+        {
+            delete fused;
+            continue;
+        }
+
+        // the other members stay in place, they only run if their tops are extracted
+        for (size_t j = 0; j < entries.size(); j++)
+        {
+            blobs[entries[j]].consumer = i;
+        }
+
+        delete layer;
+        layers[i] = fused;
+    }
+}
+
 Net::Net()
     : d(new NetPrivate(opt))
 {
@@ -1371,6 +2888,10 @@ int Net::load_param(const DataReader& dr)
     }
 
     d->layers.resize((size_t)layer_count);
+    d->layer_param_hashes.clear();
+    d->layer_param_hashes.resize(layer_count);
+    d->layer_kv_cache.clear();
+    d->layer_kv_cache.resize(layer_count, 0);
     d->blobs.resize((size_t)blob_count);
 
 #if NCNN_VULKAN
@@ -1513,6 +3034,9 @@ int Net::load_param(const DataReader& dr)
             continue;
         }
 
+        d->layer_param_hashes[i] = hash_param_dict(pd);
+        d->layer_kv_cache[i] = layer->typeindex == LayerType::MultiHeadAttention && pd.get(7, 0);
+
         // pull out top shape hints
         Mat shape_hints = pd.get(30, Mat());
         if (!shape_hints.empty())
@@ -1618,7 +3142,13 @@ int Net::load_param(const DataReader& dr)
         d->layers[i] = layer;
     }
 
+    if (opt.use_elementwise_fusion && !opt.use_vulkan_compute)
+    {
+        d->fuse_elementwise_layers();
+    }
+
     d->update_input_output_indexes();
+    d->update_state_blob_indexes();
     d->update_input_output_names();
 
 #undef SCAN_VALUE
@@ -1667,6 +3197,10 @@ int Net::load_param_bin(const DataReader& dr)
     }
 
     d->layers.resize(layer_count);
+    d->layer_param_hashes.clear();
+    d->layer_param_hashes.resize(layer_count);
+    d->layer_kv_cache.clear();
+    d->layer_kv_cache.resize(layer_count, 0);
     d->blobs.resize(blob_count);
 
 #if NCNN_VULKAN
@@ -1792,6 +3326,9 @@ int Net::load_param_bin(const DataReader& dr)
             continue;
         }
 
+        d->layer_param_hashes[i] = hash_param_dict(pd);
+        d->layer_kv_cache[i] = layer->typeindex == LayerType::MultiHeadAttention && pd.get(7, 0);
+
         // pull out top blob shape hints
         Mat shape_hints = pd.get(30, Mat());
         if (!shape_hints.empty())
@@ -1896,7 +3433,13 @@ int Net::load_param_bin(const DataReader& dr)
         d->layers[i] = layer;
     }
 
+    if (opt.use_elementwise_fusion && !opt.use_vulkan_compute)
+    {
+        d->fuse_elementwise_layers();
+    }
+
     d->update_input_output_indexes();
+    d->update_state_blob_indexes();
 
 #undef READ_VALUE
     return 0;
@@ -1927,46 +3470,61 @@ int Net::load_model(const DataReader& dr)
     }
 #endif // NCNN_VULKAN
 
-    ModelBinFromDataReader mb(dr);
-    for (int i = 0; i < layer_count; i++)
-    {
-        Layer* layer = d->layers[i];
+    const bool hash_weights = d->pipeline_data_cache_saving || !d->pipeline_data_cache.empty();
 
-        //Here we found inconsistent content in the parameter file.
-        if (!layer)
-        {
-            NCNN_LOGE("load_model error at layer %d, parameter file has inconsistent content.", i);
-            ret = -1;
-            break;
-        }
+    DataReaderHashing hdr(dr, hash_weights);
+    ModelBinFromDataReader mb(hdr);
 
-        int lret = layer->load_model(mb);
-        if (lret != 0)
+    d->layer_weight_hashes.clear();
+    if (hash_weights)
+        d->layer_weight_hashes.resize(layer_count);
+
+    if (opt.use_parallel_create_pipeline && opt.num_threads > 1 && !opt.use_vulkan_compute)
+    {
+        ret = d->load_model_parallel(mb, hdr);
+    }
+    else
+    {
+        for (int i = 0; i < layer_count; i++)
         {
-#if NCNN_STRING
-            NCNN_LOGE("layer load_model %d %s failed", i, layer->name.c_str());
-#else
-            NCNN_LOGE("layer load_model %d failed", i);
-#endif
-            ret = -1;
-            break;
-        }
+            Layer* layer = d->layers[i];
 
-        Option opt1 = get_masked_option(opt, layer->featmask);
+            //Here we found inconsistent content in the parameter file.
+            if (!layer)
+            {
+                NCNN_LOGE("load_model error at layer %d, parameter file has inconsistent content.", i);
+                ret = -1;
+                break;
+            }
 
-        int cret = layer->create_pipeline(opt1);
-        if (cret != 0)
-        {
+            int lret = layer->load_model(mb);
+            if (lret != 0)
+            {
 #if NCNN_STRING
-            NCNN_LOGE("layer create_pipeline %d %s failed", i, layer->name.c_str());
+                NCNN_LOGE("layer load_model %d %s failed", i, layer->name.c_str());
 #else
-            NCNN_LOGE("layer create_pipeline %d failed", i);
+                NCNN_LOGE("layer load_model %d failed", i);
 #endif
-            ret = -1;
-            break;
+                ret = -1;
+                break;
+            }
+
+            if (hash_weights)
+                d->layer_weight_hashes[i] = hdr.take_hash();
+
+            int cret = d->create_layer_pipeline(i);
+            if (cret != 0)
+            {
+                ret = -1;
+                break;
+            }
         }
     }
 
+    d->pipeline_data_cache.clear();
+    d->pipeline_data_cache_weight_hashes.clear();
+    d->kernel_profile.clear();
+
     if (opt.use_local_pool_allocator)
     {
         if (opt.blob_allocator == 0)
@@ -1998,6 +3556,421 @@ int Net::load_model(const DataReader& dr)
 }
 
 #if NCNN_STDIO
+// everything the transformed weight data depends on
+// cpu features select the layer implementation, packing and kernel timing
+static void get_cpu_feature_key(std::vector<int>& key)
+{
+    key.push_back(cpu_support_x86_avx());
+    key.push_back(cpu_support_x86_fma());
+    key.push_back(cpu_support_x86_xop());
+    key.push_back(cpu_support_x86_f16c());
+    key.push_back(cpu_support_x86_avx2());
+    key.push_back(cpu_support_x86_avx_vnni());
+    key.push_back(cpu_support_x86_avx512());
+    key.push_back(cpu_support_x86_avx512_vnni());
+    key.push_back(cpu_support_x86_avx512_bf16());
+    key.push_back(cpu_support_x86_avx512_fp16());
+    key.push_back(cpu_support_arm_asimdhp());
+    key.push_back(cpu_support_arm_asimddp());
+    key.push_back(cpu_support_arm_asimdfhm());
+    key.push_back(cpu_support_arm_bf16());
+    key.push_back(cpu_support_arm_i8mm());
+    key.push_back(cpu_support_arm_sve());
+    key.push_back(cpu_support_riscv_v());
+    key.push_back(cpu_support_riscv_zfh());
+    key.push_back(get_cpu_level2_cache_size());
+}
+
+static void get_pipeline_data_cache_key(const Option& opt, const std::vector<Layer*>& layers, const std::vector<unsigned int>& layer_param_hashes, std::vector<int>& key)
+{
+    key.clear();
+
+    get_cpu_feature_key(key);
+
+    key.push_back(opt.num_threads);
+    key.push_back(opt.use_winograd_convolution);
+    key.push_back(opt.use_sgemm_convolution);
+    key.push_back(opt.use_int8_inference);
+    key.push_back(opt.use_fp16_packed);
+    key.push_back(opt.use_fp16_storage);
+    key.push_back(opt.use_fp16_arithmetic);
+    key.push_back(opt.use_int8_packed);
+    key.push_back(opt.use_int8_storage);
+    key.push_back(opt.use_int8_arithmetic);
+    key.push_back(opt.use_packing_layout);
+    key.push_back(opt.use_bf16_storage);
+    key.push_back(opt.use_a53_a55_optimized_kernel);
+    key.push_back(opt.use_winograd23_convolution);
+    key.push_back(opt.use_winograd43_convolution);
+    key.push_back(opt.use_winograd63_convolution);
+    key.push_back(opt.use_kernel_autotune);
+    key.push_back(opt.use_x86_fp16_storage);
+    key.push_back(opt.use_x86_fp16_arithmetic);
+
+    key.push_back((int)layers.size());
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        key.push_back(layers[i]->typeindex);
+        key.push_back(layers[i]->featmask);
+        key.push_back(i < layer_param_hashes.size() ? (int)layer_param_hashes[i] : 0);
+    }
+}
+
+// "ncpd"
+static const int pipeline_data_cache_magic = 0x6470636e;
+
+int Net::save_pipeline_data_cache(const char* cachepath) const
+{
+    if (opt.use_vulkan_compute)
+    {
+        NCNN_LOGE("pipeline data cache supports cpu inference only");
+        return -1;
+    }
+
+    if (d->layer_weight_hashes.size() != d->layers.size())
+    {
+        NCNN_LOGE("weights not hashed, call set_pipeline_data_cache_saving before load_model");
+        return -1;
+    }
+
+    FILE* fp = fopen(cachepath, "wb");
+    if (!fp)
+    {
+        NCNN_LOGE("fopen %s failed", cachepath);
+        return -1;
+    }
+
+    std::vector<int> key;
+    get_pipeline_data_cache_key(opt, d->layers, d->layer_param_hashes, key);
+
+    const int key_size = (int)key.size();
+    fwrite(&pipeline_data_cache_magic, sizeof(int), 1, fp);
+    fwrite(&key_size, sizeof(int), 1, fp);
+    fwrite(&key[0], sizeof(int), key_size, fp);
+
+    for (size_t i = 0; i < d->layers.size(); i++)
+    {
+        std::vector<Mat> pipeline_data;
+        int count = d->layers[i]->save_pipeline_data(pipeline_data) == 0 ? (int)pipeline_data.size() : -1;
+        unsigned int weight_hash = d->layer_weight_hashes[i];
+        fwrite(&weight_hash, sizeof(unsigned int), 1, fp);
+        fwrite(&count, sizeof(int), 1, fp);
+
+        for (int j = 0; j < count; j++)
+        {
+            const Mat& m = pipeline_data[j];
+
+            // dims w h d c elempack elemsize
+            int header[7] = {m.dims, m.w, m.h, m.d, m.c, m.elempack, (int)m.elemsize};
+            fwrite(header, sizeof(int), 7, fp);
+
+            if (m.dims != 0)
+                fwrite(m.data, m.elemsize, m.total(), fp);
+        }
+    }
+
+    int ret = ferror(fp) ? -1 : 0;
+    fclose(fp);
+
+    if (ret != 0)
+        NCNN_LOGE("fwrite %s failed", cachepath);
+
+    return ret;
+}
+
+void Net::set_pipeline_data_cache_saving(bool enabled)
+{
+    d->pipeline_data_cache_saving = enabled;
+}
+
+// the mat header is sane and its data fits in the remaining bytes
+static bool check_pipeline_data_header(const int header[7], size_t remaining)
+{
+    const int dims = header[0];
+    if (dims < 0 || dims > 4)
+        return false;
+
+    if (dims == 0)
+        return true;
+
+    const int elempack = header[5];
+    const int elemsize = header[6];
+    if (elempack < 1 || elempack > 64 || elemsize < 1 || elemsize > 64)
+        return false;
+
+    // w h d c, unused ones are 1
+    const int shape[4] = {header[1], dims >= 2 ? header[2] : 1, dims == 4 ? header[3] : 1, dims >= 3 ? header[4] : 1};
+
+    size_t size = elemsize;
+    for (int i = 0; i < 4; i++)
+    {
+        if (shape[i] < 1 || (size_t)shape[i] > remaining / size)
+            return false;
+
+        size *= shape[i];
+    }
+
+    return true;
+}
+
+int Net::load_pipeline_data_cache(const char* cachepath)
+{
+    if (d->layers.empty())
+    {
+        NCNN_LOGE("network graph not ready");
+        return -1;
+    }
+
+    if (opt.use_vulkan_compute)
+    {
+        NCNN_LOGE("pipeline data cache supports cpu inference only");
+        return -1;
+    }
+
+    FILE* fp = fopen(cachepath, "rb");
+    if (!fp)
+    {
+        NCNN_LOGE("fopen %s failed", cachepath);
+        return -1;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    const long file_size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    std::vector<int> key;
+    get_pipeline_data_cache_key(opt, d->layers, d->layer_param_hashes, key);
+
+    int magic = 0;
+    int key_size = 0;
+    std::vector<int> cache_key;
+    if (fread(&magic, sizeof(int), 1, fp) == 1 && fread(&key_size, sizeof(int), 1, fp) == 1
+            && magic == pipeline_data_cache_magic && key_size == (int)key.size())
+    {
+        cache_key.resize(key_size);
+        if (fread(&cache_key[0], sizeof(int), key_size, fp) != (size_t)key_size)
+            cache_key.clear();
+    }
+
+    if (cache_key != key)
+    {
+        NCNN_LOGE("pipeline data cache %s does not match the current cpu, option, graph or param", cachepath);
+        fclose(fp);
+        return -1;
+    }
+
+    d->pipeline_data_cache.clear();
+    d->pipeline_data_cache.resize(d->layers.size());
+    d->pipeline_data_cache_weight_hashes.clear();
+    d->pipeline_data_cache_weight_hashes.resize(d->layers.size());
+
+    int ret = 0;
+    for (size_t i = 0; i < d->layers.size() && ret == 0; i++)
+    {
+        // the weight is checked when the layer loads its model
+        int count = 0;
+        if (fread(&d->pipeline_data_cache_weight_hashes[i], sizeof(unsigned int), 1, fp) != 1 || fread(&count, sizeof(int), 1, fp) != 1)
+        {
+            ret = -1;
+            break;
+        }
+
+        // -1 for a layer without pipeline data
+        if (count < -1 || (count > 0 && (size_t)count > (size_t)(file_size - ftell(fp)) / (7 * sizeof(int))))
+        {
+            ret = -1;
+            break;
+        }
+
+        for (int j = 0; j < count; j++)
+        {
+            int header[7];
+            if (fread(header, sizeof(int), 7, fp) != 7 || !check_pipeline_data_header(header, (size_t)(file_size - ftell(fp))))
+            {
+                ret = -1;
+                break;
+            }
+
+            const int dims = header[0];
+            const int w = header[1];
+            const int h = header[2];
+            const int dd = header[3];
+            const int c = header[4];
+            const int elempack = header[5];
+            const size_t elemsize = header[6];
+
+            Mat m;
+            if (dims == 1) m.create(w, elemsize, elempack);
+            if (dims == 2) m.create(w, h, elemsize, elempack);
+            if (dims == 3) m.create(w, h, c, elemsize, elempack);
+            if (dims == 4) m.create(w, h, dd, c, elemsize, elempack);
+
+            if (dims != 0)
+            {
+                if (m.empty())
+                {
+                    ret = -100;
+                    break;
+                }
+
+                if (fread(m.data, m.elemsize, m.total(), fp) != m.total())
+                {
+                    ret = -1;
+                    break;
+                }
+            }
+
+            d->pipeline_data_cache[i].push_back(m);
+        }
+    }
+
+    fclose(fp);
+
+    if (ret != 0)
+    {
+        NCNN_LOGE("pipeline data cache %s corrupted", cachepath);
+        d->pipeline_data_cache.clear();
+        d->pipeline_data_cache_weight_hashes.clear();
+    }
+
+    return ret;
+}
+
+// "nckp"
+static const int kernel_profile_magic = 0x706b636e;
+
+// the cpu and graph the kernel timing applies to
+static void get_kernel_profile_key(const std::vector<Layer*>& layers, const std::vector<unsigned int>& layer_param_hashes, std::vector<int>& key)
+{
+    key.clear();
+
+    get_cpu_feature_key(key);
+
+    key.push_back((int)layers.size());
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        key.push_back(layers[i]->typeindex);
+        key.push_back(i < layer_param_hashes.size() ? (int)layer_param_hashes[i] : 0);
+    }
+}
+
+int Net::save_kernel_profile(const char* profilepath) const
+{
+    FILE* fp = fopen(profilepath, "wb");
+    if (!fp)
+    {
+        NCNN_LOGE("fopen %s failed", profilepath);
+        return -1;
+    }
+
+    std::vector<int> key;
+    get_kernel_profile_key(d->layers, d->layer_param_hashes, key);
+
+    const int key_size = (int)key.size();
+    fwrite(&kernel_profile_magic, sizeof(int), 1, fp);
+    fwrite(&key_size, sizeof(int), 1, fp);
+    fwrite(&key[0], sizeof(int), key_size, fp);
+
+    const int layer_count = (int)d->layers.size();
+    for (int i = 0; i < layer_count; i++)
+    {
+        const Layer* layer = d->layers[i];
+
+        std::vector<int> profile;
+        if (layer->save_kernel_profile(profile) != 0)
+            profile.clear();
+
+        const int size = (int)profile.size();
+        fwrite(&size, sizeof(int), 1, fp);
+
+        if (size > 0)
+            fwrite(&profile[0], sizeof(int), size, fp);
+    }
+
+    int ret = ferror(fp) ? -1 : 0;
+    fclose(fp);
+
+    if (ret != 0)
+        NCNN_LOGE("fwrite %s failed", profilepath);
+
+    return ret;
+}
+
+int Net::load_kernel_profile(const char* profilepath)
+{
+    if (d->layers.empty())
+    {
+        NCNN_LOGE("network graph not ready");
+        return -1;
+    }
+
+    FILE* fp = fopen(profilepath, "rb");
+    if (!fp)
+    {
+        NCNN_LOGE("fopen %s failed", profilepath);
+        return -1;
+    }
+
+    std::vector<int> key;
+    get_kernel_profile_key(d->layers, d->layer_param_hashes, key);
+
+    int magic = 0;
+    int key_size = 0;
+    fread(&magic, sizeof(int), 1, fp);
+    fread(&key_size, sizeof(int), 1, fp);
+
+    std::vector<int> saved_key;
+    if (magic == kernel_profile_magic && key_size == (int)key.size())
+    {
+        saved_key.resize(key_size);
+        if (fread(&saved_key[0], sizeof(int), key_size, fp) != (size_t)key_size)
+            saved_key.clear();
+    }
+
+    if (saved_key != key)
+    {
+        NCNN_LOGE("kernel profile %s does not match the current cpu, graph or param", profilepath);
+        fclose(fp);
+        return -1;
+    }
+
+    const int layer_count = (int)d->layers.size();
+    std::vector<std::vector<int> > kernel_profile(layer_count);
+
+    int ret = 0;
+    for (int i = 0; i < layer_count; i++)
+    {
+        int size = 0;
+        if (fread(&size, sizeof(int), 1, fp) != 1 || size < 0)
+        {
+            ret = -1;
+            break;
+        }
+
+        if (size == 0)
+            continue;
+
+        kernel_profile[i].resize(size);
+        if (fread(&kernel_profile[i][0], sizeof(int), size, fp) != (size_t)size)
+        {
+            ret = -1;
+            break;
+        }
+    }
+
+    fclose(fp);
+
+    if (ret != 0)
+    {
+        NCNN_LOGE("kernel profile %s corrupted", profilepath);
+        return ret;
+    }
+
+    d->kernel_profile = kernel_profile;
+
+    return 0;
+}
+
 #if NCNN_STRING
 int Net::load_param(FILE* fp)
 {
@@ -2066,6 +4039,28 @@ int Net::load_model(const char* modelpath)
     fclose(fp);
     return ret;
 }
+
+int Net::load_model_mmap(const char* modelpath)
+{
+    DataReaderFromMmap* dr = new DataReaderFromMmap(modelpath);
+    if (dr->empty())
+    {
+        delete dr;
+        return -1;
+    }
+
+    // keep the mapping even on failure, some layers may reference it already
+    d->model_mmaps.push_back(dr);
+
+    int ret = load_model(*dr);
+    if (ret != 0)
+        return ret;
+
+    // weights repacked in create_pipeline do not need the source pages any more
+    dr->release_resident_pages();
+
+    return 0;
+}
 #endif // NCNN_STDIO
 
 int Net::load_param(const unsigned char* _mem)
@@ -2221,6 +4216,37 @@ void Net::clear()
         d->local_workspace_allocator = 0;
     }
 
+#if NCNN_STDIO
+    for (size_t i = 0; i < d->model_mmaps.size(); i++)
+    {
+        delete d->model_mmaps[i];
+    }
+    d->model_mmaps.clear();
+#endif // NCNN_STDIO
+
+    d->layer_param_hashes.clear();
+    d->layer_weight_hashes.clear();
+    d->layer_kv_cache.clear();
+    d->state_blob_indexes.clear();
+    d->pipeline_data_cache.clear();
+    d->pipeline_data_cache_weight_hashes.clear();
+    d->kernel_profile.clear();
+
+    for (size_t i = 0; i < d->planned_allocators.size(); i++)
+    {
+        delete d->planned_allocators[i];
+    }
+    d->planned_allocators.clear();
+    d->planned_arena_size = 0;
+
+#if NCNN_THREADS
+    if (d->forward_worker_pool)
+    {
+        delete d->forward_worker_pool;
+        d->forward_worker_pool = 0;
+    }
+#endif // NCNN_THREADS
+
 #if NCNN_VULKAN
     if (d->weight_vkallocator)
     {
@@ -2246,6 +4272,13 @@ Extractor Net::create_extractor() const
     return Extractor(this, d->blobs.size());
 }
 
+size_t Net::planned_arena_size() const
+{
+    MutexLockGuard lock(d->planned_allocator_lock);
+
+    return d->planned_arena_size;
+}
+
 const std::vector<int>& Net::input_indexes() const
 {
     return d->input_blob_indexes;
@@ -2407,17 +4440,113 @@ Layer* Net::create_overwrite_builtin_layer(int typeindex)
     return layer;
 }
 
-class ExtractorPrivate
+static int convert_output_layout(Mat& feat, int type, const Option& opt)
 {
-public:
-    ExtractorPrivate(const Net* _net)
-        : net(_net)
+    if (opt.use_packing_layout && (type == 0) && feat.elempack != 1)
+    {
+        Mat bottom_blob_unpacked;
+        convert_packing(feat, bottom_blob_unpacked, 1, opt);
+        feat = bottom_blob_unpacked;
+        if (feat.empty())
+            return -100;
+    }
+
+    // clang-format off
+    // *INDENT-OFF*
+#if NCNN_ARM82
+    if (opt.use_fp16_storage && cpu_support_arm_asimdhp() && (type == 0))
+    {
+        if (feat.elembits() == 16)
+        {
+            Mat feat_fp32;
+            cast_float16_to_float32(feat, feat_fp32, opt);
+            feat = feat_fp32;
+        }
+    }
+    else
+#endif // NCNN_ARM82
+#if NCNN_VFPV4
+    if (opt.use_fp16_storage && !opt.use_bf16_storage && cpu_support_arm_vfpv4() && (type == 0))
+    {
+        if (feat.elembits() == 16)
+        {
+            Mat feat_fp32;
+            cast_float16_to_float32(feat, feat_fp32, opt);
+            feat = feat_fp32;
+        }
+    }
+    else
+#endif // NCNN_VFPV4
+#if NCNN_RVV
+    if (opt.use_fp16_storage && cpu_support_riscv_v() && cpu_support_riscv_zfh() && (type == 0))
+    {
+        if (feat.elembits() == 16)
+        {
+            Mat feat_fp32;
+            cast_float16_to_float32(feat, feat_fp32, opt);
+            feat = feat_fp32;
+        }
+    }
+    else
+#endif // NCNN_RVV
+#if NCNN_F16C
+    if (opt.use_fp16_storage && !opt.use_bf16_storage && opt.use_x86_fp16_storage && cpu_support_x86_f16c() && (type == 0))
+    {
+        if (feat.elembits() == 16)
+        {
+            Mat feat_fp32;
+            cast_float16_to_float32(feat, feat_fp32, opt);
+            feat = feat_fp32;
+        }
+    }
+    else
+#endif // NCNN_F16C
+#if NCNN_BF16
+    if (opt.use_bf16_storage && (type == 0))
+    {
+        if (feat.elembits() == 16)
+        {
+            Mat feat_fp32;
+            cast_bfloat16_to_float32(feat, feat_fp32, opt);
+            feat = feat_fp32;
+        }
+    }
+    else
+#endif // NCNN_BF16
+    if (feat.elembits() == 8 && (type == 0))
+    {
+        Mat feat_fp32;
+        cast_int8_to_float32(feat, feat_fp32, opt);
+        feat = feat_fp32;
+    }
+    // *INDENT-ON*
+    // clang-format on
+    if (feat.empty())
+        return -100;
+
+    return 0;
+}
+
+class ExtractorPrivate
+{
+public:
+    ExtractorPrivate(const Net* _net)
+        : net(_net)
     {
     }
     const Net* net;
     std::vector<Mat> blob_mats;
     Option opt;
 
+    // one blob_mats for each sample
+    std::vector<std::vector<Mat> > batch_blob_mats;
+
+    PlannedAllocator* local_planned_allocator;
+
+    bool profiling;
+    std::vector<LayerProfile> layer_profiles;
+    std::vector<LayerProfileAllocator*> profile_workspace_allocators;
+
 #if NCNN_VULKAN
     VkAllocator* local_blob_vkallocator;
     VkAllocator* local_staging_vkallocator;
@@ -2427,11 +4556,26 @@ public:
 #endif // NCNN_VULKAN
 };
 
+static void feed_empty_state(const NetPrivate* d, std::vector<Mat>& blob_mats)
+{
+    for (size_t i = 0; i < d->state_blob_indexes.size(); i++)
+    {
+        const int blob_index = d->state_blob_indexes[i];
+        if (blob_mats[blob_index].dims != 0)
+            continue;
+
+        // zero length sequence, or zero history for streaming layers
+        blob_mats[blob_index] = Mat(0, 0, (size_t)4u);
+    }
+}
+
 Extractor::Extractor(const Net* _net, size_t blob_count)
     : d(new ExtractorPrivate(_net))
 {
     d->blob_mats.resize(blob_count);
     d->opt = d->net->opt;
+    d->local_planned_allocator = 0;
+    d->profiling = false;
 
 #if NCNN_VULKAN
     if (d->net->opt.use_vulkan_compute)
@@ -2449,6 +4593,11 @@ Extractor::~Extractor()
 {
     clear();
 
+    for (size_t i = 0; i < d->profile_workspace_allocators.size(); i++)
+    {
+        delete d->profile_workspace_allocators[i];
+    }
+
     delete d;
 }
 
@@ -2457,7 +4606,18 @@ Extractor::Extractor(const Extractor& rhs)
 {
     d->net = rhs.d->net;
     d->blob_mats = rhs.d->blob_mats;
+    d->batch_blob_mats = rhs.d->batch_blob_mats;
     d->opt = rhs.d->opt;
+    d->local_planned_allocator = 0;
+    d->profiling = rhs.d->profiling;
+    d->layer_profiles = rhs.d->layer_profiles;
+
+    if (rhs.d->local_planned_allocator)
+    {
+        // the planned allocator belongs to rhs only
+        d->opt.blob_allocator = d->net->opt.blob_allocator;
+        d->opt.workspace_allocator = d->net->opt.workspace_allocator;
+    }
 
 #if NCNN_VULKAN
     d->local_blob_vkallocator = 0;
@@ -2473,9 +4633,21 @@ Extractor& Extractor::operator=(const Extractor& rhs)
     if (this == &rhs)
         return *this;
 
+    clear();
+
     d->net = rhs.d->net;
     d->blob_mats = rhs.d->blob_mats;
+    d->batch_blob_mats = rhs.d->batch_blob_mats;
     d->opt = rhs.d->opt;
+    d->profiling = rhs.d->profiling;
+    d->layer_profiles = rhs.d->layer_profiles;
+
+    if (rhs.d->local_planned_allocator)
+    {
+        // the planned allocator belongs to rhs only
+        d->opt.blob_allocator = d->net->opt.blob_allocator;
+        d->opt.workspace_allocator = d->net->opt.workspace_allocator;
+    }
 
 #if NCNN_VULKAN
     d->local_blob_vkallocator = 0;
@@ -2491,6 +4663,18 @@ Extractor& Extractor::operator=(const Extractor& rhs)
 void Extractor::clear()
 {
     d->blob_mats.clear();
+    d->batch_blob_mats.clear();
+
+    if (d->local_planned_allocator)
+    {
+        // all blobs returned, the recorded session is complete now
+        d->local_planned_allocator->plan();
+        d->net->d->reclaim_planned_allocator(d->local_planned_allocator);
+        d->local_planned_allocator = 0;
+
+        d->opt.blob_allocator = d->net->opt.blob_allocator;
+        d->opt.workspace_allocator = d->net->opt.workspace_allocator;
+    }
 
 #if NCNN_VULKAN
     if (d->opt.use_vulkan_compute)
@@ -2531,6 +4715,19 @@ void Extractor::set_workspace_allocator(Allocator* allocator)
     d->opt.workspace_allocator = allocator;
 }
 
+void Extractor::set_profiling(bool enable)
+{
+    d->profiling = enable;
+
+    if (enable)
+        d->layer_profiles.clear();
+}
+
+const std::vector<LayerProfile>& Extractor::layer_profiles() const
+{
+    return d->layer_profiles;
+}
+
 #if NCNN_VULKAN
 void Extractor::set_vulkan_compute(bool enable)
 {
@@ -2590,6 +4787,42 @@ int Extractor::extract(const char* blob_name, Mat& feat, int type)
 
     return extract(blob_index, feat, type);
 }
+
+int Extractor::input_batch(const char* blob_name, const std::vector<Mat>& ins)
+{
+    int blob_index = d->net->find_blob_index_by_name(blob_name);
+    if (blob_index == -1)
+    {
+        NCNN_LOGE("Try");
+        const std::vector<const char*>& input_names = d->net->input_names();
+        for (size_t i = 0; i < input_names.size(); i++)
+        {
+            NCNN_LOGE("    ex.input_batch(\"%s\", ins%d);", input_names[i], (int)i);
+        }
+
+        return -1;
+    }
+
+    return input_batch(blob_index, ins);
+}
+
+int Extractor::extract_batch(const char* blob_name, std::vector<Mat>& feats, int type)
+{
+    int blob_index = d->net->find_blob_index_by_name(blob_name);
+    if (blob_index == -1)
+    {
+        NCNN_LOGE("Try");
+        const std::vector<const char*>& output_names = d->net->output_names();
+        for (size_t i = 0; i < output_names.size(); i++)
+        {
+            NCNN_LOGE("    ex.extract_batch(\"%s\", outs%d);", output_names[i], (int)i);
+        }
+
+        return -1;
+    }
+
+    return extract_batch(blob_index, feats, type);
+}
 #endif // NCNN_STRING
 
 int Extractor::input(int blob_index, const Mat& in)
@@ -2613,12 +4846,32 @@ int Extractor::extract(int blob_index, Mat& feat, int type)
     int old_flush_denormals = get_flush_denormals();
     set_flush_denormals(d->opt.flush_denormals);
 
+    // record every cpu layer run by this call
+    LayerProfileSink profile_sink(&d->layer_profiles, &d->profile_workspace_allocators);
+    LayerProfileScope profile_scope(d->profiling ? &profile_sink : 0);
+
     int ret = 0;
 
     if (d->blob_mats[blob_index].dims == 0)
     {
         int layer_index = d->net->blobs()[blob_index].producer;
 
+        // start without kv cache and streaming history unless they were set
+        feed_empty_state(d->net->d, d->blob_mats);
+
+        // use planned allocator
+        if (d->opt.use_memory_planner && !d->opt.use_vulkan_compute && !d->local_planned_allocator)
+        {
+            if (!d->opt.blob_allocator && !d->opt.workspace_allocator)
+            {
+                d->local_planned_allocator = d->net->d->acquire_planned_allocator();
+                d->local_planned_allocator->rewind();
+
+                d->opt.blob_allocator = d->local_planned_allocator;
+                d->opt.workspace_allocator = d->local_planned_allocator;
+            }
+        }
+
         // use local allocator
         if (d->opt.use_local_pool_allocator)
         {
@@ -2714,10 +4967,16 @@ int Extractor::extract(int blob_index, Mat& feat, int type)
         }
         else
         {
-            ret = d->net->d->forward_layer(layer_index, d->blob_mats, d->opt);
+            if (d->opt.use_branch_parallel)
+                ret = d->net->d->forward_layer_parallel(layer_index, d->blob_mats, d->opt);
+            else
+                ret = d->net->d->forward_layer(layer_index, d->blob_mats, d->opt);
         }
 #else
-        ret = d->net->d->forward_layer(layer_index, d->blob_mats, d->opt);
+        if (d->opt.use_branch_parallel)
+            ret = d->net->d->forward_layer_parallel(layer_index, d->blob_mats, d->opt);
+        else
+            ret = d->net->d->forward_layer(layer_index, d->blob_mats, d->opt);
 #endif // NCNN_VULKAN
     }
 
@@ -2726,74 +4985,120 @@ int Extractor::extract(int blob_index, Mat& feat, int type)
     // empty is valid for outputs
     if (!feat.empty())
     {
-        if (d->opt.use_packing_layout && (type == 0) && feat.elempack != 1)
+        if (convert_output_layout(feat, type, d->opt) != 0)
+            return -100;
+
+        if (d->opt.use_local_pool_allocator && feat.allocator == d->net->d->local_blob_allocator)
         {
-            Mat bottom_blob_unpacked;
-            convert_packing(feat, bottom_blob_unpacked, 1, d->opt);
-            feat = bottom_blob_unpacked;
+            // detach the returned mat from local pool allocator
+            // so we could destroy net instance much earlier
+            feat = feat.clone();
             if (feat.empty())
                 return -100;
         }
 
-        // clang-format off
-        // *INDENT-OFF*
-#if NCNN_ARM82
-        if (d->opt.use_fp16_storage && cpu_support_arm_asimdhp() && (type == 0))
-        {
-            if (feat.elembits() == 16)
-            {
-                Mat feat_fp32;
-                cast_float16_to_float32(feat, feat_fp32, d->opt);
-                feat = feat_fp32;
-            }
-        }
-        else
-#endif // NCNN_ARM82
-#if NCNN_VFPV4
-        if (d->opt.use_fp16_storage && !d->opt.use_bf16_storage && cpu_support_arm_vfpv4() && (type == 0))
+        if (d->local_planned_allocator && feat.allocator == d->local_planned_allocator)
         {
-            if (feat.elembits() == 16)
-            {
-                Mat feat_fp32;
-                cast_float16_to_float32(feat, feat_fp32, d->opt);
-                feat = feat_fp32;
-            }
+            // detach the returned mat from planned allocator
+            // the arena is overwritten by the next extraction
+            feat = feat.clone();
+            if (feat.empty())
+                return -100;
         }
-        else
-#endif // NCNN_VFPV4
-#if NCNN_RVV
-        if (d->opt.use_fp16_storage && cpu_support_riscv_v() && cpu_support_riscv_zfh() && (type == 0))
+    }
+
+    set_kmp_blocktime(old_blocktime);
+    set_flush_denormals(old_flush_denormals);
+
+    return ret;
+}
+
+int Extractor::input_batch(int blob_index, const std::vector<Mat>& ins)
+{
+    if (blob_index < 0 || blob_index >= (int)d->blob_mats.size())
+        return -1;
+
+    if (ins.empty())
+        return -1;
+
+    if (d->batch_blob_mats.empty())
+    {
+        d->batch_blob_mats.resize(ins.size(), std::vector<Mat>(d->blob_mats.size()));
+    }
+
+    if (d->batch_blob_mats.size() != ins.size())
+    {
+        NCNN_LOGE("input_batch got %d samples but the batch size is %d", (int)ins.size(), (int)d->batch_blob_mats.size());
+        return -1;
+    }
+
+    for (size_t i = 0; i < ins.size(); i++)
+    {
+        d->batch_blob_mats[i][blob_index] = ins[i];
+    }
+
+    return 0;
+}
+
+int Extractor::extract_batch(int blob_index, std::vector<Mat>& feats, int type)
+{
+    if (blob_index < 0 || blob_index >= (int)d->blob_mats.size())
+        return -1;
+
+    if (d->batch_blob_mats.empty())
+    {
+        NCNN_LOGE("extract_batch without input_batch");
+        return -1;
+    }
+
+    if (d->opt.use_vulkan_compute)
+    {
+        NCNN_LOGE("extract_batch is not supported with vulkan compute");
+        return -1;
+    }
+
+    int old_blocktime = get_kmp_blocktime();
+    set_kmp_blocktime(d->opt.openmp_blocktime);
+
+    int old_flush_denormals = get_flush_denormals();
+    set_flush_denormals(d->opt.flush_denormals);
+
+    int ret = 0;
+
+    if (d->batch_blob_mats[0][blob_index].dims == 0)
+    {
+        int layer_index = d->net->blobs()[blob_index].producer;
+
+        // use local allocator
+        if (d->opt.use_local_pool_allocator)
         {
-            if (feat.elembits() == 16)
+            if (!d->opt.blob_allocator)
             {
-                Mat feat_fp32;
-                cast_float16_to_float32(feat, feat_fp32, d->opt);
-                feat = feat_fp32;
+                d->opt.blob_allocator = d->net->d->local_blob_allocator;
             }
-        }
-        else
-#endif // NCNN_RVV
-#if NCNN_BF16
-        if (d->opt.use_bf16_storage && (type == 0))
-        {
-            if (feat.elembits() == 16)
+            if (!d->opt.workspace_allocator)
             {
-                Mat feat_fp32;
-                cast_bfloat16_to_float32(feat, feat_fp32, d->opt);
-                feat = feat_fp32;
+                d->opt.workspace_allocator = d->net->d->local_workspace_allocator;
             }
         }
-        else
-#endif // NCNN_BF16
-        if (feat.elembits() == 8 && (type == 0))
-        {
-            Mat feat_fp32;
-            cast_int8_to_float32(feat, feat_fp32, d->opt);
-            feat = feat_fp32;
-        }
-        // *INDENT-ON*
-        // clang-format on
+
+        ret = d->net->d->forward_layer_batch(layer_index, d->batch_blob_mats, d->opt);
+    }
+
+    const size_t batch = d->batch_blob_mats.size();
+
+    feats.resize(batch);
+    for (size_t i = 0; i < batch; i++)
+    {
+        Mat& feat = feats[i];
+
+        feat = d->batch_blob_mats[i][blob_index];
+
+        // empty is valid for outputs
         if (feat.empty())
+            continue;
+
+        if (convert_output_layout(feat, type, d->opt) != 0)
             return -100;
 
         if (d->opt.use_local_pool_allocator && feat.allocator == d->net->d->local_blob_allocator)
@@ -2812,6 +5117,68 @@ int Extractor::extract(int blob_index, Mat& feat, int type)
     return ret;
 }
 
+int Extractor::set_kv_cache(const std::vector<Mat>& kv_cache)
+{
+    const std::vector<Layer*>& layers = d->net->layers();
+
+    size_t kv_cache_count = 0;
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        if (is_kv_cache_layer(d->net->d, (int)i))
+            kv_cache_count += 2;
+    }
+
+    if (kv_cache.size() != kv_cache_count)
+    {
+        NCNN_LOGE("set_kv_cache got %d mats but the net needs %d", (int)kv_cache.size(), (int)kv_cache_count);
+        return -1;
+    }
+
+    size_t j = 0;
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        const Layer* layer = layers[i];
+        if (!is_kv_cache_layer(d->net->d, (int)i))
+            continue;
+
+        const size_t bottom_count = layer->bottoms.size();
+        d->blob_mats[layer->bottoms[bottom_count - 2]] = kv_cache[j].empty() ? Mat(0, 0, (size_t)4u) : kv_cache[j];
+        d->blob_mats[layer->bottoms[bottom_count - 1]] = kv_cache[j + 1].empty() ? Mat(0, 0, (size_t)4u) : kv_cache[j + 1];
+        j += 2;
+    }
+
+    return 0;
+}
+
+int Extractor::get_kv_cache(std::vector<Mat>& kv_cache)
+{
+    const std::vector<Layer*>& layers = d->net->layers();
+
+    kv_cache.clear();
+
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        const Layer* layer = layers[i];
+        if (!is_kv_cache_layer(d->net->d, (int)i))
+            continue;
+
+        Mat xk;
+        int ret = extract(layer->tops[1], xk);
+        if (ret != 0)
+            return ret;
+
+        Mat xv;
+        ret = extract(layer->tops[2], xv);
+        if (ret != 0)
+            return ret;
+
+        kv_cache.push_back(xk);
+        kv_cache.push_back(xv);
+    }
+
+    return 0;
+}
+
 #if NCNN_VULKAN
 #if NCNN_STRING
 int Extractor::input(const char* blob_name, const VkMat& in)
@@ -2994,4 +5361,355 @@ int Extractor::extract(int blob_index, VkImageMat& feat, VkCompute& cmd)
 }
 #endif // NCNN_VULKAN
 
+
+class SessionPrivate
+{
+public:
+    SessionPrivate(const Net* _net)
+        : net(_net)
+    {
+    }
+    const Net* net;
+    std::vector<Mat> blob_mats;
+    Option opt;
+
+    PlannedAllocator* local_planned_allocator;
+
+    int old_blocktime;
+    int old_flush_denormals;
+
+    // recurrent state fed from state_tops[i] of the previous frame to state_bottoms[i]
+    std::vector<int> state_layers;
+    std::vector<int> state_bottoms;
+    std::vector<int> state_tops;
+    std::vector<Mat> states;
+
+    bool started;
+    bool extracted;
+
+    void collect_state_pairs(const NetPrivate* net_d);
+    Mat zero_state(int i) const;
+    void begin_frame();
+};
+
+void SessionPrivate::collect_state_pairs(const NetPrivate* net_d)
+{
+    const std::vector<Layer*>& layers = net->layers();
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        const Layer* layer = layers[i];
+
+        const size_t bottom_count = layer->bottoms.size();
+        const size_t top_count = layer->tops.size();
+
+        size_t first_state = 0;
+        if (layer->typeindex == LayerType::LSTM && bottom_count == 3 && top_count == 3)
+            first_state = 1;
+        else if ((layer->typeindex == LayerType::GRU || layer->typeindex == LayerType::RNN) && bottom_count == 2 && top_count == 2)
+            first_state = 1;
+        else if (is_kv_cache_layer(net_d, (int)i))
+            first_state = bottom_count - 2;
+        else if (is_streaming_layer(layer))
+            first_state = 1;
+        else
+            continue;
+
+        for (size_t j = first_state; j < bottom_count; j++)
+        {
+            const int blob_index = layer->bottoms[j];
+
+            // only graph inputs carry state, other producers compute it every frame
+            const int producer = net->blobs()[blob_index].producer;
+            if (producer < 0 || layers[producer]->typeindex != LayerType::Input)
+                continue;
+
+            state_layers.push_back((int)i);
+            state_bottoms.push_back(blob_index);
+            state_tops.push_back(layer->tops[top_count - (bottom_count - j)]);
+        }
+    }
+
+    states.resize(state_bottoms.size());
+}
+
+Mat SessionPrivate::zero_state(int i) const
+{
+    const Layer* layer = net->layers()[state_layers[i]];
+    const int blob_index = state_bottoms[i];
+
+    if (layer->typeindex == LayerType::LSTM)
+    {
+        const LSTM* lstm = static_cast<const LSTM*>(layer);
+        const int num_directions = lstm->direction == 2 ? 2 : 1;
+
+        // hidden state is num_output wide, cell state is hidden_size wide
+        const int w = blob_index == layer->bottoms[1] ? lstm->num_output : lstm->hidden_size;
+
+        Mat m(w, num_directions, (size_t)4u);
+        m.fill(0.f);
+        return m;
+    }
+
+    if (layer->typeindex == LayerType::GRU)
+    {
+        const GRU* gru = static_cast<const GRU*>(layer);
+        const int num_directions = gru->direction == 2 ? 2 : 1;
+
+        Mat m(gru->num_output, num_directions, (size_t)4u);
+        m.fill(0.f);
+        return m;
+    }
+
+    if (layer->typeindex == LayerType::RNN)
+    {
+        const RNN* rnn = static_cast<const RNN*>(layer);
+        const int num_directions = rnn->direction == 2 ? 2 : 1;
+
+        Mat m(rnn->num_output, num_directions, (size_t)4u);
+        m.fill(0.f);
+        return m;
+    }
+
+    // kv cache starts from zero length sequence, streaming layers from zero history
+    return Mat(0, 0, (size_t)4u);
+}
+
+void SessionPrivate::begin_frame()
+{
+    if (extracted)
+    {
+        // carry the state outputs computed by the previous frame
+        Option opt_heap = opt;
+        opt_heap.blob_allocator = 0;
+        opt_heap.workspace_allocator = 0;
+
+        for (size_t i = 0; i < state_tops.size(); i++)
+        {
+            Mat m = blob_mats[state_tops[i]];
+            if (m.dims == 0)
+                continue;
+
+            convert_output_layout(m, 0, opt_heap);
+
+            // detach from the arena before it is rewound
+            states[i] = m.allocator ? m.clone() : m;
+        }
+    }
+
+    for (size_t i = 0; i < blob_mats.size(); i++)
+    {
+        blob_mats[i].release();
+    }
+
+    if (local_planned_allocator)
+    {
+        // the first frame records, the following frames replay the arena
+        local_planned_allocator->rewind();
+    }
+
+    started = true;
+    extracted = false;
+}
+
+Session::Session(const Net* _net)
+    : d(new SessionPrivate(_net))
+{
+    d->blob_mats.resize(d->net->blobs().size());
+    d->opt = d->net->opt;
+    d->local_planned_allocator = 0;
+    d->started = false;
+    d->extracted = false;
+
+    if (d->opt.use_vulkan_compute)
+    {
+        NCNN_LOGE("Session does not support vulkan compute yet");
+    }
+
+    // resolve allocators once for all frames
+    if (d->opt.use_memory_planner && !d->opt.use_vulkan_compute)
+    {
+        if (!d->opt.blob_allocator && !d->opt.workspace_allocator)
+        {
+            d->local_planned_allocator = d->net->d->acquire_planned_allocator();
+
+            d->opt.blob_allocator = d->local_planned_allocator;
+            d->opt.workspace_allocator = d->local_planned_allocator;
+        }
+    }
+
+    if (d->opt.use_local_pool_allocator)
+    {
+        if (!d->opt.blob_allocator)
+        {
+            d->opt.blob_allocator = d->net->d->local_blob_allocator;
+        }
+        if (!d->opt.workspace_allocator)
+        {
+            d->opt.workspace_allocator = d->net->d->local_workspace_allocator;
+        }
+    }
+
+    d->old_blocktime = get_kmp_blocktime();
+    set_kmp_blocktime(d->opt.openmp_blocktime);
+
+    d->old_flush_denormals = get_flush_denormals();
+    set_flush_denormals(d->opt.flush_denormals);
+
+    d->collect_state_pairs(d->net->d);
+}
+
+Session::~Session()
+{
+    d->blob_mats.clear();
+    d->states.clear();
+
+    if (d->local_planned_allocator)
+    {
+        d->local_planned_allocator->plan();
+        d->net->d->reclaim_planned_allocator(d->local_planned_allocator);
+        d->local_planned_allocator = 0;
+    }
+
+    set_kmp_blocktime(d->old_blocktime);
+    set_flush_denormals(d->old_flush_denormals);
+
+    delete d;
+}
+
+Session::Session(const Session&)
+    : d(0)
+{
+}
+
+Session& Session::operator=(const Session&)
+{
+    return *this;
+}
+
+void Session::reset()
+{
+    for (size_t i = 0; i < d->states.size(); i++)
+    {
+        d->states[i].release();
+    }
+
+    for (size_t i = 0; i < d->blob_mats.size(); i++)
+    {
+        d->blob_mats[i].release();
+    }
+
+    d->started = false;
+    d->extracted = false;
+}
+
+#if NCNN_STRING
+int Session::input(const char* blob_name, const Mat& in)
+{
+    int blob_index = d->net->find_blob_index_by_name(blob_name);
+    if (blob_index == -1)
+    {
+        NCNN_LOGE("Try");
+        const std::vector<const char*>& input_names = d->net->input_names();
+        for (size_t i = 0; i < input_names.size(); i++)
+        {
+            NCNN_LOGE("    session.input(\"%s\", in%d);", input_names[i], (int)i);
+        }
+
+        return -1;
+    }
+
+    return input(blob_index, in);
+}
+
+int Session::extract(const char* blob_name, Mat& feat, int type)
+{
+    int blob_index = d->net->find_blob_index_by_name(blob_name);
+    if (blob_index == -1)
+    {
+        NCNN_LOGE("Try");
+        const std::vector<const char*>& output_names = d->net->output_names();
+        for (size_t i = 0; i < output_names.size(); i++)
+        {
+            NCNN_LOGE("    session.extract(\"%s\", out%d);", output_names[i], (int)i);
+        }
+
+        return -1;
+    }
+
+    return extract(blob_index, feat, type);
+}
+#endif // NCNN_STRING
+
+int Session::input(int blob_index, const Mat& in)
+{
+    if (blob_index < 0 || blob_index >= (int)d->blob_mats.size())
+        return -1;
+
+    if (!d->started || d->extracted)
+        d->begin_frame();
+
+    d->blob_mats[blob_index] = in;
+
+    return 0;
+}
+
+int Session::extract(int blob_index, Mat& feat, int type)
+{
+    if (blob_index < 0 || blob_index >= (int)d->blob_mats.size())
+        return -1;
+
+    if (d->opt.use_vulkan_compute)
+        return -1;
+
+    if (!d->started)
+        d->begin_frame();
+
+    int ret = 0;
+
+    if (d->blob_mats[blob_index].dims == 0)
+    {
+        // state inputs not set explicitly come from the previous frame
+        for (size_t i = 0; i < d->state_bottoms.size(); i++)
+        {
+            Mat& m = d->blob_mats[d->state_bottoms[i]];
+            if (m.dims != 0)
+                continue;
+
+            if (d->states[i].dims == 0)
+                d->states[i] = d->zero_state((int)i);
+
+            m = d->states[i];
+        }
+
+        int layer_index = d->net->blobs()[blob_index].producer;
+
+        if (d->opt.use_branch_parallel)
+            ret = d->net->d->forward_layer_parallel(layer_index, d->blob_mats, d->opt);
+        else
+            ret = d->net->d->forward_layer(layer_index, d->blob_mats, d->opt);
+    }
+
+    d->extracted = true;
+
+    feat = d->blob_mats[blob_index];
+
+    // empty is valid for outputs
+    if (!feat.empty())
+    {
+        if (convert_output_layout(feat, type, d->opt) != 0)
+            return -100;
+
+        if ((d->opt.use_local_pool_allocator && feat.allocator == d->net->d->local_blob_allocator)
+                || (d->local_planned_allocator && feat.allocator == d->local_planned_allocator))
+        {
+            // the arena and pool are reused by the next frame
+            feat = feat.clone();
+            if (feat.empty())
+                return -100;
+        }
+    }
+
+    return ret;
+}
+
 } // namespace ncnn
@@ -15,6 +15,7 @@
 #ifndef NCNN_NET_H
 #define NCNN_NET_H
 
+#include "benchmark.h"
 #include "blob.h"
 #include "layer.h"
 #include "mat.h"
@@ -34,6 +35,7 @@ class VkCompute;
 #endif // NCNN_VULKAN
 class DataReader;
 class Extractor;
+class Session;
 class NetPrivate;
 class NCNN_EXPORT Net
 {
@@ -92,6 +94,40 @@ public:
     // return 0 if success
     int load_model(FILE* fp);
     int load_model(const char* modelpath);
+
+    // map network weight data from model file
+    // weight data is referenced from the mapping instead of copied where possible
+    // the mapping is retained until the net is cleared
+    // return 0 if success
+    int load_model_mmap(const char* modelpath);
+
+    // save the weight data transformed by create_pipeline of each layer
+    // call after load_model, cpu inference only
+    // the weights must have been hashed, see set_pipeline_data_cache_saving
+    // return 0 if success
+    int save_pipeline_data_cache(const char* cachepath) const;
+
+    // hash the weight data in the following load_model so that save_pipeline_data_cache can bind the cache to it
+    // weights are only hashed otherwise when a pipeline data cache is loaded
+    void set_pipeline_data_cache_saving(bool enabled);
+
+    // use the weight data saved by save_pipeline_data_cache in the following load_model
+    // so that layers skip weight transform in create_pipeline
+    // call after load_param with the same option, the cache is rejected if cpu, option, graph or param differs
+    // layers whose weight differs from the cached one transform weights again
+    // return 0 if success
+    int load_pipeline_data_cache(const char* cachepath);
+
+    // save the kernel choice each layer tuned for the input shapes run so far
+    // run inference with opt.use_kernel_autotune beforehand to record the measured best
+    // return 0 if success
+    int save_kernel_profile(const char* profilepath) const;
+
+    // use the kernel choice saved by save_kernel_profile in the following load_model
+    // call after load_param, the profile is rejected if cpu, graph or param differs
+    // the loaded choice is final, opt.use_kernel_autotune does not tune these layers again
+    // return 0 if success
+    int load_kernel_profile(const char* profilepath);
 #endif // NCNN_STDIO
 
     // load network structure from external memory
@@ -129,6 +165,11 @@ public:
     // construct an Extractor from network
     Extractor create_extractor() const;
 
+    // peak bytes of the arena planned with opt.use_memory_planner
+    // the first extraction only records blob lifetimes, the arena is planned when its extractor is cleared or destroyed
+    // return 0 until then
+    size_t planned_arena_size() const;
+
     // get input/output indexes/names
     const std::vector<int>& input_indexes() const;
     const std::vector<int>& output_indexes() const;
@@ -145,6 +186,7 @@ public:
 
 protected:
     friend class Extractor;
+    friend class Session;
 #if NCNN_STRING
     int find_blob_index_by_name(const char* name) const;
     int find_layer_index_by_name(const char* name) const;
@@ -192,6 +234,14 @@ public:
     // set workspace memory allocator
     void set_workspace_allocator(Allocator* allocator);
 
+    // record wall time, shapes, allocation and kernel path of every cpu layer
+    // forward in the following extract calls
+    // enabling drops the records collected before
+    void set_profiling(bool enable);
+
+    // profiling records in completion order
+    const std::vector<LayerProfile>& layer_profiles() const;
+
 #if NCNN_VULKAN
     // deprecated, no-op
     // instead, set net.opt.use_vulkan_compute before net.load_param()
@@ -226,6 +276,38 @@ public:
     // type = 1, do not convert fp16/bf16 or / and packing
     int extract(int blob_index, Mat& feat, int type = 0);
 
+#if NCNN_STRING
+    // set batched input by blob name, one mat for each sample
+    // all batched inputs must have the same sample count
+    // return 0 if success
+    int input_batch(const char* blob_name, const std::vector<Mat>& ins);
+
+    // get batched result by blob name, one mat for each sample
+    // layers run one after another over the whole batch so weights stay in cache
+    // innerproduct, gemm with constant B and 1x1 stride 1 convolution run the batch as one gemm
+    // other layers run the samples one by one
+    // return 0 if success
+    int extract_batch(const char* blob_name, std::vector<Mat>& feats, int type = 0);
+#endif // NCNN_STRING
+
+    // set batched input by blob index
+    // return 0 if success
+    int input_batch(int blob_index, const std::vector<Mat>& ins);
+
+    // get batched result by blob index
+    // return 0 if success
+    int extract_batch(int blob_index, std::vector<Mat>& feats, int type = 0);
+
+    // set the past xk and xv of every multiheadattention with kv cache, two mats for each in layer order
+    // pass empty mats or skip this call for the first step
+    // return 0 if success
+    int set_kv_cache(const std::vector<Mat>& kv_cache);
+
+    // get the updated xk and xv of every multiheadattention with kv cache, two mats for each in layer order
+    // feed them to set_kv_cache of the extractor for the next step
+    // return 0 if success
+    int get_kv_cache(std::vector<Mat>& kv_cache);
+
 #if NCNN_VULKAN
 #if NCNN_STRING
     // set input by blob name
@@ -270,6 +352,54 @@ private:
     ExtractorPrivate* const d;
 };
 
+class SessionPrivate;
+class NCNN_EXPORT Session
+{
+public:
+    // run the net frame after frame with the same shapes
+    // allocators, openmp blocktime and denormal flushing are resolved once,
+    // the blob storage of the first frame is planned and reused by the following frames,
+    // and the state outputs of recurrent layers are fed back as their state inputs
+    // state inputs are the extra inputs of lstm gru rnn, multiheadattention with kv cache
+    // and streaming convolution1d convolutiondepthwise1d pooling1d
+    // that come from Input layers, they start from zero
+    // a session must be used from one thread and destroyed before the net
+    Session(const Net* net);
+    virtual ~Session();
+
+    // drop the recurrent state, the next frame starts from zero state
+    void reset();
+
+#if NCNN_STRING
+    // set input of the current frame by blob name
+    // the first input after extract starts a new frame
+    // return 0 if success
+    int input(const char* blob_name, const Mat& in);
+
+    // get result of the current frame by blob name
+    // return 0 if success
+    // type = 0, default
+    // type = 1, do not convert fp16/bf16 or / and packing
+    int extract(const char* blob_name, Mat& feat, int type = 0);
+#endif // NCNN_STRING
+
+    // set input of the current frame by blob index
+    // the first input after extract starts a new frame
+    // return 0 if success
+    int input(int blob_index, const Mat& in);
+
+    // get result of the current frame by blob index
+    // return 0 if success
+    int extract(int blob_index, Mat& feat, int type = 0);
+
+private:
+    Session(const Session&);
+    Session& operator=(const Session&);
+
+private:
+    SessionPrivate* const d;
+};
+
 } // namespace ncnn
 
 #endif // NCNN_NET_H
@@ -77,6 +77,18 @@ Option::Option()
 
     use_fp16_uniform = true;
     use_int8_uniform = true;
+
+    use_memory_planner = false;
+    use_branch_parallel = false;
+    use_parallel_create_pipeline = false;
+    use_elementwise_fusion = false;
+    use_kernel_autotune = false;
+
+    use_x86_fp16_storage = false;
+    use_x86_fp16_arithmetic = false;
+
+    use_reserved_10 = false;
+    use_reserved_11 = false;
 }
 
 } // namespace ncnn
@@ -148,7 +148,49 @@ public:
     bool use_fp16_uniform;
     bool use_int8_uniform;
 
-    bool use_reserved_9;
+    // the following flags are packed into one byte of the former reserved fields
+    // so that the size and layout of Option stay binary compatible
+    // bit fields have no member pointer, bindings access them through getter and setter
+
+    // enable static memory planning for cpu inference
+    // the first extraction records blob lifetimes, the following ones
+    // with the same input shapes reuse one preallocated arena
+    // intermediate blob and workspace allocation take no heap allocation then
+    bool use_memory_planner : 1;
+
+    // run independent graph branches concurrently on cpu
+    // the num_threads budget is split between the layers in flight
+    // the worker threads are kept by the net and reused across extractions
+    // blob and workspace allocator must be thread-safe when enabled
+    bool use_branch_parallel : 1;
+
+    // create layer pipelines on a pool of num_threads workers during load_model
+    // each worker transforms one layer at a time on a single thread
+    // the model bin is still read sequentially by the calling thread
+    // blob and workspace allocator must be thread-safe when enabled
+    bool use_parallel_create_pipeline : 1;
+
+    // collapse chains of elementwise layers into one FusedElementwise layer in load_param
+    // the fused chain reads its input once and writes its output once per tile
+    // intermediate blobs of the chain are computed only when extracted explicitly
+    bool use_elementwise_fusion : 1;
+
+    // time the candidate kernels of convolution and gemm once per input shape and keep the fastest
+    // all weight transform variants are prepared in create_pipeline, which costs extra memory
+    // the tuned choice is cached per layer and input shape, up to 64 shapes per layer
+    // without it nothing is cached, the kernel is picked by heuristics unless a kernel profile is loaded
+    bool use_kernel_autotune : 1;
+
+    // keep the weights of x86 convolution and gemm in fp16 via f16c, together with use_fp16_storage
+    // halves the weight memory, but the fp16 kernels are slower than the packed fp32 ones
+    // disabled by default
+    bool use_x86_fp16_storage : 1;
+
+    // multiply in fp16 on avx512_fp16 cpus in the x86 fp16 storage kernels, together with use_fp16_arithmetic
+    // activations beyond the fp16 range overflow
+    // disabled by default
+    bool use_x86_fp16_arithmetic : 1;
+
     bool use_reserved_10;
     bool use_reserved_11;
 };
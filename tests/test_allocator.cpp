@@ -0,0 +1,213 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "allocator.h"
+#include "mat.h"
+
+static int test_size_class_pool_allocator_reuse()
+{
+    ncnn::SizeClassPoolAllocator allocator;
+
+    void* ptr0 = allocator.fastMalloc(100);
+    if (!ptr0 || (size_t)ptr0 % NCNN_MALLOC_ALIGN != 0)
+    {
+        fprintf(stderr, "size class pool allocator returned unaligned block %p\n", ptr0);
+        return -1;
+    }
+
+    memset(ptr0, 0x5a, 100);
+    allocator.fastFree(ptr0);
+
+    // 100 bytes rounds up to the 128 bytes class
+    if (allocator.held_size() != 128)
+    {
+        fprintf(stderr, "size class pool allocator held_size %lu expect 128\n", (unsigned long)allocator.held_size());
+        return -1;
+    }
+
+    void* ptr1 = allocator.fastMalloc(120);
+    if (ptr1 != ptr0 || allocator.hit_count() != 1 || allocator.miss_count() != 1 || allocator.held_size() != 0)
+    {
+        fprintf(stderr, "size class pool allocator did not reuse the cached block\n");
+        return -1;
+    }
+
+    // a different class never hits
+    void* ptr2 = allocator.fastMalloc(1000);
+    if (ptr2 == ptr0 || allocator.miss_count() != 2)
+    {
+        fprintf(stderr, "size class pool allocator mixed size classes\n");
+        return -1;
+    }
+
+    allocator.fastFree(ptr1);
+    allocator.fastFree(ptr2);
+
+    allocator.clear();
+
+    if (allocator.held_size() != 0)
+    {
+        fprintf(stderr, "size class pool allocator clear failed\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int test_size_class_pool_allocator_mat()
+{
+    ncnn::SizeClassPoolAllocator allocator;
+
+    for (int i = 0; i < 10; i++)
+    {
+        ncnn::Mat a(17 + i, 13, 8, (size_t)4u, &allocator);
+        ncnn::Mat b(17 + i, 13, 8, (size_t)4u, &allocator);
+        a.fill(1.f);
+        b.fill(2.f);
+
+        const float* pa = a.channel(7);
+        const float* pb = b.channel(7);
+        if (pa[0] != 1.f || pb[0] != 2.f)
+        {
+            fprintf(stderr, "size class pool allocator mat data corrupted\n");
+            return -1;
+        }
+    }
+
+    if (allocator.hit_count() == 0)
+    {
+        fprintf(stderr, "size class pool allocator never hits for mat\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+#if NCNN_THREADS
+struct thread_args
+{
+    ncnn::SizeClassPoolAllocator* allocator;
+    int seed;
+    int malloc_count;
+    int ret;
+};
+
+static void* size_class_pool_allocator_worker(void* _args)
+{
+    thread_args* args = (thread_args*)_args;
+
+    unsigned int seed = args->seed;
+
+    void* ptrs[16] = {0};
+    size_t sizes[16] = {0};
+    for (int i = 0; i < 4000; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        const int j = (seed >> 8) % 16;
+
+        if (ptrs[j])
+        {
+            // check the pattern survived other threads
+            const unsigned char* p = (const unsigned char*)ptrs[j];
+            if (p[0] != (unsigned char)j || p[sizes[j] - 1] != (unsigned char)j)
+                args->ret = -1;
+
+            args->allocator->fastFree(ptrs[j]);
+            ptrs[j] = 0;
+        }
+        else
+        {
+            sizes[j] = 1 + (seed >> 12) % 5000;
+            ptrs[j] = args->allocator->fastMalloc(sizes[j]);
+            args->malloc_count++;
+            memset(ptrs[j], j, sizes[j]);
+        }
+    }
+
+    for (int j = 0; j < 16; j++)
+    {
+        args->allocator->fastFree(ptrs[j]);
+    }
+
+    return 0;
+}
+
+static int test_size_class_pool_allocator_threads()
+{
+    ncnn::SizeClassPoolAllocator allocator;
+
+    const int thread_count = 4;
+
+    std::vector<thread_args> args(thread_count);
+    std::vector<ncnn::Thread*> threads(thread_count);
+    for (int i = 0; i < thread_count; i++)
+    {
+        args[i].allocator = &allocator;
+        args[i].seed = 7767517 + i;
+        args[i].malloc_count = 0;
+        args[i].ret = 0;
+        threads[i] = new ncnn::Thread(size_class_pool_allocator_worker, &args[i]);
+    }
+
+    int ret = 0;
+    size_t malloc_count = 0;
+    for (int i = 0; i < thread_count; i++)
+    {
+        threads[i]->join();
+        delete threads[i];
+
+        if (args[i].ret != 0)
+            ret = -1;
+
+        malloc_count += args[i].malloc_count;
+    }
+
+    if (ret != 0)
+    {
+        fprintf(stderr, "size class pool allocator data corrupted across threads\n");
+        return -1;
+    }
+
+    if (allocator.hit_count() + allocator.miss_count() != malloc_count)
+    {
+        fprintf(stderr, "size class pool allocator lost count %lu %lu\n", (unsigned long)allocator.hit_count(), (unsigned long)allocator.miss_count());
+        return -1;
+    }
+
+    allocator.clear();
+
+    if (allocator.held_size() != 0)
+    {
+        fprintf(stderr, "size class pool allocator clear failed\n");
+        return -1;
+    }
+
+    return 0;
+}
+#else
+static int test_size_class_pool_allocator_threads()
+{
+    return 0;
+}
+#endif // NCNN_THREADS
+
+int main()
+{
+    return test_size_class_pool_allocator_reuse()
+           || test_size_class_pool_allocator_mat()
+           || test_size_class_pool_allocator_threads();
+}
@@ -213,9 +213,75 @@ static int test_convolution1d_1()
     return 0;
 }
 
+static int test_convolution1d_streaming(int w, int h, int outh, int kernel, int dilation, int stride, int bias)
+{
+    std::vector<ncnn::Mat> as(2);
+    as[0] = RandomMat(w, h);
+    as[1] = RandomMat(dilation * (kernel - 1), h);
+
+    ncnn::ParamDict pd;
+    pd.set(0, outh);     // num_output
+    pd.set(1, kernel);   // kernel_w
+    pd.set(2, dilation); // dilation_w
+    pd.set(3, stride);   // stride_w
+    pd.set(5, bias);     // bias_term
+    pd.set(6, outh * h * kernel);
+    pd.set(20, 1); // streaming
+
+    int activation_type = RAND() % 6; // 0 1 2 3 4 5
+    ncnn::Mat activation_params(2);
+    activation_params[0] = RandomFloat(-1, 0); // alpha
+    activation_params[1] = RandomFloat(0, 1);  // beta
+    pd.set(9, activation_type);
+    pd.set(10, activation_params);
+
+    std::vector<ncnn::Mat> weights(bias ? 2 : 1);
+    weights[0] = RandomMat(outh * h * kernel);
+    if (bias)
+        weights[1] = RandomMat(outh);
+
+    int ret = test_layer("Convolution1D", pd, weights, as, 2);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_convolution1d_streaming failed w=%d h=%d outh=%d kernel=%d dilation=%d stride=%d bias=%d act=%d actparams=[%f,%f]\n", w, h, outh, kernel, dilation, stride, bias, activation_type, activation_params[0], activation_params[1]);
+    }
+
+    return ret;
+}
+
+static int test_convolution1d_2()
+{
+    static const int kds[5][3] = {
+        {2, 1, 1},
+        {2, 1, 2},
+        {3, 1, 1},
+        {3, 2, 1},
+        {5, 1, 2},
+    };
+
+    for (int i = 0; i < 5; i++)
+    {
+        const int k = kds[i][0];
+        const int d = kds[i][1];
+        const int s = kds[i][2];
+
+        int ret = 0
+                  || test_convolution1d_streaming(4, 1, 1, k, d, s, 1)
+                  || test_convolution1d_streaming(4, 4, 13, k, d, s, 0)
+                  || test_convolution1d_streaming(8, 12, 12, k, d, s, 1)
+                  || test_convolution1d_streaming(2, 8, 16, k, d, s, 0)
+                  || test_convolution1d_streaming(6, 16, 8, k, d, s, 1);
+
+        if (ret != 0)
+            return -1;
+    }
+
+    return 0;
+}
+
 int main()
 {
     SRAND(7767517);
 
-    return test_convolution1d_0() || test_convolution1d_1();
+    return test_convolution1d_0() || test_convolution1d_1() || test_convolution1d_2();
 }
@@ -204,9 +204,48 @@ static int test_convolutiondepthwise1d_1()
     return 0;
 }
 
+static int test_convolutiondepthwise1d_streaming(int w, int h, int outh, int kernel, int dilation, int stride, int bias, int group)
+{
+    std::vector<ncnn::Mat> as(2);
+    as[0] = RandomMat(w, h);
+    as[1] = RandomMat(dilation * (kernel - 1), h);
+
+    ncnn::ParamDict pd;
+    pd.set(0, outh);     // num_output
+    pd.set(1, kernel);   // kernel_w
+    pd.set(2, dilation); // dilation_w
+    pd.set(3, stride);   // stride_w
+    pd.set(5, bias);     // bias_term
+    pd.set(6, outh / group * h / group * kernel * group);
+    pd.set(7, group);
+    pd.set(20, 1); // streaming
+
+    std::vector<ncnn::Mat> weights(bias ? 2 : 1);
+    weights[0] = RandomMat(outh / group * h / group * kernel * group);
+    if (bias)
+        weights[1] = RandomMat(outh);
+
+    int ret = test_layer("ConvolutionDepthWise1D", pd, weights, as, 2);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_convolutiondepthwise1d_streaming failed w=%d h=%d outh=%d kernel=%d dilation=%d stride=%d bias=%d group=%d\n", w, h, outh, kernel, dilation, stride, bias, group);
+    }
+
+    return ret;
+}
+
+static int test_convolutiondepthwise1d_2()
+{
+    return 0
+           || test_convolutiondepthwise1d_streaming(4, 8, 8, 3, 1, 1, 1, 8)
+           || test_convolutiondepthwise1d_streaming(4, 8, 8, 3, 2, 2, 0, 8)
+           || test_convolutiondepthwise1d_streaming(2, 16, 16, 5, 1, 1, 1, 16)
+           || test_convolutiondepthwise1d_streaming(6, 12, 12, 2, 1, 2, 1, 4);
+}
+
 int main()
 {
     SRAND(7767517);
 
-    return test_convolutiondepthwise1d_0() || test_convolutiondepthwise1d_1();
+    return test_convolutiondepthwise1d_0() || test_convolutiondepthwise1d_1() || test_convolutiondepthwise1d_2();
 }
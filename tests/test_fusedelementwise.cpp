@@ -0,0 +1,134 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "testutil.h"
+
+// op_type src0 src1 a b for each instruction, register 0 is the input
+static ncnn::Mat make_program(const float* data, int instruction_count)
+{
+    return ncnn::Mat(instruction_count * 5, (void*)data).clone();
+}
+
+static int test_fusedelementwise(const ncnn::Mat& a, const float* data, int instruction_count)
+{
+    ncnn::ParamDict pd;
+    pd.set(0, 1);
+    pd.set(1, make_program(data, instruction_count));
+
+    std::vector<ncnn::Mat> weights(0);
+
+    int ret = test_layer("FusedElementwise", pd, weights, a);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_fusedelementwise failed a.dims=%d a=(%d %d %d %d) instruction_count=%d\n", a.dims, a.w, a.h, a.d, a.c, instruction_count);
+    }
+
+    return ret;
+}
+
+// sigmoid(x) * x + 0.5
+static const float program_0[] = {
+    3, 0, 0, 0.f, 0.f,
+    1, 1, 0, 2.f, 0.f,
+    2, 2, 0, 0.f, 0.5f
+};
+
+// hardswish(clip(relu(x) * 2, -1, 3)) then tanh
+static const float program_1[] = {
+    4, 0, 0, 0.1f, 0.f,
+    2, 1, 0, 2.f, 2.f,
+    5, 2, 0, -1.f, 3.f,
+    8, 3, 0, 0.2f, 0.5f,
+    0, 4, 0, 16.f, 0.f
+};
+
+// x - max(x, gelu(x)) + elu(x) * mish(x) / (1 + hardsigmoid(x))
+static const float program_2[] = {
+    10, 0, 0, 0.f, 0.f,
+    10, 0, 0, 1.f, 0.f,
+    1, 1, 2, 4.f, 0.f,
+    1, 0, 3, 1.f, 0.f,
+    9, 0, 0, 0.1f, 0.f,
+    11, 0, 0, 0.f, 0.f,
+    1, 5, 6, 2.f, 0.f,
+    7, 0, 0, 0.2f, 0.5f,
+    2, 8, 0, 0.f, 1.f,
+    1, 7, 9, 3.f, 0.f,
+    1, 4, 10, 0.f, 0.f
+};
+
+// square(swish(abs(x))) + exp(-abs(x)) + log(abs(x) + 1)
+static const float program_3[] = {
+    0, 0, 0, 0.f, 0.f,
+    6, 1, 0, 0.f, 0.f,
+    0, 2, 0, 4.f, 0.f,
+    0, 1, 0, 1.f, 0.f,
+    0, 4, 0, 7.f, 0.f,
+    2, 1, 0, 0.f, 1.f,
+    0, 6, 0, 8.f, 0.f,
+    1, 3, 5, 0.f, 0.f,
+    1, 8, 7, 0.f, 0.f
+};
+
+static int test_fusedelementwise_programs(const ncnn::Mat& a)
+{
+    return 0
+           || test_fusedelementwise(a, program_0, 3)
+           || test_fusedelementwise(a, program_1, 5)
+           || test_fusedelementwise(a, program_2, 11)
+           || test_fusedelementwise(a, program_3, 9);
+}
+
+static int test_fusedelementwise_0()
+{
+    return 0
+           || test_fusedelementwise_programs(RandomMat(5, 6, 7, 24))
+           || test_fusedelementwise_programs(RandomMat(7, 8, 9, 12))
+           || test_fusedelementwise_programs(RandomMat(3, 4, 5, 13));
+}
+
+static int test_fusedelementwise_1()
+{
+    return 0
+           || test_fusedelementwise_programs(RandomMat(5, 7, 24))
+           || test_fusedelementwise_programs(RandomMat(7, 9, 12))
+           || test_fusedelementwise_programs(RandomMat(3, 5, 13));
+}
+
+static int test_fusedelementwise_2()
+{
+    return 0
+           || test_fusedelementwise_programs(RandomMat(15, 24))
+           || test_fusedelementwise_programs(RandomMat(17, 12))
+           || test_fusedelementwise_programs(RandomMat(19, 15));
+}
+
+static int test_fusedelementwise_3()
+{
+    return 0
+           || test_fusedelementwise_programs(RandomMat(128))
+           || test_fusedelementwise_programs(RandomMat(124))
+           || test_fusedelementwise_programs(RandomMat(127));
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    return 0
+           || test_fusedelementwise_0()
+           || test_fusedelementwise_1()
+           || test_fusedelementwise_2()
+           || test_fusedelementwise_3();
+}
@@ -0,0 +1,210 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "testutil.h"
+
+#if NCNN_INT8
+static int test_gemm_int8(int M, int N, int K, float alpha, int transA, int transB, int output_transpose, int constantA, int constantB)
+{
+    ncnn::ParamDict pd;
+    pd.set(0, alpha);
+    pd.set(1, 1.f); // beta
+    pd.set(2, transA);
+    pd.set(3, transB);
+    pd.set(4, constantA);
+    pd.set(5, constantB);
+    pd.set(6, 1);
+    pd.set(7, M);
+    pd.set(8, N);
+    pd.set(9, K);
+    pd.set(10, -1);
+    pd.set(14, output_transpose);
+    pd.set(18, 2); // int8_scale_term
+
+    std::vector<ncnn::Mat> weights;
+    if (constantA) weights.push_back(transA ? RandomS8Mat(M, K) : RandomS8Mat(K, M));
+    if (constantB) weights.push_back(transB ? RandomS8Mat(K, N) : RandomS8Mat(N, K));
+    if (constantA) weights.push_back(RandomMat(M, 100.f, 200.f));
+    if (constantB) weights.push_back(RandomMat(N, 100.f, 200.f));
+
+    std::vector<ncnn::Mat> a;
+    if (!constantA) a.push_back(transA ? RandomMat(M, K) : RandomMat(K, M));
+    if (!constantB) a.push_back(transB ? RandomMat(K, N) : RandomMat(N, K));
+
+    int ret = test_layer("Gemm", pd, weights, a);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_gemm_int8 failed M=%d N=%d K=%d alpha=%f transA=%d transB=%d output_transpose=%d constantA=%d constantB=%d\n", M, N, K, alpha, transA, transB, output_transpose, constantA, constantB);
+    }
+
+    return ret;
+}
+
+static int test_gemm_int8_bias(int M, int N, int K, const ncnn::Mat& C, float alpha, float beta, int transA, int transB, int output_transpose, int constantA, int constantB, int constantC)
+{
+    int broadcast_type_C = 0;
+    if (C.dims == 1 && C.w == 1)
+    {
+        // scalar
+        broadcast_type_C = 0;
+    }
+    if (C.dims == 1 && C.w == M)
+    {
+        // M
+        // auto broadcast from h to w is the ncnn-style convention
+        broadcast_type_C = 1;
+    }
+    if (C.dims == 1 && C.w == N)
+    {
+        // N
+        broadcast_type_C = 4;
+    }
+    if (C.dims == 2 && C.w == 1 && C.h == M)
+    {
+        // Mx1
+        broadcast_type_C = 2;
+    }
+    if (C.dims == 2 && C.w == N && C.h == M)
+    {
+        // MxN
+        broadcast_type_C = 3;
+    }
+    if (C.dims == 2 && C.w == N && C.h == 1)
+    {
+        // 1xN
+        broadcast_type_C = 4;
+    }
+
+    ncnn::ParamDict pd;
+    pd.set(0, alpha);
+    pd.set(1, beta);
+    pd.set(2, transA);
+    pd.set(3, transB);
+    pd.set(4, constantA);
+    pd.set(5, constantB);
+    pd.set(6, constantC);
+    pd.set(7, M);
+    pd.set(8, N);
+    pd.set(9, K);
+    pd.set(10, broadcast_type_C);
+    pd.set(14, output_transpose);
+    pd.set(18, 2); // int8_scale_term
+
+    std::vector<ncnn::Mat> weights;
+    if (constantA) weights.push_back(transA ? RandomS8Mat(M, K) : RandomS8Mat(K, M));
+    if (constantB) weights.push_back(transB ? RandomS8Mat(K, N) : RandomS8Mat(N, K));
+    if (constantC) weights.push_back(C);
+    if (constantA) weights.push_back(RandomMat(M, 100.f, 200.f));
+    if (constantB) weights.push_back(RandomMat(N, 100.f, 200.f));
+
+    std::vector<ncnn::Mat> a;
+    if (!constantA) a.push_back(transA ? RandomMat(M, K) : RandomMat(K, M));
+    if (!constantB) a.push_back(transB ? RandomMat(K, N) : RandomMat(N, K));
+    if (!constantC) a.push_back(C);
+
+    int ret = test_layer("Gemm", pd, weights, a);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_gemm_int8_bias failed M=%d N=%d K=%d C.dims=%d C=(%d %d %d) alpha=%f beta=%f transA=%d transB=%d output_transpose=%d constantA=%d constantB=%d constantC=%d\n", M, N, K, C.dims, C.w, C.h, C.c, alpha, beta, transA, transB, output_transpose, constantA, constantB, constantC);
+    }
+
+    return ret;
+}
+
+static int test_gemm_0(int M, int N, int K)
+{
+    return 0
+           || test_gemm_int8(M, N, K, 2.1f, 0, 0, 0, 0, 0)
+           || test_gemm_int8(M, N, K, 3.1f, 0, 1, 0, 0, 0)
+           || test_gemm_int8(M, N, K, 4.1f, 1, 0, 1, 0, 0)
+           || test_gemm_int8(M, N, K, 5.1f, 1, 1, 1, 0, 0)
+
+           || test_gemm_int8(M, N, K, 2.1f, 0, 0, 0, 1, 0)
+           || test_gemm_int8(M, N, K, 3.1f, 0, 1, 1, 1, 0)
+           || test_gemm_int8(M, N, K, 4.1f, 1, 0, 0, 1, 0)
+           || test_gemm_int8(M, N, K, 5.1f, 1, 1, 1, 1, 0)
+
+           || test_gemm_int8(M, N, K, 2.1f, 0, 0, 1, 0, 1)
+           || test_gemm_int8(M, N, K, 3.1f, 0, 1, 0, 0, 1)
+           || test_gemm_int8(M, N, K, 4.1f, 1, 0, 1, 0, 1)
+           || test_gemm_int8(M, N, K, 5.1f, 1, 1, 0, 0, 1)
+
+           || test_gemm_int8(M, N, K, 2.1f, 0, 0, 0, 1, 1)
+           || test_gemm_int8(M, N, K, 3.1f, 0, 1, 1, 1, 1)
+           || test_gemm_int8(M, N, K, 4.1f, 1, 0, 0, 1, 1)
+           || test_gemm_int8(M, N, K, 5.1f, 1, 1, 1, 1, 1);
+}
+
+static int test_gemm_1(int M, int N, int K)
+{
+    return 0
+           || test_gemm_int8_bias(M, N, K, RandomMat(1), 2.1f, 0.5f, 0, 0, 0, 0, 0, 0)
+           || test_gemm_int8_bias(M, N, K, RandomMat(M), 3.1f, 0.6f, 0, 1, 0, 1, 0, 0)
+           || test_gemm_int8_bias(M, N, K, RandomMat(1, M), 4.1f, 0.7f, 1, 0, 1, 0, 1, 0)
+           || test_gemm_int8_bias(M, N, K, RandomMat(N, M), 5.1f, 0.8f, 1, 1, 1, 1, 1, 0)
+           || test_gemm_int8_bias(M, N, K, RandomMat(N, 1), 2.1f, 0.5f, 0, 0, 0, 1, 0, 1)
+           || test_gemm_int8_bias(M, N, K, RandomMat(N), 3.1f, 0.6f, 0, 1, 1, 0, 1, 1)
+           || test_gemm_int8_bias(M, N, K, RandomMat(N, M), 1.0f, 1.0f, 1, 0, 0, 1, 1, 1);
+}
+#endif // NCNN_INT8
+
+int main()
+{
+    SRAND(7767517);
+
+#if NCNN_INT8
+    int mnk[][3] = {
+        {1, 1, 1},
+        {2, 2, 2},
+        {3, 3, 3},
+        {4, 4, 4},
+        {5, 5, 5},
+        {8, 8, 8},
+        {15, 15, 15},
+        {16, 16, 16},
+        {31, 31, 31},
+        {1, 1, 23},
+        {1, 31, 1},
+        {23, 1, 1},
+        {12, 12, 23},
+        {24, 35, 24},
+        {47, 24, 24},
+        {1, 35, 47},
+        {31, 7, 3},
+        {28, 20, 7},
+        {32, 32, 9},
+        {47, 35, 48},
+        {48, 35, 67},
+        {37, 40, 130}
+    };
+
+    int mnk_count = sizeof(mnk) / sizeof(int) / 3;
+
+    for (int i = 0; i < mnk_count; i++)
+    {
+        int M = mnk[i][0];
+        int N = mnk[i][1];
+        int K = mnk[i][2];
+
+        int ret = 0
+                  || test_gemm_0(M, N, K)
+                  || test_gemm_1(M, N, K);
+
+        if (ret != 0)
+            return ret;
+    }
+#endif // NCNN_INT8
+
+    return 0;
+}
@@ -47,10 +47,19 @@ static int test_instancenorm_0()
            || test_instancenorm(RandomMat(5, 7, 16), 0.02f, 1);
 }
 
+static int test_instancenorm_1()
+{
+    return 0
+           || test_instancenorm(RandomMat(40, 33, 3), 0.001f, 1)
+           || test_instancenorm(RandomMat(40, 33, 8), 0.001f, 1)
+           || test_instancenorm(RandomMat(23, 61, 16), 0.001f, 0);
+}
+
 int main()
 {
     SRAND(7767517);
 
     return 0
-           || test_instancenorm_0();
+           || test_instancenorm_0()
+           || test_instancenorm_1();
 }
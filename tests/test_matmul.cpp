@@ -54,6 +54,29 @@ static int test_matmul_transb(const ncnn::Mat& a, const ncnn::Mat& b)
     return ret;
 }
 
+#if NCNN_INT8
+static int test_matmul_int8(const ncnn::Mat& a, const ncnn::Mat& b, int transB)
+{
+    ncnn::ParamDict pd;
+    pd.set(0, transB);
+    pd.set(18, 2); // int8_scale_term
+
+    std::vector<ncnn::Mat> weights(0);
+
+    std::vector<ncnn::Mat> as(2);
+    as[0] = a;
+    as[1] = b;
+
+    int ret = test_layer("MatMul", pd, weights, as);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_matmul_int8 failed a.dims=%d a=(%d %d %d %d) b.dims=%d b=(%d %d %d %d) transB=%d\n", a.dims, a.w, a.h, a.d, a.c, b.dims, b.w, b.h, b.d, b.c, transB);
+    }
+
+    return ret;
+}
+#endif // NCNN_INT8
+
 static int test_matmul_0()
 {
     return 0
@@ -230,10 +253,45 @@ static int test_matmul_15()
            || test_matmul_transb(RandomMat(14, 20, 8, 18), RandomMat(14, 9, 8, 18));
 }
 
+#if NCNN_INT8
+static int test_matmul_16()
+{
+    return 0
+           || test_matmul_int8(RandomMat(124), RandomMat(124), 0)
+           || test_matmul_int8(RandomMat(13), RandomMat(7, 13), 0)
+           || test_matmul_int8(RandomMat(19, 13), RandomMat(19), 1)
+           || test_matmul_int8(RandomMat(23, 17), RandomMat(14, 23), 0)
+           || test_matmul_int8(RandomMat(32, 16), RandomMat(32, 24), 1)
+           || test_matmul_int8(RandomMat(14, 23, 5), RandomMat(9, 14, 5), 0)
+           || test_matmul_int8(RandomMat(16, 22, 9, 3), RandomMat(16, 10, 9, 3), 1)
+           || test_matmul_int8(RandomMat(14, 20, 8, 2), RandomMat(9, 14), 0);
+}
+#endif // NCNN_INT8
+
 int main()
 {
     SRAND(7767517);
 
+#if NCNN_INT8
+    return 0
+           || test_matmul_0()
+           || test_matmul_1()
+           || test_matmul_2()
+           || test_matmul_3()
+           || test_matmul_4()
+           || test_matmul_5()
+           || test_matmul_6()
+           || test_matmul_7()
+           || test_matmul_8()
+           || test_matmul_9()
+           || test_matmul_10()
+           || test_matmul_11()
+           || test_matmul_12()
+           || test_matmul_13()
+           || test_matmul_14()
+           || test_matmul_15()
+           || test_matmul_16();
+#else
     return 0
            || test_matmul_0()
            || test_matmul_1()
@@ -251,4 +309,5 @@ int main()
            || test_matmul_13()
            || test_matmul_14()
            || test_matmul_15();
+#endif
 }
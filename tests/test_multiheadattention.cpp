@@ -132,6 +132,97 @@ static int test_multiheadattention_sameqkv(const ncnn::Mat& a, int embed_dim, in
     return ret;
 }
 
+#if NCNN_INT8
+static int test_multiheadattention_int8(const ncnn::Mat& q, const ncnn::Mat& k, const ncnn::Mat& v, int embed_dim, int num_heads, int attn_mask)
+{
+    const int qdim = q.w;
+    const int kdim = k.w;
+    const int vdim = v.w;
+
+    ncnn::ParamDict pd;
+    pd.set(0, embed_dim);
+    pd.set(1, num_heads);
+    pd.set(2, embed_dim * qdim);
+    pd.set(3, kdim);
+    pd.set(4, vdim);
+    pd.set(5, attn_mask);
+    pd.set(6, 1.f / sqrtf(embed_dim / num_heads));
+    pd.set(18, 2); // int8_scale_term
+
+    std::vector<ncnn::Mat> weights(12);
+    weights[0] = RandomS8Mat(embed_dim * qdim);
+    weights[1] = RandomMat(embed_dim);
+    weights[2] = RandomS8Mat(embed_dim * kdim);
+    weights[3] = RandomMat(embed_dim);
+    weights[4] = RandomS8Mat(embed_dim * vdim);
+    weights[5] = RandomMat(embed_dim);
+    weights[6] = RandomS8Mat(qdim * embed_dim);
+    weights[7] = RandomMat(qdim);
+    weights[8] = RandomMat(embed_dim, 500.f, 800.f);
+    weights[9] = RandomMat(embed_dim, 500.f, 800.f);
+    weights[10] = RandomMat(embed_dim, 500.f, 800.f);
+    weights[11] = RandomMat(qdim, 500.f, 800.f);
+
+    std::vector<ncnn::Mat> as(3);
+    as[0] = q;
+    as[1] = k;
+    as[2] = v;
+
+    if (attn_mask)
+    {
+        as.push_back(RandomMat(k.h, q.h));
+    }
+
+    float epsilon = 0.01;
+
+    int ret = test_layer("MultiHeadAttention", pd, weights, as, 1, epsilon);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_multiheadattention_int8 failed q=(%d %d) k=(%d %d) v=(%d %d) embed_dim=%d num_heads=%d kdim=%d vdim=%d attn_mask=%d\n", q.w, q.h, k.w, k.h, v.w, v.h, embed_dim, num_heads, kdim, vdim, attn_mask);
+    }
+
+    return ret;
+}
+#endif // NCNN_INT8
+
+static int test_multiheadattention_kvcache(const ncnn::Mat& a, int past_seqlen, int embed_dim, int num_heads)
+{
+    const int qdim = a.w;
+
+    ncnn::ParamDict pd;
+    pd.set(0, embed_dim);
+    pd.set(1, num_heads);
+    pd.set(2, embed_dim * qdim);
+    pd.set(3, qdim);
+    pd.set(4, qdim);
+    pd.set(7, 1);
+
+    std::vector<ncnn::Mat> weights(8);
+    weights[0] = RandomMat(embed_dim * qdim);
+    weights[1] = RandomMat(embed_dim);
+    weights[2] = RandomMat(embed_dim * qdim);
+    weights[3] = RandomMat(embed_dim);
+    weights[4] = RandomMat(embed_dim * qdim);
+    weights[5] = RandomMat(embed_dim);
+    weights[6] = RandomMat(qdim * embed_dim);
+    weights[7] = RandomMat(qdim);
+
+    std::vector<ncnn::Mat> as(3);
+    as[0] = a;
+    as[1] = RandomMat(past_seqlen, embed_dim);
+    as[2] = RandomMat(past_seqlen, embed_dim);
+
+    float epsilon = 0.005;
+
+    int ret = test_layer("MultiHeadAttention", pd, weights, as, 3, epsilon);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_multiheadattention_kvcache failed a=(%d %d) past_seqlen=%d embed_dim=%d num_heads=%d\n", a.w, a.h, past_seqlen, embed_dim, num_heads);
+    }
+
+    return ret;
+}
+
 static int test_multiheadattention_0()
 {
     return 0
@@ -163,12 +254,42 @@ static int test_multiheadattention_2()
            || test_multiheadattention_sameqkv(RandomMat(48, 127), 64, 8);
 }
 
+static int test_multiheadattention_3()
+{
+    return 0
+           || test_multiheadattention_kvcache(RandomMat(64, 1), 17, 64, 4)
+           || test_multiheadattention_kvcache(RandomMat(48, 1), 32, 64, 8)
+           || test_multiheadattention_kvcache(RandomMat(24, 5), 11, 16, 2)
+           || test_multiheadattention_kvcache(RandomMat(12, 16), 16, 12, 3);
+}
+
+#if NCNN_INT8
+static int test_multiheadattention_4()
+{
+    return 0
+           || test_multiheadattention_int8(RandomMat(62, 66), RandomMat(32, 66), RandomMat(20, 66), 62, 2, 0)
+           || test_multiheadattention_int8(RandomMat(64, 128), RandomMat(64, 128), RandomMat(64, 128), 64, 4, 1)
+           || test_multiheadattention_int8(RandomMat(16, 5), RandomMat(24, 7), RandomMat(24, 7), 16, 2, 0)
+           || test_multiheadattention_int8(RandomMat(12, 17), RandomMat(28, 17), RandomMat(11, 17), 16, 4, 1);
+}
+#endif // NCNN_INT8
+
 int main()
 {
     SRAND(7767517);
 
+#if NCNN_INT8
+    return 0
+           || test_multiheadattention_0()
+           || test_multiheadattention_1()
+           || test_multiheadattention_2()
+           || test_multiheadattention_3()
+           || test_multiheadattention_4();
+#else
     return 0
            || test_multiheadattention_0()
            || test_multiheadattention_1()
-           || test_multiheadattention_2();
+           || test_multiheadattention_2()
+           || test_multiheadattention_3();
+#endif
 }
@@ -0,0 +1,61 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "testutil.h"
+
+static int test_mvn(const ncnn::Mat& a, int normalize_variance, int across_channels, float eps)
+{
+    ncnn::ParamDict pd;
+    pd.set(0, normalize_variance);
+    pd.set(1, across_channels);
+    pd.set(2, eps);
+
+    std::vector<ncnn::Mat> weights(0);
+
+    int ret = test_layer("MVN", pd, weights, a);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_mvn failed a.dims=%d a=(%d %d %d) normalize_variance=%d across_channels=%d eps=%f\n", a.dims, a.w, a.h, a.c, normalize_variance, across_channels, eps);
+    }
+
+    return ret;
+}
+
+static int test_mvn_0()
+{
+    return 0
+           || test_mvn(RandomMat(6, 4, 2), 0, 0, 0.0001f)
+           || test_mvn(RandomMat(5, 7, 12), 0, 1, 0.0001f)
+           || test_mvn(RandomMat(3, 3, 16), 1, 0, 0.001f)
+           || test_mvn(RandomMat(6, 4, 2), 1, 1, 0.001f)
+           || test_mvn(RandomMat(5, 7, 12), 1, 0, 0.0001f)
+           || test_mvn(RandomMat(3, 3, 16), 1, 1, 0.0001f);
+}
+
+static int test_mvn_1()
+{
+    return 0
+           || test_mvn(RandomMat(40, 33, 3), 1, 0, 0.0001f)
+           || test_mvn(RandomMat(40, 33, 8), 1, 1, 0.0001f)
+           || test_mvn(RandomMat(23, 61, 16), 1, 0, 0.0001f);
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    return 0
+           || test_mvn_0()
+           || test_mvn_1();
+}
@@ -0,0 +1,1417 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "net.h"
+#include "testutil.h"
+
+static const char* branchy_param = "7767517\n"
+                                   "9 12\n"
+                                   "Input data 0 1 data 0=24 1=24 2=16\n"
+                                   "Split splitncnn_0 1 3 data data_0 data_1 data_2\n"
+                                   "Pooling pool1 1 1 data_0 pool1 0=0 1=3 2=1 3=1\n"
+                                   "ReLU relu1 1 1 data_1 relu1\n"
+                                   "Sigmoid sigmoid1 1 1 data_2 sigmoid1\n"
+                                   "Eltwise sum 3 1 pool1 relu1 sigmoid1 sum 0=1\n"
+                                   "Split splitncnn_1 1 2 sum sum_0 sum_1\n"
+                                   "Pooling pool2 1 1 sum_0 pool2 0=1 1=2 2=2\n"
+                                   "Pooling pool3 1 1 sum_1 pool3 0=0 4=1\n";
+
+static int load_branchy_net(ncnn::Net& net, const ncnn::Option& opt)
+{
+    net.opt = opt;
+
+    int ret = net.load_param_mem(branchy_param);
+    if (ret != 0)
+        return ret;
+
+    // no layer has weight
+    const unsigned char* empty_model = (const unsigned char*)"";
+    net.load_model(empty_model);
+
+    return 0;
+}
+
+static int run_branchy_net(const ncnn::Net& net, const ncnn::Mat& in, std::vector<ncnn::Mat>& outs, ncnn::Allocator* allocator = 0)
+{
+    ncnn::Extractor ex = net.create_extractor();
+    if (allocator)
+    {
+        ex.set_blob_allocator(allocator);
+        ex.set_workspace_allocator(allocator);
+    }
+
+    ex.input("data", in);
+
+    outs.resize(2);
+    int ret = ex.extract("pool2", outs[0]);
+    if (ret != 0)
+        return ret;
+
+    ret = ex.extract("pool3", outs[1]);
+    if (ret != 0)
+        return ret;
+
+    // detach from allocator
+    outs[0] = outs[0].clone();
+    outs[1] = outs[1].clone();
+
+    return 0;
+}
+
+static int test_memory_planner_option(const ncnn::Option& _opt)
+{
+    ncnn::Option opt = _opt;
+    opt.use_memory_planner = false;
+
+    ncnn::Net net_ref;
+    load_branchy_net(net_ref, opt);
+
+    opt.use_memory_planner = true;
+
+    ncnn::Net net;
+    load_branchy_net(net, opt);
+
+    if (net.planned_arena_size() != 0)
+    {
+        fprintf(stderr, "test_memory_planner_option arena planned before any run\n");
+        return -1;
+    }
+
+    const int shapes[3][3] = {{24, 24, 16}, {24, 24, 16}, {13, 17, 8}};
+
+    for (int i = 0; i < 6; i++)
+    {
+        const int* shape = shapes[i % 3];
+        ncnn::Mat in = RandomMat(shape[0], shape[1], shape[2]);
+
+        std::vector<ncnn::Mat> outs_ref;
+        std::vector<ncnn::Mat> outs;
+        run_branchy_net(net_ref, in, outs_ref);
+        int ret = run_branchy_net(net, in, outs);
+        if (ret != 0 || CompareMat(outs_ref, outs, 0.001) != 0)
+        {
+            fprintf(stderr, "test_memory_planner_option failed run %d lightmode=%d use_packing_layout=%d\n", i, opt.lightmode, opt.use_packing_layout);
+            return -1;
+        }
+
+        // the arena is planned once the first extractor has gone
+        if (net.planned_arena_size() == 0)
+        {
+            fprintf(stderr, "test_memory_planner_option no arena planned after run %d\n", i);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// counts the blocks taken from the heap
+class CountingAllocator : public ncnn::Allocator
+{
+public:
+    CountingAllocator()
+        : malloc_count(0)
+    {
+    }
+
+    virtual void* fastMalloc(size_t size)
+    {
+        malloc_count++;
+        return ncnn::fastMalloc(size);
+    }
+
+    virtual void fastFree(void* ptr)
+    {
+        ncnn::fastFree(ptr);
+    }
+
+    int malloc_count;
+};
+
+static int test_memory_planner_heap(const ncnn::Option& _opt)
+{
+    ncnn::Option opt = _opt;
+    opt.use_memory_planner = false;
+
+    ncnn::Net net;
+    load_branchy_net(net, opt);
+
+    CountingAllocator heap_allocator;
+
+    ncnn::PlannedAllocator planned_allocator;
+    planned_allocator.set_fallback_allocator(&heap_allocator);
+
+    ncnn::Mat in = RandomMat(24, 24, 16);
+
+    std::vector<ncnn::Mat> outs_ref;
+    run_branchy_net(net, in, outs_ref);
+
+    // the recording session runs on heap
+    std::vector<ncnn::Mat> outs;
+    run_branchy_net(net, in, outs, &planned_allocator);
+    if (heap_allocator.malloc_count == 0 || planned_allocator.plan() != 0)
+    {
+        fprintf(stderr, "test_memory_planner_heap recording failed lightmode=%d use_packing_layout=%d\n", opt.lightmode, opt.use_packing_layout);
+        return -1;
+    }
+
+    // replayed sessions take every block from the arena
+    for (int i = 0; i < 3; i++)
+    {
+        heap_allocator.malloc_count = 0;
+        planned_allocator.rewind();
+
+        int ret = run_branchy_net(net, in, outs, &planned_allocator);
+        if (ret != 0 || CompareMat(outs_ref, outs, 0.001) != 0 || heap_allocator.malloc_count != 0)
+        {
+            fprintf(stderr, "test_memory_planner_heap failed run %d heap mallocs %d lightmode=%d use_packing_layout=%d\n", i, heap_allocator.malloc_count, opt.lightmode, opt.use_packing_layout);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int test_memory_planner_allocator(const ncnn::Option& _opt)
+{
+    ncnn::Option opt = _opt;
+    opt.use_memory_planner = false;
+
+    ncnn::Net net;
+    load_branchy_net(net, opt);
+
+    ncnn::PlannedAllocator planned_allocator;
+
+    ncnn::Mat in = RandomMat(24, 24, 16);
+
+    std::vector<ncnn::Mat> outs_ref;
+    run_branchy_net(net, in, outs_ref);
+
+    for (int i = 0; i < 4; i++)
+    {
+        planned_allocator.rewind();
+
+        std::vector<ncnn::Mat> outs;
+        int ret = run_branchy_net(net, in, outs, &planned_allocator);
+        if (ret != 0 || CompareMat(outs_ref, outs, 0.001) != 0)
+        {
+            fprintf(stderr, "test_memory_planner_allocator failed run %d lightmode=%d use_packing_layout=%d\n", i, opt.lightmode, opt.use_packing_layout);
+            return -1;
+        }
+
+        if (i == 0)
+        {
+            ret = planned_allocator.plan();
+            if (ret != 0)
+            {
+                fprintf(stderr, "test_memory_planner_allocator plan failed\n");
+                return -1;
+            }
+        }
+
+        if (planned_allocator.arena_size() == 0)
+        {
+            fprintf(stderr, "test_memory_planner_allocator arena not planned\n");
+            return -1;
+        }
+    }
+
+    // the arena must be smaller than the sum of all intermediate blobs
+    const size_t blob_size = 24 * 24 * 16 * sizeof(float);
+    if (opt.lightmode && planned_allocator.arena_size() >= blob_size * 7)
+    {
+        fprintf(stderr, "test_memory_planner_allocator arena too large %lu\n", (unsigned long)planned_allocator.arena_size());
+        return -1;
+    }
+
+    return 0;
+}
+
+struct BranchyNetJob
+{
+    const ncnn::Net* net;
+    ncnn::Mat in;
+    std::vector<ncnn::Mat> outs;
+    int ret;
+};
+
+static void* run_branchy_net_job(void* args)
+{
+    BranchyNetJob* job = (BranchyNetJob*)args;
+    job->ret = run_branchy_net(*job->net, job->in, job->outs);
+    return 0;
+}
+
+static int test_branch_parallel(const ncnn::Option& _opt)
+{
+    ncnn::Option opt = _opt;
+    opt.use_branch_parallel = false;
+
+    ncnn::Net net_ref;
+    load_branchy_net(net_ref, opt);
+
+    opt.num_threads = 4;
+    opt.use_branch_parallel = true;
+
+    ncnn::Net net;
+    load_branchy_net(net, opt);
+
+    for (int i = 0; i < 4; i++)
+    {
+        ncnn::Mat in = RandomMat(19 + i, 23, 16);
+
+        std::vector<ncnn::Mat> outs_ref;
+        std::vector<ncnn::Mat> outs;
+        run_branchy_net(net_ref, in, outs_ref);
+        int ret = run_branchy_net(net, in, outs);
+        if (ret != 0 || CompareMat(outs_ref, outs, 0.001) != 0)
+        {
+            fprintf(stderr, "test_branch_parallel failed run %d lightmode=%d use_packing_layout=%d use_memory_planner=%d\n", i, opt.lightmode, opt.use_packing_layout, opt.use_memory_planner);
+            return -1;
+        }
+    }
+
+#if NCNN_THREADS
+    // concurrent extractors share the worker pool of the net
+    BranchyNetJob jobs[2];
+    ncnn::Thread* threads[2];
+    for (int i = 0; i < 2; i++)
+    {
+        jobs[i].net = &net;
+        jobs[i].in = RandomMat(21, 17 + i, 16);
+        jobs[i].ret = -1;
+        threads[i] = new ncnn::Thread(run_branchy_net_job, (void*)&jobs[i]);
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        threads[i]->join();
+        delete threads[i];
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        std::vector<ncnn::Mat> outs_ref;
+        run_branchy_net(net_ref, jobs[i].in, outs_ref);
+        if (jobs[i].ret != 0 || CompareMat(outs_ref, jobs[i].outs, 0.001) != 0)
+        {
+            fprintf(stderr, "test_branch_parallel failed concurrent run %d lightmode=%d use_packing_layout=%d use_memory_planner=%d\n", i, opt.lightmode, opt.use_packing_layout, opt.use_memory_planner);
+            return -1;
+        }
+    }
+#endif // NCNN_THREADS
+
+    return 0;
+}
+
+static const char* batch_param = "7767517\n"
+                                 "8 8\n"
+                                 "Input data 0 1 data 0=6 1=6 2=8\n"
+                                 "Convolution conv1 1 1 data conv1 0=16 1=1 5=1 6=128 9=1\n"
+                                 "Pooling pool1 1 1 conv1 pool1 0=0 1=2 2=2\n"
+                                 "InnerProduct fc1 1 1 pool1 fc1 0=16 1=1 2=2304 9=1\n"
+                                 "Reshape reshape1 1 1 fc1 reshape1 0=4 1=4\n"
+                                 "Gemm gemm1 1 1 reshape1 gemm1 4=0 5=1 6=1 8=8 9=4 10=-1\n"
+                                 "Flatten flatten1 1 1 gemm1 flatten1\n"
+                                 "InnerProduct fc2 1 1 flatten1 fc2 0=10 1=1 2=320\n";
+
+static void append_random_weight(std::vector<float>& model, int size, bool with_flag)
+{
+    if (with_flag)
+        model.push_back(0.f);
+
+    ncnn::Mat m = RandomMat(size, -0.2f, 0.2f);
+    model.insert(model.end(), (const float*)m, (const float*)m + size);
+}
+
+static int load_batch_net(ncnn::Net& net, const ncnn::Option& opt, std::vector<float>& model)
+{
+    net.opt = opt;
+
+    int ret = net.load_param_mem(batch_param);
+    if (ret != 0)
+        return ret;
+
+    model.clear();
+    append_random_weight(model, 128, true);
+    append_random_weight(model, 16, false);
+    append_random_weight(model, 2304, true);
+    append_random_weight(model, 16, false);
+    append_random_weight(model, 32, true);
+    append_random_weight(model, 320, true);
+    append_random_weight(model, 10, false);
+
+    int nread = net.load_model((const unsigned char*)&model[0]);
+    if (nread != (int)(model.size() * sizeof(float)))
+        return -1;
+
+    return 0;
+}
+
+static int test_batch(const ncnn::Option& opt, int batch)
+{
+    // weights are referenced, keep model alive
+    std::vector<float> model;
+    ncnn::Net net;
+    if (load_batch_net(net, opt, model) != 0)
+    {
+        fprintf(stderr, "test_batch load failed\n");
+        return -1;
+    }
+
+    std::vector<ncnn::Mat> ins(batch);
+    for (int i = 0; i < batch; i++)
+    {
+        ins[i] = RandomMat(6, 6, 8);
+    }
+
+    std::vector<ncnn::Mat> outs_ref(batch);
+    for (int i = 0; i < batch; i++)
+    {
+        ncnn::Extractor ex = net.create_extractor();
+        ex.input("data", ins[i]);
+        ex.extract("fc2", outs_ref[i]);
+        outs_ref[i] = outs_ref[i].clone();
+    }
+
+    std::vector<ncnn::Mat> outs;
+    {
+        ncnn::Extractor ex = net.create_extractor();
+        ex.input_batch("data", ins);
+
+        int ret = ex.extract_batch("fc2", outs);
+        if (ret != 0 || (int)outs.size() != batch)
+        {
+            fprintf(stderr, "test_batch extract_batch failed batch=%d\n", batch);
+            return -1;
+        }
+
+        for (int i = 0; i < batch; i++)
+        {
+            outs[i] = outs[i].clone();
+        }
+
+        // inconsistent batch size
+        std::vector<ncnn::Mat> ins2(batch + 1, ins[0]);
+        ret = ex.input_batch("data", ins2);
+        if (ret == 0)
+        {
+            fprintf(stderr, "test_batch input_batch accepted inconsistent batch size\n");
+            return -1;
+        }
+    }
+
+    if (CompareMat(outs_ref, outs, 0.001) != 0)
+    {
+        fprintf(stderr, "test_batch failed batch=%d lightmode=%d use_packing_layout=%d\n", batch, opt.lightmode, opt.use_packing_layout);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int test_load_model_mmap(const ncnn::Option& opt)
+{
+    std::vector<float> model;
+    ncnn::Net net_ref;
+    if (load_batch_net(net_ref, opt, model) != 0)
+    {
+        fprintf(stderr, "test_load_model_mmap load failed\n");
+        return -1;
+    }
+
+    const char* modelpath = "test_net_mmap.bin";
+    FILE* fp = fopen(modelpath, "wb");
+    if (!fp)
+    {
+        fprintf(stderr, "test_load_model_mmap fopen %s failed\n", modelpath);
+        return -1;
+    }
+    fwrite(&model[0], sizeof(float), model.size(), fp);
+    fclose(fp);
+
+    int ret = 0;
+    {
+        ncnn::Net net;
+        net.opt = opt;
+        net.load_param_mem(batch_param);
+        ret = net.load_model_mmap(modelpath);
+        if (ret != 0)
+        {
+            fprintf(stderr, "test_load_model_mmap load_model_mmap failed\n");
+        }
+
+        for (int i = 0; i < 3 && ret == 0; i++)
+        {
+            ncnn::Mat in = RandomMat(6, 6, 8);
+
+            ncnn::Mat out_ref;
+            ncnn::Mat out;
+            {
+                ncnn::Extractor ex = net_ref.create_extractor();
+                ex.input("data", in);
+                ex.extract("fc2", out_ref);
+            }
+            {
+                ncnn::Extractor ex = net.create_extractor();
+                ex.input("data", in);
+                ex.extract("fc2", out);
+            }
+
+            if (CompareMat(out_ref, out, 0.001) != 0)
+            {
+                fprintf(stderr, "test_load_model_mmap failed lightmode=%d use_packing_layout=%d\n", opt.lightmode, opt.use_packing_layout);
+                ret = -1;
+            }
+        }
+    }
+
+    remove(modelpath);
+
+    {
+        ncnn::Net net;
+        net.opt = opt;
+        net.load_param_mem(batch_param);
+        if (net.load_model_mmap(modelpath) == 0)
+        {
+            fprintf(stderr, "test_load_model_mmap accepted missing file\n");
+            ret = -1;
+        }
+    }
+
+    return ret;
+}
+
+static const char* pipeline_param = "7767517\n"
+                                    "7 7\n"
+                                    "Input data 0 1 data 0=12 1=12 2=16\n"
+                                    "Convolution conv1 1 1 data conv1 0=16 1=3 4=1 5=1 6=2304 9=1\n"
+                                    "Convolution conv2 1 1 conv1 conv2 0=8 1=1 5=1 6=128\n"
+                                    "Convolution conv3 1 1 conv2 conv3 0=8 1=3 2=2 4=2 5=1 6=576\n"
+                                    "InnerProduct fc 1 1 conv3 fc 0=10 1=1 2=11520\n"
+                                    "Reshape reshape 1 1 fc reshape 0=10 1=1\n"
+                                    "Gemm gemm 1 1 reshape gemm 5=1 6=1 8=6 9=10 10=-1\n";
+
+static const char* pipeline_param_conv2_outch4 = "7767517\n"
+                                                "7 7\n"
+                                                "Input data 0 1 data 0=12 1=12 2=16\n"
+                                                "Convolution conv1 1 1 data conv1 0=16 1=3 4=1 5=1 6=2304 9=1\n"
+                                                "Convolution conv2 1 1 conv1 conv2 0=4 1=1 5=1 6=64\n"
+                                                "Convolution conv3 1 1 conv2 conv3 0=8 1=3 2=2 4=2 5=1 6=288\n"
+                                                "InnerProduct fc 1 1 conv3 fc 0=10 1=1 2=11520\n"
+                                                "Reshape reshape 1 1 fc reshape 0=10 1=1\n"
+                                                "Gemm gemm 1 1 reshape gemm 5=1 6=1 8=6 9=10 10=-1\n";
+
+static int run_pipeline_net(const ncnn::Net& net, const ncnn::Mat& in, ncnn::Mat& out)
+{
+    ncnn::Extractor ex = net.create_extractor();
+    ex.input("data", in);
+    return ex.extract("gemm", out);
+}
+
+static void make_pipeline_model(std::vector<float>& model)
+{
+    append_random_weight(model, 2304, true);
+    append_random_weight(model, 16, false);
+    append_random_weight(model, 128, true);
+    append_random_weight(model, 8, false);
+    append_random_weight(model, 576, true);
+    append_random_weight(model, 8, false);
+    append_random_weight(model, 11520, true);
+    append_random_weight(model, 10, false);
+    append_random_weight(model, 60, true);
+}
+
+static int test_pipeline_data_cache(const ncnn::Option& opt)
+{
+    std::vector<float> model;
+    make_pipeline_model(model);
+
+    const char* cachepath = "test_net_pipeline.cache";
+
+    ncnn::Net net_ref;
+    net_ref.opt = opt;
+    net_ref.load_param_mem(pipeline_param);
+    net_ref.set_pipeline_data_cache_saving(true);
+    net_ref.load_model((const unsigned char*)&model[0]);
+
+    if (net_ref.save_pipeline_data_cache(cachepath) != 0)
+    {
+        fprintf(stderr, "test_pipeline_data_cache save failed\n");
+        return -1;
+    }
+
+    int ret = 0;
+    {
+        ncnn::Net net;
+        net.opt = opt;
+        net.load_param_mem(pipeline_param);
+        if (net.load_pipeline_data_cache(cachepath) != 0)
+        {
+            fprintf(stderr, "test_pipeline_data_cache load failed\n");
+            ret = -1;
+        }
+        net.load_model((const unsigned char*)&model[0]);
+
+        for (int i = 0; i < 2 && ret == 0; i++)
+        {
+            ncnn::Mat in = RandomMat(12, 12, 16);
+
+            ncnn::Mat out_ref;
+            ncnn::Mat out;
+            run_pipeline_net(net_ref, in, out_ref);
+            run_pipeline_net(net, in, out);
+
+            if (out.empty() || CompareMat(out_ref, out, 0.001) != 0)
+            {
+                fprintf(stderr, "test_pipeline_data_cache failed lightmode=%d use_packing_layout=%d\n", opt.lightmode, opt.use_packing_layout);
+                ret = -1;
+            }
+        }
+    }
+
+    {
+        // packing layout changes the transformed weight
+        ncnn::Net net;
+        net.opt = opt;
+        net.opt.use_packing_layout = !opt.use_packing_layout;
+        net.load_param_mem(pipeline_param);
+        if (net.load_pipeline_data_cache(cachepath) == 0)
+        {
+            fprintf(stderr, "test_pipeline_data_cache accepted mismatched option\n");
+            ret = -1;
+        }
+    }
+
+    {
+        // num_output changes the transformed weight shape
+        ncnn::Net net;
+        net.opt = opt;
+        net.load_param_mem(pipeline_param_conv2_outch4);
+        if (net.load_pipeline_data_cache(cachepath) == 0)
+        {
+            fprintf(stderr, "test_pipeline_data_cache accepted mismatched param\n");
+            ret = -1;
+        }
+    }
+
+    {
+        // layer data count out of range
+        std::vector<int> data;
+        FILE* fp = fopen(cachepath, "rb");
+        if (fp)
+        {
+            int v;
+            while (fread(&v, sizeof(int), 1, fp) == 1)
+                data.push_back(v);
+            fclose(fp);
+        }
+
+        const char* badpath = "test_net_pipeline_bad.cache";
+        if (data.size() > 2 && (size_t)data[1] + 4 < data.size())
+        {
+            // magic key_size key weight_hash count
+            data[2 + data[1] + 1] = -5;
+
+            fp = fopen(badpath, "wb");
+            fwrite(&data[0], sizeof(int), data.size(), fp);
+            fclose(fp);
+        }
+
+        ncnn::Net net;
+        net.opt = opt;
+        net.load_param_mem(pipeline_param);
+        if (net.load_pipeline_data_cache(badpath) == 0)
+        {
+            fprintf(stderr, "test_pipeline_data_cache accepted corrupted cache\n");
+            ret = -1;
+        }
+
+        remove(badpath);
+    }
+
+    {
+        // same graph with other weights
+        std::vector<float> model2;
+        make_pipeline_model(model2);
+
+        ncnn::Net net_ref2;
+        net_ref2.opt = opt;
+        net_ref2.load_param_mem(pipeline_param);
+        net_ref2.load_model((const unsigned char*)&model2[0]);
+
+        ncnn::Net net;
+        net.opt = opt;
+        net.load_param_mem(pipeline_param);
+        net.load_pipeline_data_cache(cachepath);
+        net.load_model((const unsigned char*)&model2[0]);
+
+        ncnn::Mat in = RandomMat(12, 12, 16);
+
+        ncnn::Mat out_ref;
+        ncnn::Mat out;
+        run_pipeline_net(net_ref2, in, out_ref);
+        run_pipeline_net(net, in, out);
+
+        if (out.empty() || CompareMat(out_ref, out, 0.001) != 0)
+        {
+            fprintf(stderr, "test_pipeline_data_cache used cache of mismatched weight lightmode=%d use_packing_layout=%d\n", opt.lightmode, opt.use_packing_layout);
+            ret = -1;
+        }
+    }
+
+    remove(cachepath);
+
+    return ret;
+}
+
+static int test_parallel_create_pipeline(const ncnn::Option& _opt)
+{
+    std::vector<float> model;
+    make_pipeline_model(model);
+
+    ncnn::Option opt = _opt;
+    opt.num_threads = 4;
+    opt.use_parallel_create_pipeline = false;
+
+    ncnn::Net net_ref;
+    net_ref.opt = opt;
+    net_ref.load_param_mem(pipeline_param);
+    net_ref.load_model((const unsigned char*)&model[0]);
+
+    opt.use_parallel_create_pipeline = true;
+
+    ncnn::Net net;
+    net.opt = opt;
+    net.load_param_mem(pipeline_param);
+    if (net.load_model((const unsigned char*)&model[0]) != (int)(model.size() * sizeof(float)))
+    {
+        fprintf(stderr, "test_parallel_create_pipeline load_model failed\n");
+        return -1;
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        ncnn::Mat in = RandomMat(12, 12, 16);
+
+        ncnn::Mat out_ref;
+        ncnn::Mat out;
+        run_pipeline_net(net_ref, in, out_ref);
+        run_pipeline_net(net, in, out);
+
+        if (out.empty() || CompareMat(out_ref, out, 0.001) != 0)
+        {
+            fprintf(stderr, "test_parallel_create_pipeline failed lightmode=%d use_packing_layout=%d\n", opt.lightmode, opt.use_packing_layout);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int test_profiling(const ncnn::Option& opt)
+{
+    std::vector<float> model;
+    make_pipeline_model(model);
+
+    ncnn::Net net;
+    net.opt = opt;
+    net.load_param_mem(pipeline_param);
+    net.load_model((const unsigned char*)&model[0]);
+
+    ncnn::Mat in = RandomMat(12, 12, 16);
+
+    ncnn::Mat out_ref;
+    run_pipeline_net(net, in, out_ref);
+
+    ncnn::Extractor ex = net.create_extractor();
+    ex.set_profiling(true);
+    ex.input("data", in);
+
+    ncnn::Mat out;
+    ex.extract("gemm", out);
+
+    if (out.empty() || CompareMat(out_ref, out, 0.001) != 0)
+    {
+        fprintf(stderr, "test_profiling changed the output lightmode=%d use_packing_layout=%d\n", opt.lightmode, opt.use_packing_layout);
+        return -1;
+    }
+
+    // conv1 conv2 conv3 fc reshape gemm
+    const std::vector<ncnn::LayerProfile>& profiles = ex.layer_profiles();
+    if (profiles.size() != 6)
+    {
+        fprintf(stderr, "test_profiling got %d records expect 6\n", (int)profiles.size());
+        return -1;
+    }
+
+    for (size_t i = 0; i < profiles.size(); i++)
+    {
+        const ncnn::LayerProfile& profile = profiles[i];
+
+        if (profile.end < profile.start || profile.bottom_shapes.size() != 1 || profile.top_shapes.size() != 1 || profile.top_shapes[0].dims == 0)
+        {
+            fprintf(stderr, "test_profiling bad record for layer %d\n", profile.layer_index);
+            return -1;
+        }
+
+        if (profile.top_shapes[0].data != 0)
+        {
+            fprintf(stderr, "test_profiling record holds blob data for layer %d\n", profile.layer_index);
+            return -1;
+        }
+    }
+
+    // conv1 pads its input in workspace and creates a new top blob
+    const ncnn::Mat& conv1_top = profiles[0].top_shapes[0];
+    if (profiles[0].allocated_bytes <= (size_t)conv1_top.w * conv1_top.h * conv1_top.c * conv1_top.elemsize)
+    {
+        fprintf(stderr, "test_profiling conv1 allocated %d bytes\n", (int)profiles[0].allocated_bytes);
+        return -1;
+    }
+
+    if (profiles.back().top_shapes[0].w != 6)
+    {
+        fprintf(stderr, "test_profiling gemm output shape %d expect 6\n", profiles.back().top_shapes[0].w);
+        return -1;
+    }
+
+#if NCNN_STDIO
+    const char* tracepath = "test_net_profile.json";
+    if (ncnn::save_chrome_trace(tracepath, profiles) != 0)
+    {
+        fprintf(stderr, "test_profiling save_chrome_trace failed\n");
+        return -1;
+    }
+    remove(tracepath);
+#endif // NCNN_STDIO
+
+    // disabled extractor records nothing
+    ncnn::Extractor ex2 = net.create_extractor();
+    ex2.input("data", in);
+    ex2.extract("gemm", out);
+    if (!ex2.layer_profiles().empty())
+    {
+        fprintf(stderr, "test_profiling recorded without enabling\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static const char* session_ref_param = "7767517\n"
+                                       "2 2\n"
+                                       "Input x 0 1 x\n"
+                                       "GRU gru 1 1 x y 0=8 1=96 2=0\n";
+
+static const char* session_param = "7767517\n"
+                                   "3 4\n"
+                                   "Input x 0 1 x\n"
+                                   "Input h0 0 1 h0\n"
+                                   "GRU gru 2 2 x h0 y hn 0=8 1=96 2=0\n";
+
+static int test_session(const ncnn::Option& opt)
+{
+    // zero flag tag, weight_xc, bias_c, weight_hc
+    std::vector<float> model;
+    const int sizes[3] = {96, 32, 192};
+    for (int i = 0; i < 3; i++)
+    {
+        model.push_back(0.f);
+        ncnn::Mat w = RandomMat(sizes[i]);
+        model.insert(model.end(), (const float*)w, (const float*)w + sizes[i]);
+    }
+
+    ncnn::Net net_ref;
+    net_ref.opt = opt;
+    ncnn::Net net;
+    net.opt = opt;
+    if (net_ref.load_param_mem(session_ref_param) != 0 || net.load_param_mem(session_param) != 0
+            || net_ref.load_model((const unsigned char*)&model[0]) <= 0 || net.load_model((const unsigned char*)&model[0]) <= 0)
+    {
+        fprintf(stderr, "test_session load failed\n");
+        return -1;
+    }
+
+    const int T = 6;
+    ncnn::Mat x = RandomMat(4, T);
+
+    ncnn::Mat y_ref;
+    {
+        ncnn::Extractor ex = net_ref.create_extractor();
+        ex.input("x", x);
+        ex.extract("y", y_ref);
+    }
+
+    ncnn::Session session(&net);
+    for (int k = 0; k < 2; k++)
+    {
+        for (int t = 0; t < T; t++)
+        {
+            ncnn::Mat x_t = x.row_range(t, 1).clone();
+            session.input("x", x_t);
+
+            ncnn::Mat y_t;
+            int ret = session.extract("y", y_t);
+            if (ret != 0)
+            {
+                fprintf(stderr, "test_session extract failed\n");
+                return -1;
+            }
+
+            if (CompareMat(y_ref.row_range(t, 1), y_t, 0.001) != 0)
+            {
+                fprintf(stderr, "test_session failed frame=%d pass=%d lightmode=%d use_packing_layout=%d use_memory_planner=%d\n", t, k, opt.lightmode, opt.use_packing_layout, opt.use_memory_planner);
+                return -1;
+            }
+        }
+
+        // start over from zero state
+        session.reset();
+    }
+
+    return 0;
+}
+
+static const char* autotune_param = "7767517\n"
+                                    "6 7\n"
+                                    "Input data 0 1 data\n"
+                                    "Convolution conv1 1 1 data conv1 0=16 1=3 4=1 5=1 6=2304 9=1\n"
+                                    "Convolution conv2 1 1 conv1 conv2 0=16 1=1 5=1 6=256\n"
+                                    "Reshape reshape 1 1 conv2 reshape 0=-1 1=16\n"
+                                    "Split splitncnn_0 1 2 reshape reshape_0 reshape_1\n"
+                                    "Gemm gemm 2 1 reshape_0 reshape_1 gemm 3=1\n";
+
+static const char* autotune_param_conv2_relu = "7767517\n"
+                                              "6 7\n"
+                                              "Input data 0 1 data\n"
+                                              "Convolution conv1 1 1 data conv1 0=16 1=3 4=1 5=1 6=2304 9=1\n"
+                                              "Convolution conv2 1 1 conv1 conv2 0=16 1=1 5=1 6=256 9=1\n"
+                                              "Reshape reshape 1 1 conv2 reshape 0=-1 1=16\n"
+                                              "Split splitncnn_0 1 2 reshape reshape_0 reshape_1\n"
+                                              "Gemm gemm 2 1 reshape_0 reshape_1 gemm 3=1\n";
+
+static int test_kernel_autotune(const ncnn::Option& _opt)
+{
+    std::vector<float> model;
+    append_random_weight(model, 2304, true);
+    append_random_weight(model, 16, false);
+    append_random_weight(model, 256, true);
+    append_random_weight(model, 16, false);
+
+    ncnn::Option opt = _opt;
+    opt.use_kernel_autotune = false;
+
+    ncnn::Net net_ref;
+    net_ref.opt = opt;
+
+    opt.use_kernel_autotune = true;
+
+    ncnn::Net net;
+    net.opt = opt;
+
+    if (net_ref.load_param_mem(autotune_param) != 0 || net.load_param_mem(autotune_param) != 0
+            || net_ref.load_model((const unsigned char*)&model[0]) <= 0 || net.load_model((const unsigned char*)&model[0]) <= 0)
+    {
+        fprintf(stderr, "test_kernel_autotune load failed\n");
+        return -1;
+    }
+
+    // revisit the shapes to run from the kernel cache
+    const int shapes[6][2] = {{17, 13}, {24, 24}, {9, 30}, {17, 13}, {24, 24}, {9, 30}};
+    for (int i = 0; i < 6; i++)
+    {
+        ncnn::Mat in = RandomMat(shapes[i][0], shapes[i][1], 16);
+
+        ncnn::Mat out_ref;
+        ncnn::Mat out;
+        {
+            ncnn::Extractor ex = net_ref.create_extractor();
+            ex.input("data", in);
+            ex.extract("gemm", out_ref);
+        }
+        {
+            ncnn::Extractor ex = net.create_extractor();
+            ex.input("data", in);
+            int ret = ex.extract("gemm", out);
+            if (ret != 0)
+            {
+                fprintf(stderr, "test_kernel_autotune extract failed\n");
+                return -1;
+            }
+        }
+
+        if (CompareMat(out_ref, out, 0.001) != 0)
+        {
+            fprintf(stderr, "test_kernel_autotune failed run %d lightmode=%d use_packing_layout=%d\n", i, opt.lightmode, opt.use_packing_layout);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int test_kernel_profile(const ncnn::Option& _opt)
+{
+    std::vector<float> model;
+    append_random_weight(model, 2304, true);
+    append_random_weight(model, 16, false);
+    append_random_weight(model, 256, true);
+    append_random_weight(model, 16, false);
+
+    const char* profilepath = "test_net_kernel.profile";
+
+    const int shapes[3][2] = {{17, 13}, {24, 24}, {9, 30}};
+
+    ncnn::Option opt = _opt;
+    opt.use_kernel_autotune = false;
+
+    ncnn::Net net_ref;
+    net_ref.opt = opt;
+    net_ref.load_param_mem(autotune_param);
+    net_ref.load_model((const unsigned char*)&model[0]);
+
+    {
+        ncnn::Net net_tune;
+        net_tune.opt = opt;
+        net_tune.opt.use_kernel_autotune = true;
+        net_tune.load_param_mem(autotune_param);
+        net_tune.load_model((const unsigned char*)&model[0]);
+
+        for (int i = 0; i < 3; i++)
+        {
+            ncnn::Extractor ex = net_tune.create_extractor();
+            ex.input("data", RandomMat(shapes[i][0], shapes[i][1], 16));
+
+            ncnn::Mat out;
+            ex.extract("gemm", out);
+        }
+
+        if (net_tune.save_kernel_profile(profilepath) != 0)
+        {
+            fprintf(stderr, "test_kernel_profile save failed\n");
+            return -1;
+        }
+    }
+
+    int ret = 0;
+    {
+        ncnn::Net net;
+        net.opt = opt;
+        net.load_param_mem(autotune_param);
+        if (net.load_kernel_profile(profilepath) != 0)
+        {
+            fprintf(stderr, "test_kernel_profile load failed\n");
+            ret = -1;
+        }
+        net.load_model((const unsigned char*)&model[0]);
+
+        for (int i = 0; i < 3 && ret == 0; i++)
+        {
+            ncnn::Mat in = RandomMat(shapes[i][0], shapes[i][1], 16);
+
+            ncnn::Mat out_ref;
+            ncnn::Mat out;
+            {
+                ncnn::Extractor ex = net_ref.create_extractor();
+                ex.input("data", in);
+                ex.extract("gemm", out_ref);
+            }
+            {
+                ncnn::Extractor ex = net.create_extractor();
+                ex.input("data", in);
+                ex.extract("gemm", out);
+            }
+
+            if (out.empty() || CompareMat(out_ref, out, 0.001) != 0)
+            {
+                fprintf(stderr, "test_kernel_profile failed run %d lightmode=%d use_packing_layout=%d\n", i, opt.lightmode, opt.use_packing_layout);
+                ret = -1;
+            }
+        }
+    }
+
+    {
+        // the profile belongs to another graph
+        ncnn::Net net;
+        net.opt = opt;
+        net.load_param_mem(pipeline_param);
+        if (net.load_kernel_profile(profilepath) == 0)
+        {
+            fprintf(stderr, "test_kernel_profile accepted mismatched graph\n");
+            ret = -1;
+        }
+    }
+
+    {
+        // same layers with another param
+        ncnn::Net net;
+        net.opt = opt;
+        net.load_param_mem(autotune_param_conv2_relu);
+        if (net.load_kernel_profile(profilepath) == 0)
+        {
+            fprintf(stderr, "test_kernel_profile accepted mismatched param\n");
+            ret = -1;
+        }
+    }
+
+    remove(profilepath);
+
+    return ret;
+}
+
+static const char* kv_cache_param = "7767517\n"
+                                   "9 14\n"
+                                   "Input data 0 1 data\n"
+                                   "Input mask 0 1 mask\n"
+                                   "Input k1 0 1 k1\n"
+                                   "Input v1 0 1 v1\n"
+                                   "Input k2 0 1 k2\n"
+                                   "Input v2 0 1 v2\n"
+                                   "Split splitncnn_0 1 2 mask mask_0 mask_1\n"
+                                   "MultiHeadAttention mha1 4 3 data mask_0 k1 v1 mha1 mha1_k mha1_v 0=16 1=4 2=256 5=1 7=1\n"
+                                   "MultiHeadAttention mha2 4 3 mha1 mask_1 k2 v2 mha2 mha2_k mha2_v 0=16 1=4 2=256 5=1 7=1\n";
+
+static int test_kv_cache(const ncnn::Option& opt)
+{
+    std::vector<float> model;
+    for (int i = 0; i < 2; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            append_random_weight(model, 256, true);
+            append_random_weight(model, 16, false);
+        }
+    }
+
+    ncnn::Net net;
+    net.opt = opt;
+    net.load_param_mem(kv_cache_param);
+    net.load_model((const unsigned char*)&model[0]);
+
+    const int seqlen = 5;
+    ncnn::Mat in = RandomMat(16, seqlen);
+
+    // the whole sequence at once with causal mask
+    ncnn::Mat causal_mask(seqlen, seqlen);
+    for (int i = 0; i < seqlen; i++)
+    {
+        float* ptr = causal_mask.row(i);
+        for (int j = 0; j < seqlen; j++)
+        {
+            ptr[j] = j > i ? -10000.f : 0.f;
+        }
+    }
+
+    ncnn::Mat out_ref;
+    {
+        ncnn::Extractor ex = net.create_extractor();
+        ex.input("data", in);
+        ex.input("mask", causal_mask);
+        ex.extract("mha2", out_ref);
+    }
+
+    // one token per step with the cache of previous steps
+    std::vector<ncnn::Mat> kv_cache;
+    for (int i = 0; i < seqlen; i++)
+    {
+        ncnn::Extractor ex = net.create_extractor();
+        if (i > 0)
+            ex.set_kv_cache(kv_cache);
+
+        ncnn::Mat mask(i + 1, 1);
+        mask.fill(0.f);
+
+        ex.input("data", in.row_range(i, 1).clone());
+        ex.input("mask", mask);
+
+        ncnn::Mat out;
+        ex.extract("mha2", out);
+
+        if (out.empty() || CompareMat(out_ref.row_range(i, 1), out, 0.001) != 0)
+        {
+            fprintf(stderr, "test_kv_cache failed at step %d lightmode=%d use_packing_layout=%d\n", i, opt.lightmode, opt.use_packing_layout);
+            return -1;
+        }
+
+        if (ex.get_kv_cache(kv_cache) != 0 || kv_cache.size() != 4)
+        {
+            fprintf(stderr, "test_kv_cache get_kv_cache failed at step %d\n", i);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static const char* bf16_group_param = "7767517\n"
+                                     "3 3\n"
+                                     "Input data 0 1 data 0=16 1=16 2=32\n"
+                                     "ConvolutionDepthWise convdw1 1 1 data convdw1 0=32 1=3 4=1 5=1 6=2304 7=4 9=1\n"
+                                     "Convolution conv1 1 1 convdw1 conv1 0=16 1=3 4=1 5=1 6=4608\n";
+
+static int test_bf16_group_convolution(const ncnn::Option& _opt)
+{
+    std::vector<float> model;
+    append_random_weight(model, 2304, true);
+    append_random_weight(model, 32, false);
+    append_random_weight(model, 4608, true);
+    append_random_weight(model, 16, false);
+
+    ncnn::Option opt = _opt;
+    opt.use_bf16_storage = false;
+
+    ncnn::Net net_ref;
+    net_ref.opt = opt;
+
+    opt.use_bf16_storage = true;
+
+    ncnn::Net net;
+    net.opt = opt;
+
+    // the fp32 group convolutions run inside a layer without bf16 storage
+    if (net_ref.load_param_mem(bf16_group_param) != 0 || net.load_param_mem(bf16_group_param) != 0)
+    {
+        fprintf(stderr, "test_bf16_group_convolution load failed\n");
+        return -1;
+    }
+    net_ref.load_model((const unsigned char*)&model[0]);
+    net.load_model((const unsigned char*)&model[0]);
+
+    ncnn::Mat in = RandomMat(16, 16, 32);
+
+    ncnn::Mat out_ref;
+    {
+        ncnn::Extractor ex = net_ref.create_extractor();
+        ex.input("data", in);
+        ex.extract("conv1", out_ref);
+    }
+
+    ncnn::Mat out;
+    {
+        ncnn::Extractor ex = net.create_extractor();
+        ex.input("data", in);
+        int ret = ex.extract("conv1", out);
+        if (ret != 0)
+        {
+            fprintf(stderr, "test_bf16_group_convolution extract failed\n");
+            return -1;
+        }
+    }
+
+    if (CompareMat(out_ref, out, 0.05) != 0)
+    {
+        fprintf(stderr, "test_bf16_group_convolution failed lightmode=%d use_packing_layout=%d\n", opt.lightmode, opt.use_packing_layout);
+        return -1;
+    }
+
+    return 0;
+}
+
+static const char* fusion_param = "7767517\n"
+                                  "9 11\n"
+                                  "Input data 0 1 data 0=24 1=24 2=16\n"
+                                  "Split splitncnn_0 1 2 data data_0 data_1\n"
+                                  "Sigmoid sigmoid1 1 1 data_0 sigmoid1\n"
+                                  "BinaryOp mul1 2 1 sigmoid1 data_1 mul1 0=2\n"
+                                  "BinaryOp add1 1 1 mul1 add1 0=0 1=1 2=0.5\n"
+                                  "Clip clip1 1 1 add1 clip1 0=-1 1=2\n"
+                                  "Pooling pool1 1 1 clip1 pool1 0=0 1=2 2=2\n"
+                                  "HardSwish hardswish1 1 1 pool1 hardswish1\n"
+                                  "UnaryOp tanh1 1 1 hardswish1 tanh1 0=16\n";
+
+static int test_elementwise_fusion(const ncnn::Option& _opt)
+{
+    ncnn::Option opt = _opt;
+    opt.use_elementwise_fusion = false;
+
+    ncnn::Net net_ref;
+    net_ref.opt = opt;
+
+    opt.use_elementwise_fusion = true;
+
+    ncnn::Net net;
+    net.opt = opt;
+
+    // no layer has weight
+    const unsigned char* empty_model = (const unsigned char*)"";
+    if (net_ref.load_param_mem(fusion_param) != 0 || net.load_param_mem(fusion_param) != 0)
+    {
+        fprintf(stderr, "test_elementwise_fusion load failed\n");
+        return -1;
+    }
+    net_ref.load_model(empty_model);
+    net.load_model(empty_model);
+
+    // the two chains collapse into their last layer
+    const std::vector<ncnn::Layer*>& layers = net.layers();
+    if (layers[5]->type != "FusedElementwise" || layers[8]->type != "FusedElementwise" || layers[6]->type != "Pooling")
+    {
+        fprintf(stderr, "test_elementwise_fusion chains not fused\n");
+        return -1;
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        ncnn::Mat in = RandomMat(19 + i, 23, 16);
+
+        ncnn::Mat out_ref;
+        {
+            ncnn::Extractor ex = net_ref.create_extractor();
+            ex.input("data", in);
+            ex.extract("tanh1", out_ref);
+        }
+
+        ncnn::Mat out;
+        {
+            ncnn::Extractor ex = net.create_extractor();
+            ex.input("data", in);
+            int ret = ex.extract("tanh1", out);
+            if (ret != 0)
+            {
+                fprintf(stderr, "test_elementwise_fusion extract failed\n");
+                return -1;
+            }
+        }
+
+        if (CompareMat(out_ref, out, 0.001) != 0)
+        {
+            fprintf(stderr, "test_elementwise_fusion failed run %d lightmode=%d use_packing_layout=%d\n", i, opt.lightmode, opt.use_packing_layout);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    ncnn::Option opts[3];
+
+    opts[0].num_threads = 1;
+    opts[0].use_packing_layout = false;
+
+    opts[1].num_threads = 1;
+    opts[1].use_packing_layout = true;
+
+    opts[2].num_threads = 1;
+    opts[2].lightmode = false;
+
+    for (int i = 0; i < 3; i++)
+    {
+        int ret = test_memory_planner_option(opts[i]) || test_memory_planner_allocator(opts[i]) || test_memory_planner_heap(opts[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        int ret = test_branch_parallel(opts[i]);
+        if (ret != 0)
+            return ret;
+
+        ncnn::Option opt = opts[i];
+        opt.use_memory_planner = true;
+        ret = test_branch_parallel(opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        int ret = test_batch(opts[i], 1) || test_batch(opts[i], 3) || test_batch(opts[i], 8);
+        if (ret != 0)
+            return ret;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        int ret = test_load_model_mmap(opts[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        int ret = test_pipeline_data_cache(opts[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        int ret = test_parallel_create_pipeline(opts[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        int ret = test_profiling(opts[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        int ret = test_session(opts[i]);
+        if (ret != 0)
+            return ret;
+
+        ncnn::Option opt = opts[i];
+        opt.use_memory_planner = true;
+        ret = test_session(opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        int ret = test_kv_cache(opts[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        int ret = test_bf16_group_convolution(opts[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        int ret = test_elementwise_fusion(opts[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        int ret = test_kernel_autotune(opts[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        int ret = test_kernel_profile(opts[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
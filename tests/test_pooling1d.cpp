@@ -247,6 +247,38 @@ static int test_pooling1d_4()
            || test_pooling1d(13, 16, 0, 1, 1, 0, 0, 0, 1, 0, 12);
 }
 
+static int test_pooling1d_streaming(int w, int h, int pooling_type, int kernel, int stride)
+{
+    std::vector<ncnn::Mat> as(2);
+    as[0] = RandomMat(w, h);
+    as[1] = RandomMat(kernel - 1, h);
+
+    ncnn::ParamDict pd;
+    pd.set(0, pooling_type); // pooling_type
+    pd.set(1, kernel);       // kernel_w
+    pd.set(2, stride);       // stride_w
+    pd.set(20, 1);           // streaming
+
+    std::vector<ncnn::Mat> weights(0);
+
+    int ret = test_layer("Pooling1D", pd, weights, as, 2);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_pooling1d_streaming failed w=%d h=%d pooling_type=%d kernel=%d stride=%d\n", w, h, pooling_type, kernel, stride);
+    }
+
+    return ret;
+}
+
+static int test_pooling1d_5()
+{
+    return 0
+           || test_pooling1d_streaming(4, 3, 0, 2, 1)
+           || test_pooling1d_streaming(4, 8, 1, 3, 1)
+           || test_pooling1d_streaming(6, 16, 0, 3, 2)
+           || test_pooling1d_streaming(6, 4, 1, 4, 2);
+}
+
 int main()
 {
     SRAND(7767517);
@@ -256,5 +288,6 @@ int main()
            || test_pooling1d_1()
            || test_pooling1d_2()
            || test_pooling1d_3()
-           || test_pooling1d_4();
+           || test_pooling1d_4()
+           || test_pooling1d_5();
 }
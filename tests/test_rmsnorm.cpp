@@ -49,7 +49,8 @@ static int test_rmsnorm_0()
            || test_rmsnorm(RandomMat(5, 6, 12), 5, 0.02f, 1)
            || test_rmsnorm(RandomMat(4, 7, 16), 4, 0.02f, 1)
            || test_rmsnorm(RandomMat(6, 7, 24), 6, 0.001f, 1)
-           || test_rmsnorm(RandomMat(5, 8, 32), 5, 0.001f, 1);
+           || test_rmsnorm(RandomMat(5, 8, 32), 5, 0.001f, 1)
+           || test_rmsnorm(RandomMat(1200, 3, 16), 1200, 0.001f, 1);
 }
 
 static int test_rmsnorm_1()
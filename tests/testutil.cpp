@@ -410,6 +410,18 @@ static int convert_to_optimal_layout(const ncnn::Mat& a, ncnn::Mat& a4, const nc
                 dst_elempack = 8;
             else if (elemcount % 4 == 0)
                 dst_elempack = 4;
+#elif NCNN_AVX512
+            if (elemcount % 16 == 0 && ncnn::cpu_support_x86_avx512())
+                dst_elempack = 16;
+            else if (elemcount % 8 == 0 && ncnn::cpu_support_x86_avx())
+                dst_elempack = 8;
+            else if (elemcount % 4 == 0)
+                dst_elempack = 4;
+#elif NCNN_AVX
+            if (elemcount % 8 == 0 && ncnn::cpu_support_x86_avx())
+                dst_elempack = 8;
+            else if (elemcount % 4 == 0)
+                dst_elempack = 4;
 #elif NCNN_RVV
             const int packn = ncnn::cpu_riscv_vlenb() / 2;
             if (elemcount % packn == 0)
@@ -1406,16 +1418,17 @@ int test_layer_opt(const char* layer_type, const ncnn::ParamDict& pd, const std:
 
 int test_layer(const char* layer_type, const ncnn::ParamDict& pd, const std::vector<ncnn::Mat>& weights, const std::vector<ncnn::Mat>& a, int top_blob_count, float epsilon, void (*func)(ncnn::Layer*), int flag)
 {
-    // pack fp16p fp16s fp16a bf16s shader8 image
-    const int options[][7] = {
-        {0, 0, 0, 0, 0, 0, 0},
-        {0, 0, 1, 0, 0, 0, 0},
-        {0, 0, 1, 1, 1, 0, 0},
-        {1, 0, 0, 0, 0, 0, 0},
-        {1, 1, 0, 0, 1, 0, 0},
-        {1, 0, 1, 0, 0, 1, 0},
-        {1, 1, 1, 1, 0, 0, 0},
-        {1, 1, 1, 1, 1, 1, 1},
+    // pack fp16p fp16s fp16a bf16s shader8 image x86fp16
+    const int options[][8] = {
+        {0, 0, 0, 0, 0, 0, 0, 0},
+        {0, 0, 1, 0, 0, 0, 0, 1},
+        {0, 0, 1, 1, 1, 0, 0, 1},
+        {1, 0, 0, 0, 0, 0, 0, 0},
+        {1, 1, 0, 0, 1, 0, 0, 0},
+        {1, 0, 1, 0, 0, 1, 0, 1},
+        {1, 1, 1, 1, 0, 0, 0, 1},
+        {1, 1, 1, 1, 1, 1, 1, 1},
+        {1, 0, 1, 1, 0, 0, 0, 0},
     };
 
     const int opt_count = sizeof(options) / sizeof(options[0]);
@@ -1428,6 +1441,8 @@ int test_layer(const char* layer_type, const ncnn::ParamDict& pd, const std::vec
         opt.use_fp16_packed = options[i][1];
         opt.use_fp16_storage = options[i][2];
         opt.use_fp16_arithmetic = options[i][3];
+        opt.use_x86_fp16_storage = options[i][7];
+        opt.use_x86_fp16_arithmetic = options[i][7];
         opt.use_bf16_storage = options[i][4];
         opt.use_shader_pack8 = options[i][5];
         opt.use_image_storage = options[i][6];
@@ -1442,16 +1457,17 @@ int test_layer(const char* layer_type, const ncnn::ParamDict& pd, const std::vec
 
 int test_layer(const char* layer_type, const ncnn::ParamDict& pd, const std::vector<ncnn::Mat>& weights, const ncnn::Mat& a, float epsilon, void (*func)(ncnn::Layer*), int flag)
 {
-    // pack fp16p fp16s fp16a bf16s shader8 image
-    const int options[][7] = {
-        {0, 0, 0, 0, 0, 0, 0},
-        {0, 0, 1, 0, 0, 0, 0},
-        {0, 0, 1, 1, 1, 0, 0},
-        {1, 0, 0, 0, 0, 0, 0},
-        {1, 1, 0, 0, 1, 0, 0},
-        {1, 0, 1, 0, 0, 1, 0},
-        {1, 1, 1, 1, 0, 0, 0},
-        {1, 1, 1, 1, 1, 1, 1},
+    // pack fp16p fp16s fp16a bf16s shader8 image x86fp16
+    const int options[][8] = {
+        {0, 0, 0, 0, 0, 0, 0, 0},
+        {0, 0, 1, 0, 0, 0, 0, 1},
+        {0, 0, 1, 1, 1, 0, 0, 1},
+        {1, 0, 0, 0, 0, 0, 0, 0},
+        {1, 1, 0, 0, 1, 0, 0, 0},
+        {1, 0, 1, 0, 0, 1, 0, 1},
+        {1, 1, 1, 1, 0, 0, 0, 1},
+        {1, 1, 1, 1, 1, 1, 1, 1},
+        {1, 0, 1, 1, 0, 0, 0, 0},
     };
 
     const int opt_count = sizeof(options) / sizeof(options[0]);
@@ -1464,6 +1480,8 @@ int test_layer(const char* layer_type, const ncnn::ParamDict& pd, const std::vec
         opt.use_fp16_packed = options[i][1];
         opt.use_fp16_storage = options[i][2];
         opt.use_fp16_arithmetic = options[i][3];
+        opt.use_x86_fp16_storage = options[i][7];
+        opt.use_x86_fp16_arithmetic = options[i][7];
         opt.use_bf16_storage = options[i][4];
         opt.use_shader_pack8 = options[i][5];
         opt.use_image_storage = options[i][6];
@@ -1757,16 +1775,17 @@ int test_layer_oom_opt(const char* layer_type, const ncnn::ParamDict& pd, const
 
 int test_layer_oom(const char* layer_type, const ncnn::ParamDict& pd, const std::vector<ncnn::Mat>& weights, const std::vector<ncnn::Mat>& a, int top_blob_count, int flag)
 {
-    // pack fp16p fp16s fp16a bf16s shader8 image
-    const int options[][7] = {
-        {0, 0, 0, 0, 0, 0, 0},
-        {0, 0, 1, 0, 0, 0, 0},
-        {0, 0, 1, 1, 1, 0, 0},
-        {1, 0, 0, 0, 0, 0, 0},
-        {1, 1, 0, 0, 1, 0, 0},
-        {1, 0, 1, 0, 0, 1, 0},
-        {1, 1, 1, 1, 0, 0, 0},
-        {1, 1, 1, 1, 1, 1, 1},
+    // pack fp16p fp16s fp16a bf16s shader8 image x86fp16
+    const int options[][8] = {
+        {0, 0, 0, 0, 0, 0, 0, 0},
+        {0, 0, 1, 0, 0, 0, 0, 1},
+        {0, 0, 1, 1, 1, 0, 0, 1},
+        {1, 0, 0, 0, 0, 0, 0, 0},
+        {1, 1, 0, 0, 1, 0, 0, 0},
+        {1, 0, 1, 0, 0, 1, 0, 1},
+        {1, 1, 1, 1, 0, 0, 0, 1},
+        {1, 1, 1, 1, 1, 1, 1, 1},
+        {1, 0, 1, 1, 0, 0, 0, 0},
     };
 
     const int opt_count = sizeof(options) / sizeof(options[0]);
@@ -1779,6 +1798,8 @@ int test_layer_oom(const char* layer_type, const ncnn::ParamDict& pd, const std:
         opt.use_fp16_packed = options[i][1];
         opt.use_fp16_storage = options[i][2];
         opt.use_fp16_arithmetic = options[i][3];
+        opt.use_x86_fp16_storage = options[i][7];
+        opt.use_x86_fp16_arithmetic = options[i][7];
         opt.use_bf16_storage = options[i][4];
         opt.use_shader_pack8 = options[i][5];
         opt.use_image_storage = options[i][6];
@@ -1793,16 +1814,17 @@ int test_layer_oom(const char* layer_type, const ncnn::ParamDict& pd, const std:
 
 int test_layer_oom(const char* layer_type, const ncnn::ParamDict& pd, const std::vector<ncnn::Mat>& weights, const ncnn::Mat& a, int flag)
 {
-    // pack fp16p fp16s fp16a bf16s shader8 image
-    const int options[][7] = {
-        {0, 0, 0, 0, 0, 0, 0},
-        {0, 0, 1, 0, 0, 0, 0},
-        {0, 0, 1, 1, 1, 0, 0},
-        {1, 0, 0, 0, 0, 0, 0},
-        {1, 1, 0, 0, 1, 0, 0},
-        {1, 0, 1, 0, 0, 1, 0},
-        {1, 1, 1, 1, 0, 0, 0},
-        {1, 1, 1, 1, 1, 1, 1},
+    // pack fp16p fp16s fp16a bf16s shader8 image x86fp16
+    const int options[][8] = {
+        {0, 0, 0, 0, 0, 0, 0, 0},
+        {0, 0, 1, 0, 0, 0, 0, 1},
+        {0, 0, 1, 1, 1, 0, 0, 1},
+        {1, 0, 0, 0, 0, 0, 0, 0},
+        {1, 1, 0, 0, 1, 0, 0, 0},
+        {1, 0, 1, 0, 0, 1, 0, 1},
+        {1, 1, 1, 1, 0, 0, 0, 1},
+        {1, 1, 1, 1, 1, 1, 1, 1},
+        {1, 0, 1, 1, 0, 0, 0, 0},
     };
 
     const int opt_count = sizeof(options) / sizeof(options[0]);
@@ -1815,6 +1837,8 @@ int test_layer_oom(const char* layer_type, const ncnn::ParamDict& pd, const std:
         opt.use_fp16_packed = options[i][1];
         opt.use_fp16_storage = options[i][2];
         opt.use_fp16_arithmetic = options[i][3];
+        opt.use_x86_fp16_storage = options[i][7];
+        opt.use_x86_fp16_arithmetic = options[i][7];
         opt.use_bf16_storage = options[i][4];
         opt.use_shader_pack8 = options[i][5];
         opt.use_image_storage = options[i][6];
@@ -891,11 +891,15 @@ int ModelWriter::save(const char* parampath, const char* binpath)
             fprintf_param_value(" 5=%d", bias_term)
             fprintf_param_value(" 6=%d", weight_data_size)
             fprintf_param_value(" 8=%d", int8_scale_term)
-            fprintf_param_value(" 9=%d", activation_type)
             {
-                if (!op->activation_params.empty()) fprintf_param_float_array(10, op->activation_params, pp);
+                // the activation of residual convolution is kept aside at load time
+                const int activation_type = op->residual ? op->residual_activation_type : op->activation_type;
+                const ncnn::Mat& activation_params = op->residual ? op->residual_activation_params : op->activation_params;
+                if (activation_type != op_default->activation_type) fprintf(pp, " 9=%d", activation_type);
+                if (!activation_params.empty()) fprintf_param_float_array(10, activation_params, pp);
             }
             fprintf_param_value(" 19=%d", dynamic_weight)
+            fprintf_param_value(" 20=%d", residual)
 
             if (op->dynamic_weight == 0)
             {
@@ -1761,6 +1765,7 @@ int ModelWriter::save(const char* parampath, const char* binpath)
             fprintf_param_value(" 12=%d", output_elempack)
             fprintf_param_value(" 13=%d", output_elemtype)
             fprintf_param_value(" 14=%d", output_transpose)
+            fprintf_param_value(" 18=%d", int8_scale_term)
             fprintf_param_value(" 20=%d", constant_TILE_M)
             fprintf_param_value(" 21=%d", constant_TILE_N)
             fprintf_param_value(" 22=%d", constant_TILE_K)
@@ -1777,6 +1782,21 @@ int ModelWriter::save(const char* parampath, const char* binpath)
             {
                 fwrite_weight_tag_data(op->C_data, bp);
             }
+
+#if NCNN_INT8
+            // write int8_scale data
+            if (op->int8_scale_term)
+            {
+                if (op->constantA == 1)
+                {
+                    fwrite_weight_data(op->A_data_int8_scales, bp, 90, 100);
+                }
+                if (op->constantB == 1)
+                {
+                    fwrite_weight_data(op->B_data_int8_scales, bp, 90, 100);
+                }
+            }
+#endif // NCNN_INT8
         }
         else if (layer->type == "GLU")
         {
@@ -1984,6 +2004,7 @@ int ModelWriter::save(const char* parampath, const char* binpath)
             ncnn::MatMul* op_default = (ncnn::MatMul*)layer_default;
 
             fprintf_param_value(" 0=%d", transB)
+            fprintf_param_value(" 18=%d", int8_scale_term)
         }
         else if (layer->type == "MemoryData")
         {
@@ -2008,6 +2029,8 @@ int ModelWriter::save(const char* parampath, const char* binpath)
             fprintf_param_value(" 4=%d", vdim)
             fprintf_param_value(" 5=%d", attn_mask)
             fprintf_param_value(" 6=%e", scale)
+            fprintf_param_value(" 7=%d", kv_cache)
+            fprintf_param_value(" 18=%d", int8_scale_term)
 
             fwrite_weight_tag_data(op->q_weight_data, bp);
             fwrite_weight_data(op->q_bias_data, bp);
@@ -2017,6 +2040,17 @@ int ModelWriter::save(const char* parampath, const char* binpath)
             fwrite_weight_data(op->v_bias_data, bp);
             fwrite_weight_tag_data(op->out_weight_data, bp);
             fwrite_weight_data(op->out_bias_data, bp);
+
+#if NCNN_INT8
+            // write int8_scale data
+            if (op->int8_scale_term)
+            {
+                fwrite_weight_data(op->q_weight_data_int8_scales, bp, 90, 100);
+                fwrite_weight_data(op->k_weight_data_int8_scales, bp, 90, 100);
+                fwrite_weight_data(op->v_weight_data_int8_scales, bp, 90, 100);
+                fwrite_weight_data(op->out_weight_data_int8_scales, bp, 90, 100);
+            }
+#endif // NCNN_INT8
         }
         else if (layer->type == "MVN")
         {
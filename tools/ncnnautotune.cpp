@@ -0,0 +1,224 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_DEPRECATE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// ncnn public header
+#include "cpu.h"
+#include "mat.h"
+#include "net.h"
+
+static std::vector<std::vector<int> > parse_comma_int_array_list(char* s)
+{
+    std::vector<std::vector<int> > aai;
+
+    char* pch = strtok(s, "[]");
+    while (pch != NULL)
+    {
+        // parse a,b,c
+        int v;
+        int nconsumed = 0;
+        int nscan = sscanf(pch, "%d%n", &v, &nconsumed);
+        if (nscan == 1)
+        {
+            // ok we get array
+            pch += nconsumed;
+
+            std::vector<int> ai;
+            ai.push_back(v);
+
+            nscan = sscanf(pch, ",%d%n", &v, &nconsumed);
+            while (nscan == 1)
+            {
+                pch += nconsumed;
+
+                ai.push_back(v);
+
+                nscan = sscanf(pch, ",%d%n", &v, &nconsumed);
+            }
+
+            // array end
+            aai.push_back(ai);
+        }
+
+        pch = strtok(NULL, "[]");
+    }
+
+    return aai;
+}
+
+static ncnn::Mat make_input(const std::vector<int>& shape)
+{
+    ncnn::Mat m;
+    if (shape.size() == 1) m.create(shape[0]);
+    if (shape.size() == 2) m.create(shape[0], shape[1]);
+    if (shape.size() == 3) m.create(shape[0], shape[1], shape[2]);
+    if (shape.size() == 4) m.create(shape[0], shape[1], shape[2], shape[3]);
+
+    // kernel timing does not depend on the values
+    if (!m.empty())
+        m.fill(0.01f);
+
+    return m;
+}
+
+static void show_usage()
+{
+    fprintf(stderr, "Usage: ncnnautotune [ncnnparam] [ncnnbin] [ncnnprofile] [(key=value)...]\n");
+    fprintf(stderr, "  shape=[224,224,3],...[w,h,c] one shape for each input blob, repeat for more input sizes\n");
+    fprintf(stderr, "  thread=8 the same as in deployment, kernel choice depends on thread count\n");
+    fprintf(stderr, "The profile is bound to this cpu and model, load_kernel_profile rejects it otherwise\n");
+    fprintf(stderr, "Sample usage: ncnnautotune resnet.param resnet.bin resnet.profile shape=[224,224,3] shape=[320,320,3] thread=4\n");
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 5)
+    {
+        show_usage();
+        return -1;
+    }
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (argv[i][0] == '-')
+        {
+            show_usage();
+            return -1;
+        }
+    }
+
+    const char* inparam = argv[1];
+    const char* inbin = argv[2];
+    const char* outprofile = argv[3];
+
+    std::vector<std::vector<std::vector<int> > > shapes_list;
+    int num_threads = ncnn::get_physical_big_cpu_count();
+
+    for (int i = 4; i < argc; i++)
+    {
+        // key=value
+        char* kv = argv[i];
+
+        char* eqs = strchr(kv, '=');
+        if (eqs == NULL)
+        {
+            fprintf(stderr, "unrecognized arg %s\n", kv);
+            continue;
+        }
+
+        // split k v
+        eqs[0] = '\0';
+        const char* key = kv;
+        char* value = eqs + 1;
+
+        if (memcmp(key, "shape", 5) == 0)
+            shapes_list.push_back(parse_comma_int_array_list(value));
+        if (memcmp(key, "thread", 6) == 0)
+            num_threads = atoi(value);
+    }
+
+    if (num_threads <= 0)
+    {
+        fprintf(stderr, "malformed thread %d\n", num_threads);
+        return -1;
+    }
+
+    // the tuned kernels are fp32 ones
+    ncnn::Option opt;
+    opt.num_threads = num_threads;
+    opt.use_fp16_packed = false;
+    opt.use_fp16_storage = false;
+    opt.use_fp16_arithmetic = false;
+    opt.use_bf16_storage = false;
+    opt.use_kernel_autotune = true;
+
+    ncnn::Net net;
+    net.opt = opt;
+
+    if (net.load_param(inparam) != 0)
+    {
+        fprintf(stderr, "load_param %s failed\n", inparam);
+        return -1;
+    }
+    if (net.load_model(inbin) != 0)
+    {
+        fprintf(stderr, "load_model %s failed\n", inbin);
+        return -1;
+    }
+
+    const std::vector<int>& input_indexes = net.input_indexes();
+    const std::vector<int>& output_indexes = net.output_indexes();
+
+    if (shapes_list.empty())
+    {
+        fprintf(stderr, "expect at least one shape\n");
+        return -1;
+    }
+
+    for (size_t i = 0; i < shapes_list.size(); i++)
+    {
+        const std::vector<std::vector<int> >& shapes = shapes_list[i];
+        if (shapes.size() != input_indexes.size())
+        {
+            fprintf(stderr, "expect %d shapes, but got %d\n", (int)input_indexes.size(), (int)shapes.size());
+            return -1;
+        }
+
+        ncnn::Extractor ex = net.create_extractor();
+
+        for (size_t j = 0; j < input_indexes.size(); j++)
+        {
+            ncnn::Mat in = make_input(shapes[j]);
+            if (in.empty())
+            {
+                fprintf(stderr, "malformed shape for input %d\n", (int)j);
+                return -1;
+            }
+
+            ex.input(input_indexes[j], in);
+        }
+
+        // the first run of every new shape times the candidate kernels
+        for (size_t j = 0; j < output_indexes.size(); j++)
+        {
+            ncnn::Mat out;
+            int ret = ex.extract(output_indexes[j], out);
+            if (ret != 0)
+            {
+                fprintf(stderr, "extract output %d failed for shape set %d\n", (int)j, (int)i);
+                return -1;
+            }
+        }
+
+        fprintf(stderr, "tuned shape set %d / %d\n", (int)i + 1, (int)shapes_list.size());
+    }
+
+    if (net.save_kernel_profile(outprofile) != 0)
+    {
+        fprintf(stderr, "save_kernel_profile %s failed\n", outprofile);
+        return -1;
+    }
+
+    fprintf(stderr, "kernel profile for %d threads written to %s\n", num_threads, outprofile);
+
+    return 0;
+}
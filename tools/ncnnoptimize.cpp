@@ -64,6 +64,7 @@ public:
     int fuse_innerproduct_batchnorm();
     int fuse_innerproduct_add();
     int fuse_innerproduct_dropout();
+    int fuse_convolution_eltwise();
     int fuse_convolution_activation();
     int fuse_convolutiondepthwise_activation();
     int fuse_deconvolution_activation();
@@ -162,6 +163,10 @@ int NetOptimize::fuse_convolution_batchnorm()
         if (layers[i]->type != "Convolution")
             continue;
 
+        // the residual is added after the convolution, nothing can be folded into the weights
+        if (((ncnn::Convolution*)layers[i])->residual)
+            continue;
+
         // Convolution - BatchNorm
         int top_blob_index = layers[i]->tops[0];
 
@@ -245,6 +250,10 @@ int NetOptimize::fuse_convolution_mul()
         if (layers[i]->type != "Convolution")
             continue;
 
+        // the residual is added after the convolution, nothing can be folded into the weights
+        if (((ncnn::Convolution*)layers[i])->residual)
+            continue;
+
         // Convolution - BinaryOp
         int top_blob_index = layers[i]->tops[0];
 
@@ -334,6 +343,10 @@ int NetOptimize::fuse_convolution_add()
         if (layers[i]->type != "Convolution")
             continue;
 
+        // the residual is added after the convolution, nothing can be folded into the weights
+        if (((ncnn::Convolution*)layers[i])->residual)
+            continue;
+
         // Convolution - BinaryOp
         int top_blob_index = layers[i]->tops[0];
 
@@ -1276,6 +1289,92 @@ int NetOptimize::fuse_innerproduct_dropout()
     return 0;
 }
 
+int NetOptimize::fuse_convolution_eltwise()
+{
+    const size_t layer_count = layers.size();
+    for (size_t i = 0; i < layer_count; i++)
+    {
+        if (layers[i]->type != "Convolution")
+            continue;
+
+        ncnn::Convolution* convolution = (ncnn::Convolution*)layers[i];
+
+        // the activation must come after the add
+        if (convolution->residual || convolution->dynamic_weight || convolution->int8_scale_term > 100 || convolution->activation_type != 0)
+            continue;
+
+        // Convolution - Eltwise
+        int top_blob_index = layers[i]->tops[0];
+
+        size_t j = i + 1;
+        for (; j < layer_count; j++)
+        {
+            if (layers[j]->bottoms.size() != 2)
+                continue;
+
+            if (layers[j]->bottoms[0] != top_blob_index && layers[j]->bottoms[1] != top_blob_index)
+                continue;
+
+            if (layers[j]->type == "Eltwise")
+            {
+                ncnn::Eltwise* eltwise = (ncnn::Eltwise*)layers[j];
+                if (eltwise->op_type != ncnn::Eltwise::Operation_SUM)
+                    continue;
+
+                if (!eltwise->coeffs.empty() && (eltwise->coeffs[0] != 1.f || eltwise->coeffs[1] != 1.f))
+                    continue;
+
+                break;
+            }
+
+            if (layers[j]->type == "BinaryOp")
+            {
+                ncnn::BinaryOp* binaryop = (ncnn::BinaryOp*)layers[j];
+                if (binaryop->op_type != ncnn::BinaryOp::Operation_ADD || binaryop->with_scalar)
+                    continue;
+
+                // broadcasting add can not be fused, both shapes must be known and equal
+                const ncnn::Mat& shape0 = blobs[binaryop->bottoms[0]].shape;
+                const ncnn::Mat& shape1 = blobs[binaryop->bottoms[1]].shape;
+                if (shape0.dims == 0 || shape0.dims != shape1.dims || shape0.w != shape1.w || shape0.h != shape1.h || shape0.c != shape1.c)
+                    continue;
+
+                break;
+            }
+        }
+
+        if (j == layer_count)
+            continue;
+
+        // fuse Convolution - Eltwise to Convolution with residual
+        ncnn::Layer* eltwise = layers[j];
+
+        const int residual_blob_index = eltwise->bottoms[0] == top_blob_index ? eltwise->bottoms[1] : eltwise->bottoms[0];
+        if (residual_blob_index == top_blob_index)
+            continue;
+
+        fprintf(stderr, "fuse_convolution_eltwise %s %s\n", convolution->name.c_str(), eltwise->name.c_str());
+
+        convolution->residual = 1;
+        convolution->residual_activation_type = 0;
+        convolution->residual_activation_params = ncnn::Mat();
+
+        convolution->bottoms.push_back(residual_blob_index);
+        blobs[residual_blob_index].consumer = j;
+
+        int top_blob_index_final = eltwise->tops[0];
+        convolution->tops[0] = top_blob_index_final;
+        blobs[top_blob_index_final].producer = j;
+        eltwise->type = "ncnnfused";
+
+        // the residual may be produced after the convolution, take the place of eltwise
+        layers[j] = convolution;
+        layers[i] = eltwise;
+    }
+
+    return 0;
+}
+
 int NetOptimize::fuse_convolution_activation()
 {
     const size_t layer_count = layers.size();
@@ -1351,6 +1450,15 @@ int NetOptimize::fuse_convolution_activation()
             convolution->activation_params[1] = hardswish->beta;
         }
 
+        if (convolution->residual)
+        {
+            // the activation runs after the residual add
+            convolution->residual_activation_type = convolution->activation_type;
+            convolution->residual_activation_params = convolution->activation_params;
+            convolution->activation_type = 0;
+            convolution->activation_params = ncnn::Mat();
+        }
+
         int top_blob_index_final = activation->tops[0];
         convolution->tops[0] = top_blob_index_final;
         blobs[top_blob_index_final].producer = i;
@@ -2758,6 +2866,8 @@ int main(int argc, char** argv)
     if (argc < 6)
     {
         fprintf(stderr, "usage: %s [inparam] [inbin] [outparam] [outbin] [flag] [cutstart] [cutend]\n", argv[0]);
+        fprintf(stderr, "  flag 0 = fp32, 1 = fp16, add 2 to fuse convolution - eltwise sum into residual convolution\n");
+        fprintf(stderr, "  residual convolution runs on cpu only, vulkan inference falls back to cpu for it\n");
         return -1;
     }
 
@@ -2766,6 +2876,10 @@ int main(int argc, char** argv)
     const char* outparam = argv[3];
     const char* outbin = argv[4];
     int flag = atoi(argv[5]);
+
+    // residual fusion is opt-in, the fused convolution has no vulkan implementation
+    const bool fuse_residual = flag & 2;
+    flag &= ~2;
     const char* cutstartname = nullptr;
     const char* cutendname = nullptr;
 
@@ -2824,6 +2938,8 @@ int main(int argc, char** argv)
     optimizer.replace_reduction_with_global_pooling();
     optimizer.replace_prelu_with_leaky_relu();
 
+    if (fuse_residual)
+        optimizer.fuse_convolution_eltwise();
     optimizer.fuse_convolution_activation();
     optimizer.fuse_convolutiondepthwise_activation();
     optimizer.fuse_deconvolution_activation();
@@ -133,6 +133,9 @@ public:
     int quantize_lstm();
     int quantize_gru();
 
+    int quantize_gemm();
+    int quantize_multiheadattention();
+
     int fuse_requantize();
 };
 
@@ -562,6 +565,151 @@ int NetQuantize::quantize_gru()
     return 0;
 }
 
+// quantize weight (w, h) with one scale per row, or one scale per column when per_column
+static int quantize_weight_int8(const ncnn::Mat& weight, int per_column, ncnn::Mat& weight_int8, ncnn::Mat& weight_int8_scales, const ncnn::Option& opt)
+{
+    const int rows = per_column ? weight.w : weight.h;
+    const int size = per_column ? weight.h : weight.w;
+
+    // gather each scale group into one row
+    ncnn::Mat weight_rows(size, rows);
+    for (int i = 0; i < rows; i++)
+    {
+        float* ptr = weight_rows.row(i);
+        for (int k = 0; k < size; k++)
+        {
+            ptr[k] = per_column ? weight.row(k)[i] : weight.row(i)[k];
+        }
+    }
+
+    weight_int8_scales.create(rows);
+    for (int i = 0; i < rows; i++)
+    {
+        const float* ptr = weight_rows.row(i);
+        float absmax = 0.f;
+        for (int k = 0; k < size; k++)
+        {
+            absmax = std::max(absmax, (float)fabs(ptr[k]));
+        }
+        weight_int8_scales[i] = absmax == 0.f ? 1.f : 127 / absmax;
+    }
+
+    ncnn::Option opt_q = opt;
+    opt_q.blob_allocator = weight.allocator;
+    opt_q.use_packing_layout = false;
+
+    ncnn::Mat weight_rows_int8;
+    ncnn::quantize_to_int8(weight_rows, weight_rows_int8, weight_int8_scales, opt_q);
+    if (weight_rows_int8.empty())
+        return -100;
+
+    if (!per_column)
+    {
+        weight_int8 = weight_rows_int8;
+        return 0;
+    }
+
+    weight_int8.create(weight.w, weight.h, (size_t)1u, weight.allocator);
+    if (weight_int8.empty())
+        return -100;
+
+    for (int k = 0; k < size; k++)
+    {
+        signed char* outptr = weight_int8.row<signed char>(k);
+        for (int i = 0; i < rows; i++)
+        {
+            outptr[i] = weight_rows_int8.row<const signed char>(i)[k];
+        }
+    }
+
+    return 0;
+}
+
+int NetQuantize::quantize_gemm()
+{
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        if (layers[i]->type != "Gemm")
+            continue;
+
+        // Gemm - quantize constant A / B from fp32 to int8
+        ncnn::Gemm* gemm = (ncnn::Gemm*)layers[i];
+
+        // dynamic A and B are not worth quantizing blindly
+        if (!gemm->constantA && !gemm->constantB)
+            continue;
+
+        fprintf(stderr, "quantize_gemm %s\n", gemm->name.c_str());
+
+        // one scale per M for A, one scale per N for B
+        if (gemm->constantA)
+        {
+            ncnn::Mat A_data_int8;
+            ncnn::Mat A_data_int8_scales;
+            int ret = quantize_weight_int8(gemm->A_data, gemm->transA, A_data_int8, A_data_int8_scales, opt);
+            if (ret != 0)
+                return ret;
+
+            gemm->A_data = A_data_int8;
+            gemm->A_data_int8_scales = A_data_int8_scales;
+        }
+
+        if (gemm->constantB)
+        {
+            ncnn::Mat B_data_int8;
+            ncnn::Mat B_data_int8_scales;
+            int ret = quantize_weight_int8(gemm->B_data, gemm->transB ? 0 : 1, B_data_int8, B_data_int8_scales, opt);
+            if (ret != 0)
+                return ret;
+
+            gemm->B_data = B_data_int8;
+            gemm->B_data_int8_scales = B_data_int8_scales;
+        }
+
+        gemm->int8_scale_term = 2;
+    }
+
+    return 0;
+}
+
+int NetQuantize::quantize_multiheadattention()
+{
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        if (layers[i]->type != "MultiHeadAttention")
+            continue;
+
+        // MultiHeadAttention - quantize q/k/v/out weight from fp32 to int8
+        ncnn::MultiHeadAttention* mha = (ncnn::MultiHeadAttention*)layers[i];
+
+        fprintf(stderr, "quantize_multiheadattention %s\n", mha->name.c_str());
+
+        const int embed_dim = mha->embed_dim;
+        const int qdim = mha->weight_data_size / embed_dim;
+
+        ncnn::Mat* weights[4] = {&mha->q_weight_data, &mha->k_weight_data, &mha->v_weight_data, &mha->out_weight_data};
+        ncnn::Mat* weight_scales[4] = {&mha->q_weight_data_int8_scales, &mha->k_weight_data_int8_scales, &mha->v_weight_data_int8_scales, &mha->out_weight_data_int8_scales};
+        const int num_outputs[4] = {embed_dim, embed_dim, embed_dim, qdim};
+
+        for (int j = 0; j < 4; j++)
+        {
+            const int num_output = num_outputs[j];
+            const int size = weights[j]->w / num_output;
+
+            ncnn::Mat weight_int8;
+            int ret = quantize_weight_int8(weights[j]->reshape(size, num_output), 0, weight_int8, *weight_scales[j], opt);
+            if (ret != 0)
+                return ret;
+
+            *weights[j] = weight_int8.reshape(size * num_output);
+        }
+
+        mha->int8_scale_term = 2;
+    }
+
+    return 0;
+}
+
 int NetQuantize::fuse_requantize()
 {
     const size_t layer_count = layers.size();
@@ -810,6 +958,9 @@ int main(int argc, char** argv)
     quantizer.quantize_lstm();
     quantizer.quantize_gru();
 
+    quantizer.quantize_gemm();
+    quantizer.quantize_multiheadattention();
+
     quantizer.fuse_requantize();
 
     quantizer.save(outparam, outbin);